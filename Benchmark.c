@@ -0,0 +1,1196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LineIndexer.h"
+#include "WrapIndex.h"
+#include "FileMapping.h"
+#include "BlockCache.h"
+#include "TextSearch.h"
+#include "Regex.h"
+#include "TrigramIndex.h"
+#include "ColumnIndex.h"
+#include "TabIndex.h"
+#include "CompressedFile.h"
+#include "Thread.h"
+#include "Error.h"
+#include <zlib.h>
+
+#ifndef _WIN32
+    #include <time.h>
+#endif
+
+#define DEFAULT_CORPUS_SIZE (256LL * 1024 * 1024)
+#define REPEATS_NUMBER 5
+#define COMPRESSED_BENCHMARK_FILE "benchmark.gz"  // temporary file text is compressed into
+
+// tokens planted into generated corpus for trigram index (see PlantRareTokens) and numbers of lines they're in
+static char const * const rareTokens[] = { "ID-0042-RARE", "ID-1337-SOME", "ERR-TIMEOUT" };
+static int const rareTokenCounts[]     = { 4,              64,             1024 };
+
+/**
+ * Gives current value of monotonic clock.
+ * OUT:
+ * @return time in seconds
+ */
+static double GetSeconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+ * Lets other threads run for about a millisecond.
+ */
+static void PauseThread(void) {
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec pause = { 0, 1000000 };
+    nanosleep(&pause, NULL);
+#endif
+}
+
+/**
+ * Fills buffer with log-like lines of random length (mostly "\n" ended, some "\r\n" and "\r" ended).
+ * IN:
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets generated text
+ */
+static void GenerateCorpus(char * buffer, long long size) {
+    static char const alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789 =:[]";
+    unsigned int seed = 12345;
+    long long position = 0;
+    long long lineEnd;
+
+    while (position < size) {
+        seed = seed * 1103515245u + 12345u;
+        lineEnd = position + 20 + (long long)((seed >> 16) % 140);
+        for (; position < lineEnd && position < size; ++position) {
+            seed = seed * 1103515245u + 12345u;
+            buffer[position] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+        }
+        if (position < size && (seed & 0x0F00) == 0)
+            buffer[position++] = '\r';
+        if (position < size && (seed & 0xF000) != 0)
+            buffer[position++] = '\n';
+    }
+}
+
+/**
+ * Writes tokens which aren't made of corpus alphabet over beginnings of random lines, each token
+ * in it's own number of lines (see rareTokens), so trigram index has blocks to skip for them.
+ * IN:
+ * @param size - size of buffer
+ *
+ * INOUT:
+ * @param buffer - text generated by GenerateCorpus
+ */
+static void PlantRareTokens(char * buffer, long long size) {
+    unsigned int seed = 54321;
+    long long position, end;
+    size_t token, length;
+    int planted;
+
+    for (token = 0; token < sizeof(rareTokens) / sizeof(rareTokens[0]); ++token) {
+        length = strlen(rareTokens[token]);
+        for (planted = 0; planted < rareTokenCounts[token]; ) {
+            seed = seed * 1103515245u + 12345u;
+            position = (long long)(((unsigned long long)seed << 16 ^ seed >> 8) % (unsigned long long)size);
+            while (position < size && position > 0 && buffer[position - 1] != '\n')
+                ++position;
+            for (end = position; end < size && end < position + (long long)length && buffer[end] != '\n' &&
+                 buffer[end] != '\r'; ++end)
+                ;
+            // lines shorter than token are left as they are
+            if (end - position < (long long)length)
+                continue;
+            memcpy(buffer + position, rareTokens[token], length);
+            ++planted;
+        }
+    }
+}
+
+/**
+ * Fills buffer with UTF-8 lines of random length mixing ASCII symbols with 2, 3 and 4 byte characters.
+ * Every 1000th line is a long one, so it gets column checkpoints.
+ * IN:
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets generated text
+ */
+static void GenerateUtf8Corpus(char * buffer, long long size) {
+    static char const * const symbols[] = { "a", "b", "c", "=", " ", "1", "\xD0\x96", "\xD1\x8F", "\xE2\x82\xAC",
+                                            "\xE4\xB8\xAD", "\xF0\x9F\x98\x80" };
+    unsigned int seed = 54321;
+    long long position = 0;
+    long long lineEnd;
+    long long lineNumber = 0;
+    char const * symbol;
+
+    while (position < size) {
+        seed = seed * 1103515245u + 12345u;
+        lineEnd = position + 20 + (long long)((seed >> 16) % ((lineNumber++ % 1000 == 0) ? 200000 : 200));
+        while (position < lineEnd && position < size) {
+            seed = seed * 1103515245u + 12345u;
+            symbol = symbols[(seed >> 16) % (sizeof(symbols) / sizeof(symbols[0]))];
+            if (position + (long long)strlen(symbol) > size)
+                symbol = "a";   // characters aren't cut by the end of buffer
+            while (*symbol != '\0')
+                buffer[position++] = *symbol++;
+        }
+        if (position < size)
+            buffer[position++] = '\n';
+    }
+}
+
+/**
+ * Turns spaces of generated UTF-8 text into tabs, so most lines are expanded.
+ * IN:
+ * @param buffer - text generated by GenerateUtf8Corpus
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets text with tabs
+ */
+static void GenerateTabCorpus(char * buffer, long long size) {
+    long long position;
+
+    GenerateUtf8Corpus(buffer, size);
+    for (position = 0; position < size; ++position) {
+        if (buffer[position] == ' ')
+            buffer[position] = '\t';
+    }
+}
+
+/**
+ * Checks whether two indexes are identical.
+ * IN:
+ * @param first, second - pointers to indexes to compare
+ *
+ * OUT:
+ * @return TRUE if indexes are equal
+ */
+static BOOL CompareLineIndexes(LineIndex const * first, LineIndex const * second) {
+    long long line;
+
+    if (first->linesNumber != second->linesNumber || first->maxLength != second->maxLength)
+        return FALSE;
+    for (line = 0; line <= first->linesNumber; ++line) {
+        if (GetIndexedLineBeginning(first, line) != GetIndexedLineBeginning(second, line))
+            return FALSE;
+    }
+    return memcmp(first->crlfLines, second->crlfLines, (first->linesNumber + 7) / 8) == 0;
+}
+
+/**
+ * Measures throughput of every supported line indexer kernel.
+ * IN:
+ * @param data - text to index
+ * @param size - size of text in bytes
+ */
+static void BenchmarkIndexerKernels(char const * data, long long size) {
+    IndexerOptions options = { INDEXER_KERNEL_SCALAR, 1, LINE_INDEX_FLAT };
+    LineIndex reference;
+    LineIndex index;
+    double bestTime, startTime, elapsed;
+    int kernel, repeat;
+
+    if (BuildLineIndex(&reference, data, size, &options) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+
+    printf("line indexer: %lld bytes, %lld lines, longest line %lld, detected kernel %s\n",
+           size, reference.linesNumber, reference.maxLength, GetIndexerKernelName(DetectIndexerKernel()));
+    printf("%-8s %12s %10s\n", "kernel", "seconds", "GB/s");
+
+    for (kernel = INDEXER_KERNEL_SCALAR; kernel < INDEXER_KERNELS_NUMBER; ++kernel) {
+        if (!IsIndexerKernelSupported((IndexerKernel)kernel))
+            continue;
+
+        options.kernel = (IndexerKernel)kernel;
+        bestTime = 0;
+        for (repeat = 0; repeat < REPEATS_NUMBER; ++repeat) {
+            startTime = GetSeconds();
+            if (BuildLineIndex(&index, data, size, &options) != ERR_NO) {
+                PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+                DestroyLineIndex(&reference);
+                return;
+            }
+            elapsed = GetSeconds() - startTime;
+            if (repeat == 0 || elapsed < bestTime)
+                bestTime = elapsed;
+
+            if (repeat == 0 && !CompareLineIndexes(&reference, &index))
+                printf("%-8s index differs from scalar one\n", GetIndexerKernelName((IndexerKernel)kernel));
+            DestroyLineIndex(&index);
+        }
+
+        printf("%-8s %12.6f %10.3f\n", GetIndexerKernelName((IndexerKernel)kernel),
+               bestTime, (double)size / bestTime / 1e9);
+    }
+
+    DestroyLineIndex(&reference);
+}
+
+/**
+ * Measures scaling of parallel line indexing with the detected kernel
+ * from a single thread up to number of logical processors.
+ * IN:
+ * @param data - text to index
+ * @param size - size of text in bytes
+ */
+static void BenchmarkIndexerThreads(char const * data, long long size) {
+    IndexerOptions options = { INDEXER_KERNEL_AUTO, 1, LINE_INDEX_FLAT };
+    LineIndex reference;
+    LineIndex index;
+    double bestTime, singleTime = 0, startTime, elapsed;
+    int maxThreadsNumber = GetHardwareConcurrency();
+    int threadsNumber, repeat;
+
+    if (BuildLineIndex(&reference, data, size, &options) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+
+    printf("parallel line indexer: kernel %s, up to %i threads\n",
+           GetIndexerKernelName(DetectIndexerKernel()), maxThreadsNumber);
+    printf("%-8s %12s %10s %8s\n", "threads", "seconds", "GB/s", "speedup");
+
+    for (threadsNumber = 1; ; threadsNumber *= 2) {
+        if (threadsNumber > maxThreadsNumber)
+            threadsNumber = maxThreadsNumber;
+
+        options.threadsNumber = threadsNumber;
+        bestTime = 0;
+        for (repeat = 0; repeat < REPEATS_NUMBER; ++repeat) {
+            startTime = GetSeconds();
+            if (BuildLineIndex(&index, data, size, &options) != ERR_NO) {
+                PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+                DestroyLineIndex(&reference);
+                return;
+            }
+            elapsed = GetSeconds() - startTime;
+            if (repeat == 0 || elapsed < bestTime)
+                bestTime = elapsed;
+
+            if (repeat == 0 && !CompareLineIndexes(&reference, &index))
+                printf("%-8i index differs from serial one\n", threadsNumber);
+            DestroyLineIndex(&index);
+        }
+        if (threadsNumber == 1)
+            singleTime = bestTime;
+
+        printf("%-8i %12.6f %10.3f %8.2f\n", threadsNumber, bestTime,
+               (double)size / bestTime / 1e9, singleTime / bestTime);
+        if (threadsNumber == maxThreadsNumber)
+            break;
+    }
+
+    DestroyLineIndex(&reference);
+}
+
+/**
+ * Compares memory and access latency of flat and packed line indexes.
+ * IN:
+ * @param data - text to index
+ * @param size - size of text in bytes
+ */
+static void BenchmarkLineIndexModes(char const * data, long long size) {
+    static char const * modeNames[] = { "flat", "packed" };
+    IndexerOptions options = { INDEXER_KERNEL_AUTO, 0, LINE_INDEX_FLAT };
+    LineIndex indexes[2];
+    double startTime, buildTime, randomTime, sequentialTime;
+    unsigned int seed = 12345;
+    long long checksum = 0;
+    long long lookupsNumber, lookup, line;
+    int mode;
+
+    printf("line index modes\n");
+    printf("%-8s %14s %12s %12s %14s %14s\n",
+           "mode", "index bytes", "bytes/line", "build s", "random ns", "sequential ns");
+
+    for (mode = LINE_INDEX_FLAT; mode <= LINE_INDEX_PACKED; ++mode) {
+        options.mode = (LineIndexMode)mode;
+        startTime = GetSeconds();
+        if (BuildLineIndex(&indexes[mode], data, size, &options) != ERR_NO) {
+            PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+            if (mode == LINE_INDEX_PACKED)
+                DestroyLineIndex(&indexes[LINE_INDEX_FLAT]);
+            return;
+        }
+        buildTime = GetSeconds() - startTime;
+
+        // random lookups model painting of arbitrary screens after scrollbar drags
+        lookupsNumber = max(indexes[mode].linesNumber, 10000000LL);
+        startTime = GetSeconds();
+        for (lookup = 0; lookup < lookupsNumber; ++lookup) {
+            seed = seed * 1103515245u + 12345u;
+            line = (long long)(((unsigned long long)seed * indexes[mode].linesNumber) >> 32);
+            checksum += GetIndexedLineBeginning(&indexes[mode], line);
+        }
+        randomTime = GetSeconds() - startTime;
+
+        startTime = GetSeconds();
+        for (line = 0; line < indexes[mode].linesNumber; ++line)
+            checksum += GetIndexedLineBeginning(&indexes[mode], line);
+        sequentialTime = GetSeconds() - startTime;
+
+        printf("%-8s %14lu %12.2f %12.6f %14.2f %14.2f\n", modeNames[mode],
+               (unsigned long)GetLineIndexMemory(&indexes[mode]),
+               (double)GetLineIndexMemory(&indexes[mode]) / indexes[mode].linesNumber,
+               buildTime, randomTime * 1e9 / lookupsNumber, sequentialTime * 1e9 / indexes[mode].linesNumber);
+    }
+
+    if (!CompareLineIndexes(&indexes[LINE_INDEX_FLAT], &indexes[LINE_INDEX_PACKED]))
+        printf("packed index differs from flat one\n");
+    printf("(checksum %lld)\n", checksum);
+
+    DestroyLineIndex(&indexes[LINE_INDEX_FLAT]);
+    DestroyLineIndex(&indexes[LINE_INDEX_PACKED]);
+}
+
+/**
+ * Compares reopening of file with index cached next to it and scanning it again, in both index modes.
+ * Cache file is removed afterwards.
+ * IN:
+ * @param filename - name of file with text
+ * @param data - mapped text of the same file
+ * @param size - size of text in bytes
+ */
+static void BenchmarkLineIndexCache(char const * filename, char const * data, long long size) {
+    static char const * modeNames[] = { "flat", "packed" };
+    IndexerOptions options = { INDEXER_KERNEL_AUTO, 0, LINE_INDEX_FLAT };
+    LineIndex built, loaded;
+    double startTime, buildTime, saveTime, loadTime;
+    long long cacheSize, modified;
+    char cacheFilename[FILENAME_MAX];
+    int mode;
+
+    if (strlen(filename) + sizeof(LINE_INDEX_FILE_EXTENSION) > sizeof(cacheFilename))
+        return;
+    strcpy(cacheFilename, filename);
+    strcat(cacheFilename, LINE_INDEX_FILE_EXTENSION);
+
+    printf("line index cache\n");
+    printf("%-8s %12s %12s %12s %14s %10s\n", "mode", "build s", "save s", "load s", "cache bytes", "speed-up");
+
+    for (mode = LINE_INDEX_FLAT; mode <= LINE_INDEX_PACKED; ++mode) {
+        options.mode = (LineIndexMode)mode;
+        startTime = GetSeconds();
+        if (BuildLineIndex(&built, data, size, &options) != ERR_NO) {
+            PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+            return;
+        }
+        buildTime = GetSeconds() - startTime;
+
+        startTime = GetSeconds();
+        if (SaveLineIndex(&built, filename, data, NULL, NULL) != ERR_NO) {
+            PrintError(NULL, ERR_WRITE, __FILE__, __LINE__);
+            DestroyLineIndex(&built);
+            return;
+        }
+        saveTime = GetSeconds() - startTime;
+
+        startTime = GetSeconds();
+        if (LoadLineIndex(&loaded, filename, data, NULL, NULL, size, (LineIndexMode)mode) != ERR_NO) {
+            printf("saved index can't be loaded back\n");
+            DestroyLineIndex(&built);
+            remove(cacheFilename);
+            return;
+        }
+        loadTime = GetSeconds() - startTime;
+
+        if (!CompareLineIndexes(&built, &loaded))
+            printf("loaded index differs from built one\n");
+        if (GetFileStamp(cacheFilename, &cacheSize, &modified) != ERR_NO)
+            cacheSize = 0;
+        printf("%-8s %12.6f %12.6f %12.6f %14lld %10.2f\n", modeNames[mode], buildTime, saveTime, loadTime, cacheSize,
+               buildTime / max(loadTime, 1e-9));
+
+        DestroyLineIndex(&loaded);
+        DestroyLineIndex(&built);
+        remove(cacheFilename);
+    }
+}
+
+/**
+ * Measures counting of wrap view rows on resize, building of wrap index
+ * and random seeking of rows, which happens on every scrollbar thumb drag in wrap view mode.
+ * IN:
+ * @param data - text to index
+ * @param size - size of text in bytes
+ */
+static void BenchmarkWrapIndex(char const * data, long long size) {
+    static int const widths[] = { 40, 80, 200 };
+    LineIndex index;
+    WrapIndex wrapIndex = { NULL, 0, 0, 0 };
+    double startTime, buildTime, countTime, seekTime;
+    unsigned int seed = 12345;
+    long long checksum = 0;
+    long long lookupsNumber = 1000000;
+    long long lookup, row, line, position;
+    int width;
+
+    if (BuildLineIndex(&index, data, size, NULL) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+
+    printf("wrap index\n");
+    printf("%-8s %14s %12s %12s %14s\n", "width", "rows", "count us", "build s", "seek ns");
+
+    for (width = 0; width < (int)(sizeof(widths) / sizeof(widths[0])); ++width) {
+        // resize step recounts rows by lengths histogram only
+        startTime = GetSeconds();
+        checksum += CountTotalWrapRows(&index, widths[width]);
+        countTime = GetSeconds() - startTime;
+
+        startTime = GetSeconds();
+        if (BuildWrapIndex(&wrapIndex, &index, widths[width]) != ERR_NO) {
+            PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+            break;
+        }
+        buildTime = GetSeconds() - startTime;
+
+        // row to line and back, as thumb drag does
+        startTime = GetSeconds();
+        for (lookup = 0; lookup < lookupsNumber; ++lookup) {
+            seed = seed * 1103515245u + 12345u;
+            row = (long long)(((unsigned long long)seed * wrapIndex.rowsNumber) >> 32);
+            line = FindWrapRow(&wrapIndex, &index, row, &position);
+            if (GetWrapRow(&wrapIndex, &index, line, position) != row)
+                printf("row %lld is found wrong\n", row);
+            checksum += line;
+        }
+        seekTime = GetSeconds() - startTime;
+
+        printf("%-8i %14lld %12.2f %12.6f %14.2f\n", widths[width], wrapIndex.rowsNumber,
+               countTime * 1e6, buildTime, seekTime * 1e9 / lookupsNumber);
+    }
+    printf("(checksum %lld)\n", checksum);
+
+    DestroyWrapIndex(&wrapIndex);
+    DestroyLineIndex(&index);
+}
+
+/**
+ * Measures reading of screens of lines through block cache, the way file bigger than cache budget is shown:
+ * paging down reads blocks sequentially, jumps read blocks at random positions.
+ * IN:
+ * @param filename - name of file to read
+ * @param data - mapped text of the same file, used to index lines
+ * @param size - size of text in bytes
+ */
+static void BenchmarkBlockCache(char const * filename, char const * data, long long size) {
+    static long long const budgets[] = { 1LL << 20, DEFAULT_CACHE_BUDGET };
+    static char const * const patternNames[] = { "page down", "jumps" };
+    BlockCache cache;
+    BlockCacheStats stats;
+    LineIndex index;
+    double startTime, readTime;
+    unsigned int seed = 12345;
+    long long checksum = 0;
+    long long screensNumber = 100000;
+    long long screen, line, firstLine, beginning, length;
+    char const * text;
+    int budget, pattern;
+
+    if (BuildLineIndex(&index, data, size, NULL) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+
+    printf("block cache (screens of 50 lines by 120 symbols)\n");
+    printf("%-10s %-10s %12s %10s %12s %12s\n", "budget MB", "pattern", "screen us", "hits %", "evictions", "resident MB");
+
+    for (budget = 0; budget < (int)(sizeof(budgets) / sizeof(budgets[0])); ++budget) {
+        for (pattern = 0; pattern < 2; ++pattern) {
+            if (OpenBlockCache(&cache, filename, budgets[budget]) != ERR_NO) {
+                PrintError(NULL, ERR_OPEN_FILE, __FILE__, __LINE__);
+                DestroyLineIndex(&index);
+                return;
+            }
+
+            startTime = GetSeconds();
+            for (screen = 0, firstLine = 0; screen < screensNumber; ++screen) {
+                if (pattern == 0)
+                    firstLine = (firstLine + 50 < index.linesNumber) ? firstLine + 50 : 0;
+                else {
+                    seed = seed * 1103515245u + 12345u;
+                    firstLine = (long long)(((unsigned long long)seed * index.linesNumber) >> 32);
+                }
+                for (line = firstLine; line < firstLine + 50 && line < index.linesNumber; ++line) {
+                    beginning = GetIndexedLineBeginning(&index, line);
+                    length = GetLineContentEnd(&index, line) - beginning;
+                    text = ReadCachedText(&cache, beginning, (length < 120) ? length : 120);
+                    if (text == NULL || (length > 0 && *text != data[beginning]))
+                        printf("line %lld is read wrong\n", line);
+                    checksum += length;
+                }
+            }
+            readTime = GetSeconds() - startTime;
+
+            stats = cache.stats;
+            printf("%-10.0f %-10s %12.2f %10.2f %12lld %12.2f\n", budgets[budget] / 1048576.0, patternNames[pattern],
+                   readTime * 1e6 / screensNumber, 100.0 * stats.hits / max(1, stats.hits + stats.misses),
+                   stats.evictions, stats.residentSize / 1048576.0);
+            CloseBlockCache(&cache);
+        }
+    }
+    printf("(checksum %lld)\n", checksum);
+
+    DestroyLineIndex(&index);
+}
+
+/**
+ * Measures opening of gzip file: the single pass building line index and restart points, then reading screens
+ * at random positions with restart points and from the beginning of text.
+ * IN:
+ * @param data - text to compress
+ * @param size - size of text in bytes
+ */
+static void BenchmarkCompressedFile(char const * data, long long size) {
+    IndexerOptions options = { INDEXER_KERNEL_AUTO, 0, LINE_INDEX_FLAT };
+    CompressedIndex compressed;
+    CompressedReader * reader = NULL;
+    LineIndex index, reference;
+    gzFile file;
+    char screen[50 * 120];
+    double startTime, scanTime, readTime;
+    long long position, portion, offset, checkpointsNumber;
+    unsigned int seed = 7;
+    int reads, pass;
+
+    // fast level keeps compression short, restart points don't depend on it
+    file = gzopen(COMPRESSED_BENCHMARK_FILE, "wb1");
+    if (file == NULL) {
+        PrintError(NULL, ERR_OPEN_FILE, __FILE__, __LINE__);
+        return;
+    }
+    for (position = 0; position < size; position += portion) {
+        portion = min(size - position, 1LL << 30);
+        if (gzwrite(file, data + position, (unsigned int)portion) != (int)portion) {
+            PrintError(NULL, ERR_WRITE, __FILE__, __LINE__);
+            gzclose(file);
+            remove(COMPRESSED_BENCHMARK_FILE);
+            return;
+        }
+    }
+    gzclose(file);
+
+    if (CreateCompressedIndex(&compressed, COMPRESSED_BENCHMARK_FILE) != ERR_NO ||
+        OpenCompressedReader(&reader, COMPRESSED_BENCHMARK_FILE, &compressed) != ERR_NO) {
+        PrintError(NULL, ERR_OPEN_FILE, __FILE__, __LINE__);
+        DestroyCompressedIndex(&compressed);
+        remove(COMPRESSED_BENCHMARK_FILE);
+        return;
+    }
+    startTime = GetSeconds();
+    if (BuildSequentialLineIndex(&index, ScanCompressedText, reader, &options) != ERR_NO) {
+        PrintError(NULL, ERR_READ, __FILE__, __LINE__);
+        CloseCompressedReader(reader);
+        DestroyCompressedIndex(&compressed);
+        remove(COMPRESSED_BENCHMARK_FILE);
+        return;
+    }
+    scanTime = GetSeconds() - startTime;
+    printf("gzip file of %.2f MB: scanned in %.3f seconds (%.3f GB/s of text), %lld restart points take %.2f MB\n",
+           compressed.compressedSize / 1048576.0, scanTime, (double)size / scanTime / 1e9, compressed.checkpointsNumber,
+           GetCompressedIndexMemory(&compressed) / 1048576.0);
+    if (BuildLineIndex(&reference, data, size, &options) == ERR_NO) {
+        if (compressed.size != size || !CompareLineIndexes(&index, &reference))
+            printf("index of decompressed text differs from index of text\n");
+        DestroyLineIndex(&reference);
+    }
+
+    // the second pass reads from text beginning, as if there were no restart points
+    checkpointsNumber = compressed.checkpointsNumber;
+    for (pass = 0; pass < 2; ++pass) {
+        compressed.checkpointsNumber = (pass == 0) ? checkpointsNumber : 1;
+        readTime = 0;
+        for (reads = 0; reads < ((pass == 0) ? 100 : 10); ++reads) {
+            seed = seed * 1103515245u + 12345u;
+            offset = (long long)(((unsigned long long)seed * (unsigned long long)max(size - (long long)sizeof(screen), 0)) >> 32);
+            portion = min(size - offset, (long long)sizeof(screen));
+            startTime = GetSeconds();
+            if (!ReadCompressedText(reader, offset, screen, (size_t)portion) || memcmp(screen, data + offset, portion) != 0)
+                printf("screen at %lld is read wrong\n", offset);
+            readTime += GetSeconds() - startTime;
+        }
+        printf("random screen: %.3f ms %s\n", readTime * 1e3 / reads,
+               (pass == 0) ? "with restart points" : "from text beginning");
+    }
+    compressed.checkpointsNumber = checkpointsNumber;
+
+    CloseCompressedReader(reader);
+    DestroyCompressedIndex(&compressed);
+    DestroyLineIndex(&index);
+    remove(COMPRESSED_BENCHMARK_FILE);
+}
+
+// times of search notifications
+typedef struct {
+    double firstTime;           // time of the first published hits
+    double lastTime;            // time of the latest notification (the final one after search is finished)
+} SearchTiming;
+
+/**
+ * Records time of search notification. Called from search thread.
+ * IN:
+ * @param context - pointer to SearchTiming
+ */
+static void RecordSearchProgress(void * context) {
+    SearchTiming * timing = (SearchTiming*)context;
+
+    if (timing->firstTime == 0)
+        timing->firstTime = GetSeconds();
+    timing->lastTime = GetSeconds();
+}
+
+/**
+ * Measures throughput of literal search with every supported kernel in a single thread and in all threads,
+ * and latency of the first published hits.
+ * IN:
+ * @param data - text to search
+ * @param size - size of text in bytes
+ */
+static void BenchmarkTextSearch(char const * data, long long size) {
+    static char const * patterns[] = { "=", "abc", "0123456789" };
+    IndexerOptions options = { INDEXER_KERNEL_SCALAR, 1, LINE_INDEX_FLAT };
+    volatile SearchTiming timing;
+    TextSearch * search;
+    long long hitsNumber = 0;
+    double bestTime, firstTime = 0, startTime;
+    int maxThreadsNumber = GetHardwareConcurrency();
+    unsigned int pattern;
+    int kernel, threads, repeat;
+
+    printf("text search: %lld bytes, up to %i threads\n", size, maxThreadsNumber);
+    printf("%-12s %-8s %-8s %10s %12s %10s %12s\n", "pattern", "kernel", "threads", "hits", "seconds", "GB/s", "first hits");
+
+    for (pattern = 0; pattern < sizeof(patterns) / sizeof(patterns[0]); ++pattern) {
+        for (kernel = INDEXER_KERNEL_SCALAR; kernel < INDEXER_KERNELS_NUMBER; ++kernel) {
+            if (!IsIndexerKernelSupported((IndexerKernel)kernel) || kernel == INDEXER_KERNEL_AVX512)
+                continue;
+            for (threads = 1; ; threads = maxThreadsNumber) {
+                options.kernel        = (IndexerKernel)kernel;
+                options.threadsNumber = threads;
+                bestTime = 0;
+                for (repeat = 0; repeat < REPEATS_NUMBER; ++repeat) {
+                    timing.firstTime = timing.lastTime = 0;
+                    startTime = GetSeconds();
+                    if (StartTextSearch(&search, data, NULL, NULL, size, patterns[pattern], strlen(patterns[pattern]),
+                                        NULL, &options, RecordSearchProgress, (void*)&timing) != ERR_NO) {
+                        PrintError(NULL, ERR_THREAD, __FILE__, __LINE__);
+                        return;
+                    }
+                    while (!IsTextSearchFinished(search, NULL))
+                        PauseThread();
+                    hitsNumber = GetSearchHitsNumber(search);
+                    DestroyTextSearch(search);
+
+                    if (repeat == 0 || timing.lastTime - startTime < bestTime) {
+                        bestTime  = timing.lastTime - startTime;
+                        firstTime = timing.firstTime - startTime;
+                    }
+                }
+                printf("%-12s %-8s %-8i %10lld %12.6f %10.3f %12.6f\n", patterns[pattern],
+                       GetIndexerKernelName((IndexerKernel)kernel), threads, hitsNumber,
+                       bestTime, (double)size / bestTime / 1e9, firstTime);
+                if (threads == maxThreadsNumber)
+                    break;
+            }
+        }
+    }
+}
+
+/**
+ * Checks that empty lines are found by regex like line index counts them, the last one after line break at
+ * the end of text included. Mismatches are printed.
+ */
+static void CheckEmptyLineSearch(void) {
+    static char const * texts[]        = { "a\n\nb\n", "a\r\n", "a", "\n", "a\rb\r" };
+    static long long const hits[][3]   = { { 2, 5, -1 }, { 3, -1, -1 }, { -1, -1, -1 }, { 0, 1, -1 }, { 4, -1, -1 } };
+    TextSearch * search;
+    long long hit;
+    unsigned int text;
+    BOOL failed = FALSE;
+
+    for (text = 0; text < sizeof(texts) / sizeof(texts[0]); ++text) {
+        if (StartRegexSearch(&search, texts[text], NULL, NULL, (long long)strlen(texts[text]), "^$", 2,
+                             NULL, NULL, NULL, NULL) != ERR_NO) {
+            PrintError(NULL, ERR_THREAD, __FILE__, __LINE__);
+            return;
+        }
+        while (!IsTextSearchFinished(search, NULL))
+            PauseThread();
+        for (hit = 0; hit < 3 && (hits[text][hit] >= 0 || hit < GetSearchHitsNumber(search)); ++hit) {
+            if (hit >= GetSearchHitsNumber(search) || GetSearchHit(search, hit) != hits[text][hit]) {
+                printf("empty line %lld of text %u is found wrong\n", hit, text);
+                failed = TRUE;
+            }
+        }
+        DestroyTextSearch(search);
+    }
+    printf("empty lines search %s\n", failed ? "failed" : "passed");
+}
+
+/**
+ * Measures throughput of regular expression search for patterns with and without required literals
+ * in a single thread and in all threads.
+ * IN:
+ * @param data - text to search
+ * @param size - size of text in bytes
+ */
+static void BenchmarkRegexSearch(char const * data, long long size) {
+    static char const * patterns[] = { "abc", ".*xyz", "key=[0-9]+", "a[0-9]+b", "^[a-z]+ [0-9]", "(foo|bar)=", "[0-9]{3}:[0-9]{2}" };
+    IndexerOptions options = { INDEXER_KERNEL_AUTO, 1, LINE_INDEX_FLAT };
+    TextSearch * search;
+    Regex * regex;
+    char const * literal;
+    size_t literalLength;
+    long long hitsNumber = 0;
+    double bestTime, time;
+    int maxThreadsNumber = GetHardwareConcurrency();
+    unsigned int pattern;
+    int threads, repeat;
+
+    printf("regex search: %lld bytes, up to %i threads\n", size, maxThreadsNumber);
+    printf("%-20s %-8s %-8s %10s %12s %10s\n", "pattern", "literal", "threads", "lines", "seconds", "GB/s");
+
+    for (pattern = 0; pattern < sizeof(patterns) / sizeof(patterns[0]); ++pattern) {
+        if (CompileRegex(&regex, patterns[pattern], strlen(patterns[pattern])) != ERR_NO) {
+            PrintError(NULL, ERR_REGEX, __FILE__, __LINE__);
+            return;
+        }
+        literal = GetRegexLiteral(regex, &literalLength);
+
+        for (threads = 1; ; threads = maxThreadsNumber) {
+            options.threadsNumber = threads;
+            bestTime = 0;
+            for (repeat = 0; repeat < REPEATS_NUMBER; ++repeat) {
+                time = GetSeconds();
+                if (StartRegexSearch(&search, data, NULL, NULL, size, patterns[pattern], strlen(patterns[pattern]),
+                                     NULL, &options, NULL, NULL) != ERR_NO) {
+                    PrintError(NULL, ERR_THREAD, __FILE__, __LINE__);
+                    DestroyRegex(regex);
+                    return;
+                }
+                while (!IsTextSearchFinished(search, NULL))
+                    PauseThread();
+                time = GetSeconds() - time;
+                hitsNumber = GetSearchHitsNumber(search);
+                DestroyTextSearch(search);
+
+                if (repeat == 0 || time < bestTime)
+                    bestTime = time;
+            }
+            printf("%-20s %-8.*s %-8i %10lld %12.6f %10.3f\n", patterns[pattern], (int)literalLength, literal,
+                   threads, hitsNumber, bestTime, (double)size / bestTime / 1e9);
+            if (threads == maxThreadsNumber)
+                break;
+        }
+        DestroyRegex(regex);
+    }
+    CheckEmptyLineSearch();
+}
+
+/**
+ * Measures the best time of search over all threads.
+ * IN:
+ * @param data - text to search
+ * @param size - size of text in bytes
+ * @param pattern - string or regular expression to find
+ * @param regex - TRUE if pattern is regular expression
+ * @param trigrams - trigram index narrowing search (may be NULL)
+ *
+ * OUT:
+ * @param hitsNumber - gets number of found hits
+ * @return time in seconds (-1 if search can't be started)
+ */
+static double MeasureSearch(char const * data, long long size, char const * pattern, BOOL regex,
+                            TrigramIndex const * trigrams, long long * hitsNumber) {
+    TextSearch * search;
+    ErrorType errorType;
+    double bestTime = 0, time;
+    int repeat;
+
+    for (repeat = 0; repeat < REPEATS_NUMBER; ++repeat) {
+        time = GetSeconds();
+        if (regex)
+            errorType = StartRegexSearch(&search, data, NULL, NULL, size, pattern, strlen(pattern), trigrams, NULL, NULL, NULL);
+        else
+            errorType = StartTextSearch(&search, data, NULL, NULL, size, pattern, strlen(pattern), trigrams, NULL, NULL, NULL);
+        if (errorType != ERR_NO)
+            return -1;
+        while (!IsTextSearchFinished(search, NULL))
+            PauseThread();
+        time = GetSeconds() - time;
+        *hitsNumber = GetSearchHitsNumber(search);
+        DestroyTextSearch(search);
+
+        if (repeat == 0 || time < bestTime)
+            bestTime = time;
+    }
+    return bestTime;
+}
+
+/**
+ * Measures building of trigram index, it's size and speed-up of searches narrowed by it.
+ * For file index is also saved next to it and loaded back (saved index is removed afterwards).
+ * IN:
+ * @param filename - name of file with text (NULL for generated corpus)
+ * @param data - text to index
+ * @param size - size of text in bytes
+ */
+static void BenchmarkTrigramIndex(char const * filename, char const * data, long long size) {
+    static char const * patterns[] = { "abc", "0123456789", "error", "key=[0-9]+", "(foo|bar)=",
+                                       "ID-0042-RARE", "ID-1337-SOME", "ERR-TIMEOUT", "ID-[0-9]+-RARE" };
+    static BOOL const regexes[]    = { FALSE, FALSE,        FALSE,   TRUE,         TRUE,
+                                       FALSE,          FALSE,          FALSE,         TRUE };
+    TrigramIndexBuilder * builder;
+    TrigramIndex * trigrams = NULL;
+    TrigramIndex * loaded = NULL;
+    ErrorType errorType = ERR_NO;
+    LineIndex index;
+    Regex * regex = NULL;
+    unsigned int * candidates;
+    char const * literal;
+    size_t literalLength;
+    long long blocksNumber, block, candidatesNumber, hitsNumber, indexedHitsNumber = 0;
+    long long sidecarSize, modified;
+    double time, fullTime, indexedTime;
+    unsigned int pattern;
+    char sidecar[FILENAME_MAX];
+
+    if (BuildLineIndex(&index, data, size, NULL) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+
+    time = GetSeconds();
+    if (StartTrigramIndexBuilder(&builder, data, NULL, NULL, &index, size, NULL, NULL, NULL) != ERR_NO) {
+        PrintError(NULL, ERR_THREAD, __FILE__, __LINE__);
+        DestroyLineIndex(&index);
+        return;
+    }
+    while (!TakeTrigramIndex(builder, &trigrams, &errorType))
+        PauseThread();
+    time = GetSeconds() - time;
+    DestroyTrigramIndexBuilder(builder);
+    DestroyLineIndex(&index);
+    if (trigrams == NULL) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        return;
+    }
+
+    blocksNumber = GetTrigramBlocksNumber(trigrams);
+    printf("trigram index: %lld bytes, %lld blocks\n", size, blocksNumber);
+    printf("build %.6f seconds (%.3f GB/s), %.2f MB in memory\n", time, (double)size / time / 1e9,
+           GetTrigramIndexMemory(trigrams) / 1048576.0);
+
+    if (filename != NULL && strlen(filename) + sizeof(TRIGRAM_FILE_EXTENSION) <= sizeof(sidecar)) {
+        strcpy(sidecar, filename);
+        strcat(sidecar, TRIGRAM_FILE_EXTENSION);
+        time = GetSeconds();
+        errorType = GetFileStamp(filename, &sidecarSize, &modified);
+        if (errorType == ERR_NO)
+            errorType = SaveTrigramIndex(trigrams, filename, modified);
+        fullTime = GetSeconds() - time;
+        time = GetSeconds();
+        if (errorType == ERR_NO)
+            errorType = LoadTrigramIndex(&loaded, filename);
+        time = GetSeconds() - time;
+        if (errorType == ERR_NO && loaded != NULL && GetFileStamp(sidecar, &sidecarSize, &modified) == ERR_NO)
+            printf("save %.6f seconds, load %.6f seconds, %.2f MB on disk\n", fullTime, time, sidecarSize / 1048576.0);
+        else
+            printf("saved index can't be loaded back\n");
+        DestroyTrigramIndex(loaded);
+        remove(sidecar);
+    }
+
+    printf("%-20s %12s %10s %12s %12s %10s\n", "pattern", "candidates %", "hits", "full s", "indexed s", "speed-up");
+    for (pattern = 0; pattern < sizeof(patterns) / sizeof(patterns[0]); ++pattern) {
+        // blocks checked by narrowed search are those containing all trigrams of required literal
+        literal = patterns[pattern];
+        literalLength = strlen(literal);
+        if (regexes[pattern]) {
+            if (CompileRegex(&regex, patterns[pattern], strlen(patterns[pattern])) != ERR_NO) {
+                PrintError(NULL, ERR_REGEX, __FILE__, __LINE__);
+                break;
+            }
+            literal = GetRegexLiteral(regex, &literalLength);
+        }
+        candidates = FindTrigramCandidates(trigrams, literal, literalLength);
+        candidatesNumber = blocksNumber;
+        if (candidates != NULL)
+            for (block = 0, candidatesNumber = 0; block < blocksNumber; ++block)
+                candidatesNumber += (candidates[block >> 5] >> (block & 31)) & 1;
+        free(candidates);
+        DestroyRegex(regex);
+        regex = NULL;
+
+        fullTime    = MeasureSearch(data, size, patterns[pattern], regexes[pattern], NULL, &hitsNumber);
+        indexedTime = MeasureSearch(data, size, patterns[pattern], regexes[pattern], trigrams, &indexedHitsNumber);
+        if (fullTime < 0 || indexedTime < 0) {
+            PrintError(NULL, ERR_THREAD, __FILE__, __LINE__);
+            break;
+        }
+        if (hitsNumber != indexedHitsNumber)
+            printf("%s: %lld hits are found with index instead of %lld\n", patterns[pattern], indexedHitsNumber, hitsNumber);
+        printf("%-20s %12.2f %10lld %12.6f %12.6f %10.2f\n", patterns[pattern],
+               100.0 * candidatesNumber / max(1, blocksNumber), hitsNumber, fullTime, indexedTime,
+               fullTime / max(indexedTime, 1e-9));
+    }
+
+    DestroyTrigramIndex(trigrams);
+}
+
+/**
+ * Measures UTF-8 validation and counting throughput of every supported kernel, building of column index
+ * and speed-up of column lookups in long lines given by checkpoints.
+ * IN:
+ * @param data - text to measure
+ * @param size - size of text in bytes
+ */
+static void BenchmarkColumnIndex(char const * data, long long size) {
+    IndexerOptions options = { INDEXER_KERNEL_AUTO, 0, LINE_INDEX_FLAT };
+    LineIndex index;
+    ColumnIndex columns;
+    long long reference, measured, counted, line, longestLine, lookup, column, offset, checkpoint;
+    long long begin, length, position, multibyteLines = 0;
+    double bestTime, countTime, startTime, elapsed, scanTime;
+    unsigned int seed = 1;
+    int kernel, repeat;
+
+    reference = MeasureColumns(data, size, INDEXER_KERNEL_SCALAR);
+    printf("column index: %lld bytes, %lld characters%s\n", size, reference, (reference < 0) ? " (not valid UTF-8)" : "");
+    printf("%-8s %12s %10s %12s %10s\n", "kernel", "validate s", "GB/s", "count s", "GB/s");
+    for (kernel = INDEXER_KERNEL_SCALAR; kernel < INDEXER_KERNELS_NUMBER; ++kernel) {
+        if (!IsIndexerKernelSupported((IndexerKernel)kernel))
+            continue;
+        bestTime = countTime = 0;
+        measured = counted = 0;
+        for (repeat = 0; repeat < REPEATS_NUMBER; ++repeat) {
+            startTime = GetSeconds();
+            measured = MeasureColumns(data, size, (IndexerKernel)kernel);
+            elapsed = GetSeconds() - startTime;
+            if (repeat == 0 || elapsed < bestTime)
+                bestTime = elapsed;
+
+            startTime = GetSeconds();
+            counted = CountColumns(data, size, (IndexerKernel)kernel);
+            elapsed = GetSeconds() - startTime;
+            if (repeat == 0 || elapsed < countTime)
+                countTime = elapsed;
+        }
+        if (measured != reference || (reference >= 0 && counted != reference))
+            printf("%-8s columns differ from scalar ones\n", GetIndexerKernelName((IndexerKernel)kernel));
+        printf("%-8s %12.6f %10.3f %12.6f %10.3f\n", GetIndexerKernelName((IndexerKernel)kernel),
+               bestTime, (double)size / bestTime / 1e9, countTime, (double)size / countTime / 1e9);
+    }
+
+    if (BuildLineIndex(&index, data, size, &options) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+    startTime = GetSeconds();
+    if (BuildColumnIndex(&columns, &index, data, NULL, NULL, &options) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        DestroyLineIndex(&index);
+        return;
+    }
+    elapsed = GetSeconds() - startTime;
+
+    // the longest multibyte line shows cost of lookups without checkpoints
+    longestLine = -1;
+    for (line = 0; line < index.linesNumber; ++line) {
+        if (IsAsciiLine(&columns, line))
+            continue;
+        multibyteLines++;
+        if (longestLine < 0 || GetLineContentEnd(&columns.lines, line) - GetIndexedLineBeginning(&columns.lines, line) >
+                               GetLineContentEnd(&columns.lines, longestLine) - GetIndexedLineBeginning(&columns.lines, longestLine))
+            longestLine = line;
+    }
+    printf("build %.6f seconds (%.3f GB/s), %.2f MB in memory, %lld multibyte lines, %lld checkpoints, longest %lld columns\n",
+           elapsed, (double)size / elapsed / 1e9, GetColumnIndexMemory(&columns) / 1048576.0, multibyteLines,
+           columns.checkpointsNumber, columns.lines.maxLength);
+
+    if (longestLine >= 0) {
+        begin  = GetIndexedLineBeginning(&index, longestLine);
+        length = GetLineContentEnd(&columns.lines, longestLine) - GetIndexedLineBeginning(&columns.lines, longestLine);
+        scanTime = elapsed = 0;
+        for (lookup = 0; lookup < 1000; ++lookup) {
+            seed = seed * 1103515245u + 12345u;
+            column = (long long)(((unsigned long long)seed << 16) % (unsigned long long)length);
+
+            startTime  = GetSeconds();
+            checkpoint = GetColumnCheckpoint(&columns, longestLine, column, &offset);
+            position   = offset + SkipColumns(data + begin + offset, GetLineContentEnd(&index, longestLine) - begin - offset,
+                                              column - checkpoint, INDEXER_KERNEL_AUTO);
+            elapsed   += GetSeconds() - startTime;
+
+            startTime = GetSeconds();
+            if (SkipColumns(data + begin, GetLineContentEnd(&index, longestLine) - begin, column, INDEXER_KERNEL_AUTO) != position)
+                printf("checkpoint of column %lld gives wrong offset\n", column);
+            scanTime += GetSeconds() - startTime;
+        }
+        printf("column lookup in line of %lld columns: %.3f us with checkpoints, %.3f us from line beginning\n",
+               length, elapsed * 1e3, scanTime * 1e3);
+    }
+
+    DestroyColumnIndex(&columns);
+    DestroyLineIndex(&index);
+}
+
+/**
+ * Measures display widths of all lines with tabs expanded (as if every line were shown) and compares expanding
+ * of window in the longest line from it's checkpoint with expanding from line beginning.
+ * IN:
+ * @param data - text to measure
+ * @param size - size of text in bytes
+ */
+static void BenchmarkTabIndex(char const * data, long long size) {
+    IndexerOptions options = { INDEXER_KERNEL_AUTO, 0, LINE_INDEX_FLAT };
+    LineIndex index;
+    TabIndex tabs;
+    TabLine * tabLine;
+    char const * text;
+    long long line, longestLine, begin, length, lookup, column, offset, checkpoint, expanded, reference;
+    long long tabLines = 0;
+    double startTime, elapsed, scanTime;
+    unsigned int seed = 1;
+    BOOL utf8;
+    size_t scratchSize;
+
+    if (BuildLineIndex(&index, data, size, &options) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+    if (CreateTabIndex(&tabs, DEFAULT_TAB_SIZE) != ERR_NO) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        DestroyLineIndex(&index);
+        return;
+    }
+
+    // lines which aren't valid UTF-8 are measured byte per column as they're shown
+    longestLine = -1;
+    startTime = GetSeconds();
+    for (line = 0; line < index.linesNumber; ++line) {
+        begin   = GetIndexedLineBeginning(&index, line);
+        length  = GetLineContentEnd(&index, line) - begin;
+        tabLine = StartTabLine(&tabs, line);
+        AddTabText(&tabs, tabLine, data + begin, length, 0, MeasureColumns(data + begin, length, INDEXER_KERNEL_AUTO) >= 0);
+        FinishTabLine(&tabs, tabLine);
+        if (tabLine->tabs)
+            tabLines++;
+        if (tabLine->tabs && tabLine->width == tabs.maxWidth)
+            longestLine = line;
+    }
+    elapsed = GetSeconds() - startTime;
+    printf("tab index: measured %lld lines in %.6f seconds (%.3f GB/s), %lld lines with tabs, the widest %lld columns\n",
+           index.linesNumber, elapsed, (double)size / elapsed / 1e9, tabLines, tabs.maxWidth);
+
+    if (longestLine >= 0) {
+        begin   = GetIndexedLineBeginning(&index, longestLine);
+        length  = GetLineContentEnd(&index, longestLine) - begin;
+        utf8    = MeasureColumns(data + begin, length, INDEXER_KERNEL_AUTO) >= 0;
+        tabLine = StartTabLine(&tabs, longestLine);
+        AddTabText(&tabs, tabLine, data + begin, length, 0, utf8);
+        FinishTabLine(&tabs, tabLine);
+
+        // window of 120 columns is expanded like a painted row, scratch buffer isn't reallocated after the first one
+        scanTime = elapsed = 0;
+        scratchSize = 0;
+        for (lookup = 0; lookup < 1000; ++lookup) {
+            seed = seed * 1103515245u + 12345u;
+            column = (long long)(((unsigned long long)seed << 16) % (unsigned long long)tabLine->width);
+
+            startTime  = GetSeconds();
+            checkpoint = GetTabCheckpoint(tabLine, column, &offset);
+            text = ExpandTabs(&tabs, data + begin + offset, min(length - offset, (column + 120 - checkpoint) * 4), checkpoint,
+                              column, 120, utf8, &expanded);
+            elapsed += GetSeconds() - startTime;
+            if (lookup == 1)
+                scratchSize = tabs.scratchSize;
+
+            startTime = GetSeconds();
+            text = ExpandTabs(&tabs, data + begin, length, 0, column, 120, utf8, &reference);
+            scanTime += GetSeconds() - startTime;
+            if (reference != expanded)
+                printf("checkpoint of column %lld gives wrong text\n", column);
+        }
+        (void)text;
+        printf("expanding window of line of %lld columns: %.3f us with checkpoints, %.3f us from line beginning%s\n",
+               tabLine->width, elapsed * 1e3, scanTime * 1e3, (tabs.scratchSize != scratchSize) ? " (scratch regrown)" : "");
+    }
+
+    DestroyTabIndex(&tabs);
+    DestroyLineIndex(&index);
+}
+
+/**
+ * Runs benchmarks on file passed as a command line argument or on generated corpus.
+ * Usage: Benchmark [file]
+ */
+int main(int argc, char * argv[]) {
+    FileMapping mapping;
+    char * corpus = NULL;
+    ErrorType errorType;
+
+    if (argc > 1) {
+        errorType = MapFile(&mapping, argv[1]);
+        if (errorType != ERR_NO) {
+            PrintError(NULL, errorType, __FILE__, __LINE__);
+            return errorType;
+        }
+        BenchmarkIndexerKernels(mapping.view, mapping.size);
+        BenchmarkIndexerThreads(mapping.view, mapping.size);
+        BenchmarkLineIndexModes(mapping.view, mapping.size);
+        BenchmarkLineIndexCache(argv[1], mapping.view, mapping.size);
+        BenchmarkWrapIndex(mapping.view, mapping.size);
+        BenchmarkBlockCache(argv[1], mapping.view, mapping.size);
+        BenchmarkCompressedFile(mapping.view, mapping.size);
+        BenchmarkTextSearch(mapping.view, mapping.size);
+        BenchmarkRegexSearch(mapping.view, mapping.size);
+        BenchmarkTrigramIndex(argv[1], mapping.view, mapping.size);
+        BenchmarkColumnIndex(mapping.view, mapping.size);
+        BenchmarkTabIndex(mapping.view, mapping.size);
+        UnmapFile(&mapping);
+        return ERR_NO;
+    }
+
+    corpus = (char*)malloc(DEFAULT_CORPUS_SIZE);
+    if (corpus == NULL) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return ERR_NOMEM;
+    }
+    GenerateCorpus(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkIndexerKernels(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkIndexerThreads(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkLineIndexModes(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkWrapIndex(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkCompressedFile(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkTextSearch(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkRegexSearch(corpus, DEFAULT_CORPUS_SIZE);
+    PlantRareTokens(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkTrigramIndex(NULL, corpus, DEFAULT_CORPUS_SIZE);
+    GenerateUtf8Corpus(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkColumnIndex(corpus, DEFAULT_CORPUS_SIZE);
+    GenerateTabCorpus(corpus, DEFAULT_CORPUS_SIZE);
+    BenchmarkTabIndex(corpus, DEFAULT_CORPUS_SIZE);
+    free(corpus);
+
+    return ERR_NO;
+}
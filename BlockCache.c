@@ -0,0 +1,375 @@
+// 64-bit file offsets on 32-bit POSIX systems
+#define _FILE_OFFSET_BITS 64
+
+#include "BlockCache.h"
+#include "FileMapping.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+struct tag_CacheSlot {
+    long long block;            // number of block kept in slot (-1 if slot is empty)
+    char * data;                // memory for block data (NULL until slot is used)
+    int newer;                  // neighbour slot used later (-1 for the newest one)
+    int older;                  // neighbour slot used earlier (-1 for the oldest one)
+    int next;                   // next slot in hash chain (-1 for the last one)
+};
+
+/**
+ * Reads block of cached file.
+ * IN:
+ * @param source - file stream
+ * @param offset - index of the first byte to read
+ * @param size - number of bytes to read
+ *
+ * OUT:
+ * @param buffer - gets read bytes
+ * @return TRUE if successed, FALSE else
+ */
+static BOOL ReadBlockFile(void * source, long long offset, char * buffer, size_t size) {
+    return ReadFileRange((FILE*)source, offset, buffer, size) == 0;
+}
+
+/**
+ * Allocates slots of opened cache.
+ * IN:
+ * @param cache - pointer to cache with source of text
+ * @param budget - memory blocks may take in bytes (at least one block is kept anyway)
+ *
+ * OUT:
+ * cache gets empty slots and hash table
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL AllocateSlots(BlockCache * cache, long long budget) {
+    long long blocksNumber;
+    int bucketsNumber;
+    int i;
+
+    // memory for blocks is allocated when they're read, so growing file may use the whole budget
+    blocksNumber = budget / CACHE_BLOCK_SIZE;
+    if (blocksNumber > INT_MAX / 4)
+        blocksNumber = INT_MAX / 4;
+    cache->slotsNumber = (blocksNumber > 1) ? (int)blocksNumber : 1;
+
+    // hash table is kept at most half full
+    for (bucketsNumber = 1; bucketsNumber < cache->slotsNumber * 2; bucketsNumber *= 2)
+        ;
+    cache->bucketsMask = bucketsNumber - 1;
+    cache->slots   = (CacheSlot*)calloc(cache->slotsNumber, sizeof(CacheSlot));
+    cache->buckets = (int*)malloc(bucketsNumber * sizeof(int));
+    if (cache->slots == NULL || cache->buckets == NULL)
+        return FALSE;
+    for (i = 0; i < bucketsNumber; ++i)
+        cache->buckets[i] = -1;
+    return TRUE;
+}
+
+/**
+ * Opens file to read it by blocks kept within memory budget.
+ * IN:
+ * @param cache - pointer to cache structure to initialize
+ * @param filename - name of file to read
+ * @param budget - memory blocks may take in bytes (at least one block is kept anyway)
+ *
+ * OUT:
+ * cache gets opened file with no blocks read
+ * @return code of error occured during opening (ERR_NO if successed)
+ */
+ErrorType OpenBlockCache(BlockCache * cache, char const * filename, long long budget) {
+    if (cache == NULL)
+        return ERR_NULL_PTR;
+    memset(cache, 0, sizeof(BlockCache));
+    cache->newest = cache->oldest = -1;
+
+    cache->file = (filename != NULL) ? fopen(filename, "rb") : NULL;
+    if (cache->file == NULL)
+        return ERR_OPEN_FILE;
+    cache->read   = ReadBlockFile;
+    cache->source = cache->file;
+    if (SeekFile(cache->file, 0, SEEK_END) != 0 || (cache->fileSize = TellFile(cache->file)) < 0) {
+        CloseBlockCache(cache);
+        return ERR_READ;
+    }
+
+    if (!AllocateSlots(cache, budget)) {
+        CloseBlockCache(cache);
+        return ERR_NOMEM;
+    }
+    return ERR_NO;
+}
+
+/**
+ * Opens text of known size which is read by function (e.g. decompressed) to read it by blocks kept within memory budget.
+ * Source of text isn't closed with cache.
+ * IN:
+ * @param cache - pointer to cache structure to initialize
+ * @param read - function reading ranges of text
+ * @param source - source of text passed to read
+ * @param size - size of text in bytes
+ * @param budget - memory blocks may take in bytes (at least one block is kept anyway)
+ *
+ * OUT:
+ * cache gets text source with no blocks read
+ * @return code of error occured during opening (ERR_NO if successed)
+ */
+ErrorType OpenReaderCache(BlockCache * cache, TextReader read, void * source, long long size, long long budget) {
+    if (cache == NULL || read == NULL)
+        return ERR_NULL_PTR;
+    memset(cache, 0, sizeof(BlockCache));
+    cache->newest   = cache->oldest = -1;
+    cache->read     = read;
+    cache->source   = source;
+    cache->fileSize = size;
+
+    if (!AllocateSlots(cache, budget)) {
+        CloseBlockCache(cache);
+        return ERR_NOMEM;
+    }
+    return ERR_NO;
+}
+
+/**
+ * Closes file and frees memory of cached blocks (source of text opened with OpenReaderCache stays open).
+ * IN:
+ * @param cache - pointer to cache (may be partially initialized by OpenBlockCache)
+ *
+ * OUT:
+ * cache fields set as zero
+ */
+void CloseBlockCache(BlockCache * cache) {
+    int i;
+
+    if (cache == NULL)
+        return;
+    if (cache->file != NULL)
+        fclose(cache->file);
+    for (i = 0; cache->slots != NULL && i < cache->slotsUsed; ++i)
+        free(cache->slots[i].data);
+    free(cache->slots);
+    free(cache->buckets);
+    free(cache->scratch);
+    memset(cache, 0, sizeof(BlockCache));
+}
+
+/**
+ * Removes slot from list of slots ordered by the time of use.
+ * IN:
+ * @param cache - pointer to cache
+ * @param slot - number of slot in the list
+ */
+static void UnlinkSlot(BlockCache * cache, int slot) {
+    CacheSlot * item = &cache->slots[slot];
+
+    if (item->newer >= 0)
+        cache->slots[item->newer].older = item->older;
+    else
+        cache->newest = item->older;
+    if (item->older >= 0)
+        cache->slots[item->older].newer = item->newer;
+    else
+        cache->oldest = item->newer;
+}
+
+/**
+ * Puts slot into list of slots ordered by the time of use.
+ * IN:
+ * @param cache - pointer to cache
+ * @param slot - number of slot out of the list
+ * @param newest - non-zero to put slot as the most recently used one, 0 to put it as the first to reuse
+ */
+static void LinkSlot(BlockCache * cache, int slot, int newest) {
+    CacheSlot * item = &cache->slots[slot];
+
+    if (newest) {
+        item->newer = -1;
+        item->older = cache->newest;
+        if (cache->newest >= 0)
+            cache->slots[cache->newest].newer = slot;
+        else
+            cache->oldest = slot;
+        cache->newest = slot;
+    }
+    else {
+        item->older = -1;
+        item->newer = cache->oldest;
+        if (cache->oldest >= 0)
+            cache->slots[cache->oldest].older = slot;
+        else
+            cache->newest = slot;
+        cache->oldest = slot;
+    }
+}
+
+/**
+ * Removes slot from hash chain of it's block.
+ * IN:
+ * @param cache - pointer to cache
+ * @param slot - number of slot keeping a block
+ */
+static void UnhashSlot(BlockCache * cache, int slot) {
+    int * link = &cache->buckets[cache->slots[slot].block & cache->bucketsMask];
+
+    while (*link != slot)
+        link = &cache->slots[*link].next;
+    *link = cache->slots[slot].next;
+}
+
+/**
+ * Gives slot which keeps block, reads block from file if it isn't cached.
+ * The least recently used block is dropped if all slots are taken.
+ * IN:
+ * @param cache - pointer to cache
+ * @param block - number of block
+ *
+ * OUT:
+ * @return pointer to slot of block (NULL if block can't be read)
+ */
+static CacheSlot * GetBlock(BlockCache * cache, long long block) {
+    int * bucket = &cache->buckets[block & cache->bucketsMask];
+    long long offset = block * CACHE_BLOCK_SIZE;
+    size_t size;
+    int slot;
+
+    for (slot = *bucket; slot >= 0; slot = cache->slots[slot].next) {
+        if (cache->slots[slot].block == block) {
+            cache->stats.hits++;
+            UnlinkSlot(cache, slot);
+            LinkSlot(cache, slot, 1);
+            return &cache->slots[slot];
+        }
+    }
+
+    // take a new slot while budget allows, else reuse the least recently used one
+    cache->stats.misses++;
+    if (cache->slotsUsed < cache->slotsNumber &&
+        (cache->slots[cache->slotsUsed].data = (char*)malloc(CACHE_BLOCK_SIZE)) != NULL) {
+        slot = cache->slotsUsed++;
+        cache->stats.residentSize += CACHE_BLOCK_SIZE;
+    }
+    else if (cache->oldest >= 0) {
+        slot = cache->oldest;
+        UnlinkSlot(cache, slot);
+        if (cache->slots[slot].block >= 0) {
+            UnhashSlot(cache, slot);
+            cache->stats.evictions++;
+        }
+    }
+    else
+        return NULL;    // there's not enough memory even for one block
+
+    size = (size_t)((cache->fileSize - offset < CACHE_BLOCK_SIZE) ? cache->fileSize - offset : CACHE_BLOCK_SIZE);
+    if (!cache->read(cache->source, offset, cache->slots[slot].data, size)) {
+        cache->slots[slot].block = -1;
+        LinkSlot(cache, slot, 0);
+        return NULL;
+    }
+    TRACE_COUNTER("bytes read", size);
+
+    cache->slots[slot].block = block;
+    cache->slots[slot].next  = *bucket;
+    *bucket = slot;
+    LinkSlot(cache, slot, 1);
+    return &cache->slots[slot];
+}
+
+/**
+ * Gives text of file range. Text of a single block is returned in place,
+ * text spanning several blocks is copied into scratch buffer.
+ * Returned text stays valid until the next call only.
+ * IN:
+ * @param cache - pointer to cache
+ * @param offset - position of the first byte of range in file
+ * @param length - number of bytes in range
+ *
+ * OUT:
+ * @return pointer to text of range (NULL if range is out of file or it can't be read)
+ */
+char const * ReadCachedText(BlockCache * cache, long long offset, long long length) {
+    CacheSlot * slot;
+    long long block = offset / CACHE_BLOCK_SIZE;
+    long long position, portion;
+    char * scratch;
+
+    if (offset < 0 || length < 0 || offset + length > cache->fileSize)
+        return NULL;
+    if (length == 0)
+        return "";
+
+    // the most common case: range lies in one block
+    if ((offset + length - 1) / CACHE_BLOCK_SIZE == block) {
+        slot = GetBlock(cache, block);
+        return (slot != NULL) ? slot->data + offset % CACHE_BLOCK_SIZE : NULL;
+    }
+
+    if ((size_t)length > cache->scratchSize) {
+        scratch = (char*)realloc(cache->scratch, (size_t)length);
+        if (scratch == NULL)
+            return NULL;
+        cache->scratch     = scratch;
+        cache->scratchSize = (size_t)length;
+    }
+    for (position = 0; position < length; position += portion) {
+        slot = GetBlock(cache, (offset + position) / CACHE_BLOCK_SIZE);
+        if (slot == NULL)
+            return NULL;
+        portion = CACHE_BLOCK_SIZE - (offset + position) % CACHE_BLOCK_SIZE;
+        if (portion > length - position)
+            portion = length - position;
+        memcpy(cache->scratch + position, slot->data + (offset + position) % CACHE_BLOCK_SIZE, (size_t)portion);
+    }
+    return cache->scratch;
+}
+
+/**
+ * Updates size of file which has grown since cache has been opened.
+ * Cached block at the end of file is dropped, since it may have got new bytes.
+ * IN:
+ * @param cache - pointer to cache
+ *
+ * OUT:
+ * cache->fileSize gets new size of file (size of truncated file and size of text of other source aren't changed)
+ * @return code of error occured during checking size (ERR_NO if successed)
+ */
+ErrorType RefreshBlockCache(BlockCache * cache) {
+    long long size;
+    long long block = cache->fileSize / CACHE_BLOCK_SIZE;
+    int slot;
+
+    if (cache->file == NULL)
+        return ERR_NO;
+    if (SeekFile(cache->file, 0, SEEK_END) != 0 || (size = TellFile(cache->file)) < 0)
+        return ERR_READ;
+    if (size <= cache->fileSize)
+        return ERR_NO;
+
+    for (slot = cache->buckets[block & cache->bucketsMask]; slot >= 0; slot = cache->slots[slot].next) {
+        if (cache->slots[slot].block == block) {
+            UnhashSlot(cache, slot);
+            cache->slots[slot].block = -1;
+            UnlinkSlot(cache, slot);
+            LinkSlot(cache, slot, 0);
+            break;
+        }
+    }
+    cache->fileSize = size;
+    return ERR_NO;
+}
+
+/**
+ * Reads range of text right from source of cache, cached blocks aren't used or changed (see TextReader).
+ * Range may be bigger than cache budget, e.g. when the whole text is scanned.
+ * IN:
+ * @param source - pointer to BlockCache
+ * @param offset - index of the first byte to read
+ * @param size - number of bytes to read
+ *
+ * OUT:
+ * @param buffer - gets read bytes
+ * @return TRUE if successed, FALSE else
+ */
+BOOL ReadUncachedText(void * source, long long offset, char * buffer, size_t size) {
+    BlockCache const * cache = (BlockCache const*)source;
+
+    return cache->read(cache->source, offset, buffer, size);
+}
@@ -0,0 +1,48 @@
+#ifndef BLOCKCACHE_H_INCLUDED
+#define BLOCKCACHE_H_INCLUDED
+
+#include <stdio.h>
+#include <stddef.h>
+#include "Error.h"
+#include "LineIndexer.h"
+
+#define CACHE_BLOCK_SIZE (64 * 1024)            // size of blocks file is read by
+#define DEFAULT_CACHE_BUDGET (64LL << 20)       // memory blocks may take unless other budget is set
+
+typedef struct tag_CacheSlot CacheSlot;
+
+// counters of cache efficiency
+typedef struct {
+    long long hits;             // Number of block requests served from memory
+    long long misses;           // Number of blocks read from file
+    long long evictions;        // Number of blocks dropped to make room for other ones
+    long long residentSize;     // Size of memory allocated for blocks in bytes
+} BlockCacheStats;
+
+/* file (or other text source) read by blocks of CACHE_BLOCK_SIZE bytes, when budget is exhausted
+ * the least recently used block is dropped to read a new one */
+typedef struct {
+    FILE * file;                // Cached file (NULL if text is read from other source)
+    TextReader read;            // Function reading blocks of text
+    void * source;              // Source of text passed to read (file if it's cached)
+    long long fileSize;         // Size of file in bytes
+    CacheSlot * slots;          // Array of [slotsNumber] slots for blocks
+    int slotsNumber;            // Number of blocks fitting into budget
+    int slotsUsed;              // Number of slots which have got memory for block
+    int * buckets;              // Hash table of [bucketsMask + 1] first slots of chains (-1 if chain is empty)
+    int bucketsMask;            // Mask of block number giving it's bucket
+    int newest;                 // The most recently used slot (-1 if cache is empty)
+    int oldest;                 // The least recently used slot, it's reused first
+    char * scratch;             // Buffer where text spanning several blocks is put together
+    size_t scratchSize;         // Size of scratch buffer
+    BlockCacheStats stats;      // Counters of cache efficiency
+} BlockCache;
+
+ErrorType OpenBlockCache(BlockCache * cache, char const * filename, long long budget);
+ErrorType OpenReaderCache(BlockCache * cache, TextReader read, void * source, long long size, long long budget);
+void CloseBlockCache(BlockCache * cache);
+ErrorType RefreshBlockCache(BlockCache * cache);
+char const * ReadCachedText(BlockCache * cache, long long offset, long long length);
+BOOL ReadUncachedText(void * source, long long offset, char * buffer, size_t size);
+
+#endif // BLOCKCACHE_H_INCLUDED
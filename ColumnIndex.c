@@ -0,0 +1,1097 @@
+#include "ColumnIndex.h"
+#include "Thread.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define COLUMN_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    #define COLUMN_NEON
+    #include <arm_neon.h>
+#endif
+
+// vector kernels are compiled for their instruction sets regardless of compiler flags
+// and are called only if CPU supports them (see IsIndexerKernelSupported)
+#ifdef __GNUC__
+    #define COLUMN_TARGET(features) __attribute__((target(features)))
+    #define COLUMN_INLINE static inline __attribute__((always_inline))
+#else
+    #define COLUMN_TARGET(features)
+    #define COLUMN_INLINE static __forceinline
+#endif
+
+#define MAX_COLUMN_SEGMENT_SIZE (64LL << 20)        // lines kept in memory are measured by segments of about this size
+#define MAX_STREAM_COLUMN_SEGMENT_SIZE (8LL << 20)  // limit of segments read into buffer
+#define MIN_COLUMN_CHUNK_SIZE (1LL << 20)           // smaller chunks aren't worth a thread
+#define MAX_COLUMN_TASKS 64                         // the biggest number of chunks segment is splitted into
+#define INITIAL_CHECKPOINTS_CAPACITY 256
+
+// function giving number of code points of valid UTF-8 text (-1 if text isn't valid)
+typedef long long (*ColumnKernel)(unsigned char const * text, long long size);
+
+// lines of segment measured by one thread
+typedef struct {
+    unsigned char const * text; // text of segment
+    long long base;             // index of text byte text begins with
+    LineIndex const * index;    // index of lines in bytes
+    long long firstLine;        // the first line of chunk
+    long long endLine;          // the line after the last one of chunk
+    long long * lengths;        // gets numbers of columns of lines contents by numbers of lines (-1 if line isn't valid UTF-8)
+    ColumnKernel kernel;        // function to measure lines with
+} ColumnTask;
+
+/**
+ * Counts trailing zero bits of non-zero mask.
+ * IN:
+ * @param mask - mask to process (mustn't be 0)
+ *
+ * OUT:
+ * @return index of the lowest set bit
+ */
+COLUMN_INLINE int CountTrailingZeros(unsigned long long mask) {
+#ifdef __GNUC__
+    return __builtin_ctzll(mask);
+#else
+    unsigned long bit;
+    if (_BitScanForward(&bit, (unsigned long)mask))
+        return (int)bit;
+    _BitScanForward(&bit, (unsigned long)(mask >> 32));
+    return (int)bit + 32;
+#endif
+}
+
+/**
+ * Counts set bits of mask.
+ * IN:
+ * @param mask - mask to process
+ *
+ * OUT:
+ * @return number of set bits
+ */
+COLUMN_INLINE int CountBits(unsigned int mask) {
+#ifdef __GNUC__
+    return __builtin_popcount(mask);
+#else
+    // POPCNT instruction may be missing on CPUs with SSE2 only
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    return (int)((((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#endif
+}
+
+/**
+ * Gives length of UTF-8 sequence if it's valid. Overlong forms, surrogates
+ * and code points above U+10FFFF are not valid.
+ * IN:
+ * @param text - the first byte of sequence
+ * @param size - number of bytes available from text
+ *
+ * OUT:
+ * @return number of bytes of sequence (0 if it isn't valid)
+ */
+COLUMN_INLINE int GetSequenceLength(unsigned char const * text, long long size) {
+    unsigned char low = 0x80;   // range of the second byte
+    unsigned char high = 0xBF;
+    int length, i;
+
+    if (text[0] < 0x80)
+        return 1;
+    if (text[0] < 0xC2)
+        return 0;   // continuation byte or overlong form of ASCII symbol
+    if (text[0] < 0xE0)
+        length = 2;
+    else if (text[0] < 0xF0) {
+        length = 3;
+        if (text[0] == 0xE0)
+            low = 0xA0;
+        else if (text[0] == 0xED)
+            high = 0x9F;
+    }
+    else if (text[0] < 0xF5) {
+        length = 4;
+        if (text[0] == 0xF0)
+            low = 0x90;
+        else if (text[0] == 0xF4)
+            high = 0x8F;
+    }
+    else
+        return 0;
+
+    if (size < length || text[1] < low || text[1] > high)
+        return 0;
+    for (i = 2; i < length; ++i) {
+        if ((text[i] & 0xC0) != 0x80)
+            return 0;
+    }
+    return length;
+}
+
+/**
+ * Validates and counts characters starting in range of text (the last one may end after it).
+ * IN:
+ * @param text - text to measure
+ * @param size - size of text
+ * @param position - beginning of range (it has to be beginning of character)
+ * @param end - end of range
+ *
+ * INOUT:
+ * @param columns - number of characters measured before, gets characters of range added
+ *
+ * OUT:
+ * @return position after the last measured character (-1 if text isn't valid UTF-8)
+ */
+COLUMN_INLINE long long MeasureRange(unsigned char const * text, long long size, long long position, long long end,
+                                     long long * columns) {
+    int length;
+
+    while (position < end) {
+        length = GetSequenceLength(text + position, size - position);
+        if (length == 0)
+            return -1;
+        position += length;
+        ++*columns;
+    }
+    return position;
+}
+
+static long long MeasureScalar(unsigned char const * text, long long size) {
+    long long columns = 0;
+
+    return (MeasureRange(text, size, 0, size, &columns) < 0) ? -1 : columns;
+}
+
+#ifdef COLUMN_X86
+/* SSE2 has no byte shuffles for table lookups: blocks of ASCII symbols are skipped with vectors,
+ * the first multibyte character of block and the following ones are checked by scalar code */
+COLUMN_TARGET("sse2")
+static long long MeasureSse2(unsigned char const * text, long long size) {
+    long long columns = 0;
+    long long position = 0;
+    unsigned int mask;
+
+    while (position + 16 <= size) {
+        mask = (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((__m128i const *)(text + position)));
+        if (mask == 0) {
+            columns  += 16;
+            position += 16;
+            continue;
+        }
+        columns += CountTrailingZeros(mask);
+        position = MeasureRange(text, size, position + CountTrailingZeros(mask), position + 16, &columns);
+        if (position < 0)
+            return -1;
+    }
+    return (MeasureRange(text, size, position, size, &columns) < 0) ? -1 : columns;
+}
+
+/* AVX2 kernel validates 32 bytes at once with lookup tables of "Validating UTF-8 In Less Than One Instruction
+ * Per Byte" (J. Keiser, D. Lemire): the high and low nibbles of the first byte of each pair of adjacent bytes
+ * and the high nibble of the second one give sets of errors the pair may be a part of, their intersection
+ * is the error pair really has. Characters are counted as bytes which aren't continuation ones. */
+#define UTF8_TOO_SHORT      0x01    // lead byte followed by non-continuation byte
+#define UTF8_TOO_LONG       0x02    // ASCII byte followed by continuation byte
+#define UTF8_OVERLONG_3     0x04    // 11100000 100xxxxx
+#define UTF8_TOO_LARGE      0x08    // 11110100 1001xxxx, 11110100 101xxxxx or 11110101 and greater leads
+#define UTF8_SURROGATE      0x10    // 11101101 101xxxxx
+#define UTF8_OVERLONG_2     0x20    // 1100000x 10xxxxxx
+#define UTF8_TOO_LARGE_1000 0x40    // leads greater than 11110100 followed by 1000xxxx
+#define UTF8_OVERLONG_4     0x40    // 11110000 1000xxxx
+#define UTF8_TWO_CONTS      0x80    // continuation byte followed by continuation byte
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)   // errors which don't depend on low nibble
+
+static unsigned char const firstHighErrors[16] = {
+    // 0xxxxxxx: ASCII byte
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    // 10xxxxxx: continuation byte
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    // 1100xxxx, 1101xxxx: lead of two bytes
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    // 1110xxxx: lead of three bytes
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    // 1111xxxx: lead of four bytes
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+static unsigned char const firstLowErrors[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,   // xxxx0000
+    UTF8_CARRY | UTF8_OVERLONG_2,                                       // xxxx0001
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,                                        // xxxx0100
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE, // xxxx1101
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+
+static unsigned char const secondHighErrors[16] = {
+    // 0xxxxxxx: ASCII byte
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    // 1000xxxx, 1001xxxx, 101xxxxx: continuation byte
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    // 11xxxxxx: lead byte
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+// block is incomplete if one of it's last three bytes starts sequence longer than the rest of block
+static unsigned char const incompleteLimits[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+
+COLUMN_TARGET("avx2,popcnt")
+static long long MeasureAvx2(unsigned char const * text, long long size) {
+    __m256i const firstHigh  = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const *)firstHighErrors));
+    __m256i const firstLow   = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const *)firstLowErrors));
+    __m256i const secondHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const *)secondHighErrors));
+    __m256i const limits     = _mm256_loadu_si256((__m256i const *)incompleteLimits);
+    __m256i const nibble     = _mm256_set1_epi8(0x0F);
+    __m256i const leads      = _mm256_set1_epi8(-65);   // bytes greater than continuation ones as signed
+    __m256i previous   = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    __m256i errors     = _mm256_setzero_si256();
+    __m256i block, shifted, previous1, previous2, previous3, special, required;
+    unsigned char tail[32];
+    long long columns = 0;
+    long long position;
+    BOOL last = FALSE;
+
+    for (position = 0; !last; position += 32) {
+        // the last block is padded with zeros, so sequence cut by the end of text is followed by ASCII byte
+        if (position + 32 <= size)
+            block = _mm256_loadu_si256((__m256i const *)(text + position));
+        else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, text + position, (size_t)(size - position));
+            block = _mm256_loadu_si256((__m256i const *)tail);
+            columns -= 32 - (size - position);
+            last = TRUE;
+        }
+        columns += CountBits((unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(block, leads)));
+
+        if (_mm256_movemask_epi8(block) == 0) {
+            // ASCII block is valid unless it interrupts sequence started in previous block
+            errors = _mm256_or_si256(errors, incomplete);
+            incomplete = _mm256_setzero_si256();
+        }
+        else {
+            shifted   = _mm256_permute2x128_si256(previous, block, 0x21);
+            previous1 = _mm256_alignr_epi8(block, shifted, 15);
+            previous2 = _mm256_alignr_epi8(block, shifted, 14);
+            previous3 = _mm256_alignr_epi8(block, shifted, 13);
+            special = _mm256_and_si256(
+                          _mm256_and_si256(
+                              _mm256_shuffle_epi8(firstHigh, _mm256_and_si256(_mm256_srli_epi16(previous1, 4), nibble)),
+                              _mm256_shuffle_epi8(firstLow, _mm256_and_si256(previous1, nibble))),
+                          _mm256_shuffle_epi8(secondHigh, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble)));
+            // the third and the fourth bytes of sequences have to be continuation ones (their pairs have TWO_CONTS)
+            required = _mm256_or_si256(_mm256_subs_epu8(previous2, _mm256_set1_epi8((char)(0xE0 - 0x80))),
+                                       _mm256_subs_epu8(previous3, _mm256_set1_epi8((char)(0xF0 - 0x80))));
+            required = _mm256_and_si256(required, _mm256_set1_epi8((char)0x80));
+            errors = _mm256_or_si256(errors, _mm256_xor_si256(required, special));
+            incomplete = _mm256_subs_epu8(block, limits);
+        }
+        previous = block;
+    }
+    return _mm256_testz_si256(errors, errors) ? columns : -1;
+}
+#endif // COLUMN_X86
+
+#ifdef COLUMN_NEON
+static long long MeasureNeon(unsigned char const * text, long long size) {
+    uint8x16_t const high = vdupq_n_u8(0x80);
+    long long columns = 0;
+    long long position = 0;
+    unsigned long long mask;
+
+    while (position + 16 <= size) {
+        // narrow flags of non-ASCII bytes to 4 bits per byte since NEON has no movemask
+        mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(
+                   vtstq_u8(vld1q_u8(text + position), high)), 4)), 0);
+        if (mask == 0) {
+            columns  += 16;
+            position += 16;
+            continue;
+        }
+        columns += CountTrailingZeros(mask) >> 2;
+        position = MeasureRange(text, size, position + (CountTrailingZeros(mask) >> 2), position + 16, &columns);
+        if (position < 0)
+            return -1;
+    }
+    return (MeasureRange(text, size, position, size, &columns) < 0) ? -1 : columns;
+}
+#endif // COLUMN_NEON
+
+/**
+ * Gives measuring function of kernel chosen for indexing (AVX-512 CPUs use AVX2 kernel).
+ * IN:
+ * @param kernel - supported kernel
+ *
+ * OUT:
+ * @return pointer to measuring function
+ */
+static ColumnKernel GetColumnKernel(IndexerKernel kernel) {
+    switch (kernel) {
+#ifdef COLUMN_X86
+    case INDEXER_KERNEL_SSE2:
+        return MeasureSse2;
+    case INDEXER_KERNEL_AVX2:
+    case INDEXER_KERNEL_AVX512:
+        return MeasureAvx2;
+#endif
+#ifdef COLUMN_NEON
+    case INDEXER_KERNEL_NEON:
+        return MeasureNeon;
+#endif
+    default:
+        return MeasureScalar;
+    }
+}
+
+/**
+ * Replaces kernel which can't be used with the best one supported by CPU.
+ * IN:
+ * @param kernel - asked kernel
+ *
+ * OUT:
+ * @return supported kernel
+ */
+static IndexerKernel ResolveKernel(IndexerKernel kernel) {
+    if (kernel == INDEXER_KERNEL_AUTO || !IsIndexerKernelSupported(kernel))
+        return DetectIndexerKernel();
+    return kernel;
+}
+
+/**
+ * Validates UTF-8 text and counts it's characters.
+ * IN:
+ * @param text - text to measure
+ * @param size - size of text in bytes
+ * @param kernel - kernel to measure text with (unsupported kernels are replaced with the detected one)
+ *
+ * OUT:
+ * @return number of code points (-1 if text isn't valid UTF-8)
+ */
+long long MeasureColumns(char const * text, long long size, IndexerKernel kernel) {
+    return GetColumnKernel(ResolveKernel(kernel))((unsigned char const *)text, size);
+}
+
+static long long CountScalar(unsigned char const * text, long long size) {
+    long long columns = 0;
+    long long position;
+
+    for (position = 0; position < size; ++position)
+        columns += ((text[position] & 0xC0) != 0x80);
+    return columns;
+}
+
+static long long SkipScalar(unsigned char const * text, long long size, long long columns) {
+    long long position;
+
+    for (position = 0; position < size; ++position) {
+        if ((text[position] & 0xC0) != 0x80 && columns-- == 0)
+            return position;
+    }
+    return size;
+}
+
+#ifdef COLUMN_X86
+COLUMN_TARGET("sse2")
+static long long CountSse2(unsigned char const * text, long long size) {
+    __m128i const leads = _mm_set1_epi8(-65);
+    long long columns = 0;
+    long long position;
+
+    for (position = 0; position + 16 <= size; position += 16)
+        columns += CountBits((unsigned int)_mm_movemask_epi8(
+                       _mm_cmpgt_epi8(_mm_loadu_si128((__m128i const *)(text + position)), leads)));
+    return columns + CountScalar(text + position, size - position);
+}
+
+COLUMN_TARGET("avx2,popcnt")
+static long long CountAvx2(unsigned char const * text, long long size) {
+    __m256i const leads = _mm256_set1_epi8(-65);
+    long long columns = 0;
+    long long position;
+
+    for (position = 0; position + 32 <= size; position += 32)
+        columns += CountBits((unsigned int)_mm256_movemask_epi8(
+                       _mm256_cmpgt_epi8(_mm256_loadu_si256((__m256i const *)(text + position)), leads)));
+    return columns + CountScalar(text + position, size - position);
+}
+
+COLUMN_TARGET("sse2")
+static long long SkipSse2(unsigned char const * text, long long size, long long columns) {
+    __m128i const leads = _mm_set1_epi8(-65);
+    unsigned int mask;
+    long long position;
+    int count;
+
+    for (position = 0; position + 16 <= size; position += 16) {
+        mask  = (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((__m128i const *)(text + position)), leads));
+        count = CountBits(mask);
+        if (count > columns) {
+            for (; columns > 0; --columns)
+                mask &= mask - 1;
+            return position + CountTrailingZeros(mask);
+        }
+        columns -= count;
+    }
+    return position + SkipScalar(text + position, size - position, columns);
+}
+
+COLUMN_TARGET("avx2,popcnt")
+static long long SkipAvx2(unsigned char const * text, long long size, long long columns) {
+    __m256i const leads = _mm256_set1_epi8(-65);
+    unsigned int mask;
+    long long position;
+    int count;
+
+    for (position = 0; position + 32 <= size; position += 32) {
+        mask  = (unsigned int)_mm256_movemask_epi8(
+                    _mm256_cmpgt_epi8(_mm256_loadu_si256((__m256i const *)(text + position)), leads));
+        count = CountBits(mask);
+        if (count > columns) {
+            for (; columns > 0; --columns)
+                mask &= mask - 1;
+            return position + CountTrailingZeros(mask);
+        }
+        columns -= count;
+    }
+    return position + SkipScalar(text + position, size - position, columns);
+}
+#endif // COLUMN_X86
+
+/**
+ * Counts characters of UTF-8 text without validating it (each byte which isn't continuation one begins character).
+ * IN:
+ * @param text - text to count characters of
+ * @param size - size of text in bytes
+ * @param kernel - kernel to count with (unsupported kernels are replaced with the detected one)
+ *
+ * OUT:
+ * @return number of characters
+ */
+long long CountColumns(char const * text, long long size, IndexerKernel kernel) {
+    switch (ResolveKernel(kernel)) {
+#ifdef COLUMN_X86
+    case INDEXER_KERNEL_SSE2:
+        return CountSse2((unsigned char const *)text, size);
+    case INDEXER_KERNEL_AVX2:
+    case INDEXER_KERNEL_AVX512:
+        return CountAvx2((unsigned char const *)text, size);
+#endif
+    default:
+        return CountScalar((unsigned char const *)text, size);
+    }
+}
+
+/**
+ * Finds character of UTF-8 text by it's number without validating text.
+ * IN:
+ * @param text - text beginning with character
+ * @param size - size of text in bytes
+ * @param columns - number of characters to skip
+ * @param kernel - kernel to count with (unsupported kernels are replaced with the detected one)
+ *
+ * OUT:
+ * @return offset of character in bytes (size if text has no more than columns characters)
+ */
+long long SkipColumns(char const * text, long long size, long long columns, IndexerKernel kernel) {
+    switch (ResolveKernel(kernel)) {
+#ifdef COLUMN_X86
+    case INDEXER_KERNEL_SSE2:
+        return SkipSse2((unsigned char const *)text, size, columns);
+    case INDEXER_KERNEL_AVX2:
+    case INDEXER_KERNEL_AVX512:
+        return SkipAvx2((unsigned char const *)text, size, columns);
+#endif
+    default:
+        return SkipScalar((unsigned char const *)text, size, columns);
+    }
+}
+
+/**
+ * Sets or clears bit of bit array.
+ * IN:
+ * @param bits - bit array
+ * @param bit - number of bit
+ * @param value - TRUE to set bit, FALSE to clear it
+ */
+COLUMN_INLINE void SetBit(unsigned char * bits, long long bit, BOOL value) {
+    if (value)
+        bits[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+    else
+        bits[bit >> 3] &= (unsigned char)~(1 << (bit & 7));
+}
+
+/**
+ * Makes sure column index has room for specified number of lines.
+ * IN:
+ * @param columns - pointer to column index to grow
+ * @param linesNumber - number of lines to keep
+ *
+ * OUT:
+ * columns->lines.lineBeginnings, columns->lines.crlfLines, columns->asciiLines may be reallocated
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL ReserveColumnLines(ColumnIndex * columns, long long linesNumber) {
+    long long capacity = columns->lines.capacity;
+    long long * lineBeginnings;
+    unsigned char * crlfLines;
+    unsigned char * asciiLines;
+
+    if (linesNumber <= capacity)
+        return TRUE;
+    capacity = max(linesNumber, capacity * 2);
+    if ((unsigned long long)capacity >= SIZE_MAX / sizeof(long long))
+        return FALSE;
+
+    lineBeginnings = (long long*)realloc(columns->lines.lineBeginnings, (size_t)(capacity + 1) * sizeof(long long));
+    if (lineBeginnings == NULL)
+        return FALSE;
+    columns->lines.lineBeginnings = lineBeginnings;
+
+    crlfLines = (unsigned char*)realloc(columns->lines.crlfLines, (size_t)(capacity / 8 + 1));
+    if (crlfLines == NULL)
+        return FALSE;
+    columns->lines.crlfLines = crlfLines;
+
+    asciiLines = (unsigned char*)realloc(columns->asciiLines, (size_t)(capacity / 8 + 1));
+    if (asciiLines == NULL)
+        return FALSE;
+    columns->asciiLines = asciiLines;
+
+    columns->lines.capacity = capacity;
+    return TRUE;
+}
+
+/**
+ * Starts list of checkpoints of line.
+ * IN:
+ * @param columns - pointer to column index
+ * @param lineNumber - number of line (greater than numbers of lines having checkpoints already)
+ *
+ * OUT:
+ * columns->checkpointedLines gets line which checkpoints are added next
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL StartCheckpoints(ColumnIndex * columns, long long lineNumber) {
+    CheckpointedLine * checkpointedLines;
+    long long capacity;
+
+    if (columns->checkpointedNumber == columns->checkpointedCapacity) {
+        capacity = (columns->checkpointedCapacity > 0) ? columns->checkpointedCapacity * 2 : INITIAL_CHECKPOINTS_CAPACITY;
+        checkpointedLines = (CheckpointedLine*)realloc(columns->checkpointedLines, (size_t)capacity * sizeof(CheckpointedLine));
+        if (checkpointedLines == NULL)
+            return FALSE;
+        columns->checkpointedLines    = checkpointedLines;
+        columns->checkpointedCapacity = capacity;
+    }
+    columns->checkpointedLines[columns->checkpointedNumber].line  = lineNumber;
+    columns->checkpointedLines[columns->checkpointedNumber].first = columns->checkpointsNumber;
+    columns->checkpointedNumber++;
+    return TRUE;
+}
+
+/**
+ * Saves checkpoints of line which columns are in part of it's content.
+ * IN:
+ * @param columns - pointer to column index with checkpoints of line started (see StartCheckpoints)
+ * @param text - part of line content beginning with character
+ * @param size - size of part in bytes
+ * @param offset - offset of part from line beginning in bytes
+ * @param column - column part begins with
+ * @param end - column after part
+ * @param kernel - supported kernel to count characters with
+ *
+ * OUT:
+ * columns->checkpoints gets offsets of checkpoints columns found in part
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL AddCheckpoints(ColumnIndex * columns, char const * text, long long size, long long offset,
+                           long long column, long long end, IndexerKernel kernel) {
+    long long checkpoint = (column / COLUMN_CHECKPOINT_STEP + 1) * COLUMN_CHECKPOINT_STEP;
+    long long position = 0;
+    long long * checkpoints;
+    long long capacity;
+
+    for (; checkpoint <= end; checkpoint += COLUMN_CHECKPOINT_STEP) {
+        if (columns->checkpointsNumber == columns->checkpointsCapacity) {
+            capacity = (columns->checkpointsCapacity > 0) ? columns->checkpointsCapacity * 2 : INITIAL_CHECKPOINTS_CAPACITY;
+            checkpoints = (long long*)realloc(columns->checkpoints, (size_t)capacity * sizeof(long long));
+            if (checkpoints == NULL)
+                return FALSE;
+            columns->checkpoints         = checkpoints;
+            columns->checkpointsCapacity = capacity;
+        }
+        position += SkipColumns(text + position, size - position, checkpoint - column, kernel);
+        column = checkpoint;
+        columns->checkpoints[columns->checkpointsNumber++] = offset + position;
+    }
+    return TRUE;
+}
+
+/**
+ * Saves measured line into column index: sets it's flags and the beginning of the next line.
+ * IN:
+ * @param columns - pointer to column index with lines before this one complete
+ * @param index - pointer to index of lines in bytes
+ * @param lineNumber - number of line
+ * @param length - number of columns of line content (-1 if it isn't valid UTF-8)
+ *
+ * OUT:
+ * columns->lines gets the beginning of the next line, maxLength is updated with line length
+ */
+static void CompleteLine(ColumnIndex * columns, LineIndex const * index, long long lineNumber, long long length) {
+    long long begin = GetIndexedLineBeginning(index, lineNumber);
+    long long end   = GetLineContentEnd(index, lineNumber);
+    long long next  = GetIndexedLineBeginning(index, lineNumber + 1);
+    BOOL ascii = (length < 0 || length == end - begin);
+
+    if (ascii)
+        length = end - begin;
+    SetBit(columns->asciiLines, lineNumber, ascii);
+    SetBit(columns->lines.crlfLines, lineNumber, next - end == 2);
+    if (columns->lines.maxLength < length)
+        columns->lines.maxLength = length;
+    columns->lines.lineBeginnings[lineNumber + 1] = columns->lines.lineBeginnings[lineNumber] + length + (next - end);
+}
+
+/**
+ * Thread routine measuring lines of chunk.
+ * IN:
+ * @param argument - pointer to ColumnTask
+ *
+ * OUT:
+ * task->lengths get numbers of columns of lines of chunk
+ */
+static void MeasureChunk(void * argument) {
+    ColumnTask * task = (ColumnTask*)argument;
+    long long line, begin;
+
+    for (line = task->firstLine; line < task->endLine; ++line) {
+        begin = GetIndexedLineBeginning(task->index, line);
+        task->lengths[line] = task->kernel(task->text + (begin - task->base), GetLineContentEnd(task->index, line) - begin);
+    }
+}
+
+/**
+ * Measures lines of segment in parallel and saves them into column index.
+ * IN:
+ * @param columns - pointer to column index with lines before segment complete
+ * @param index - pointer to index of lines in bytes
+ * @param text - text of segment
+ * @param firstLine - the first line of segment
+ * @param endLine - the line after the last one of segment
+ * @param threadsNumber - number of threads to use
+ * @param kernel - supported kernel to measure lines with
+ *
+ * OUT:
+ * columns gets lines of segment
+ * @return code of error occured during measuring (ERR_NO if successed)
+ */
+static ErrorType MeasureSegment(ColumnIndex * columns, LineIndex const * index, char const * text,
+                                long long firstLine, long long endLine, int threadsNumber, IndexerKernel kernel) {
+    ColumnTask tasks[MAX_COLUMN_TASKS];
+    long long begin = GetIndexedLineBeginning(index, firstLine);
+    long long size  = GetIndexedLineBeginning(index, endLine) - begin;
+    long long line, length;
+    ErrorType errorType;
+    int tasksNumber = (int)min(min(threadsNumber, size / MIN_COLUMN_CHUNK_SIZE), MAX_COLUMN_TASKS);
+    int i;
+
+    // numbers of columns are kept in slots of the next lines beginnings until lines are complete
+    if (tasksNumber < 1)
+        tasksNumber = 1;
+    for (i = 0; i < tasksNumber; ++i) {
+        tasks[i].text      = (unsigned char const *)text;
+        tasks[i].base      = begin;
+        tasks[i].index     = index;
+        tasks[i].firstLine = (i == 0) ? firstLine :
+                             max(tasks[i - 1].firstLine, FindIndexedLine(index, begin + (long long)((double)size * i / tasksNumber)));
+        tasks[i].lengths   = columns->lines.lineBeginnings + 1;
+        tasks[i].kernel    = GetColumnKernel(kernel);
+        if (i > 0)
+            tasks[i - 1].endLine = tasks[i].firstLine;
+    }
+    tasks[tasksNumber - 1].endLine = endLine;
+    errorType = RunThreadTasks(tasks, sizeof(ColumnTask), tasksNumber, MeasureChunk);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    for (line = firstLine; line < endLine; ++line) {
+        length = columns->lines.lineBeginnings[line + 1];
+        if (length >= COLUMN_CHECKPOINT_STEP && length < GetLineContentEnd(index, line) - GetIndexedLineBeginning(index, line)) {
+            if (!StartCheckpoints(columns, line) ||
+                !AddCheckpoints(columns, text + (GetIndexedLineBeginning(index, line) - begin),
+                                GetLineContentEnd(index, line) - GetIndexedLineBeginning(index, line), 0, 0, length, kernel))
+                return ERR_NOMEM;
+        }
+        CompleteLine(columns, index, line, length);
+    }
+    return ERR_NO;
+}
+
+/**
+ * Measures line which doesn't fit into segment by parts. Parts are cut before sequences
+ * which don't fit into them, so each part is validated separately.
+ * IN:
+ * @param columns - pointer to column index with lines before this one complete
+ * @param index - pointer to index of lines in bytes
+ * @param lineNumber - number of line
+ * @param data - entire text (NULL if it's read by parts)
+ * @param read - function reading text which isn't kept in memory
+ * @param source - argument of read
+ * @param buffer - buffer for parts read with read
+ * @param partSize - size of parts
+ * @param kernel - supported kernel to measure parts with
+ *
+ * OUT:
+ * columns gets line
+ * @return code of error occured during measuring (ERR_NO if successed)
+ */
+static ErrorType MeasureLongLine(ColumnIndex * columns, LineIndex const * index, long long lineNumber, char const * data,
+                                 TextReader read, void * source, char * buffer, long long partSize, IndexerKernel kernel) {
+    long long checkpointedNumber = columns->checkpointedNumber;
+    long long checkpointsNumber  = columns->checkpointsNumber;
+    long long begin = GetIndexedLineBeginning(index, lineNumber);
+    long long end   = GetLineContentEnd(index, lineNumber);
+    long long length = 0;
+    long long position, size, cut, measured, i;
+    unsigned char const * part;
+
+    if (!StartCheckpoints(columns, lineNumber))
+        return ERR_NOMEM;
+    for (position = begin; position < end && length >= 0; position += cut) {
+        size = min(partSize, end - position);
+        if (data != NULL)
+            part = (unsigned char const *)data + position;
+        else if (read(source, position, buffer, (size_t)size))
+            part = (unsigned char const *)buffer;
+        else
+            return ERR_READ;
+
+        // sequence started in the last three bytes of part is measured with the next part
+        cut = size;
+        for (i = size - 1; i > 0 && i >= size - 3 && position + size < end && part[i] >= 0x80; --i) {
+            if (part[i] >= 0xC0) {
+                if (i + ((part[i] >= 0xF0) ? 4 : (part[i] >= 0xE0) ? 3 : 2) > size)
+                    cut = i;
+                break;
+            }
+        }
+
+        measured = GetColumnKernel(kernel)(part, cut);
+        if (measured < 0)
+            length = -1;
+        else if (!AddCheckpoints(columns, (char const *)part, cut, position - begin, length, length + measured, kernel))
+            return ERR_NOMEM;
+        else
+            length += measured;
+    }
+
+    // checkpoints are kept for multibyte lines only
+    if (length < 0 || length == end - begin) {
+        columns->checkpointedNumber = checkpointedNumber;
+        columns->checkpointsNumber  = checkpointsNumber;
+    }
+    CompleteLine(columns, index, lineNumber, length);
+    return ERR_NO;
+}
+
+/**
+ * Measures lines of text starting from specified one by segments: each segment is measured in parallel.
+ * IN:
+ * @param columns - pointer to column index with lines before firstLine complete and room for all lines
+ * @param index - pointer to complete index of lines in bytes
+ * @param firstLine - the first line to measure
+ * @param data - entire text (NULL if it's read by segments)
+ * @param read - function reading text which isn't kept in memory
+ * @param source - argument of read
+ * @param options - settings of indexing (NULL means default ones)
+ *
+ * OUT:
+ * columns gets lines starting from firstLine
+ * @return code of error occured during measuring (ERR_NO if successed)
+ */
+static ErrorType MeasureLines(ColumnIndex * columns, LineIndex const * index, long long firstLine, char const * data,
+                              TextReader read, void * source, IndexerOptions const * options) {
+    IndexerKernel kernel = ResolveKernel((options != NULL) ? options->kernel : INDEXER_KERNEL_AUTO);
+    int threadsNumber = (options != NULL) ? options->threadsNumber : 0;
+    long long segmentSize = (data != NULL) ? MAX_COLUMN_SEGMENT_SIZE : MAX_STREAM_COLUMN_SEGMENT_SIZE;
+    long long size = GetIndexedLineBeginning(index, index->linesNumber);
+    long long line, endLine, begin, end;
+    ErrorType errorType = ERR_NO;
+    char * buffer = NULL;
+
+    if (threadsNumber <= 0)
+        threadsNumber = GetHardwareConcurrency();
+    if (data == NULL && (buffer = (char*)malloc((size_t)segmentSize)) == NULL)
+        return ERR_NOMEM;
+
+    for (line = firstLine; line < index->linesNumber && errorType == ERR_NO; line = endLine) {
+        // segment consists of whole lines which fit into it, the line which doesn't fit is measured by parts
+        begin   = GetIndexedLineBeginning(index, line);
+        endLine = (begin + segmentSize >= size) ? index->linesNumber : FindIndexedLine(index, begin + segmentSize);
+        if (endLine == line) {
+            errorType = MeasureLongLine(columns, index, line, data, read, source, buffer, segmentSize, kernel);
+            endLine = line + 1;
+            continue;
+        }
+
+        end = GetIndexedLineBeginning(index, endLine);
+        if (data == NULL && !read(source, begin, buffer, (size_t)(end - begin)))
+            errorType = ERR_READ;
+        else
+            errorType = MeasureSegment(columns, index, (data != NULL) ? data + begin : buffer, line, endLine,
+                                       threadsNumber, kernel);
+    }
+
+    free(buffer);
+    return errorType;
+}
+
+/**
+ * Builds column index of UTF-8 text: finds number of characters of each line, lines of pure ASCII
+ * and checkpoints of long multibyte lines. Text is measured by segments, each one in parallel.
+ * IN:
+ * @param columns - pointer to structure to save index in
+ * @param index - pointer to complete index of lines of text in bytes
+ * @param data - text (NULL if it's read with read)
+ * @param read - function reading text which isn't kept in memory (used if data is NULL)
+ * @param source - argument of read
+ * @param options - settings of indexing (NULL means default ones, mode is ignored)
+ *
+ * OUT:
+ * fields of columns are initialized with built index
+ * @return code of error occured during building index (ERR_NO if successed)
+ */
+ErrorType BuildColumnIndex(ColumnIndex * columns, LineIndex const * index, char const * data, TextReader read, void * source,
+                           IndexerOptions const * options) {
+    ErrorType errorType;
+
+    if (columns == NULL || index == NULL || index->unfinished || (data == NULL && read == NULL))
+        return ERR_NULL_PTR;
+    memset(columns, 0, sizeof(ColumnIndex));    // empty index is safe to destroy on errors
+
+    if (!ReserveColumnLines(columns, index->linesNumber)) {
+        DestroyColumnIndex(columns);
+        return ERR_NOMEM;
+    }
+    columns->lines.lineBeginnings[0] = 0;
+    columns->lines.linesNumber = index->linesNumber;
+
+    errorType = MeasureLines(columns, index, 0, data, read, source, options);
+    if (errorType == ERR_NO && !CountLineLengths(&columns->lines))
+        errorType = ERR_NOMEM;
+    if (errorType != ERR_NO)
+        DestroyColumnIndex(columns);
+    return errorType;
+}
+
+/**
+ * Measures lines of text which has grown since column index has been built.
+ * Only lines starting from the first rescanned one are measured (see AppendLineIndex).
+ * IN:
+ * @param columns - pointer to column index of text before it has grown
+ * @param index - pointer to complete index of lines of grown text in bytes
+ * @param firstLine - the first line rescanned by AppendLineIndex (see GetLineIndexTail)
+ * @param data - grown text (NULL if it's read with read)
+ * @param read - function reading text which isn't kept in memory (used if data is NULL)
+ * @param source - argument of read
+ * @param options - settings of indexing (NULL means default ones, mode is ignored)
+ *
+ * OUT:
+ * columns gets lines of grown text, lines lengths histogram is dropped if there's not enough memory for it
+ * @return code of error occured during measuring (column index has to be destroyed if it's not ERR_NO)
+ */
+ErrorType AppendColumnIndex(ColumnIndex * columns, LineIndex const * index, long long firstLine, char const * data,
+                            TextReader read, void * source, IndexerOptions const * options) {
+    LineIndex * lines;
+    ErrorType errorType;
+    long long line;
+    BOOL histogram;
+
+    if (columns == NULL || index == NULL || index->unfinished || (data == NULL && read == NULL) ||
+        firstLine > columns->lines.linesNumber || firstLine >= index->linesNumber)
+        return ERR_NULL_PTR;
+    lines = &columns->lines;
+    if (!ReserveColumnLines(columns, index->linesNumber))
+        return ERR_NOMEM;
+
+    // rescanned lines are measured again: their lengths and checkpoints are removed
+    histogram = (lines->lengthCounts != NULL);
+    for (line = firstLine; line < lines->linesNumber && histogram; ++line)
+        histogram = AddLineLength(lines, GetLineContentEnd(lines, line) - GetIndexedLineBeginning(lines, line), -1);
+    while (columns->checkpointedNumber > 0 && columns->checkpointedLines[columns->checkpointedNumber - 1].line >= firstLine)
+        columns->checkpointsNumber = columns->checkpointedLines[--columns->checkpointedNumber].first;
+
+    lines->linesNumber = index->linesNumber;
+    errorType = MeasureLines(columns, index, firstLine, data, read, source, options);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    for (line = firstLine; line < lines->linesNumber && histogram; ++line)
+        histogram = AddLineLength(lines, GetLineContentEnd(lines, line) - GetIndexedLineBeginning(lines, line), 1);
+    if (!histogram) {
+        // without lengths histogram rows are counted line by line
+        free(lines->lengthCounts);
+        free(lines->longLengths);
+        lines->lengthCounts  = NULL;
+        lines->longLengths   = NULL;
+        lines->lengthsNumber = 0;
+    }
+    return ERR_NO;
+}
+
+/**
+ * Frees memory allocated for column index.
+ * IN:
+ * @param columns - pointer to column index to destroy
+ *
+ * OUT:
+ * fields of columns are set to empty index
+ */
+void DestroyColumnIndex(ColumnIndex * columns) {
+    if (columns == NULL)
+        return;
+    DestroyLineIndex(&columns->lines);
+    free(columns->asciiLines);
+    free(columns->checkpointedLines);
+    free(columns->checkpoints);
+    memset(columns, 0, sizeof(ColumnIndex));
+}
+
+/**
+ * Checks whether columns of line are it's bytes, so they don't have to be converted.
+ * IN:
+ * @param columns - pointer to column index
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @return TRUE if line is pure ASCII or it isn't valid UTF-8
+ */
+BOOL IsAsciiLine(ColumnIndex const * columns, long long lineNumber) {
+    return (columns->asciiLines[lineNumber >> 3] & (1 << (lineNumber & 7))) != 0;
+}
+
+/**
+ * Finds line in array of lines having checkpoints.
+ * IN:
+ * @param columns - pointer to column index
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @return pointer to item of line (NULL if line has no checkpoints)
+ */
+static CheckpointedLine const * FindCheckpointedLine(ColumnIndex const * columns, long long lineNumber) {
+    long long low = 0;
+    long long high = columns->checkpointedNumber;
+    long long middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (columns->checkpointedLines[middle].line < lineNumber)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low < columns->checkpointedNumber && columns->checkpointedLines[low].line == lineNumber)
+        return &columns->checkpointedLines[low];
+    return NULL;
+}
+
+/**
+ * Gives the nearest checkpoint of multibyte line not after column, so the column is found
+ * by counting characters from it instead of line beginning.
+ * IN:
+ * @param columns - pointer to column index
+ * @param lineNumber - number of line
+ * @param column - column of line
+ *
+ * OUT:
+ * @param offset - gets offset of checkpoint from line beginning in bytes
+ * @return column of checkpoint (0 for line beginning)
+ */
+long long GetColumnCheckpoint(ColumnIndex const * columns, long long lineNumber, long long column, long long * offset) {
+    CheckpointedLine const * checkpointed = FindCheckpointedLine(columns, lineNumber);
+    long long length, checkpoint;
+
+    *offset = 0;
+    if (checkpointed == NULL || column < COLUMN_CHECKPOINT_STEP)
+        return 0;
+    length = GetLineContentEnd(&columns->lines, lineNumber) - GetIndexedLineBeginning(&columns->lines, lineNumber);
+    checkpoint = min(column, length) / COLUMN_CHECKPOINT_STEP;
+    *offset = columns->checkpoints[checkpointed->first + checkpoint - 1];
+    return checkpoint * COLUMN_CHECKPOINT_STEP;
+}
+
+/**
+ * Gives the nearest checkpoint of multibyte line not after byte offset, so the column of offset is found
+ * by counting characters from it instead of line beginning.
+ * IN:
+ * @param columns - pointer to column index
+ * @param lineNumber - number of line
+ * @param offset - offset from line beginning in bytes
+ *
+ * OUT:
+ * @param column - gets column of checkpoint (0 for line beginning)
+ * @return offset of checkpoint from line beginning in bytes
+ */
+long long GetOffsetCheckpoint(ColumnIndex const * columns, long long lineNumber, long long offset, long long * column) {
+    CheckpointedLine const * checkpointed = FindCheckpointedLine(columns, lineNumber);
+    long long low = 0;
+    long long high, middle;
+
+    *column = 0;
+    if (checkpointed == NULL)
+        return 0;
+
+    // number of checkpoints not after offset
+    high = (GetLineContentEnd(&columns->lines, lineNumber) - GetIndexedLineBeginning(&columns->lines, lineNumber)) /
+           COLUMN_CHECKPOINT_STEP;
+    while (low < high) {
+        middle = low + (high - low + 1) / 2;
+        if (columns->checkpoints[checkpointed->first + middle - 1] <= offset)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    *column = low * COLUMN_CHECKPOINT_STEP;
+    return (low > 0) ? columns->checkpoints[checkpointed->first + low - 1] : 0;
+}
+
+/**
+ * Gives number of bytes occupied by column index.
+ * IN:
+ * @param columns - pointer to column index
+ *
+ * OUT:
+ * @return size of index arrays in bytes
+ */
+size_t GetColumnIndexMemory(ColumnIndex const * columns) {
+    return GetLineIndexMemory(&columns->lines) + (size_t)columns->lines.capacity / 8 + 1 +
+           (size_t)columns->checkpointedCapacity * sizeof(CheckpointedLine) +
+           (size_t)columns->checkpointsCapacity * sizeof(long long);
+}
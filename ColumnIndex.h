@@ -0,0 +1,43 @@
+#ifndef COLUMNINDEX_H_INCLUDED
+#define COLUMNINDEX_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+#include "LineIndexer.h"
+
+#define COLUMN_CHECKPOINT_STEP 4096     // long multibyte lines keep byte offset of every this column
+
+typedef struct {
+    long long line;             // number of line
+    long long first;            // index of checkpoint of it's column COLUMN_CHECKPOINT_STEP in checkpoints array
+} CheckpointedLine;
+
+/* lines of UTF-8 text measured in columns: each code point takes one column,
+ * lines which aren't valid UTF-8 take one column per byte, line breaks take as many columns as bytes */
+typedef struct {
+    LineIndex lines;            // Flat index of lines beginnings and lengths in columns counted from the beginning of text
+    unsigned char * asciiLines; // Bit array of [lines.linesNumber] flags of lines which columns are their bytes
+                                // (pure ASCII lines and lines which aren't valid UTF-8)
+    CheckpointedLine * checkpointedLines;   // Array of multibyte lines having checkpoints in ascending order
+    long long checkpointedNumber;           // Number of items in checkpointedLines
+    long long checkpointedCapacity;         // Number of items memory of checkpointedLines is allocated for
+    long long * checkpoints;    // Byte offsets of every COLUMN_CHECKPOINT_STEP-th column from beginnings of their lines
+    long long checkpointsNumber;            // Number of items in checkpoints
+    long long checkpointsCapacity;          // Number of items memory of checkpoints is allocated for
+} ColumnIndex;
+
+ErrorType BuildColumnIndex(ColumnIndex * columns, LineIndex const * index, char const * data, TextReader read, void * source,
+                           IndexerOptions const * options);
+ErrorType AppendColumnIndex(ColumnIndex * columns, LineIndex const * index, long long firstLine, char const * data,
+                            TextReader read, void * source, IndexerOptions const * options);
+void DestroyColumnIndex(ColumnIndex * columns);
+BOOL IsAsciiLine(ColumnIndex const * columns, long long lineNumber);
+long long GetColumnCheckpoint(ColumnIndex const * columns, long long lineNumber, long long column, long long * offset);
+long long GetOffsetCheckpoint(ColumnIndex const * columns, long long lineNumber, long long offset, long long * column);
+size_t GetColumnIndexMemory(ColumnIndex const * columns);
+long long MeasureColumns(char const * text, long long size, IndexerKernel kernel);
+long long CountColumns(char const * text, long long size, IndexerKernel kernel);
+long long SkipColumns(char const * text, long long size, long long columns, IndexerKernel kernel);
+
+#endif // COLUMNINDEX_H_INCLUDED
@@ -0,0 +1,618 @@
+// 64-bit file offsets on 32-bit POSIX systems
+#define _FILE_OFFSET_BITS 64
+
+#include "CompressedFile.h"
+#include "FileMapping.h"
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+// NO_ZSTD is defined by builds without zstd library: zstd files are shown as they're stored
+#ifndef NO_ZSTD
+    #include <zstd.h>
+#endif
+
+#define COMPRESSED_INPUT_SIZE (256 * 1024)      // size of compressed file part read at once
+#define COMPRESSED_SKIP_SIZE (64 * 1024)        // size of buffer text before asked range is decompressed into
+#define INITIAL_COMPRESSED_CHECKPOINTS 64
+
+struct tag_CompressedReader {
+    CompressedIndex * index;    // restart points shared by all readers of file
+    FILE * file;                // compressed file
+    unsigned char * input;      // buffer of [COMPRESSED_INPUT_SIZE] compressed bytes
+    size_t inputBegin;          // index of the first byte of input not fed into decompressor yet
+    size_t inputEnd;            // index of the byte after the last read one
+    long long inputOffset;      // position in compressed file of the byte after the last read one
+    z_stream gzip;              // gzip decompressor (used if format is COMPRESSION_GZIP)
+    BOOL raw;                   // set if gzip member is decompressed from restart point (it's trailer isn't checked)
+#ifndef NO_ZSTD
+    ZSTD_DStream * zstd;        // zstd decompressor (used if format is COMPRESSION_ZSTD)
+#endif
+    long long position;         // position in text of the next decompressed byte
+    BOOL ended;                 // set when the end of compressed data is reached
+    BOOL scanning;              // set if restart points are recorded while text is decompressed (the first pass)
+    unsigned char * history;    // circular buffer of [COMPRESSED_WINDOW_SIZE] the latest bytes of text
+    long long remembered;       // number of bytes before position kept in history
+    char * skipped;             // buffer of [COMPRESSED_SKIP_SIZE] bytes text before asked range is decompressed into
+};
+
+/**
+ * Recognizes format of compressed file by it's first bytes.
+ * IN:
+ * @param filename - name of file
+ *
+ * OUT:
+ * @return format of file (COMPRESSION_NONE if file isn't compressed or it can't be read)
+ */
+CompressionFormat DetectCompression(char const * filename) {
+    unsigned char magic[4] = { 0 };
+    FILE * file;
+    size_t size;
+
+    if (filename == NULL || (file = fopen(filename, "rb")) == NULL)
+        return COMPRESSION_NONE;
+    size = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if (size >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+        return COMPRESSION_GZIP;
+#ifndef NO_ZSTD
+    if (size >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+        return COMPRESSION_ZSTD;
+#endif
+    return COMPRESSION_NONE;
+}
+
+/**
+ * Adds restart point to index.
+ * IN:
+ * @param index - pointer to index being built
+ * @param offset - position in text
+ * @param compressedOffset - position in compressed file
+ * @param bits - number of bits of the byte before compressedOffset to feed
+ * @param window - text before offset (NULL if it isn't needed)
+ *
+ * OUT:
+ * index->checkpoints gets restart point
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL AddCompressedCheckpoint(CompressedIndex * index, long long offset, long long compressedOffset, int bits,
+                                    unsigned char const * window) {
+    CompressedCheckpoint * checkpoints;
+    CompressedCheckpoint * checkpoint;
+    long long capacity;
+
+    if (index->checkpointsNumber == index->checkpointsCapacity) {
+        capacity = (index->checkpointsCapacity > 0) ? index->checkpointsCapacity * 2 : INITIAL_COMPRESSED_CHECKPOINTS;
+        checkpoints = (CompressedCheckpoint*)realloc(index->checkpoints, (size_t)capacity * sizeof(CompressedCheckpoint));
+        if (checkpoints == NULL)
+            return FALSE;
+        index->checkpoints         = checkpoints;
+        index->checkpointsCapacity = capacity;
+    }
+    checkpoint = &index->checkpoints[index->checkpointsNumber];
+    checkpoint->offset           = offset;
+    checkpoint->compressedOffset = compressedOffset;
+    checkpoint->bits             = bits;
+    checkpoint->window           = NULL;
+    if (window != NULL) {
+        checkpoint->window = (unsigned char*)malloc(COMPRESSED_WINDOW_SIZE);
+        if (checkpoint->window == NULL)
+            return FALSE;
+        memcpy(checkpoint->window, window, COMPRESSED_WINDOW_SIZE);
+    }
+    index->checkpointsNumber++;
+    return TRUE;
+}
+
+/**
+ * Initializes index of compressed file with the only restart point at file beginning.
+ * Restart points are recorded while text is read with ScanCompressedText.
+ * IN:
+ * @param index - pointer to index to initialize
+ * @param filename - name of compressed file
+ *
+ * OUT:
+ * fields of index are initialized
+ * @return code of error occured during opening (ERR_NO if successed)
+ */
+ErrorType CreateCompressedIndex(CompressedIndex * index, char const * filename) {
+    FILE * file;
+
+    if (index == NULL)
+        return ERR_NULL_PTR;
+    memset(index, 0, sizeof(CompressedIndex));
+    index->format = DetectCompression(filename);
+    if (index->format == COMPRESSION_NONE)
+        return ERR_READ;
+    if ((file = fopen(filename, "rb")) == NULL)
+        return ERR_OPEN_FILE;
+    if (SeekFile(file, 0, SEEK_END) != 0 || (index->compressedSize = TellFile(file)) < 0) {
+        fclose(file);
+        return ERR_READ;
+    }
+    fclose(file);
+
+    if (!AddCompressedCheckpoint(index, 0, 0, 0, NULL)) {
+        DestroyCompressedIndex(index);
+        return ERR_NOMEM;
+    }
+    return ERR_NO;
+}
+
+/**
+ * Frees memory of restart points.
+ * IN:
+ * @param index - pointer to index
+ *
+ * OUT:
+ * fields of index are set as zero
+ */
+void DestroyCompressedIndex(CompressedIndex * index) {
+    long long i;
+
+    if (index == NULL)
+        return;
+    for (i = 0; i < index->checkpointsNumber; ++i)
+        free(index->checkpoints[i].window);
+    free(index->checkpoints);
+    memset(index, 0, sizeof(CompressedIndex));
+}
+
+/**
+ * Gives memory taken by restart points.
+ * IN:
+ * @param index - pointer to index
+ *
+ * OUT:
+ * @return size of allocated memory in bytes
+ */
+size_t GetCompressedIndexMemory(CompressedIndex const * index) {
+    size_t size = (size_t)index->checkpointsCapacity * sizeof(CompressedCheckpoint);
+    long long i;
+
+    for (i = 0; i < index->checkpointsNumber; ++i) {
+        if (index->checkpoints[i].window != NULL)
+            size += COMPRESSED_WINDOW_SIZE;
+    }
+    return size;
+}
+
+/**
+ * Opens compressed file to read it's text. Each thread reading text has to open it's own reader.
+ * IN:
+ * @param filename - name of compressed file
+ * @param index - pointer to index of file (it has to stay valid until reader is closed)
+ *
+ * OUT:
+ * @param reader - gets pointer to reader positioned at the beginning of text (it has to be closed with CloseCompressedReader)
+ * @return code of error occured during opening (ERR_NO if successed)
+ */
+ErrorType OpenCompressedReader(CompressedReader ** reader, char const * filename, CompressedIndex * index) {
+    CompressedReader * opened;
+
+    if (reader == NULL || index == NULL || filename == NULL)
+        return ERR_NULL_PTR;
+    opened = (CompressedReader*)calloc(1, sizeof(CompressedReader));
+    if (opened == NULL)
+        return ERR_NOMEM;
+    opened->index = index;
+    opened->file  = fopen(filename, "rb");
+    if (opened->file == NULL) {
+        free(opened);
+        return ERR_OPEN_FILE;
+    }
+
+    opened->input   = (unsigned char*)malloc(COMPRESSED_INPUT_SIZE);
+    opened->skipped = (char*)malloc(COMPRESSED_SKIP_SIZE);
+    opened->history = (unsigned char*)calloc(COMPRESSED_WINDOW_SIZE, 1);
+    if (index->format == COMPRESSION_GZIP) {
+        // 15 bits window with gzip header (the largest window allowed by format)
+        if (inflateInit2(&opened->gzip, 15 + 16) != Z_OK) {
+            CloseCompressedReader(opened);
+            return ERR_NOMEM;
+        }
+    }
+#ifndef NO_ZSTD
+    else if ((opened->zstd = ZSTD_createDStream()) == NULL || ZSTD_isError(ZSTD_initDStream(opened->zstd))) {
+        CloseCompressedReader(opened);
+        return ERR_NOMEM;
+    }
+#endif
+    if (opened->input == NULL || opened->skipped == NULL || opened->history == NULL) {
+        CloseCompressedReader(opened);
+        return ERR_NOMEM;
+    }
+
+    *reader = opened;
+    return ERR_NO;
+}
+
+/**
+ * Closes compressed file and frees decompressor.
+ * IN:
+ * @param reader - pointer to reader (may be NULL)
+ */
+void CloseCompressedReader(CompressedReader * reader) {
+    if (reader == NULL)
+        return;
+    if (reader->gzip.state != NULL)
+        inflateEnd(&reader->gzip);
+#ifndef NO_ZSTD
+    if (reader->zstd != NULL)
+        ZSTD_freeDStream(reader->zstd);
+#endif
+    if (reader->file != NULL)
+        fclose(reader->file);
+    free(reader->input);
+    free(reader->history);
+    free(reader->skipped);
+    free(reader);
+}
+
+/**
+ * Makes sure input buffer has specified number of compressed bytes, bytes already fed are dropped.
+ * IN:
+ * @param reader - pointer to reader
+ * @param needed - number of bytes (not more than COMPRESSED_INPUT_SIZE)
+ *
+ * OUT:
+ * reader->input gets bytes read from file
+ * @return TRUE if input has needed bytes, FALSE if file has ended or it can't be read
+ */
+static BOOL FillInput(CompressedReader * reader, size_t needed) {
+    size_t kept = reader->inputEnd - reader->inputBegin;
+    size_t read;
+
+    if (kept >= needed)
+        return TRUE;
+    memmove(reader->input, reader->input + reader->inputBegin, kept);
+    read = fread(reader->input + kept, 1, COMPRESSED_INPUT_SIZE - kept, reader->file);
+    reader->inputBegin   = 0;
+    reader->inputEnd     = kept + read;
+    reader->inputOffset += (long long)read;
+    return reader->inputEnd >= needed;
+}
+
+/**
+ * Moves reading of compressed file to specified position.
+ * IN:
+ * @param reader - pointer to reader
+ * @param offset - position in compressed file
+ *
+ * OUT:
+ * reader->input gets empty
+ * @return TRUE if successed
+ */
+static BOOL SeekInput(CompressedReader * reader, long long offset) {
+    reader->inputBegin  = 0;
+    reader->inputEnd    = 0;
+    reader->inputOffset = offset;
+    return SeekFile(reader->file, offset, SEEK_SET) == 0;
+}
+
+/**
+ * Restarts decompression at restart point.
+ * IN:
+ * @param reader - pointer to reader
+ * @param checkpoint - pointer to restart point
+ *
+ * OUT:
+ * reader->position gets position of restart point
+ * @return TRUE if successed
+ */
+static BOOL Restart(CompressedReader * reader, CompressedCheckpoint const * checkpoint) {
+    reader->position   = checkpoint->offset;
+    reader->remembered = 0;
+    reader->ended      = FALSE;
+#ifndef NO_ZSTD
+    if (reader->index->format == COMPRESSION_ZSTD)
+        return !ZSTD_isError(ZSTD_DCtx_reset(reader->zstd, ZSTD_reset_session_only)) &&
+               SeekInput(reader, checkpoint->compressedOffset);
+#endif
+
+    // deflate stream is continued without header, the first block may begin inside of previous byte
+    reader->raw = (checkpoint->window != NULL);
+    if (!reader->raw)
+        return inflateReset2(&reader->gzip, 15 + 16) == Z_OK && SeekInput(reader, checkpoint->compressedOffset);
+    if (inflateReset2(&reader->gzip, -15) != Z_OK ||
+        !SeekInput(reader, checkpoint->compressedOffset - ((checkpoint->bits > 0) ? 1 : 0)))
+        return FALSE;
+    if (checkpoint->bits > 0) {
+        if (!FillInput(reader, 1) ||
+            inflatePrime(&reader->gzip, checkpoint->bits, reader->input[reader->inputBegin++] >> (8 - checkpoint->bits)) != Z_OK)
+            return FALSE;
+    }
+    return inflateSetDictionary(&reader->gzip, checkpoint->window, COMPRESSED_WINDOW_SIZE) == Z_OK;
+}
+
+/**
+ * Keeps the latest bytes of text for gzip restart points and for ranges overlapping the previous one.
+ * IN:
+ * @param reader - pointer to reader
+ * @param text - text decompressed at reader->position
+ * @param size - size of text
+ *
+ * OUT:
+ * reader->history gets the last COMPRESSED_WINDOW_SIZE bytes of text
+ */
+static void RememberText(CompressedReader * reader, unsigned char const * text, size_t size) {
+    long long position = reader->position;
+    size_t begin, first;
+
+    if (size > COMPRESSED_WINDOW_SIZE) {
+        position += (long long)(size - COMPRESSED_WINDOW_SIZE);
+        text     += size - COMPRESSED_WINDOW_SIZE;
+        size      = COMPRESSED_WINDOW_SIZE;
+    }
+    begin = (size_t)(position % COMPRESSED_WINDOW_SIZE);
+    first = (size < COMPRESSED_WINDOW_SIZE - begin) ? size : COMPRESSED_WINDOW_SIZE - begin;
+    memcpy(reader->history + begin, text, first);
+    memcpy(reader->history, text + first, size - first);
+    reader->remembered = (reader->remembered + (long long)size < COMPRESSED_WINDOW_SIZE) ?
+                         reader->remembered + (long long)size : COMPRESSED_WINDOW_SIZE;
+}
+
+/**
+ * Copies text kept in history.
+ * IN:
+ * @param reader - pointer to reader
+ * @param offset - position in text of the first byte to copy (not more than reader->remembered bytes before position)
+ * @param size - number of bytes to copy (range ends at position at most)
+ *
+ * OUT:
+ * @param buffer - gets text
+ */
+static void RecallText(CompressedReader const * reader, long long offset, char * buffer, size_t size) {
+    size_t begin = (size_t)(offset % COMPRESSED_WINDOW_SIZE);
+    size_t first = (size < COMPRESSED_WINDOW_SIZE - begin) ? size : COMPRESSED_WINDOW_SIZE - begin;
+
+    memcpy(buffer, reader->history + begin, first);
+    memcpy(buffer + first, reader->history, size - first);
+}
+
+/**
+ * Records gzip restart point at the end of deflate block during the first pass.
+ * IN:
+ * @param reader - pointer to reader which has just decompressed block
+ *
+ * OUT:
+ * reader->index may get restart point
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL RecordGzipCheckpoint(CompressedReader * reader) {
+    CompressedIndex * index = reader->index;
+    unsigned char window[COMPRESSED_WINDOW_SIZE];
+    size_t begin = (size_t)(reader->position % COMPRESSED_WINDOW_SIZE);
+
+    // restart point inside of the last block of member isn't possible
+    if ((reader->gzip.data_type & 128) == 0 || (reader->gzip.data_type & 64) != 0 ||
+        reader->position - index->checkpoints[index->checkpointsNumber - 1].offset < COMPRESSED_CHECKPOINT_SPACING)
+        return TRUE;
+    memcpy(window, reader->history + begin, COMPRESSED_WINDOW_SIZE - begin);
+    memcpy(window + COMPRESSED_WINDOW_SIZE - begin, reader->history, begin);
+    return AddCompressedCheckpoint(index, reader->position, reader->inputOffset - (long long)(reader->inputEnd - reader->inputBegin),
+                                   reader->gzip.data_type & 7, window);
+}
+
+/**
+ * Prepares gzip decompressor for the next member of file after the end of previous one.
+ * IN:
+ * @param reader - pointer to reader
+ *
+ * OUT:
+ * reader->ended is set if there's no next member (bytes after the last member are ignored)
+ * @return TRUE if successed, FALSE if trailer of member can't be read
+ */
+static BOOL StartNextMember(CompressedReader * reader) {
+    // member decompressed without header has it's trailer (CRC-32 and size) skipped
+    if (reader->raw) {
+        if (!FillInput(reader, 8))
+            return FALSE;
+        reader->inputBegin += 8;
+        reader->raw = FALSE;
+    }
+    if (!FillInput(reader, 2) || reader->input[reader->inputBegin] != 0x1F || reader->input[reader->inputBegin + 1] != 0x8B) {
+        reader->ended = TRUE;
+        return TRUE;
+    }
+    return inflateReset2(&reader->gzip, 15 + 16) == Z_OK;
+}
+
+/**
+ * Decompresses the next bytes of gzip file.
+ * IN:
+ * @param reader - pointer to reader
+ * @param buffer - buffer for text
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets text
+ * @return number of decompressed bytes (less than size only at the end of text), -1 if data is broken
+ */
+static long long InflateText(CompressedReader * reader, unsigned char * buffer, size_t size) {
+    z_stream * stream = &reader->gzip;
+    size_t produced = 0;
+    size_t portion;
+    BOOL filled;
+    int result;
+
+    while (produced < size && !reader->ended) {
+        // decompressor may have pending text when input is over
+        filled = (reader->inputBegin < reader->inputEnd || FillInput(reader, 1));
+        stream->next_in   = reader->input + reader->inputBegin;
+        stream->avail_in  = (uInt)(reader->inputEnd - reader->inputBegin);
+        stream->next_out  = buffer + produced;
+        stream->avail_out = (uInt)((size - produced < (1U << 30)) ? size - produced : (1U << 30));
+        portion = stream->avail_out;
+        // the first pass stops at every block end to record restart points
+        result = inflate(stream, reader->scanning ? Z_BLOCK : Z_NO_FLUSH);
+        reader->inputBegin = (size_t)(stream->next_in - reader->input);
+        portion -= stream->avail_out;
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+            return -1;
+        // truncated file (e.g. being written) shows text decompressed so far
+        if (!filled && portion == 0 && result != Z_STREAM_END) {
+            reader->ended = TRUE;
+            break;
+        }
+
+        RememberText(reader, buffer + produced, portion);
+        reader->position += (long long)portion;
+        if (reader->scanning && !RecordGzipCheckpoint(reader))
+            return -1;
+        produced += portion;
+
+        if (result == Z_STREAM_END && !StartNextMember(reader))
+            reader->ended = TRUE;
+    }
+    return (long long)produced;
+}
+
+#ifndef NO_ZSTD
+/**
+ * Decompresses the next bytes of zstd file.
+ * IN:
+ * @param reader - pointer to reader
+ * @param buffer - buffer for text
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets text
+ * @return number of decompressed bytes (less than size only at the end of text), -1 if data is broken
+ */
+static long long DecompressZstdText(CompressedReader * reader, unsigned char * buffer, size_t size) {
+    CompressedIndex * index = reader->index;
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output = { buffer, size, 0 };
+    size_t result, portion;
+    BOOL filled;
+
+    while (output.pos < size && !reader->ended) {
+        // decompressor may have pending text when input is over
+        filled = (reader->inputBegin < reader->inputEnd || FillInput(reader, 1));
+        input.src  = reader->input;
+        input.size = reader->inputEnd;
+        input.pos  = reader->inputBegin;
+        portion = output.pos;
+        result  = ZSTD_decompressStream(reader->zstd, &output, &input);
+        reader->inputBegin = input.pos;
+        if (ZSTD_isError(result))
+            return -1;
+        // the end of the last frame (or truncated file) ends text
+        if (!filled && output.pos == portion) {
+            reader->ended = TRUE;
+            break;
+        }
+        RememberText(reader, buffer + portion, output.pos - portion);
+        reader->position += (long long)(output.pos - portion);
+
+        // frame is decoded and flushed: the next one starts on a fresh decompressor
+        if (result == 0 && reader->scanning &&
+            reader->position - index->checkpoints[index->checkpointsNumber - 1].offset >= COMPRESSED_CHECKPOINT_SPACING &&
+            !AddCompressedCheckpoint(index, reader->position,
+                                     reader->inputOffset - (long long)(reader->inputEnd - reader->inputBegin), 0, NULL))
+            return -1;
+    }
+    return (long long)output.pos;
+}
+#endif
+
+/**
+ * Decompresses the next bytes of text.
+ * IN:
+ * @param reader - pointer to reader
+ * @param buffer - buffer for text
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets text
+ * @return number of decompressed bytes (less than size only at the end of text), -1 if data is broken
+ */
+static long long Decompress(CompressedReader * reader, char * buffer, size_t size) {
+#ifndef NO_ZSTD
+    if (reader->index->format == COMPRESSION_ZSTD)
+        return DecompressZstdText(reader, (unsigned char*)buffer, size);
+#endif
+    return InflateText(reader, (unsigned char*)buffer, size);
+}
+
+/**
+ * Reads the next part of text during the first pass over compressed file and records restart points
+ * (see TextStream). Reader has to be fresh, the pass is complete when 0 is returned.
+ * IN:
+ * @param source - pointer to CompressedReader
+ * @param buffer - buffer for text
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets text
+ * reader's index gets restart points and size of text decompressed so far
+ * @return number of read bytes (0 at the end of text, -1 if data is broken)
+ */
+long long ScanCompressedText(void * source, char * buffer, size_t size) {
+    CompressedReader * reader = (CompressedReader*)source;
+    long long produced;
+
+    reader->scanning = TRUE;
+    produced = Decompress(reader, buffer, size);
+    reader->scanning = FALSE;
+    if (produced < 0)
+        return -1;
+    reader->index->size = reader->position;
+    reader->index->scanned = (produced == 0);
+    return produced;
+}
+
+/**
+ * Reads range of text which has been scanned (see TextReader). Decompression continues from the last read range
+ * if asked range is close after it or overlaps it's end, else it restarts at the nearest restart point before range.
+ * IN:
+ * @param source - pointer to CompressedReader
+ * @param offset - position of the first byte of range in text
+ * @param buffer - buffer for text
+ * @param size - size of range
+ *
+ * OUT:
+ * @param buffer - gets text of range
+ * @return TRUE if successed, FALSE if range is out of text or data is broken
+ */
+BOOL ReadCompressedText(void * source, long long offset, char * buffer, size_t size) {
+    CompressedReader * reader = (CompressedReader*)source;
+    CompressedIndex const * index = reader->index;
+    long long low = 0;
+    long long high = index->checkpointsNumber - 1;
+    long long middle, portion;
+
+    if (offset < 0 || offset + (long long)size > index->size)
+        return FALSE;
+
+    // parts read by search overlap a bit, their common text is kept in history
+    if (offset < reader->position && reader->position - offset <= reader->remembered) {
+        portion = (reader->position - offset < (long long)size) ? reader->position - offset : (long long)size;
+        RecallText(reader, offset, buffer, (size_t)portion);
+        offset += portion;
+        buffer += portion;
+        size   -= (size_t)portion;
+        if (size == 0)
+            return TRUE;
+    }
+
+    // the nearest restart point before range
+    while (low < high) {
+        middle = low + (high - low + 1) / 2;
+        if (index->checkpoints[middle].offset <= offset)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    if ((offset < reader->position || index->checkpoints[low].offset > reader->position) &&
+        !Restart(reader, &index->checkpoints[low]))
+        return FALSE;
+
+    while (reader->position < offset) {
+        portion = (offset - reader->position < COMPRESSED_SKIP_SIZE) ? offset - reader->position : COMPRESSED_SKIP_SIZE;
+        if (Decompress(reader, reader->skipped, (size_t)portion) != portion)
+            return FALSE;
+    }
+    return Decompress(reader, buffer, size) == (long long)size;
+}
@@ -0,0 +1,50 @@
+#ifndef COMPRESSEDFILE_H_INCLUDED
+#define COMPRESSEDFILE_H_INCLUDED
+
+#include "Portable.h"
+#include <stdio.h>
+#include <stddef.h>
+#include "Error.h"
+
+#define COMPRESSED_CHECKPOINT_SPACING (4LL << 20)   // decompressor restart points are kept every this number of bytes of text
+#define COMPRESSED_WINDOW_SIZE 32768                // text before gzip restart point which back references may reach
+
+// formats of compressed files recognized by their first bytes
+typedef enum {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,           // gzip members (concatenated ones too)
+    COMPRESSION_ZSTD            // zstd frames: restart points are kept on frames borders only
+} CompressionFormat;
+
+typedef struct {
+    long long offset;           // position in text decompression restarts from
+    long long compressedOffset; // position in compressed file of the first byte to feed into decompressor
+    int bits;                   // gzip: number of bits of the byte before compressedOffset which belong to the next block
+    unsigned char * window;     // gzip: [COMPRESSED_WINDOW_SIZE] bytes of text before offset (NULL at member beginning)
+} CompressedCheckpoint;
+
+/* restart points of decompressor recorded during the single pass over compressed file,
+ * any position of text is reached by decompressing at most COMPRESSED_CHECKPOINT_SPACING bytes
+ * (zstd frames are decompressed from their beginnings, so frames bigger than spacing take more) */
+typedef struct {
+    CompressionFormat format;   // Format of file
+    long long compressedSize;   // Size of compressed file in bytes
+    long long size;             // Size of text decompressed so far (the whole text when scan is finished)
+    BOOL scanned;               // Set when the whole file has been decompressed once
+    CompressedCheckpoint * checkpoints;     // Array of restart points in ascending order, the first one is file beginning
+    long long checkpointsNumber;            // Number of items in checkpoints
+    long long checkpointsCapacity;          // Number of items memory of checkpoints is allocated for
+} CompressedIndex;
+
+typedef struct tag_CompressedReader CompressedReader;
+
+CompressionFormat DetectCompression(char const * filename);
+ErrorType CreateCompressedIndex(CompressedIndex * index, char const * filename);
+void DestroyCompressedIndex(CompressedIndex * index);
+size_t GetCompressedIndexMemory(CompressedIndex const * index);
+ErrorType OpenCompressedReader(CompressedReader ** reader, char const * filename, CompressedIndex * index);
+void CloseCompressedReader(CompressedReader * reader);
+long long ScanCompressedText(void * source, char * buffer, size_t size);
+BOOL ReadCompressedText(void * source, long long offset, char * buffer, size_t size);
+
+#endif // COMPRESSEDFILE_H_INCLUDED
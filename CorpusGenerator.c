@@ -0,0 +1,151 @@
+// 64-bit file offsets on 32-bit POSIX systems
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FileMapping.h"
+#include "Error.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <winioctl.h>
+    #include <io.h>
+#endif
+
+#define LINE_SIZE 64                    // size of every generated line including '\n'
+#define SEGMENT_SIZE (1LL << 20)        // size of text segment written in sparse mode
+#define SEGMENT_STRIDE (1LL << 30)      // distance between text segments in sparse mode
+
+/**
+ * Parses size with optional K, M or G suffix.
+ * IN:
+ * @param text - string to parse
+ *
+ * OUT:
+ * @return size in bytes (0 if string is invalid)
+ */
+static long long ParseSize(char const * text) {
+    char * suffix = NULL;
+    long long size = strtoll(text, &suffix, 10);
+
+    if (size <= 0)
+        return 0;
+    switch (*suffix) {
+    case 'k': case 'K':
+        return size << 10;
+    case 'm': case 'M':
+        return size << 20;
+    case 'g': case 'G':
+        return size << 30;
+    case '\0':
+        return size;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Writes generated lines into file from it's current position.
+ * Each line shows it's number and offset in file to check positions shown by viewer.
+ * IN:
+ * @param file - file stream set to position of the first line
+ * @param offset - current position in file
+ * @param size - number of bytes to write (the last line is cut if size isn't multiple of LINE_SIZE)
+ *
+ * INOUT:
+ * @param lineNumber - number of the first line to write, gets number of the next line
+ *
+ * OUT:
+ * @return code of error occured during writing (ERR_NO if successed)
+ */
+static ErrorType WriteLines(FILE * file, long long offset, long long size, long long * lineNumber) {
+    char line[LINE_SIZE + 1];
+    long long end = offset + size;
+    size_t length;
+
+    for (; offset < end; offset += LINE_SIZE) {
+        sprintf(line, "line %020lld offset %020lld ", *lineNumber, offset);
+        memset(line + strlen(line), '.', LINE_SIZE - strlen(line) - 1);
+        line[LINE_SIZE - 1] = '\n';
+
+        length = (size_t)((end - offset < LINE_SIZE) ? end - offset : LINE_SIZE);
+        if (fwrite(line, sizeof(char), length, file) != length)
+            return ERR_WRITE;
+        ++*lineNumber;
+    }
+    return ERR_NO;
+}
+
+/**
+ * Marks file as sparse, so skipped regions don't occupy disk space.
+ * POSIX file systems create holes without marking.
+ * IN:
+ * @param file - file stream opened for writing
+ */
+static void MarkSparse(FILE * file) {
+#ifdef _WIN32
+    DWORD returned;
+    HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(file));
+    DeviceIoControl(hFile, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &returned, NULL);
+#else
+    (void)file;
+#endif
+}
+
+/**
+ * Generates test corpus for large file support.
+ * Usage: CorpusGenerator file size[K|M|G] [sparse|dense]
+ * sparse: segments of lines every 1 GB, the rest of file are holes of zero bytes
+ * (each hole becomes a part of the next line), the last segment ends at the end of file;
+ * dense: the whole file consists of lines.
+ */
+int main(int argc, char * argv[]) {
+    FILE * file;
+    ErrorType errorType = ERR_NO;
+    long long size, offset, portion;
+    long long lineNumber = 0;
+    int sparse;
+
+    if (argc < 3 || (size = ParseSize(argv[2])) == 0) {
+        PrintError(NULL, ERR_ARGC, __FILE__, __LINE__);
+        fprintf(stderr, "usage: %s file size[K|M|G] [sparse|dense]\n", argv[0]);
+        return ERR_ARGC;
+    }
+    sparse = (argc < 4 || strcmp(argv[3], "dense") != 0);
+
+    file = fopen(argv[1], "wb");
+    if (file == NULL) {
+        PrintError(NULL, ERR_OPEN_FILE, __FILE__, __LINE__);
+        return ERR_OPEN_FILE;
+    }
+
+    if (!sparse)
+        errorType = WriteLines(file, 0, size, &lineNumber);
+    else {
+        MarkSparse(file);
+        for (offset = 0; offset < size && errorType == ERR_NO; offset += SEGMENT_STRIDE) {
+            // the last segment is moved to the end of file
+            if (offset + SEGMENT_STRIDE >= size && size - SEGMENT_SIZE > offset)
+                offset = size - SEGMENT_SIZE;
+            portion = (size - offset < SEGMENT_SIZE) ? size - offset : SEGMENT_SIZE;
+
+            if (SeekFile(file, offset, SEEK_SET) != 0)
+                errorType = ERR_WRITE;
+            else
+                errorType = WriteLines(file, offset, portion, &lineNumber);
+            if (offset + portion >= size)
+                break;
+        }
+    }
+
+    if (fclose(file) != 0 && errorType == ERR_NO)
+        errorType = ERR_WRITE;
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        return errorType;
+    }
+
+    printf("%s: %lld bytes, %s, %lld lines written\n", argv[1], size, sparse ? "sparse" : "dense", lineNumber);
+    return ERR_NO;
+}
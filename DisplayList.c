@@ -0,0 +1,139 @@
+#include "DisplayList.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Initializes empty display list: every row of the next frame compared with it is changed.
+ * IN:
+ * @param list - pointer to list to initialize
+ *
+ * OUT:
+ * fields of list are set to empty list
+ */
+void InitDisplayList(DisplayList * list) {
+    memset(list, 0, sizeof(DisplayList));
+}
+
+/**
+ * Frees memory allocated for rows of display list.
+ * IN:
+ * @param list - pointer to list to destroy
+ *
+ * OUT:
+ * fields of list are set to empty list
+ */
+void DestroyDisplayList(DisplayList * list) {
+    if (list == NULL)
+        return;
+    free(list->rows);
+    free(list->dirty);
+    InitDisplayList(list);
+}
+
+/**
+ * Prepares display list for frame of client area with specified number of rows.
+ * IN:
+ * @param list - pointer to display list
+ * @param screenRows - number of rows of client area
+ *
+ * OUT:
+ * list->rows and list->dirty may be reallocated, list->screenRows gets screenRows, list->rowsNumber sets as 0
+ * @return ERR_NOMEM if memory can't be allocated (ERR_NO if successed)
+ */
+ErrorType ReserveDisplayRows(DisplayList * list, int screenRows) {
+    DisplayRow * rows;
+    unsigned char * dirty;
+
+    screenRows = max(0, screenRows);
+    if (screenRows > list->capacity) {
+        rows = (DisplayRow*)realloc(list->rows, (size_t)screenRows * sizeof(DisplayRow));
+        if (rows == NULL)
+            return ERR_NOMEM;
+        list->rows = rows;
+        dirty = (unsigned char*)realloc(list->dirty, (size_t)screenRows);
+        if (dirty == NULL)
+            return ERR_NOMEM;
+        list->dirty = dirty;
+        list->capacity = screenRows;
+    }
+    list->screenRows  = screenRows;
+    list->rowsNumber  = 0;
+    list->dirtyNumber = screenRows;
+    if (screenRows > 0)
+        memset(list->dirty, 1, (size_t)screenRows);
+    return ERR_NO;
+}
+
+/**
+ * Checks whether rows look the same on screen.
+ * IN:
+ * @param first - pointer to row (NULL means empty row)
+ * @param second - pointer to row (NULL means empty row)
+ *
+ * OUT:
+ * @return TRUE if both rows are empty or show the same columns of the same bytes of text
+ */
+BOOL IsSameDisplayRow(DisplayRow const * first, DisplayRow const * second) {
+    BOOL firstEmpty  = (first == NULL || first->columns == 0);
+    BOOL secondEmpty = (second == NULL || second->columns == 0);
+
+    if (firstEmpty || secondEmpty)
+        return firstEmpty && secondEmpty;
+    return first->line == second->line && first->column == second->column && first->columns == second->columns &&
+           first->offset == second->offset && first->length == second->length;
+}
+
+/**
+ * Compares frame with the previous one shown on screen after it's content was moved by specified number of rows.
+ * Rows moved from outside of client area are always changed.
+ * IN:
+ * @param prev - pointer to previous frame
+ * @param shift - number of rows content of client area is moved up by (negative moves it down)
+ *
+ * INOUT:
+ * @param next - pointer to new frame, next->dirty gets flags of it's rows which have to be repainted
+ *
+ * OUT:
+ * @return number of rows which have to be repainted
+ */
+int DiffDisplayList(DisplayList const * prev, DisplayList * next, long long shift) {
+    DisplayRow const * prevRow;
+    DisplayRow const * nextRow;
+    long long prevIndex;
+    int row;
+
+    next->dirtyNumber = 0;
+    for (row = 0; row < next->screenRows; ++row) {
+        prevIndex = row + shift;
+        if (prevIndex < 0 || prevIndex >= prev->screenRows)
+            next->dirty[row] = 1;
+        else {
+            prevRow = (prevIndex < prev->rowsNumber) ? &prev->rows[prevIndex] : NULL;
+            nextRow = (row < next->rowsNumber) ? &next->rows[row] : NULL;
+            next->dirty[row] = !IsSameDisplayRow(prevRow, nextRow);
+        }
+        next->dirtyNumber += next->dirty[row];
+    }
+    return next->dirtyNumber;
+}
+
+/**
+ * Finds the next run of adjacent rows which have to be repainted.
+ * IN:
+ * @param list - pointer to frame compared with the previous one
+ * @param first - number of row to start search from
+ *
+ * OUT:
+ * @param count - gets number of rows in run (0 if there are no changed rows left)
+ * @return number of the first row of run
+ */
+int GetDirtyRows(DisplayList const * list, int first, int * count) {
+    int last;
+
+    while (first < list->screenRows && !list->dirty[first])
+        ++first;
+    for (last = first; last < list->screenRows && list->dirty[last]; ++last)
+        ;
+    *count = last - first;
+    return first;
+}
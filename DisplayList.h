@@ -0,0 +1,34 @@
+#ifndef DISPLAYLIST_H_INCLUDED
+#define DISPLAYLIST_H_INCLUDED
+
+#include "Portable.h"
+#include "Error.h"
+
+// row of client area: part of text line shown in it
+typedef struct {
+    long long line;             // number of text line row belongs to
+    long long column;           // first shown column of line (display column in standard mode)
+    long long columns;          // number of shown columns (0 if row is empty)
+    long long offset;           // index in text of the first byte row is read from
+    long long length;           // number of bytes row is read from
+} DisplayRow;
+
+/* rows of one frame of client area from top to bottom (rows after the last one are empty):
+ * frames are compared by positions of their rows in text, so text is read only for rows which have changed */
+typedef struct {
+    DisplayRow * rows;          // Array of visible rows
+    int rowsNumber;             // Number of items in rows
+    int screenRows;             // Number of rows of client area frame is built for
+    int capacity;               // Number of items memory of rows and dirty is allocated for
+    unsigned char * dirty;      // Array of [screenRows] flags of rows differing from previous frame (see DiffDisplayList)
+    int dirtyNumber;            // Number of set flags in dirty
+} DisplayList;
+
+void InitDisplayList(DisplayList * list);
+void DestroyDisplayList(DisplayList * list);
+ErrorType ReserveDisplayRows(DisplayList * list, int screenRows);
+BOOL IsSameDisplayRow(DisplayRow const * first, DisplayRow const * second);
+int DiffDisplayList(DisplayList const * prev, DisplayList * next, long long shift);
+int GetDirtyRows(DisplayList const * list, int first, int * count);
+
+#endif // DISPLAYLIST_H_INCLUDED
@@ -0,0 +1,332 @@
+#include "DocumentManager.h"
+#include <string.h>
+
+#define INITIAL_DOCUMENTS_CAPACITY 4
+
+/**
+ * Initializes manager without opened documents.
+ * IN:
+ * @param manager - pointer to manager to initialize
+ * @param budget - memory all documents may take in bytes (0 means DEFAULT_DOCUMENTS_BUDGET)
+ *
+ * OUT:
+ * fields of manager are initialized
+ */
+void InitDocumentManager(DocumentManager * manager, long long budget) {
+    memset(manager, 0, sizeof(DocumentManager));
+    manager->current = -1;
+    manager->budget  = (budget > 0) ? budget : DEFAULT_DOCUMENTS_BUDGET;
+}
+
+/**
+ * Closes all documents and frees memory allocated for manager.
+ * IN:
+ * @param manager - pointer to manager to destroy
+ *
+ * OUT:
+ * manager has no documents
+ */
+void DestroyDocumentManager(DocumentManager * manager) {
+    int i;
+
+    if (manager == NULL)
+        return;
+    for (i = 0; i < manager->documentsNumber; ++i) {
+        DestroyTextModel(&manager->documents[i].model);
+        free(manager->documents[i].filename);
+    }
+    free(manager->documents);
+    InitDocumentManager(manager, manager->budget);
+}
+
+/**
+ * Finds document of file with specified name.
+ * IN:
+ * @param manager - pointer to manager
+ * @param filename - name of file (NULL isn't found, blank documents are never the same)
+ *
+ * OUT:
+ * @return number of document (-1 if file isn't opened)
+ */
+static int FindDocument(DocumentManager const * manager, char const * filename) {
+    int i;
+
+    if (filename == NULL)
+        return -1;
+    for (i = 0; i < manager->documentsNumber; ++i) {
+        if (manager->documents[i].filename != NULL && strcmp(manager->documents[i].filename, filename) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * Finds loaded document which has been shown the least recently, the shown document is never found.
+ * IN:
+ * @param manager - pointer to manager
+ * @param untrimmed - TRUE to find only documents which still keep their caches
+ *
+ * OUT:
+ * @return number of document (-1 if there are no such documents)
+ */
+static int FindLeastRecentDocument(DocumentManager const * manager, BOOL untrimmed) {
+    Document const * document;
+    int found = -1;
+    int i;
+
+    for (i = 0; i < manager->documentsNumber; ++i) {
+        document = &manager->documents[i];
+        if (i == manager->current || document->model.stored == NULL || (untrimmed && document->trimmed))
+            continue;
+        if (found < 0 || document->viewed < manager->documents[found].viewed)
+            found = i;
+    }
+    return found;
+}
+
+/**
+ * Finds document which has been shown the most recently except the specified one.
+ * IN:
+ * @param manager - pointer to manager
+ * @param except - number of document to skip
+ *
+ * OUT:
+ * @return number of document (-1 if there are no other documents)
+ */
+static int FindMostRecentDocument(DocumentManager const * manager, int except) {
+    int found = -1;
+    int i;
+
+    for (i = 0; i < manager->documentsNumber; ++i) {
+        if (i != except && (found < 0 || manager->documents[i].viewed > manager->documents[found].viewed))
+            found = i;
+    }
+    return found;
+}
+
+/**
+ * Makes document the shown one.
+ * IN:
+ * @param manager - pointer to manager
+ * @param number - number of document
+ *
+ * OUT:
+ * manager->current gets number, document gets the most recent stamp
+ */
+static void MarkShownDocument(DocumentManager * manager, int number) {
+    manager->current = number;
+    manager->documents[number].viewed  = ++manager->clock;
+    manager->documents[number].trimmed = FALSE;
+}
+
+/**
+ * Opens file as new shown document with settings of previously shown one.
+ * File which is opened already is read again in place of it's document,
+ * blank shown document is replaced with file.
+ * IN:
+ * @param manager - pointer to manager
+ * @param filename - name of file to open (NULL opens blank document)
+ *
+ * OUT:
+ * document of file is shown (previous document stays shown if opening failed)
+ * @return code of error occured during building model (ERR_NO if successed)
+ */
+ErrorType OpenDocument(DocumentManager * manager, char const * filename) {
+    Document * documents;
+    Document opened;
+    ErrorType errorType;
+    char * copy = NULL;
+    int number;
+
+    if (manager == NULL)
+        return ERR_NULL_PTR;
+    if (filename != NULL && (copy = (char*)malloc(strlen(filename) + 1)) == NULL)
+        return ERR_NOMEM;
+    if (copy != NULL)
+        strcpy(copy, filename);
+
+    number = FindDocument(manager, filename);
+    if (number < 0 && manager->current >= 0 && manager->documents[manager->current].filename == NULL)
+        number = manager->current;
+    if (number >= 0) {
+        // unloaded document is read again when it's shown
+        errorType = ERR_NO;
+        if (manager->documents[number].model.stored != NULL)
+            errorType = RebuildTextModel(&manager->documents[number].model, filename);
+        if (errorType == ERR_NO)
+            errorType = ShowDocument(manager, number);
+        if (errorType != ERR_NO) {
+            free(copy);
+            return errorType;
+        }
+        free(manager->documents[number].filename);
+        manager->documents[number].filename = copy;
+        return ERR_NO;
+    }
+
+    if (manager->documentsNumber == manager->capacity) {
+        documents = (Document*)realloc(manager->documents, (size_t)max(INITIAL_DOCUMENTS_CAPACITY, manager->capacity * 2) *
+                                                           sizeof(Document));
+        if (documents == NULL) {
+            free(copy);
+            return ERR_NOMEM;
+        }
+        manager->documents = documents;
+        manager->capacity  = max(INITIAL_DOCUMENTS_CAPACITY, manager->capacity * 2);
+    }
+
+    // new document is built next to the shown one
+    memset(&opened, 0, sizeof(Document));
+    errorType = BuildTextModel(&opened.model, filename);
+    if (errorType != ERR_NO) {
+        free(copy);
+        return errorType;
+    }
+    opened.filename = copy;
+    if (manager->current >= 0)
+        InheritModelSettings(&opened.model, &manager->documents[manager->current].model);
+
+    manager->documents[manager->documentsNumber++] = opened;
+    MarkShownDocument(manager, manager->documentsNumber - 1);
+    EnforceDocumentsBudget(manager);
+    return ERR_NO;
+}
+
+/**
+ * Shows document with settings of previously shown one. Unloaded document is read again
+ * and shown at the position it has been left at.
+ * IN:
+ * @param manager - pointer to manager
+ * @param number - number of document to show
+ *
+ * OUT:
+ * manager->current gets number (it's unchanged if document can't be read)
+ * @return code of error occured during reading document (ERR_NO if successed)
+ */
+ErrorType ShowDocument(DocumentManager * manager, int number) {
+    Document * document;
+    ErrorType errorType;
+
+    if (manager == NULL || number < 0 || number >= manager->documentsNumber)
+        return ERR_NULL_PTR;
+
+    document = &manager->documents[number];
+    if (document->model.stored == NULL) {
+        errorType = ReloadTextModel(&document->model, document->filename);
+        if (errorType != ERR_NO)
+            return errorType;
+    }
+    if (manager->current >= 0 && manager->current != number)
+        InheritModelSettings(&document->model, &manager->documents[manager->current].model);
+
+    // work finished in background while document has been hidden (window is notified about the shown document only)
+    UpdateIndexingProgress(document->model.stored, document->model.displayed);
+    UpdateTrigramIndexing(document->model.stored);
+    UpdateSearchProgress(document->model.stored, document->model.displayed);
+    UpdateFilterProgress(document->model.stored, document->model.displayed);
+    MarkShownDocument(manager, number);
+    EnforceDocumentsBudget(manager);
+    return ERR_NO;
+}
+
+/**
+ * Closes document, the most recently shown of other documents is shown instead of it.
+ * The last document is replaced with blank one, so there's always a document to show.
+ * IN:
+ * @param manager - pointer to manager
+ * @param number - number of document to close
+ *
+ * OUT:
+ * document is removed, numbers of the next documents are decreased
+ * @return code of error occured during showing other document (ERR_NO if successed)
+ */
+ErrorType CloseDocument(DocumentManager * manager, int number) {
+    ErrorType errorType;
+    int next;
+
+    if (manager == NULL || number < 0 || number >= manager->documentsNumber)
+        return ERR_NULL_PTR;
+
+    if (manager->documentsNumber == 1) {
+        errorType = RebuildTextModel(&manager->documents[0].model, NULL);
+        if (errorType != ERR_NO)
+            return errorType;
+        free(manager->documents[0].filename);
+        manager->documents[0].filename = NULL;
+        return ERR_NO;
+    }
+
+    if (number == manager->current) {
+        next = FindMostRecentDocument(manager, number);
+        errorType = ShowDocument(manager, next);
+        if (errorType != ERR_NO)
+            return errorType;
+    }
+
+    DestroyTextModel(&manager->documents[number].model);
+    free(manager->documents[number].filename);
+    memmove(manager->documents + number, manager->documents + number + 1,
+            (size_t)(manager->documentsNumber - number - 1) * sizeof(Document));
+    manager->documentsNumber--;
+    if (manager->current > number)
+        manager->current--;
+    return ERR_NO;
+}
+
+/**
+ * Gives model of shown document.
+ * IN:
+ * @param manager - pointer to manager
+ *
+ * OUT:
+ * @return pointer to model (NULL if nothing is opened)
+ */
+TextModel * GetShownModel(DocumentManager * manager) {
+    return (manager->current >= 0) ? &manager->documents[manager->current].model : NULL;
+}
+
+/**
+ * Gives memory taken by document.
+ * IN:
+ * @param manager - pointer to manager
+ * @param number - number of document
+ *
+ * OUT:
+ * @param memory - gets memory taken by each kind of structures of document
+ * @return memory charged to budget in bytes (see GetTextModelMemory)
+ */
+long long GetDocumentMemory(DocumentManager const * manager, int number, ModelMemory * memory) {
+    return GetTextModelMemory(&manager->documents[number].model, memory);
+}
+
+/**
+ * Brings memory of documents within budget: the least recently shown documents drop their caches first,
+ * then their text and indexes are unloaded. The shown document is never touched, so it may exceed budget alone.
+ * IN:
+ * @param manager - pointer to manager
+ *
+ * OUT:
+ * caches of hidden documents may be dropped, hidden documents may be unloaded
+ * @return memory all documents take after eviction in bytes
+ */
+long long EnforceDocumentsBudget(DocumentManager * manager) {
+    ModelMemory memory;
+    long long total = 0;
+    int victim, i;
+
+    for (i = 0; i < manager->documentsNumber; ++i)
+        total += GetDocumentMemory(manager, i, &memory);
+
+    while (total > manager->budget && (victim = FindLeastRecentDocument(manager, TRUE)) >= 0) {
+        total -= GetDocumentMemory(manager, victim, &memory);
+        TrimTextModel(&manager->documents[victim].model);
+        manager->documents[victim].trimmed = TRUE;
+        total += GetDocumentMemory(manager, victim, &memory);
+    }
+    while (total > manager->budget && (victim = FindLeastRecentDocument(manager, FALSE)) >= 0) {
+        total -= GetDocumentMemory(manager, victim, &memory);
+        UnloadTextModel(&manager->documents[victim].model);
+        total += GetDocumentMemory(manager, victim, &memory);
+    }
+    return total;
+}
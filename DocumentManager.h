@@ -0,0 +1,37 @@
+#ifndef DOCUMENTMANAGER_H_INCLUDED
+#define DOCUMENTMANAGER_H_INCLUDED
+
+#include "Portable.h"
+#include "Error.h"
+#include "TextModel.h"
+
+#define DEFAULT_DOCUMENTS_BUDGET (256LL << 20)  // memory opened documents may take unless other budget is set
+
+typedef struct {
+    TextModel model;            // Model of document (model.stored is NULL while document is unloaded)
+    char * filename;            // Name of opened file (NULL for blank document)
+    long long viewed;           // Stamp of the last showing of document (the biggest one is the most recent)
+    BOOL trimmed;               // Set if caches of document have been dropped since it's been shown
+} Document;
+
+/* files opened at once, one of them is shown: all documents share memory budget,
+ * when it's exceeded the least recently shown documents drop their caches, then their text and indexes */
+typedef struct {
+    Document * documents;       // Array of opened documents in order of opening
+    int documentsNumber;        // Number of items in documents
+    int capacity;               // Number of items memory of documents is allocated for
+    int current;                // Number of shown document (-1 if nothing is opened)
+    long long budget;           // Memory all documents may take in bytes
+    long long clock;            // Stamp given to the next shown document
+} DocumentManager;
+
+void InitDocumentManager(DocumentManager * manager, long long budget);
+void DestroyDocumentManager(DocumentManager * manager);
+ErrorType OpenDocument(DocumentManager * manager, char const * filename);
+ErrorType ShowDocument(DocumentManager * manager, int number);
+ErrorType CloseDocument(DocumentManager * manager, int number);
+TextModel * GetShownModel(DocumentManager * manager);
+long long GetDocumentMemory(DocumentManager const * manager, int number, ModelMemory * memory);
+long long EnforceDocumentsBudget(DocumentManager * manager);
+
+#endif // DOCUMENTMANAGER_H_INCLUDED
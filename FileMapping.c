@@ -0,0 +1,278 @@
+// 64-bit file offsets on 32-bit POSIX systems
+#define _FILE_OFFSET_BITS 64
+
+#include "FileMapping.h"
+#include <stdint.h>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/**
+ * Sets mapping structure to the state of nothing mapped.
+ * IN:
+ * @param mapping - pointer to mapping structure to reset
+ */
+static void ResetMapping(FileMapping * mapping) {
+    mapping->view = NULL;
+    mapping->size = 0;
+#ifdef _WIN32
+    mapping->hFile    = INVALID_HANDLE_VALUE;
+    mapping->hMapping = NULL;
+#else
+    mapping->fileDescriptor = -1;
+#endif
+}
+
+/**
+ * Maps file with specified name into memory for reading.
+ * Does not print errors: caller is expected to fall back to regular reading if mapping fails.
+ * IN:
+ * @param mapping - pointer to structure to save mapping information in
+ * @param filename - name of file to map
+ *
+ * OUT:
+ * mapping->view gets pointer to read-only view of entire file
+ * mapping->size gets size of file in bytes
+ * @return ERR_OPEN_FILE if file can't be opened,
+ * ERR_MAP_FILE if file is empty, too big or can't be mapped (ERR_NO if successed)
+ */
+ErrorType MapFile(FileMapping * mapping, char const * filename) {
+#ifdef _WIN32
+    LARGE_INTEGER fileSize;
+#else
+    struct stat fileStat;
+    void * view;
+#endif
+
+    if (mapping == NULL)
+        return ERR_NULL_PTR;
+    ResetMapping(mapping);
+    if (filename == NULL)
+        return ERR_OPEN_FILE;
+
+#ifdef _WIN32
+    // share writing to allow viewing files which are still being written
+    mapping->hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapping->hFile == INVALID_HANDLE_VALUE)
+        return ERR_OPEN_FILE;
+
+    // file bigger than address space can't be viewed at once
+    if (!GetFileSizeEx(mapping->hFile, &fileSize) ||
+        fileSize.QuadPart <= 0 || (unsigned long long)fileSize.QuadPart > SIZE_MAX) {
+        UnmapFile(mapping);
+        return ERR_MAP_FILE;
+    }
+
+    mapping->hMapping = CreateFileMappingA(mapping->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping->hMapping == NULL) {
+        UnmapFile(mapping);
+        return ERR_MAP_FILE;
+    }
+
+    mapping->view = (char const *)MapViewOfFile(mapping->hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (mapping->view == NULL) {
+        UnmapFile(mapping);
+        return ERR_MAP_FILE;
+    }
+    mapping->size = fileSize.QuadPart;
+#else
+    mapping->fileDescriptor = open(filename, O_RDONLY);
+    if (mapping->fileDescriptor < 0)
+        return ERR_OPEN_FILE;
+
+    if (fstat(mapping->fileDescriptor, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) ||
+        fileStat.st_size <= 0 || (unsigned long long)fileStat.st_size > SIZE_MAX) {
+        UnmapFile(mapping);
+        return ERR_MAP_FILE;
+    }
+
+    view = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, mapping->fileDescriptor, 0);
+    if (view == MAP_FAILED) {
+        UnmapFile(mapping);
+        return ERR_MAP_FILE;
+    }
+    mapping->view = (char const *)view;
+    mapping->size = (long long)fileStat.st_size;
+#endif
+
+    return ERR_NO;
+}
+
+/**
+ * Unmaps file view and closes all handles of mapping.
+ * IN:
+ * @param mapping - pointer to mapping structure (may be partially initialized by MapFile)
+ *
+ * OUT:
+ * mapping gets state of nothing mapped
+ */
+void UnmapFile(FileMapping * mapping) {
+    if (mapping == NULL)
+        return;
+
+#ifdef _WIN32
+    if (mapping->view != NULL)
+        UnmapViewOfFile((LPCVOID)mapping->view);
+    if (mapping->hMapping != NULL)
+        CloseHandle(mapping->hMapping);
+    if (mapping->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(mapping->hFile);
+#else
+    if (mapping->view != NULL)
+        munmap((void *)mapping->view, (size_t)mapping->size);
+    if (mapping->fileDescriptor >= 0)
+        close(mapping->fileDescriptor);
+#endif
+
+    ResetMapping(mapping);
+}
+
+/**
+ * Maps file again if it has grown since it has been mapped, so the view covers the whole file.
+ * Files which are being written can't be truncated while they're mapped on Windows,
+ * on POSIX systems truncated file keeps it's previous view.
+ * IN:
+ * @param mapping - pointer to mapping structure of mapped file
+ *
+ * OUT:
+ * mapping->view, mapping->size get new view and size of file if it has grown
+ * @return ERR_MAP_FILE if grown file can't be mapped, previous view is kept then (ERR_NO if successed)
+ */
+ErrorType RemapFile(FileMapping * mapping) {
+#ifdef _WIN32
+    LARGE_INTEGER fileSize;
+    HANDLE hMapping;
+    char const * view;
+#else
+    struct stat fileStat;
+    void * view;
+#endif
+
+    if (mapping == NULL || mapping->view == NULL)
+        return ERR_NULL_PTR;
+
+#ifdef _WIN32
+    if (!GetFileSizeEx(mapping->hFile, &fileSize) || (unsigned long long)fileSize.QuadPart > SIZE_MAX)
+        return ERR_MAP_FILE;
+    if (fileSize.QuadPart <= mapping->size)
+        return ERR_NO;
+
+    // the new view is created before the old one is released, so data stays available on failure
+    hMapping = CreateFileMappingA(mapping->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL)
+        return ERR_MAP_FILE;
+    view = (char const *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(hMapping);
+        return ERR_MAP_FILE;
+    }
+    UnmapViewOfFile((LPCVOID)mapping->view);
+    CloseHandle(mapping->hMapping);
+    mapping->hMapping = hMapping;
+    mapping->view = view;
+    mapping->size = fileSize.QuadPart;
+#else
+    if (fstat(mapping->fileDescriptor, &fileStat) != 0 || (unsigned long long)fileStat.st_size > SIZE_MAX)
+        return ERR_MAP_FILE;
+    if ((long long)fileStat.st_size <= mapping->size)
+        return ERR_NO;
+
+    view = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, mapping->fileDescriptor, 0);
+    if (view == MAP_FAILED)
+        return ERR_MAP_FILE;
+    munmap((void *)mapping->view, (size_t)mapping->size);
+    mapping->view = (char const *)view;
+    mapping->size = (long long)fileStat.st_size;
+#endif
+
+    return ERR_NO;
+}
+
+/**
+ * Sets position of file stream with 64-bit offset.
+ * IN:
+ * @param file - file stream
+ * @param offset - offset from origin in bytes
+ * @param origin - SEEK_SET, SEEK_CUR or SEEK_END
+ *
+ * OUT:
+ * @return 0 if successed, non-zero value else
+ */
+int SeekFile(FILE * file, long long offset, int origin) {
+#if defined(_MSC_VER)
+    return _fseeki64(file, offset, origin);
+#elif defined(__MINGW32__)
+    return fseeko64(file, (off64_t)offset, origin);
+#else
+    return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+/**
+ * Gives position of file stream as 64-bit offset.
+ * IN:
+ * @param file - file stream
+ *
+ * OUT:
+ * @return offset from the beginning of file in bytes (-1 if failed)
+ */
+long long TellFile(FILE * file) {
+#if defined(_MSC_VER)
+    return _ftelli64(file);
+#elif defined(__MINGW32__)
+    return (long long)ftello64(file);
+#else
+    return (long long)ftello(file);
+#endif
+}
+
+/**
+ * Reads part of file from specified position.
+ * IN:
+ * @param file - file stream opened for binary reading
+ * @param offset - position of the first byte to read
+ * @param size - number of bytes to read
+ *
+ * OUT:
+ * @param buffer - gets read bytes
+ * @return 0 if all bytes are read, non-zero value else
+ */
+int ReadFileRange(FILE * file, long long offset, void * buffer, size_t size) {
+    if (SeekFile(file, offset, SEEK_SET) != 0)
+        return -1;
+    return fread(buffer, sizeof(char), size, file) == size ? 0 : -1;
+}
+
+/**
+ * Gives size and time of the last modification of file, they show whether data derived from file is stale.
+ * IN:
+ * @param filename - name of file
+ *
+ * OUT:
+ * @param size - gets size of file in bytes
+ * @param modified - gets time of the last modification (units depend on system)
+ * @return ERR_OPEN_FILE if file attributes can't be read (ERR_NO if successed)
+ */
+ErrorType GetFileStamp(char const * filename, long long * size, long long * modified) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+    if (filename == NULL || !GetFileAttributesExA(filename, GetFileExInfoStandard, &attributes))
+        return ERR_OPEN_FILE;
+    *size     = ((long long)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    *modified = ((long long)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat fileStat;
+
+    if (filename == NULL || stat(filename, &fileStat) != 0)
+        return ERR_OPEN_FILE;
+    *size     = (long long)fileStat.st_size;
+    *modified = (long long)fileStat.st_mtime;
+#endif
+    return ERR_NO;
+}
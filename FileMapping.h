@@ -0,0 +1,28 @@
+#ifndef FILEMAPPING_H_INCLUDED
+#define FILEMAPPING_H_INCLUDED
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+#include "Error.h"
+
+typedef struct {
+    char const * view;      // Read-only view of the entire file (NULL if nothing mapped)
+    long long size;         // Size of mapped view in bytes
+#ifdef _WIN32
+    HANDLE hFile;           // Handle of mapped file
+    HANDLE hMapping;        // Handle of file mapping object
+#else
+    int fileDescriptor;     // Descriptor of mapped file
+#endif
+} FileMapping;
+
+ErrorType MapFile(FileMapping * mapping, char const * filename);
+ErrorType RemapFile(FileMapping * mapping);
+void UnmapFile(FileMapping * mapping);
+int SeekFile(FILE * file, long long offset, int origin);
+long long TellFile(FILE * file);
+int ReadFileRange(FILE * file, long long offset, void * buffer, size_t size);
+ErrorType GetFileStamp(char const * filename, long long * size, long long * modified);
+
+#endif // FILEMAPPING_H_INCLUDED
@@ -0,0 +1,610 @@
+#include "Highlighter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+
+struct tag_HighlightLine {
+    long long line;             // number of tokenized line (-1 if slot is empty)
+    TokenSpan tokens[MAX_LINE_TOKENS];      // tokens of line in order of their offsets
+    int tokensNumber;           // number of items in tokens
+    int newer;                  // neighbour slot used later (-1 for the newest one)
+    int older;                  // neighbour slot used earlier (-1 for the oldest one)
+    int next;                   // next slot in hash chain (-1 for the last one)
+};
+
+typedef struct {
+    char const * word;
+    TokenKind kind;
+} LevelWord;
+
+// words of log levels, upper case words are levels anywhere, other ones only as values of level keys
+static LevelWord const levelWords[] = {
+    { "FATAL", TOKEN_ERROR }, { "ERROR", TOKEN_ERROR }, { "ERR", TOKEN_ERROR }, { "CRITICAL", TOKEN_ERROR },
+    { "CRIT", TOKEN_ERROR }, { "SEVERE", TOKEN_ERROR }, { "PANIC", TOKEN_ERROR }, { "EMERG", TOKEN_ERROR },
+    { "ALERT", TOKEN_ERROR }, { "WARNING", TOKEN_WARNING }, { "WARN", TOKEN_WARNING }, { "INFO", TOKEN_INFO },
+    { "NOTICE", TOKEN_INFO }, { "DEBUG", TOKEN_DEBUG }, { "TRACE", TOKEN_DEBUG }, { "VERBOSE", TOKEN_DEBUG },
+    { "FINE", TOKEN_DEBUG }, { "FINER", TOKEN_DEBUG }, { "FINEST", TOKEN_DEBUG }
+};
+static char const * const levelKeys[] = { "level", "lvl", "severity", "loglevel", "log.level" };
+static char const * const months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+/**
+ * Initializes highlighter without tokenized lines (memory is allocated when the first line is tokenized).
+ * IN:
+ * @param highlighter - pointer to highlighter to initialize
+ * @param read - function reading lines
+ * @param source - source of text passed to read
+ */
+void InitHighlighter(Highlighter * highlighter, LineTextReader read, void * source) {
+    memset(highlighter, 0, sizeof(Highlighter));
+    highlighter->read      = read;
+    highlighter->source    = source;
+    highlighter->stateLine = -1;
+}
+
+/**
+ * Frees memory allocated for tokens and checkpoints, highlighter can be used afterwards.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ */
+void DestroyHighlighter(Highlighter * highlighter) {
+    if (highlighter == NULL)
+        return;
+    free(highlighter->lines);
+    free(highlighter->buckets);
+    free(highlighter->checkpoints);
+    highlighter->lines             = NULL;
+    highlighter->buckets           = NULL;
+    highlighter->checkpoints       = NULL;
+    highlighter->checkpointsNumber = 0;
+    highlighter->stateLine         = -1;
+}
+
+/**
+ * Gives memory allocated for tokens and checkpoints.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ *
+ * OUT:
+ * @return size of memory in bytes
+ */
+size_t GetHighlighterMemory(Highlighter const * highlighter) {
+    size_t size = (size_t)highlighter->checkpointsNumber;
+
+    if (highlighter->lines != NULL)
+        size += HIGHLIGHT_CACHE_SIZE * sizeof(HighlightLine) + (highlighter->bucketsMask + 1) * sizeof(int);
+    return size;
+}
+
+/**
+ * Removes slot from list of slots ordered by the time of use.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ * @param slot - number of slot in the list
+ */
+static void UnlinkLine(Highlighter * highlighter, int slot) {
+    HighlightLine * item = &highlighter->lines[slot];
+
+    if (item->newer >= 0)
+        highlighter->lines[item->newer].older = item->older;
+    else
+        highlighter->newest = item->older;
+    if (item->older >= 0)
+        highlighter->lines[item->older].newer = item->newer;
+    else
+        highlighter->oldest = item->newer;
+}
+
+/**
+ * Puts slot into list of slots ordered by the time of use.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ * @param slot - number of slot out of the list
+ * @param newest - non-zero to put slot as the most recently used one, 0 to put it as the first to reuse
+ */
+static void LinkLine(Highlighter * highlighter, int slot, int newest) {
+    HighlightLine * item = &highlighter->lines[slot];
+
+    if (newest) {
+        item->newer = -1;
+        item->older = highlighter->newest;
+        if (highlighter->newest >= 0)
+            highlighter->lines[highlighter->newest].newer = slot;
+        else
+            highlighter->oldest = slot;
+        highlighter->newest = slot;
+    }
+    else {
+        item->older = -1;
+        item->newer = highlighter->oldest;
+        if (highlighter->oldest >= 0)
+            highlighter->lines[highlighter->oldest].older = slot;
+        else
+            highlighter->newest = slot;
+        highlighter->oldest = slot;
+    }
+}
+
+/**
+ * Removes slot from hash chain of it's line.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ * @param slot - number of slot keeping a line
+ */
+static void UnhashLine(Highlighter * highlighter, int slot) {
+    int * link = &highlighter->buckets[highlighter->lines[slot].line & highlighter->bucketsMask];
+
+    while (*link != slot)
+        link = &highlighter->lines[*link].next;
+    *link = highlighter->lines[slot].next;
+}
+
+/**
+ * Allocates empty slots of tokenized lines.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ *
+ * OUT:
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL AllocateLines(Highlighter * highlighter) {
+    int bucketsNumber = HIGHLIGHT_CACHE_SIZE * 2;   // hash table is kept at most half full
+    int i;
+
+    highlighter->lines   = (HighlightLine*)malloc(HIGHLIGHT_CACHE_SIZE * sizeof(HighlightLine));
+    highlighter->buckets = (int*)malloc(bucketsNumber * sizeof(int));
+    if (highlighter->lines == NULL || highlighter->buckets == NULL) {
+        free(highlighter->lines);
+        free(highlighter->buckets);
+        highlighter->lines   = NULL;
+        highlighter->buckets = NULL;
+        return FALSE;
+    }
+    highlighter->bucketsMask = bucketsNumber - 1;
+    for (i = 0; i < bucketsNumber; ++i)
+        highlighter->buckets[i] = -1;
+    highlighter->newest = highlighter->oldest = -1;
+    for (i = 0; i < HIGHLIGHT_CACHE_SIZE; ++i) {
+        highlighter->lines[i].line = -1;
+        LinkLine(highlighter, i, 1);
+    }
+    return TRUE;
+}
+
+/**
+ * Forgets tokens and states of lines which have changed (when text has grown).
+ * IN:
+ * @param highlighter - pointer to highlighter
+ * @param firstLine - the first changed line (0 forgets all lines and frees their memory)
+ *
+ * OUT:
+ * slots of lines starting from firstLine are emptied, checkpoints after firstLine are unknown
+ */
+void ForgetHighlightedLines(Highlighter * highlighter, long long firstLine) {
+    long long checkpoint;
+    int slot;
+
+    if (firstLine <= 0) {
+        DestroyHighlighter(highlighter);
+        return;
+    }
+    for (slot = 0; highlighter->lines != NULL && slot < HIGHLIGHT_CACHE_SIZE; ++slot) {
+        if (highlighter->lines[slot].line >= firstLine) {
+            UnhashLine(highlighter, slot);
+            highlighter->lines[slot].line = -1;
+            UnlinkLine(highlighter, slot);
+            LinkLine(highlighter, slot, 0);
+        }
+    }
+    // state at checkpoint depends on lines before it only
+    checkpoint = firstLine / HIGHLIGHT_CHECKPOINT_STEP + 1;
+    if (checkpoint < highlighter->checkpointsNumber)
+        memset(highlighter->checkpoints + checkpoint, 0, (size_t)(highlighter->checkpointsNumber - checkpoint));
+    if (highlighter->stateLine > firstLine)
+        highlighter->stateLine = -1;
+}
+
+/**
+ * Counts digits starting at position.
+ * IN:
+ * @param text - text of line
+ * @param length - length of text
+ * @param position - index of the first symbol to check
+ *
+ * OUT:
+ * @return number of digits in a row
+ */
+static int CountDigits(char const * text, int length, int position) {
+    int end = position;
+
+    while (end < length && text[end] >= '0' && text[end] <= '9')
+        end++;
+    return end - position;
+}
+
+/**
+ * Measures time starting at position: 12:34, 12:34:56, 12:34:56.789 optionally followed by zone (Z, +0200, +02:00).
+ * IN:
+ * @param text - text of line
+ * @param length - length of text
+ * @param position - index of the first symbol of time
+ *
+ * OUT:
+ * @return length of time (0 if there's no time at position)
+ */
+static int MatchTime(char const * text, int length, int position) {
+    int end = position + CountDigits(text, length, position);
+
+    if (end - position < 1 || end - position > 2 || end + 3 > length || text[end] != ':' || CountDigits(text, length, end + 1) != 2)
+        return 0;
+    end += 3;
+    if (end + 3 <= length && text[end] == ':' && CountDigits(text, length, end + 1) == 2) {
+        end += 3;
+        if (end + 1 < length && (text[end] == '.' || text[end] == ',') && CountDigits(text, length, end + 1) > 0)
+            end += 1 + CountDigits(text, length, end + 1);
+    }
+
+    if (end < length && text[end] == 'Z')
+        end++;
+    else if (end + 3 <= length && (text[end] == '+' || text[end] == '-') && CountDigits(text, length, end + 1) >= 2) {
+        end += 1 + CountDigits(text, length, end + 1);
+        if (end + 3 <= length && text[end] == ':' && CountDigits(text, length, end + 1) == 2)
+            end += 3;
+    }
+    return end - position;
+}
+
+/**
+ * Measures date or time starting at position: 2024-01-31 or 2024/01/31 optionally followed by time
+ * after 'T' or space, syslog date with time (Jan 31 12:34:56) or time alone.
+ * IN:
+ * @param text - text of line
+ * @param length - length of text
+ * @param position - index of the first symbol of timestamp
+ *
+ * OUT:
+ * @return length of timestamp (0 if there's no timestamp at position)
+ */
+static int MatchTimestamp(char const * text, int length, int position) {
+    int date = 0, time, day, month;
+
+    if (position + 10 <= length && CountDigits(text, length, position) == 4 &&
+        (text[position + 4] == '-' || text[position + 4] == '/') && CountDigits(text, length, position + 5) == 2 &&
+        text[position + 7] == text[position + 4] && CountDigits(text, length, position + 8) == 2)
+        date = 10;
+
+    // syslog date has no year, so it's taken with time only
+    for (month = 0; date == 0 && month < 12 && position + 4 < length; ++month) {
+        if (strncmp(text + position, months[month], 3) != 0 || text[position + 3] != ' ')
+            continue;
+        day = position + ((text[position + 4] == ' ') ? 5 : 4);
+        if (CountDigits(text, length, day) < 1 || CountDigits(text, length, day) > 2 ||
+            day + CountDigits(text, length, day) >= length || text[day + CountDigits(text, length, day)] != ' ')
+            break;
+        time = MatchTime(text, length, day + CountDigits(text, length, day) + 1);
+        return (time > 0) ? day + CountDigits(text, length, day) + 1 + time - position : 0;
+    }
+
+    if (date == 0)
+        return MatchTime(text, length, position);
+    if (position + date + 1 < length && (text[position + date] == 'T' || text[position + date] == ' ') &&
+        (time = MatchTime(text, length, position + date + 1)) > 0)
+        return date + 1 + time;
+    return date;
+}
+
+/**
+ * Checks whether symbol may be a part of word.
+ * IN:
+ * @param symbol - symbol to check
+ *
+ * OUT:
+ * @return TRUE if symbol is letter, digit or underscore
+ */
+static BOOL IsWordSymbol(char symbol) {
+    return isalnum((unsigned char)symbol) || symbol == '_';
+}
+
+/**
+ * Checks whether symbol may be a part of key of key=value pair.
+ * IN:
+ * @param symbol - symbol to check
+ *
+ * OUT:
+ * @return TRUE if symbol is letter, digit, underscore, dot or dash
+ */
+static BOOL IsKeySymbol(char symbol) {
+    return IsWordSymbol(symbol) || symbol == '.' || symbol == '-';
+}
+
+/**
+ * Finds level of log entry named by word.
+ * IN:
+ * @param word - text of word
+ * @param length - length of word
+ * @param anyCase - TRUE to match words in any case, FALSE to match upper case words only
+ *
+ * OUT:
+ * @return kind of level (TOKEN_PLAIN if word isn't level)
+ */
+static TokenKind MatchLevel(char const * word, int length, BOOL anyCase) {
+    size_t i;
+    int j;
+
+    if (length < 3 || length > 8)
+        return TOKEN_PLAIN;
+    for (i = 0; i < sizeof(levelWords) / sizeof(levelWords[0]); ++i) {
+        if ((int)strlen(levelWords[i].word) != length)
+            continue;
+        for (j = 0; j < length; ++j) {
+            if (word[j] != levelWords[i].word[j] && (!anyCase || toupper((unsigned char)word[j]) != levelWords[i].word[j]))
+                break;
+        }
+        if (j == length)
+            return levelWords[i].kind;
+    }
+    return TOKEN_PLAIN;
+}
+
+/**
+ * Checks whether key names level of log entry (level=error).
+ * IN:
+ * @param key - text of key
+ * @param length - length of key
+ *
+ * OUT:
+ * @return TRUE if value of key is level
+ */
+static BOOL IsLevelKey(char const * key, int length) {
+    size_t i;
+    int j;
+
+    for (i = 0; i < sizeof(levelKeys) / sizeof(levelKeys[0]); ++i) {
+        if ((int)strlen(levelKeys[i]) != length)
+            continue;
+        for (j = 0; j < length && tolower((unsigned char)key[j]) == levelKeys[i][j]; ++j)
+            ;
+        if (j == length)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * Adds token to tokens of line.
+ * IN:
+ * @param offset - offset of token from line beginning
+ * @param length - length of token
+ * @param kind - kind of token
+ *
+ * INOUT:
+ * @param tokens - array of [MAX_LINE_TOKENS] tokens of line
+ * @param tokensNumber - number of items in tokens, it's increased
+ */
+static void AddToken(int offset, int length, TokenKind kind, TokenSpan * tokens, int * tokensNumber) {
+    tokens[*tokensNumber].offset = offset;
+    tokens[*tokensNumber].length = length;
+    tokens[*tokensNumber].kind   = kind;
+    (*tokensNumber)++;
+}
+
+/**
+ * Splits beginning of line into tokens: timestamps, levels and key=value pairs. Line with timestamp or level
+ * starts new log entry, other lines continue entry (lines continuing errors and warnings take their color).
+ * IN:
+ * @param text - text of line beginning
+ * @param length - length of text (at most HIGHLIGHT_PREFIX_SIZE)
+ * @param lineSize - size of line content
+ * @param entry - state of tokenizer at line beginning: level of entry line continues
+ *
+ * OUT:
+ * @param tokens - gets tokens of line in order of their offsets (at most MAX_LINE_TOKENS)
+ * @param state - gets state of tokenizer at the beginning of the next line
+ * @return number of tokens
+ */
+static int TokenizeLine(char const * text, int length, long long lineSize, TokenKind entry, TokenSpan * tokens,
+                        TokenKind * state) {
+    int tokensNumber = 0;
+    int position = 0, end, value;
+    TokenKind level = TOKEN_PLAIN;
+    TokenKind kind;
+    BOOL started = FALSE;       // line starts new entry
+
+    while (position < length && tokensNumber < MAX_LINE_TOKENS - 1) {
+        // tokens start at word boundaries only
+        if (!IsKeySymbol(text[position]) || (position > 0 && IsWordSymbol(text[position - 1]))) {
+            position++;
+            continue;
+        }
+
+        end = MatchTimestamp(text, length, position);
+        if (end > 0) {
+            AddToken(position, end, TOKEN_TIMESTAMP, tokens, &tokensNumber);
+            started = TRUE;
+            position += end;
+            continue;
+        }
+
+        for (end = position; end < length && IsKeySymbol(text[end]); ++end)
+            ;
+        if (end < length && text[end] == '=') {
+            // quoted value ends at closing quote, other value ends at space
+            value = end + 1;
+            if (value < length && text[value] == '"') {
+                for (++value; value < length && text[value] != '"'; ++value) {
+                    if (text[value] == '\\')
+                        value++;
+                }
+                value = min(value + 1, length);
+            }
+            else {
+                while (value < length && !isspace((unsigned char)text[value]))
+                    value++;
+            }
+            kind = TOKEN_PLAIN;
+            if (level == TOKEN_PLAIN && IsLevelKey(text + position, end - position))
+                kind = MatchLevel(text + end + 1, value - end - 1, TRUE);
+            if (kind != TOKEN_PLAIN) {
+                level   = kind;
+                started = TRUE;
+            }
+            else
+                kind = TOKEN_VALUE;
+            AddToken(position, end - position, TOKEN_KEY, tokens, &tokensNumber);
+            if (value > end + 1)
+                AddToken(end + 1, value - end - 1, kind, tokens, &tokensNumber);
+            position = value;
+            continue;
+        }
+
+        // only the first level of line is it's level, the next ones are words of message
+        for (end = position; end < length && IsWordSymbol(text[end]); ++end)
+            ;
+        if (level == TOKEN_PLAIN && (kind = MatchLevel(text + position, end - position, FALSE)) != TOKEN_PLAIN) {
+            AddToken(position, end - position, kind, tokens, &tokensNumber);
+            level   = kind;
+            started = TRUE;
+        }
+        // dots and dashes aren't parts of words, they're passed alone
+        position = max(end, position + 1);
+    }
+
+    *state = started ? level : entry;
+    if (!started && (entry == TOKEN_ERROR || entry == TOKEN_WARNING) && lineSize > 0) {
+        tokensNumber = 0;
+        AddToken(0, (int)min(lineSize, INT_MAX), entry, tokens, &tokensNumber);
+    }
+    return tokensNumber;
+}
+
+/**
+ * Tokenizes line to find state of tokenizer after it.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ * @param lineNumber - number of line
+ * @param entry - state of tokenizer at line beginning
+ *
+ * OUT:
+ * @return state of tokenizer at the beginning of the next line (entry if line can't be read)
+ */
+static TokenKind PassLine(Highlighter * highlighter, long long lineNumber, TokenKind entry) {
+    TokenSpan tokens[MAX_LINE_TOKENS];
+    long long length = HIGHLIGHT_PREFIX_SIZE, lineSize;
+    char const * text;
+    TokenKind state;
+
+    text = highlighter->read(highlighter->source, lineNumber, &length, &lineSize);
+    if (text == NULL)
+        return entry;
+    TokenizeLine(text, (int)length, lineSize, entry, tokens, &state);
+    highlighter->stats.linesPassed++;
+    return state;
+}
+
+/**
+ * Finds state of tokenizer at the beginning of line: lines are passed from the nearest known checkpoint,
+ * state of the last tokenized line or from the line HIGHLIGHT_RESYNC_LINES lines above
+ * (entries are rarely that long, so they start there in plain state).
+ * IN:
+ * @param highlighter - pointer to highlighter
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * checkpoints of passed lines become known
+ * @return state at the beginning of line
+ */
+static TokenKind FindLineState(Highlighter * highlighter, long long lineNumber) {
+    long long checkpoint = lineNumber / HIGHLIGHT_CHECKPOINT_STEP;
+    long long first = max(0, lineNumber - HIGHLIGHT_RESYNC_LINES) / HIGHLIGHT_CHECKPOINT_STEP;
+    long long number, line;
+    unsigned char * checkpoints;
+    TokenKind state;
+
+    // checkpoints are counted as lines are shown, since index of file may be built in background
+    if (checkpoint >= highlighter->checkpointsNumber) {
+        number = max(checkpoint + 1, highlighter->checkpointsNumber * 2);
+        checkpoints = (unsigned char*)realloc(highlighter->checkpoints, (size_t)number);
+        if (checkpoints == NULL)
+            return TOKEN_PLAIN;
+        memset(checkpoints + highlighter->checkpointsNumber, 0, (size_t)(number - highlighter->checkpointsNumber));
+        highlighter->checkpoints       = checkpoints;
+        highlighter->checkpointsNumber = number;
+    }
+
+    while (checkpoint > first && highlighter->checkpoints[checkpoint] == 0)
+        checkpoint--;
+    line  = checkpoint * HIGHLIGHT_CHECKPOINT_STEP;
+    state = (highlighter->checkpoints[checkpoint] != 0) ? (TokenKind)(highlighter->checkpoints[checkpoint] - 1) : TOKEN_PLAIN;
+    if (highlighter->stateLine >= line && highlighter->stateLine <= lineNumber) {
+        line  = highlighter->stateLine;
+        state = highlighter->state;
+    }
+
+    for (; line < lineNumber; ++line) {
+        if (line % HIGHLIGHT_CHECKPOINT_STEP == 0)
+            highlighter->checkpoints[line / HIGHLIGHT_CHECKPOINT_STEP] = (unsigned char)(state + 1);
+        state = PassLine(highlighter, line, state);
+    }
+    if (lineNumber % HIGHLIGHT_CHECKPOINT_STEP == 0)
+        highlighter->checkpoints[lineNumber / HIGHLIGHT_CHECKPOINT_STEP] = (unsigned char)(state + 1);
+    return state;
+}
+
+/**
+ * Gives tokens of line, line is tokenized if it isn't cached.
+ * The least recently used line is dropped if all slots are taken.
+ * IN:
+ * @param highlighter - pointer to highlighter
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @param tokensNumber - gets number of tokens
+ * @return pointer to tokens in order of their offsets, valid until the next call (NULL if line can't be tokenized)
+ */
+TokenSpan const * GetLineTokens(Highlighter * highlighter, long long lineNumber, int * tokensNumber) {
+    HighlightLine * item;
+    long long length = HIGHLIGHT_PREFIX_SIZE, lineSize;
+    char const * text;
+    TokenKind entry;
+    int * bucket;
+    int slot;
+
+    *tokensNumber = 0;
+    if (lineNumber < 0 || (highlighter->lines == NULL && !AllocateLines(highlighter)))
+        return NULL;
+
+    bucket = &highlighter->buckets[lineNumber & highlighter->bucketsMask];
+    for (slot = *bucket; slot >= 0; slot = highlighter->lines[slot].next) {
+        if (highlighter->lines[slot].line == lineNumber) {
+            highlighter->stats.hits++;
+            UnlinkLine(highlighter, slot);
+            LinkLine(highlighter, slot, 1);
+            *tokensNumber = highlighter->lines[slot].tokensNumber;
+            return highlighter->lines[slot].tokens;
+        }
+    }
+
+    entry = FindLineState(highlighter, lineNumber);
+    text  = highlighter->read(highlighter->source, lineNumber, &length, &lineSize);
+    if (text == NULL)
+        return NULL;
+
+    // the least recently used line is replaced
+    highlighter->stats.misses++;
+    slot = highlighter->oldest;
+    item = &highlighter->lines[slot];
+    UnlinkLine(highlighter, slot);
+    if (item->line >= 0)
+        UnhashLine(highlighter, slot);
+    item->tokensNumber = TokenizeLine(text, (int)length, lineSize, entry, item->tokens, &highlighter->state);
+    item->line = lineNumber;
+    item->next = *bucket;
+    *bucket = slot;
+    LinkLine(highlighter, slot, 1);
+
+    // the next row usually shows the next line, so it's state is known right away
+    highlighter->stateLine = lineNumber + 1;
+    *tokensNumber = item->tokensNumber;
+    return item->tokens;
+}
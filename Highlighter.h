@@ -0,0 +1,77 @@
+#ifndef HIGHLIGHTER_H_INCLUDED
+#define HIGHLIGHTER_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+
+#define HIGHLIGHT_PREFIX_SIZE 1024      // bytes at line beginning which are tokenized, the rest of line is plain text
+#define MAX_LINE_TOKENS 32              // tokens kept per line, the rest of line is plain text
+#define HIGHLIGHT_CACHE_SIZE 1024       // number of lines tokens are kept for
+#define HIGHLIGHT_CHECKPOINT_STEP 64    // state of tokenizer is kept at the beginning of every this line
+#define HIGHLIGHT_RESYNC_LINES 256      // lines passed at most to find state of line far from known checkpoints
+
+// kinds of highlighted tokens of log lines
+typedef enum {
+    TOKEN_PLAIN,
+    TOKEN_TIMESTAMP,            // date and time: 2024-01-31, 12:34:56.789, 2024-01-31T12:34:56Z, Jan 31 12:34:56
+    TOKEN_ERROR,                // error level: ERROR, FATAL, CRITICAL... (and lines continuing error entry)
+    TOKEN_WARNING,              // warning level: WARN, WARNING (and lines continuing warning entry)
+    TOKEN_INFO,                 // info level: INFO, NOTICE
+    TOKEN_DEBUG,                // debug level: DEBUG, TRACE, VERBOSE...
+    TOKEN_KEY,                  // key of key=value pair
+    TOKEN_VALUE,                // value of key=value pair
+    TOKEN_KINDS_NUMBER
+} TokenKind;
+
+typedef struct {
+    int offset;                 // offset of the first byte of token from line beginning
+    int length;                 // number of bytes of token
+    TokenKind kind;
+} TokenSpan;
+
+// part of row shown in color of token, counted in columns from row beginning
+typedef struct {
+    int column;                 // the first column of run
+    int columns;                // number of columns of run
+    TokenKind kind;
+} HighlightRun;
+
+/* reads beginning of line: *length gives the most bytes to read and gets number of bytes read,
+ * *lineSize gets size of line content (line break isn't included), NULL is returned if line doesn't exist */
+typedef char const * (*LineTextReader)(void * source, long long lineNumber, long long * length, long long * lineSize);
+
+typedef struct tag_HighlightLine HighlightLine;
+
+// counters of highlighting efficiency
+typedef struct {
+    long long hits;             // Number of lines tokens are taken from cache for
+    long long misses;           // Number of lines tokenized to be shown
+    long long linesPassed;      // Number of lines tokenized to find state of shown lines
+} HighlightStats;
+
+/* tokens of shown lines kept in cache of the most recently used lines. Line is tokenized starting from
+ * state of entry it continues (e.g. stack trace lines continue error), which is found from the nearest checkpoint,
+ * so lines are never tokenized from the top of file */
+typedef struct {
+    LineTextReader read;        // Function reading lines
+    void * source;              // Source of text passed to read
+    HighlightLine * lines;      // Array of [HIGHLIGHT_CACHE_SIZE] slots of tokenized lines (NULL until a line is shown)
+    int * buckets;              // Hash table of first slots of chains (-1 if chain is empty)
+    int bucketsMask;            // Mask of line number giving it's bucket
+    int newest;                 // The most recently used slot
+    int oldest;                 // The least recently used slot, it's reused first
+    unsigned char * checkpoints;            // States at beginnings of every HIGHLIGHT_CHECKPOINT_STEP-th line plus 1 (0 if unknown)
+    long long checkpointsNumber;            // Number of items in checkpoints
+    long long stateLine;        // Line state of the last tokenized line leads to (-1 if there's none)
+    TokenKind state;            // State at the beginning of stateLine
+    HighlightStats stats;       // Counters of highlighting efficiency
+} Highlighter;
+
+void InitHighlighter(Highlighter * highlighter, LineTextReader read, void * source);
+void DestroyHighlighter(Highlighter * highlighter);
+size_t GetHighlighterMemory(Highlighter const * highlighter);
+void ForgetHighlightedLines(Highlighter * highlighter, long long firstLine);
+TokenSpan const * GetLineTokens(Highlighter * highlighter, long long lineNumber, int * tokensNumber);
+
+#endif // HIGHLIGHTER_H_INCLUDED
@@ -0,0 +1,2687 @@
+#include "LineIndexer.h"
+#include "Thread.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define INDEXER_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    #define INDEXER_NEON
+    #include <arm_neon.h>
+#endif
+
+// vector kernels are compiled for their instruction sets regardless of compiler flags
+// and are called only if CPU supports them (see DetectIndexerKernel)
+#ifdef __GNUC__
+    #define INDEXER_TARGET(features) __attribute__((target(features)))
+    #define INDEXER_INLINE static inline __attribute__((always_inline))
+#else
+    #define INDEXER_TARGET(features)
+    #define INDEXER_INLINE static __forceinline
+#endif
+
+#define INITIAL_LINES_CAPACITY 4096
+#define MIN_CHUNK_SIZE (1L << 20)   // smaller chunks aren't worth a thread
+
+typedef struct {
+    LineIndex * index;          // index being filled
+    char const * data;          // scanned text
+    long long size;             // size of scanned text
+    long long lineBegin;        // beginning of the line being scanned
+    BOOL failed;                // set if index can't grow
+} ScanState;
+
+typedef void (*ScanKernel)(ScanState * state, long long begin, long long end);
+
+// part of text indexed by one thread
+typedef struct {
+    LineIndex partial;          // line breaks found in chunk: lineBeginnings[0] is chunk beginning
+    char const * data;          // entire text
+    long long size;             // size of entire text
+    long long begin;            // index of the first byte of chunk
+    long long end;              // index of the byte after chunk
+    IndexerKernel kernel;       // kernel to scan chunk with
+    ErrorType errorType;        // result of scanning
+    LineIndex * target;         // index chunk results are stitched into
+    long long firstLine;        // number of the first line in target which begins in chunk
+} IndexerTask;
+
+static char const * kernelNames[INDEXER_KERNELS_NUMBER] = {
+    "auto",
+    "scalar",
+    "sse2",
+    "avx2",
+    "avx512",
+    "neon"
+};
+
+/**
+ * Counts trailing zero bits of non-zero mask.
+ * IN:
+ * @param mask - mask to process (mustn't be 0)
+ *
+ * OUT:
+ * @return index of the lowest set bit
+ */
+INDEXER_INLINE int CountTrailingZeros(unsigned long long mask) {
+#ifdef __GNUC__
+    return __builtin_ctzll(mask);
+#else
+    unsigned long bit;
+    if (_BitScanForward(&bit, (unsigned long)mask))
+        return (int)bit;
+    _BitScanForward(&bit, (unsigned long)(mask >> 32));
+    return (int)bit + 32;
+#endif
+}
+
+/**
+ * Checks whether array of items can be allocated in address space of process.
+ * IN:
+ * @param itemsNumber - number of items in array
+ * @param itemSize - size of item in bytes
+ *
+ * OUT:
+ * @return TRUE if size of array fits into size_t
+ */
+static BOOL FitsAddressSpace(long long itemsNumber, size_t itemSize) {
+    return itemsNumber >= 0 && (unsigned long long)itemsNumber <= SIZE_MAX / itemSize;
+}
+
+/**
+ * Makes sure index has room for one more line.
+ * IN:
+ * @param index - pointer to index to grow
+ *
+ * OUT:
+ * index->lineBeginnings, index->crlfLines may be reallocated
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL GrowLineIndex(LineIndex * index) {
+    long long capacity = index->capacity * 2;
+    long long * lineBeginnings;
+    unsigned char * crlfLines;
+
+    if (!FitsAddressSpace(capacity + 1, sizeof(long long)))
+        return FALSE;
+    lineBeginnings = (long long*)realloc(index->lineBeginnings, (capacity + 1) * sizeof(long long));
+    if (lineBeginnings == NULL)
+        return FALSE;
+    index->lineBeginnings = lineBeginnings;
+
+    crlfLines = (unsigned char*)realloc(index->crlfLines, capacity / 8 + 1);
+    if (crlfLines == NULL)
+        return FALSE;
+    memset(crlfLines + index->capacity / 8 + 1, 0, capacity / 8 - index->capacity / 8);
+    index->crlfLines = crlfLines;
+
+    index->capacity = capacity;
+    return TRUE;
+}
+
+/**
+ * Processes line break candidate symbol ('\n' or '\r') found by kernel:
+ * finishes current line and starts the next one.
+ * IN:
+ * @param state - pointer to state of scanning
+ * @param position - index of found symbol in text
+ *
+ * OUT:
+ * state->index gets new line, it's maxLength is updated with the finished line length
+ * state->lineBegin gets beginning of the next line
+ */
+INDEXER_INLINE void HandleLineBreak(ScanState * state, long long position) {
+    LineIndex * index = state->index;
+    char const * data = state->data;
+    long long contentEnd = position;
+    BOOL crlf = FALSE;
+
+    if (data[position] == '\r') {
+        // '\r' of "\r\n" pair: break is processed on '\n'
+        if (position + 1 < state->size && data[position + 1] == '\n')
+            return;
+    }
+    else if (position > 0 && data[position - 1] == '\r') {
+        crlf = TRUE;
+        contentEnd--;
+    }
+
+    if (index->maxLength < contentEnd - state->lineBegin)
+        index->maxLength = contentEnd - state->lineBegin;
+
+    if (index->linesNumber + 1 > index->capacity && !GrowLineIndex(index)) {
+        state->failed = TRUE;
+        return;
+    }
+    if (crlf)
+        index->crlfLines[(index->linesNumber - 1) >> 3] |= (unsigned char)(1 << ((index->linesNumber - 1) & 7));
+    index->lineBeginnings[index->linesNumber++] = position + 1;
+    state->lineBegin = position + 1;
+}
+
+/**
+ * Scans range of text byte by byte.
+ * IN:
+ * @param state - pointer to state of scanning
+ * @param begin - index of the first byte of range
+ * @param end - index of the byte after range
+ */
+static void ScanScalar(ScanState * state, long long begin, long long end) {
+    char const * data = state->data;
+    long long position;
+
+    for (position = begin; position < end && !state->failed; ++position) {
+        if (data[position] == '\n' || data[position] == '\r')
+            HandleLineBreak(state, position);
+    }
+}
+
+#ifdef INDEXER_X86
+INDEXER_TARGET("sse2")
+static void ScanSse2(ScanState * state, long long begin, long long end) {
+    __m128i const newline  = _mm_set1_epi8('\n');
+    __m128i const carriage = _mm_set1_epi8('\r');
+    __m128i chunk;
+    unsigned int mask;
+    long long position;
+
+    for (position = begin; position + 16 <= end; position += 16) {
+        chunk = _mm_loadu_si128((__m128i const *)(state->data + position));
+        mask  = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, newline),
+                                                             _mm_cmpeq_epi8(chunk, carriage)));
+        if (mask == 0)
+            continue;
+        for (; mask != 0; mask &= mask - 1)
+            HandleLineBreak(state, position + CountTrailingZeros(mask));
+        if (state->failed)
+            return;
+    }
+    ScanScalar(state, position, end);
+}
+
+INDEXER_TARGET("avx2")
+static void ScanAvx2(ScanState * state, long long begin, long long end) {
+    __m256i const newline  = _mm256_set1_epi8('\n');
+    __m256i const carriage = _mm256_set1_epi8('\r');
+    __m256i chunk;
+    unsigned int mask;
+    long long position;
+
+    for (position = begin; position + 32 <= end; position += 32) {
+        chunk = _mm256_loadu_si256((__m256i const *)(state->data + position));
+        mask  = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline),
+                                                                   _mm256_cmpeq_epi8(chunk, carriage)));
+        if (mask == 0)
+            continue;
+        for (; mask != 0; mask &= mask - 1)
+            HandleLineBreak(state, position + CountTrailingZeros(mask));
+        if (state->failed)
+            return;
+    }
+    ScanScalar(state, position, end);
+}
+
+INDEXER_TARGET("avx512f,avx512bw")
+static void ScanAvx512(ScanState * state, long long begin, long long end) {
+    __m512i const newline  = _mm512_set1_epi8('\n');
+    __m512i const carriage = _mm512_set1_epi8('\r');
+    __m512i chunk;
+    unsigned long long mask;
+    long long position;
+
+    for (position = begin; position + 64 <= end; position += 64) {
+        chunk = _mm512_loadu_si512((void const *)(state->data + position));
+        mask  = (unsigned long long)(_mm512_cmpeq_epi8_mask(chunk, newline) |
+                                     _mm512_cmpeq_epi8_mask(chunk, carriage));
+        if (mask == 0)
+            continue;
+        for (; mask != 0; mask &= mask - 1)
+            HandleLineBreak(state, position + CountTrailingZeros(mask));
+        if (state->failed)
+            return;
+    }
+    ScanScalar(state, position, end);
+}
+#endif // INDEXER_X86
+
+#ifdef INDEXER_NEON
+static void ScanNeon(ScanState * state, long long begin, long long end) {
+    uint8x16_t const newline  = vdupq_n_u8('\n');
+    uint8x16_t const carriage = vdupq_n_u8('\r');
+    uint8x16_t chunk;
+    uint8x16_t matches;
+    unsigned long long mask;
+    long long position;
+
+    for (position = begin; position + 16 <= end; position += 16) {
+        chunk   = vld1q_u8((uint8_t const *)(state->data + position));
+        matches = vorrq_u8(vceqq_u8(chunk, newline), vceqq_u8(chunk, carriage));
+        // narrow comparison result to 4 bits per byte since NEON has no movemask
+        mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+        if (mask == 0)
+            continue;
+        for (mask &= 0x8888888888888888ULL; mask != 0; mask &= mask - 1)
+            HandleLineBreak(state, position + (CountTrailingZeros(mask) >> 2));
+        if (state->failed)
+            return;
+    }
+    ScanScalar(state, position, end);
+}
+#endif // INDEXER_NEON
+
+/**
+ * Gives scanning function of specified kernel.
+ * IN:
+ * @param kernel - kernel to get function of
+ *
+ * OUT:
+ * @return pointer to scanning function (NULL if kernel is not compiled for this architecture)
+ */
+static ScanKernel GetScanKernel(IndexerKernel kernel) {
+    switch (kernel) {
+    case INDEXER_KERNEL_SCALAR:
+        return ScanScalar;
+#ifdef INDEXER_X86
+    case INDEXER_KERNEL_SSE2:
+        return ScanSse2;
+    case INDEXER_KERNEL_AVX2:
+        return ScanAvx2;
+    case INDEXER_KERNEL_AVX512:
+        return ScanAvx512;
+#endif
+#ifdef INDEXER_NEON
+    case INDEXER_KERNEL_NEON:
+        return ScanNeon;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+#ifdef INDEXER_X86
+/**
+ * Executes CPUID instruction.
+ * IN:
+ * @param leaf - value of EAX register
+ * @param subleaf - value of ECX register
+ *
+ * OUT:
+ * @param registers - gets values of EAX, EBX, ECX, EDX registers
+ */
+static void ExecuteCpuid(unsigned int leaf, unsigned int subleaf, unsigned int registers[4]) {
+#ifdef _MSC_VER
+    __cpuidex((int*)registers, (int)leaf, (int)subleaf);
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+/**
+ * Reads XCR0 register to find out which vector registers state is saved by OS.
+ * Must be called only if CPU supports OSXSAVE.
+ * OUT:
+ * @return value of XCR0 register
+ */
+static unsigned long long ReadXcr0(void) {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif // INDEXER_X86
+
+/**
+ * Checks whether kernel can be executed on this machine.
+ * IN:
+ * @param kernel - kernel to check
+ *
+ * OUT:
+ * @return TRUE if kernel is compiled for this architecture and supported by CPU and OS
+ */
+BOOL IsIndexerKernelSupported(IndexerKernel kernel) {
+#ifdef INDEXER_X86
+    unsigned int registers[4];
+    unsigned int maxLeaf;
+    unsigned long long xcr0 = 0;
+#endif
+
+    if (kernel == INDEXER_KERNEL_AUTO || kernel == INDEXER_KERNEL_SCALAR)
+        return TRUE;
+    if (GetScanKernel(kernel) == NULL)
+        return FALSE;
+
+#ifdef INDEXER_X86
+    ExecuteCpuid(0, 0, registers);
+    maxLeaf = registers[0];
+    ExecuteCpuid(1, 0, registers);
+    if (kernel == INDEXER_KERNEL_SSE2)
+        return (registers[3] & (1u << 26)) != 0;
+
+    // AVX kernels need OS support of extended registers state
+    if ((registers[2] & (1u << 27)) == 0 || (registers[2] & (1u << 28)) == 0 || maxLeaf < 7)
+        return FALSE;
+    xcr0 = ReadXcr0();
+    ExecuteCpuid(7, 0, registers);
+    if (kernel == INDEXER_KERNEL_AVX2)
+        return (xcr0 & 0x06) == 0x06 && (registers[1] & (1u << 5)) != 0;
+    if (kernel == INDEXER_KERNEL_AVX512)
+        return (xcr0 & 0xE6) == 0xE6 && (registers[1] & (1u << 16)) != 0 && (registers[1] & (1u << 30)) != 0;
+#endif
+
+    // NEON is a part of base instruction set if compiled
+    return kernel == INDEXER_KERNEL_NEON;
+}
+
+/**
+ * Chooses the fastest kernel supported on this machine.
+ * Detection is performed once, result is cached.
+ * OUT:
+ * @return the fastest supported kernel
+ */
+IndexerKernel DetectIndexerKernel(void) {
+    static IndexerKernel const preferred[] = {
+        INDEXER_KERNEL_AVX512,
+        INDEXER_KERNEL_AVX2,
+        INDEXER_KERNEL_SSE2,
+        INDEXER_KERNEL_NEON
+    };
+    static IndexerKernel detected = INDEXER_KERNEL_AUTO;
+    unsigned int i;
+
+    if (detected != INDEXER_KERNEL_AUTO)
+        return detected;
+
+    detected = INDEXER_KERNEL_SCALAR;
+    for (i = 0; i < sizeof(preferred) / sizeof(preferred[0]); ++i) {
+        if (IsIndexerKernelSupported(preferred[i])) {
+            detected = preferred[i];
+            break;
+        }
+    }
+    return detected;
+}
+
+/**
+ * Gives printable name of kernel.
+ * IN:
+ * @param kernel - kernel to get name of
+ *
+ * OUT:
+ * @return name of kernel
+ */
+char const * GetIndexerKernelName(IndexerKernel kernel) {
+    if (kernel < 0 || kernel >= INDEXER_KERNELS_NUMBER)
+        return "unknown";
+    return kernelNames[kernel];
+}
+
+/**
+ * Initializes empty line index with one line starting at specified position.
+ * IN:
+ * @param index - pointer to index to initialize
+ * @param capacity - number of lines to allocate memory for
+ * @param firstBeginning - beginning of the first line
+ *
+ * INOUT:
+ * @param spare - arrays of destroyed index (NULL if there are none), lines beginnings are taken if they have room enough
+ *
+ * OUT:
+ * fields of index are initialized
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL InitLineIndex(LineIndex * index, long long capacity, long long firstBeginning, LineIndexSpare * spare) {
+    index->mode           = LINE_INDEX_FLAT;
+    index->blocks         = NULL;
+    index->deltas         = NULL;
+    index->capacity       = capacity;
+    index->linesNumber    = 1;
+    index->maxLength      = 0;
+    index->lineBeginnings = NULL;
+    index->crlfLines      = NULL;
+    index->lengthCounts   = NULL;
+    index->longLengths    = NULL;
+    index->lengthsNumber  = 0;
+    index->unfinished     = FALSE;
+    index->storage        = NULL;
+    if (spare != NULL && spare->lineBeginnings != NULL && spare->capacity >= capacity) {
+        index->lineBeginnings = spare->lineBeginnings;
+        index->capacity       = spare->capacity;
+        spare->memory        -= (size_t)(spare->capacity + 1) * sizeof(long long);
+        spare->lineBeginnings = NULL;
+        spare->capacity       = 0;
+    }
+    else {
+        if (!FitsAddressSpace(capacity + 1, sizeof(long long)))
+            return FALSE;
+        index->lineBeginnings = (long long*)malloc((capacity + 1) * sizeof(long long));
+    }
+    index->crlfLines = (unsigned char*)calloc(index->capacity / 8 + 1, sizeof(unsigned char));
+    if (index->lineBeginnings == NULL || index->crlfLines == NULL) {
+        DestroyLineIndex(index);
+        return FALSE;
+    }
+    index->lineBeginnings[0] = firstBeginning;
+    return TRUE;
+}
+
+/**
+ * Scans range of text and saves found line breaks into index.
+ * Length of the line which starts before range is counted from range beginning.
+ * IN:
+ * @param index - pointer to index initialized with InitLineIndex
+ * @param data - entire text (bytes around range are used to classify line breaks on it's borders)
+ * @param size - size of entire text
+ * @param begin - index of the first byte of range
+ * @param end - index of the byte after range
+ * @param kernel - supported kernel to scan range with
+ *
+ * OUT:
+ * index gets lines which begin in range, maxLength of lines which end in range
+ * @return beginning of the last line found (the one which isn't finished in range)
+ */
+static long long ScanLineBreaks(LineIndex * index, char const * data, long long size, long long begin, long long end, IndexerKernel kernel) {
+    ScanState state;
+    TRACE_START(start);
+
+    state.index     = index;
+    state.data      = data;
+    state.size      = size;
+    state.lineBegin = begin;
+    state.failed    = FALSE;
+    GetScanKernel(kernel)(&state, begin, end);
+    TRACE_STOP("ScanLineBreaks", start);
+    TRACE_COUNTER("lines scanned", index->linesNumber);
+    return state.failed ? -1 : state.lineBegin;
+}
+
+/**
+ * Thread routine scanning chunk of text.
+ * IN:
+ * @param argument - pointer to IndexerTask of chunk
+ *
+ * OUT:
+ * task->partial gets line breaks found in chunk
+ * task->errorType gets result of scanning
+ */
+static void ScanChunk(void * argument) {
+    IndexerTask * task = (IndexerTask*)argument;
+
+    task->errorType = ERR_NOMEM;
+    if (!InitLineIndex(&task->partial, INITIAL_LINES_CAPACITY, task->begin, NULL))
+        return;
+    if (ScanLineBreaks(&task->partial, task->data, task->size, task->begin, task->end, task->kernel) < 0) {
+        DestroyLineIndex(&task->partial);
+        return;
+    }
+    task->errorType = ERR_NO;
+}
+
+/**
+ * Thread routine copying lines beginnings found in chunk into target index.
+ * IN:
+ * @param argument - pointer to IndexerTask of chunk
+ *
+ * OUT:
+ * task->target->lineBeginnings gets lines beginnings of chunk starting from task->firstLine
+ */
+static void CopyChunk(void * argument) {
+    IndexerTask * task = (IndexerTask*)argument;
+
+    memcpy(task->target->lineBeginnings + task->firstLine, task->partial.lineBeginnings + 1,
+           (task->partial.linesNumber - 1) * sizeof(long long));
+}
+
+/**
+ * Copies bit array into another one starting from specified bit.
+ * Target bits are expected to be zero.
+ * IN:
+ * @param source - bit array to copy
+ * @param bitsNumber - number of bits to copy
+ * @param firstBit - number of bit in target to copy the first bit into
+ *
+ * OUT:
+ * @param target - gets copied bits
+ */
+static void CopyBits(unsigned char * target, unsigned char const * source, long long bitsNumber, long long firstBit) {
+    int shift = (int)(firstBit & 7);
+    long long bytesNumber = (bitsNumber + 7) / 8;
+    long long i;
+
+    target += firstBit >> 3;
+    for (i = 0; i < bytesNumber; ++i) {
+        if (source[i] == 0)
+            continue;
+        target[i] |= (unsigned char)(source[i] << shift);
+        // check prevents writing beyond the last byte of target
+        if (shift != 0 && (source[i] >> (8 - shift)) != 0)
+            target[i + 1] |= (unsigned char)(source[i] >> (8 - shift));
+    }
+}
+
+/**
+ * Builds index of text splitted into chunks scanned by several threads simultaneously.
+ * Chunks results are stitched in order, so the index is identical to the one built in a single thread.
+ * IN:
+ * @param index - pointer to structure to save index in
+ * @param data - text to index
+ * @param size - size of text in bytes
+ * @param kernel - supported kernel to scan text with
+ * @param threadsNumber - number of threads to use (at least 2)
+ *
+ * INOUT:
+ * @param spare - arrays of destroyed index to take lines beginnings from (NULL if there are none)
+ *
+ * OUT:
+ * fields of index are initialized with built index
+ * @return code of error occured during building index (ERR_NO if successed)
+ */
+static ErrorType BuildLineIndexParallel(LineIndex * index, char const * data, long long size,
+                                        IndexerKernel kernel, int threadsNumber, LineIndexSpare * spare) {
+    IndexerTask * tasks;
+    ErrorType errorType;
+    long long linesNumber = 1;
+    long long lineBegin = 0;
+    long long lineEnd;
+    int i;
+
+    tasks = (IndexerTask*)calloc(threadsNumber, sizeof(IndexerTask));
+    if (tasks == NULL)
+        return ERR_NOMEM;
+    for (i = 0; i < threadsNumber; ++i) {
+        tasks[i].data   = data;
+        tasks[i].size   = size;
+        tasks[i].begin  = (long long)((double)size * i / threadsNumber);
+        tasks[i].end    = (long long)((double)size * (i + 1) / threadsNumber);
+        tasks[i].kernel = kernel;
+        tasks[i].target = index;
+    }
+    tasks[threadsNumber - 1].end = size;
+
+    // scan chunks
+    errorType = RunThreadTasks(tasks, sizeof(IndexerTask), threadsNumber, ScanChunk);
+    for (i = 0; i < threadsNumber && errorType == ERR_NO; ++i)
+        errorType = tasks[i].errorType;
+
+    // prefix sum of chunks lines numbers gives position of each chunk in the entire index
+    for (i = 0; i < threadsNumber && errorType == ERR_NO; ++i) {
+        tasks[i].firstLine = linesNumber;
+        linesNumber += tasks[i].partial.linesNumber - 1;
+    }
+
+    if (errorType == ERR_NO && !InitLineIndex(index, linesNumber, 0, spare))
+        errorType = ERR_NOMEM;
+    if (errorType == ERR_NO) {
+        index->linesNumber = linesNumber;
+        errorType = RunThreadTasks(tasks, sizeof(IndexerTask), threadsNumber, CopyChunk);
+    }
+
+    if (errorType == ERR_NO) {
+        for (i = 0; i < threadsNumber; ++i) {
+            LineIndex const * partial = &tasks[i].partial;
+
+            CopyBits(index->crlfLines, partial->crlfLines, partial->linesNumber - 1, tasks[i].firstLine - 1);
+            if (partial->linesNumber == 1)
+                continue;   // the whole chunk belongs to a line started before
+
+            // the first line of chunk may start in previous chunks, so it's length is counted here
+            lineEnd = GetLineContentEnd(index, tasks[i].firstLine - 1);
+            if (index->maxLength < lineEnd - lineBegin)
+                index->maxLength = lineEnd - lineBegin;
+            if (index->maxLength < partial->maxLength)
+                index->maxLength = partial->maxLength;
+            lineBegin = partial->lineBeginnings[partial->linesNumber - 1];
+        }
+
+        // the last line ends with the end of text
+        if (index->maxLength < size - lineBegin)
+            index->maxLength = size - lineBegin;
+        index->lineBeginnings[linesNumber] = size;   // special value to check end of text
+    }
+
+    for (i = 0; i < threadsNumber; ++i)
+        DestroyLineIndex(&tasks[i].partial);
+    free(tasks);
+    if (errorType != ERR_NO)
+        DestroyLineIndex(index);
+    return errorType;
+}
+
+/**
+ * Compares two lengths counts by length for qsort.
+ * IN:
+ * @param first, second - pointers to compared LengthCount structures
+ *
+ * OUT:
+ * @return negative, zero or positive value if the first length is less, equal or greater
+ */
+static int CompareLengthCounts(void const * first, void const * second) {
+    long long difference = ((LengthCount const *)first)->length - ((LengthCount const *)second)->length;
+    return (difference > 0) - (difference < 0);
+}
+
+/**
+ * Builds histogram of lines lengths: short lengths are counted in dense array,
+ * long ones are sorted and grouped. Any function of line length summed over all lines
+ * (like number of rows in wrap view mode) then takes time proportional to number of distinct lengths.
+ * IN:
+ * @param index - pointer to flat index with all lines found
+ *
+ * OUT:
+ * index->lengthCounts, index->longLengths, index->lengthsNumber get built histogram (NULL arrays if failed)
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+BOOL CountLineLengths(LineIndex * index) {
+    LengthCount * longLengths;
+    long long longLinesNumber = 0;
+    long long capacity = 0;
+    long long length, line, i;
+
+    index->lengthCounts = (long long*)calloc(LENGTH_COUNTS_SIZE, sizeof(long long));
+    if (index->lengthCounts == NULL)
+        return FALSE;
+
+    for (line = 0; line < index->linesNumber; ++line) {
+        length = GetLineContentEnd(index, line) - index->lineBeginnings[line];
+        if (length < LENGTH_COUNTS_SIZE) {
+            index->lengthCounts[length]++;
+            continue;
+        }
+
+        // long lines are rare: there are at most size / LENGTH_COUNTS_SIZE of them
+        if (longLinesNumber == capacity) {
+            capacity = (capacity == 0) ? 64 : capacity * 2;
+            longLengths = FitsAddressSpace(capacity, sizeof(LengthCount)) ?
+                          (LengthCount*)realloc(index->longLengths, (size_t)capacity * sizeof(LengthCount)) : NULL;
+            if (longLengths == NULL) {
+                // incomplete histogram is useless
+                free(index->lengthCounts);
+                free(index->longLengths);
+                index->lengthCounts = NULL;
+                index->longLengths  = NULL;
+                return FALSE;
+            }
+            index->longLengths = longLengths;
+        }
+        index->longLengths[longLinesNumber].length = length;
+        index->longLengths[longLinesNumber].linesNumber = 1;
+        longLinesNumber++;
+    }
+
+    // group equal lengths
+    if (longLinesNumber > 0)
+        qsort(index->longLengths, (size_t)longLinesNumber, sizeof(LengthCount), CompareLengthCounts);
+    for (i = 0; i < longLinesNumber; ++i) {
+        if (index->lengthsNumber > 0 && index->longLengths[index->lengthsNumber - 1].length == index->longLengths[i].length)
+            index->longLengths[index->lengthsNumber - 1].linesNumber++;
+        else
+            index->longLengths[index->lengthsNumber++] = index->longLengths[i];
+    }
+    return TRUE;
+}
+
+/**
+ * Builds flat index of lines of text in a single pass:
+ * finds lines beginnings, classifies line breaks and finds the longest line.
+ * Big texts are splitted into chunks scanned in parallel.
+ * IN:
+ * @param index - pointer to structure to save index in
+ * @param data - text to index
+ * @param size - size of text in bytes
+ * @param options - kernel and number of threads to use (NULL means defaults)
+ *
+ * INOUT:
+ * @param spare - arrays of destroyed index to take lines beginnings from (NULL if there are none)
+ *
+ * OUT:
+ * fields of index are initialized with built index
+ * @return code of error occured during building index (ERR_NO if successed)
+ */
+static ErrorType BuildFlatLineIndex(LineIndex * index, char const * data, long long size, IndexerOptions const * options,
+                                    LineIndexSpare * spare) {
+    IndexerKernel kernel = (options != NULL) ? options->kernel : INDEXER_KERNEL_AUTO;
+    int threadsNumber = (options != NULL) ? options->threadsNumber : 0;
+    ErrorType errorType;
+    long long lineBegin;
+
+    if (index == NULL || (data == NULL && size > 0))
+        return ERR_NULL_PTR;
+    memset(index, 0, sizeof(LineIndex));    // empty index is safe to destroy on errors
+
+    if (kernel == INDEXER_KERNEL_AUTO || !IsIndexerKernelSupported(kernel))
+        kernel = DetectIndexerKernel();
+
+    if (threadsNumber <= 0)
+        threadsNumber = GetHardwareConcurrency();
+    if (threadsNumber > size / MIN_CHUNK_SIZE)
+        threadsNumber = (int)(size / MIN_CHUNK_SIZE);
+
+    if (threadsNumber > 1) {
+        errorType = BuildLineIndexParallel(index, data, size, kernel, threadsNumber, spare);
+        if (errorType != ERR_NO)
+            return errorType;
+    }
+    else {
+        if (!InitLineIndex(index, INITIAL_LINES_CAPACITY, 0, spare))
+            return ERR_NOMEM;
+        lineBegin = ScanLineBreaks(index, data, size, 0, size, kernel);
+        if (lineBegin < 0) {
+            DestroyLineIndex(index);
+            return ERR_NOMEM;
+        }
+
+        // the last line ends with the end of text
+        if (index->maxLength < size - lineBegin)
+            index->maxLength = size - lineBegin;
+        index->lineBeginnings[index->linesNumber] = size;   // special value to check end of text
+    }
+
+    if (!CountLineLengths(index)) {
+        DestroyLineIndex(index);
+        return ERR_NOMEM;
+    }
+    return ERR_NO;
+}
+
+/**
+ * Builds index of lines of text in a single pass:
+ * finds lines beginnings, classifies line breaks and finds the longest line.
+ * Big texts are splitted into chunks scanned in parallel.
+ * IN:
+ * @param index - pointer to structure to save index in
+ * @param data - text to index
+ * @param size - size of text in bytes
+ * @param kernel - kernel to scan text with (unsupported kernels are replaced with the detected one)
+ * @param threadsNumber - number of threads to use (0 means number of logical processors)
+ *
+ * OUT:
+ * fields of index are initialized with built index
+ * @return code of error occured during building index (ERR_NO if successed)
+ */
+ErrorType BuildLineIndex(LineIndex * index, char const * data, long long size, IndexerOptions const * options) {
+    return BuildLineIndexReusing(index, NULL, data, size, options);
+}
+
+/**
+ * Reads delta of packed index.
+ * IN:
+ * @param delta - pointer to delta in pool (may be unaligned)
+ * @param width - size of delta in bytes
+ *
+ * OUT:
+ * @return value of delta
+ */
+INDEXER_INLINE long long ReadDelta(unsigned char const * delta, unsigned int width) {
+    unsigned short delta16;
+    unsigned int delta32;
+    unsigned long long delta64;
+
+    switch (width) {
+    case 2:
+        memcpy(&delta16, delta, sizeof(delta16));
+        return delta16;
+    case 4:
+        memcpy(&delta32, delta, sizeof(delta32));
+        return delta32;
+    default:
+        memcpy(&delta64, delta, sizeof(delta64));
+        return (long long)delta64;
+    }
+}
+
+/**
+ * Gives size of deltas enough for block of lines beginnings.
+ * IN:
+ * @param beginnings - array of lines beginnings of block
+ * @param entriesNumber - number of items in block
+ *
+ * OUT:
+ * @return size of each delta in bytes (2, 4 or 8)
+ */
+static unsigned int GetDeltaWidth(long long const * beginnings, long long entriesNumber) {
+    long long span = beginnings[entriesNumber - 1] - beginnings[0];
+    return (span <= 0xFFFF) ? 2 : (span <= 0xFFFFFFFFLL) ? 4 : 8;
+}
+
+/**
+ * Packs lines beginnings into blocks starting from specified one: lines are grouped into blocks of LINE_BLOCK_SIZE,
+ * each block keeps beginning of it's first line and offsets of the others from it
+ * in the least number of bytes enough for the block. Blocks before the first one are kept.
+ * IN:
+ * @param index - pointer to index (blocks and deltas are NULL if nothing is packed yet)
+ * @param firstBlock - number of the first block to pack
+ * @param beginnings - array of lines beginnings starting from the first line of the first block
+ * @param entriesNumber - number of lines beginnings in entire index including special value of text end
+ *
+ * OUT:
+ * index->blocks, index->deltas get packed blocks (they're unchanged if there's not enough memory)
+ * @return code of error occured during packing (ERR_NO if successed)
+ */
+static ErrorType PackLineBlocks(LineIndex * index, long long firstBlock, long long const * beginnings, long long entriesNumber) {
+    long long blocksNumber = (entriesNumber + LINE_BLOCK_SIZE - 1) / LINE_BLOCK_SIZE;
+    long long first, last, line;
+    long long span;
+    size_t poolStart = (firstBlock > 0) ? index->blocks[firstBlock].deltasOffset : 0;
+    size_t poolSize = poolStart;
+    unsigned short delta16;
+    unsigned int delta32;
+    unsigned long long delta64;
+    LineBlock * blocks;
+    unsigned char * deltas;
+    LineBlock * block;
+    long long i;
+
+    // choose width of each block deltas (blocks aren't changed until memory is allocated)
+    for (i = firstBlock; i < blocksNumber; ++i) {
+        first = i * LINE_BLOCK_SIZE;
+        last  = min(first + LINE_BLOCK_SIZE, entriesNumber) - 1;
+        poolSize += (size_t)(last - first + 1) *
+                    GetDeltaWidth(beginnings + first - firstBlock * LINE_BLOCK_SIZE, last - first + 1);
+    }
+
+    if (!FitsAddressSpace(blocksNumber, sizeof(LineBlock)))
+        return ERR_NOMEM;
+    blocks = (LineBlock*)realloc(index->blocks, blocksNumber * sizeof(LineBlock));
+    if (blocks == NULL)
+        return ERR_NOMEM;
+    index->blocks = blocks;
+    deltas = (unsigned char*)realloc(index->deltas, poolSize);
+    if (deltas == NULL)
+        return ERR_NOMEM;
+    index->deltas = deltas;
+
+    for (poolSize = poolStart, i = firstBlock; i < blocksNumber; ++i) {
+        block = &index->blocks[i];
+        first = i * LINE_BLOCK_SIZE;
+        last  = min(first + LINE_BLOCK_SIZE, entriesNumber) - 1;
+
+        block->anchor       = beginnings[first - firstBlock * LINE_BLOCK_SIZE];
+        block->deltasOffset = poolSize;
+        block->deltaWidth   = GetDeltaWidth(beginnings + first - firstBlock * LINE_BLOCK_SIZE, last - first + 1);
+        poolSize += (size_t)(last - first + 1) * block->deltaWidth;
+
+        for (line = first; line <= last; ++line) {
+            unsigned char * delta = index->deltas + block->deltasOffset + (line - first) * block->deltaWidth;
+            span = beginnings[line - firstBlock * LINE_BLOCK_SIZE] - block->anchor;
+            switch (block->deltaWidth) {
+            case 2:
+                delta16 = (unsigned short)span;
+                memcpy(delta, &delta16, sizeof(delta16));
+                break;
+            case 4:
+                delta32 = (unsigned int)span;
+                memcpy(delta, &delta32, sizeof(delta32));
+                break;
+            default:
+                delta64 = (unsigned long long)span;
+                memcpy(delta, &delta64, sizeof(delta64));
+                break;
+            }
+        }
+    }
+    return ERR_NO;
+}
+
+/**
+ * Builds blocks of packed index from lines beginnings of flat one (see PackLineBlocks).
+ * IN:
+ * @param index - pointer to flat index to pack
+ *
+ * INOUT:
+ * @param spare - arrays of destroyed index to pack blocks into (NULL if there are none), they're taken
+ *
+ * OUT:
+ * index->mode gets LINE_INDEX_PACKED, index->lineBeginnings is left to caller to release
+ * @return code of error occured during packing (ERR_NO if successed)
+ */
+static ErrorType BuildLineBlocks(LineIndex * index, LineIndexSpare * spare) {
+    ErrorType errorType;
+
+    index->blocks = NULL;
+    index->deltas = NULL;
+    if (spare != NULL) {
+        // kept arrays are reallocated to the sizes needed, so memory they've got is reused
+        index->blocks = spare->blocks;
+        index->deltas = spare->deltas;
+        spare->blocks = NULL;
+        spare->deltas = NULL;
+        spare->memory = (spare->lineBeginnings != NULL) ? (size_t)(spare->capacity + 1) * sizeof(long long) : 0;
+    }
+    errorType = PackLineBlocks(index, 0, index->lineBeginnings, index->linesNumber + 1);
+    if (errorType != ERR_NO) {
+        free(index->blocks);
+        free(index->deltas);
+        index->blocks = NULL;
+        index->deltas = NULL;
+        return errorType;
+    }
+
+    index->mode = LINE_INDEX_PACKED;
+    return ERR_NO;
+}
+
+/**
+ * Gives size of pool of packed index deltas.
+ * IN:
+ * @param index - pointer to packed index
+ *
+ * OUT:
+ * @return size of pool in bytes
+ */
+static size_t GetDeltasSize(LineIndex const * index) {
+    long long blocksNumber = (index->linesNumber + LINE_BLOCK_SIZE) / LINE_BLOCK_SIZE;
+
+    return index->blocks[blocksNumber - 1].deltasOffset +
+           (size_t)((index->linesNumber + 1) - (blocksNumber - 1) * LINE_BLOCK_SIZE) *
+           index->blocks[blocksNumber - 1].deltaWidth;
+}
+
+/**
+ * Copies array into allocated memory.
+ * IN:
+ * @param source - array to copy (may be NULL)
+ * @param size - size of array in bytes
+ *
+ * OUT:
+ * @param failed - sets as TRUE if there's not enough memory
+ * @return pointer to allocated copy (NULL if source is NULL or empty, or if copying failed)
+ */
+static void * CopyArray(void const * source, size_t size, BOOL * failed) {
+    void * copy;
+
+    if (source == NULL || size == 0)
+        return NULL;
+    copy = malloc(size);
+    if (copy == NULL)
+        *failed = TRUE;
+    else
+        memcpy(copy, source, size);
+    return copy;
+}
+
+/**
+ * Copies arrays of index loaded from cache file into allocated memory, so index can be changed.
+ * IN:
+ * @param index - pointer to index
+ *
+ * OUT:
+ * index arrays get allocated copies, cache file is unmapped (index is unchanged if it's not ERR_NO)
+ * @return code of error occured during copying (ERR_NO if successed)
+ */
+static ErrorType DetachLineIndex(LineIndex * index) {
+    LineIndex copy = *index;
+    long long blocksNumber = (index->linesNumber + LINE_BLOCK_SIZE) / LINE_BLOCK_SIZE;
+    BOOL packed = (index->mode == LINE_INDEX_PACKED);
+    BOOL failed = FALSE;
+
+    if (index->storage == NULL)
+        return ERR_NO;
+
+    copy.lineBeginnings = (long long*)CopyArray(packed ? NULL : index->lineBeginnings,
+                                                (size_t)(index->linesNumber + 1) * sizeof(long long), &failed);
+    copy.blocks         = (LineBlock*)CopyArray(packed ? index->blocks : NULL,
+                                                (size_t)blocksNumber * sizeof(LineBlock), &failed);
+    copy.deltas         = (unsigned char*)CopyArray(packed ? index->deltas : NULL,
+                                                    packed ? GetDeltasSize(index) : 0, &failed);
+    copy.crlfLines      = (unsigned char*)CopyArray(index->crlfLines, (size_t)index->linesNumber / 8 + 1, &failed);
+    copy.lengthCounts   = (long long*)CopyArray(index->lengthCounts, LENGTH_COUNTS_SIZE * sizeof(long long), &failed);
+    copy.longLengths    = (LengthCount*)CopyArray(index->longLengths,
+                                                  (size_t)index->lengthsNumber * sizeof(LengthCount), &failed);
+    if (failed) {
+        free(copy.lineBeginnings);
+        free(copy.blocks);
+        free(copy.deltas);
+        free(copy.crlfLines);
+        free(copy.lengthCounts);
+        free(copy.longLengths);
+        return ERR_NOMEM;
+    }
+
+    UnmapFile(index->storage);
+    free(index->storage);
+    copy.storage  = NULL;
+    copy.capacity = index->linesNumber;
+    *index = copy;
+    return ERR_NO;
+}
+
+/**
+ * Converts flat index into packed one (see BuildLineBlocks).
+ * IN:
+ * @param index - pointer to index to pack
+ *
+ * OUT:
+ * index->mode gets LINE_INDEX_PACKED, index->lineBeginnings is freed
+ * @return code of error occured during packing (ERR_NO if successed)
+ */
+ErrorType PackLineIndex(LineIndex * index) {
+    ErrorType errorType;
+
+    if (index == NULL)
+        return ERR_NULL_PTR;
+    if (index->mode == LINE_INDEX_PACKED)
+        return ERR_NO;
+
+    errorType = DetachLineIndex(index);
+    if (errorType != ERR_NO)
+        return errorType;
+    errorType = BuildLineBlocks(index, NULL);
+    if (errorType != ERR_NO)
+        return errorType;
+    free(index->lineBeginnings);
+    index->lineBeginnings = NULL;
+    return ERR_NO;
+}
+
+/**
+ * Builds index of lines of text (see BuildLineIndex) in memory of destroyed index where it fits.
+ * Flat lines beginnings packed index is built from are kept in spare afterwards.
+ * IN:
+ * @param index - pointer to structure to save index in
+ * @param data - text to index
+ * @param size - size of text in bytes
+ * @param options - kernel, number of threads and representation of index (NULL means defaults)
+ *
+ * INOUT:
+ * @param spare - arrays kept by RetainLineIndex (NULL to allocate fresh memory)
+ *
+ * OUT:
+ * fields of index are initialized with built index
+ * @return code of error occured during building index (ERR_NO if successed)
+ */
+ErrorType BuildLineIndexReusing(LineIndex * index, LineIndexSpare * spare, char const * data, long long size,
+                                IndexerOptions const * options) {
+    ErrorType errorType;
+
+    errorType = BuildFlatLineIndex(index, data, size, options, spare);
+    if (errorType != ERR_NO || options == NULL || options->mode != LINE_INDEX_PACKED)
+        return errorType;
+
+    errorType = BuildLineBlocks(index, spare);
+    if (errorType != ERR_NO) {
+        DestroyLineIndex(index);
+        return errorType;
+    }
+    if (spare != NULL) {
+        // flat array is the biggest one, the next index is built in it
+        free(spare->lineBeginnings);
+        spare->lineBeginnings = index->lineBeginnings;
+        spare->capacity       = index->capacity;
+        spare->memory         = (size_t)(index->capacity + 1) * sizeof(long long);  // packed arrays are taken
+    }
+    else
+        free(index->lineBeginnings);
+    index->lineBeginnings = NULL;
+    return ERR_NO;
+}
+
+/**
+ * Gives beginning of line in text.
+ * IN:
+ * @param index - pointer to line index
+ * @param lineNumber - number of line (linesNumber gives size of text)
+ *
+ * OUT:
+ * @return index of the first symbol of line
+ */
+long long GetIndexedLineBeginning(LineIndex const * index, long long lineNumber) {
+    LineBlock const * block;
+
+    if (index->mode == LINE_INDEX_FLAT)
+        return index->lineBeginnings[lineNumber];
+
+    block = &index->blocks[lineNumber >> LINE_BLOCK_SHIFT];
+    return (long long)(block->anchor + ReadDelta(index->deltas + block->deltasOffset +
+                                            (size_t)(lineNumber & (LINE_BLOCK_SIZE - 1)) * block->deltaWidth,
+                                            block->deltaWidth));
+}
+
+/**
+ * Finds line which contains symbol with binary search of lines beginnings.
+ * IN:
+ * @param index - pointer to line index
+ * @param position - index of symbol in text
+ *
+ * OUT:
+ * @return number of line (the last line if position is out of text)
+ */
+long long FindIndexedLine(LineIndex const * index, long long position) {
+    long long low = 0;
+    long long high = index->linesNumber - 1;
+    long long middle;
+
+    while (low < high) {
+        middle = low + (high - low + 1) / 2;
+        if (GetIndexedLineBeginning(index, middle) <= position)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
+/**
+ * Gives number of bytes occupied by line index.
+ * IN:
+ * @param index - pointer to line index
+ *
+ * OUT:
+ * @return size of index arrays in bytes
+ */
+size_t GetLineIndexMemory(LineIndex const * index) {
+    size_t memory = (size_t)index->capacity / 8 + 1;   // line breaks flags
+    long long blocksNumber;
+
+    // lengths histogram
+    if (index->lengthCounts != NULL)
+        memory += LENGTH_COUNTS_SIZE * sizeof(long long) + (size_t)index->lengthsNumber * sizeof(LengthCount);
+
+    if (index->mode == LINE_INDEX_FLAT)
+        return memory + (size_t)(index->capacity + 1) * sizeof(long long);
+
+    blocksNumber = (index->linesNumber + LINE_BLOCK_SIZE) / LINE_BLOCK_SIZE;
+    memory += (size_t)blocksNumber * sizeof(LineBlock);
+    return memory + GetDeltasSize(index);
+}
+
+/**
+ * Frees memory allocated for line index.
+ * IN:
+ * @param index - pointer to index to destroy
+ *
+ * OUT:
+ * fields of index are set to empty index
+ */
+void DestroyLineIndex(LineIndex * index) {
+    if (index == NULL)
+        return;
+    if (index->storage != NULL) {
+        // arrays of index loaded from cache file are parts of it's view
+        UnmapFile(index->storage);
+        free(index->storage);
+    }
+    else {
+        if (index->lineBeginnings != NULL)
+            free(index->lineBeginnings);
+        if (index->blocks != NULL)
+            free(index->blocks);
+        if (index->deltas != NULL)
+            free(index->deltas);
+        if (index->crlfLines != NULL)
+            free(index->crlfLines);
+        if (index->lengthCounts != NULL)
+            free(index->lengthCounts);
+        if (index->longLengths != NULL)
+            free(index->longLengths);
+    }
+    index->mode           = LINE_INDEX_FLAT;
+    index->lineBeginnings = NULL;
+    index->blocks         = NULL;
+    index->deltas         = NULL;
+    index->crlfLines      = NULL;
+    index->lengthCounts   = NULL;
+    index->longLengths    = NULL;
+    index->lengthsNumber  = 0;
+    index->unfinished     = FALSE;
+    index->linesNumber    = 0;
+    index->capacity       = 0;
+    index->maxLength      = 0;
+    index->storage        = NULL;
+}
+
+/**
+ * Destroys line index keeping it's arrays to build the next index in.
+ * Kept arrays of the same kind are released, arrays of index loaded from cache file aren't kept.
+ * IN:
+ * @param index - pointer to index to destroy
+ *
+ * INOUT:
+ * @param spare - pointer to kept arrays (see BuildLineIndexReusing)
+ *
+ * OUT:
+ * fields of index are set to empty index
+ */
+void RetainLineIndex(LineIndex * index, LineIndexSpare * spare) {
+    size_t beginningsSize;
+    long long blocksNumber;
+
+    if (index == NULL || spare == NULL || index->storage != NULL) {
+        DestroyLineIndex(index);
+        return;
+    }
+
+    beginningsSize = (spare->lineBeginnings != NULL) ? (size_t)(spare->capacity + 1) * sizeof(long long) : 0;
+    if (index->mode == LINE_INDEX_FLAT && index->lineBeginnings != NULL) {
+        free(spare->lineBeginnings);
+        spare->memory        -= beginningsSize;
+        spare->lineBeginnings = index->lineBeginnings;
+        spare->capacity       = index->capacity;
+        spare->memory        += (size_t)(index->capacity + 1) * sizeof(long long);
+        index->lineBeginnings = NULL;
+    }
+    else if (index->mode == LINE_INDEX_PACKED && index->blocks != NULL && index->deltas != NULL) {
+        blocksNumber = (index->linesNumber + LINE_BLOCK_SIZE) / LINE_BLOCK_SIZE;
+        free(spare->blocks);
+        free(spare->deltas);
+        spare->memory = beginningsSize + (size_t)blocksNumber * sizeof(LineBlock) + GetDeltasSize(index);
+        spare->blocks = index->blocks;
+        spare->deltas = index->deltas;
+        index->blocks = NULL;
+        index->deltas = NULL;
+    }
+    DestroyLineIndex(index);
+}
+
+/**
+ * Frees arrays kept by RetainLineIndex.
+ * IN:
+ * @param spare - pointer to kept arrays
+ *
+ * OUT:
+ * fields of spare are set to empty
+ */
+void ReleaseLineIndexSpare(LineIndexSpare * spare) {
+    if (spare == NULL)
+        return;
+    free(spare->lineBeginnings);
+    free(spare->blocks);
+    free(spare->deltas);
+    memset(spare, 0, sizeof(LineIndexSpare));
+}
+
+/**
+ * Gives index of the end of line content (line break symbols are not included).
+ * IN:
+ * @param index - pointer to line index
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @return index of the first symbol after line content
+ */
+long long GetLineContentEnd(LineIndex const * index, long long lineNumber) {
+    long long end = GetIndexedLineBeginning(index, lineNumber + 1);
+
+    if (lineNumber == index->linesNumber - 1 && !index->unfinished)
+        return end;     // the last line has no line break
+    if (index->crlfLines[lineNumber >> 3] & (1 << (lineNumber & 7)))
+        return end - 2;
+    return end - 1;
+}
+
+/**
+ * Adds lines of specified length to histogram of lines lengths or removes them from it.
+ * IN:
+ * @param index - pointer to index with histogram built
+ * @param length - length of line content
+ * @param linesNumber - number of lines to add (negative to remove lines)
+ *
+ * OUT:
+ * index->lengthCounts, index->longLengths get changed numbers of lines
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+BOOL AddLineLength(LineIndex * index, long long length, long long linesNumber) {
+    LengthCount * longLengths;
+    long long left = 0;
+    long long right = index->lengthsNumber;
+    long long middle;
+
+    if (length < LENGTH_COUNTS_SIZE) {
+        index->lengthCounts[length] += linesNumber;
+        return TRUE;
+    }
+
+    // the first long length which is not less than length
+    while (left < right) {
+        middle = left + (right - left) / 2;
+        if (index->longLengths[middle].length < length)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    if (left < index->lengthsNumber && index->longLengths[left].length == length) {
+        index->longLengths[left].linesNumber += linesNumber;
+        if (index->longLengths[left].linesNumber == 0) {
+            memmove(index->longLengths + left, index->longLengths + left + 1,
+                    (size_t)(index->lengthsNumber - left - 1) * sizeof(LengthCount));
+            index->lengthsNumber--;
+        }
+        return TRUE;
+    }
+
+    longLengths = FitsAddressSpace(index->lengthsNumber + 1, sizeof(LengthCount)) ?
+                  (LengthCount*)realloc(index->longLengths, (size_t)(index->lengthsNumber + 1) * sizeof(LengthCount)) : NULL;
+    if (longLengths == NULL)
+        return FALSE;
+    index->longLengths = longLengths;
+    memmove(index->longLengths + left + 1, index->longLengths + left,
+            (size_t)(index->lengthsNumber - left) * sizeof(LengthCount));
+    index->longLengths[left].length      = length;
+    index->longLengths[left].linesNumber = linesNumber;
+    index->lengthsNumber++;
+    return TRUE;
+}
+
+/**
+ * Makes sure index has room for specified number of lines.
+ * IN:
+ * @param index - pointer to index to grow
+ * @param linesNumber - number of lines to keep
+ *
+ * OUT:
+ * index->crlfLines (and index->lineBeginnings of flat index) may be reallocated
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL ReserveLines(LineIndex * index, long long linesNumber) {
+    unsigned char * crlfLines;
+    long long capacity;
+
+    while (index->capacity < linesNumber) {
+        if (index->mode == LINE_INDEX_FLAT) {
+            if (!GrowLineIndex(index))
+                return FALSE;
+            continue;
+        }
+
+        // packed index keeps only line breaks flags growing
+        capacity = (index->capacity > 0) ? index->capacity * 2 : INITIAL_LINES_CAPACITY;
+        crlfLines = (unsigned char*)realloc(index->crlfLines, capacity / 8 + 1);
+        if (crlfLines == NULL)
+            return FALSE;
+        memset(crlfLines + index->capacity / 8 + 1, 0, capacity / 8 - index->capacity / 8);
+        index->crlfLines = crlfLines;
+        index->capacity  = capacity;
+    }
+    return TRUE;
+}
+
+/**
+ * Gives number of the first line which has to be rescanned when text grows (see AppendLineIndex).
+ * The last line isn't finished, and the line before it may end with '\r' of "\r\n" split by growth.
+ * IN:
+ * @param index - pointer to complete index
+ *
+ * OUT:
+ * @return number of line
+ */
+long long GetLineIndexTail(LineIndex const * index) {
+    return (index->linesNumber > 1) ? index->linesNumber - 2 : 0;
+}
+
+// text read from offset of other text (see ReadShiftedText)
+typedef struct {
+    TextReader read;            // function reading entire text
+    void * source;              // argument of read
+    long long base;             // offset of the first byte of part in entire text
+} ShiftedText;
+
+/**
+ * Reads part of text like text of it's own (see TextReader).
+ * IN:
+ * @param source - pointer to ShiftedText
+ * @param offset - index of the first byte to read in part
+ * @param size - number of bytes to read
+ *
+ * OUT:
+ * @param buffer - gets read bytes
+ * @return TRUE if successed, FALSE else
+ */
+static BOOL ReadShiftedText(void * source, long long offset, char * buffer, size_t size) {
+    ShiftedText const * shifted = (ShiftedText const*)source;
+
+    return shifted->read(shifted->source, shifted->base + offset, buffer, size);
+}
+
+/**
+ * Adds lines of text appended since index has been built. Only the tail of text is scanned:
+ * the last two lines of index and appended bytes, so time doesn't depend on text size.
+ * Tail which isn't kept in memory is read by segments, so memory doesn't depend on size of appended text.
+ * IN:
+ * @param index - pointer to complete index of text which has grown
+ * @param tail - text starting from the beginning of GetLineIndexTail(index) line (NULL if it's read with read function)
+ * @param read - function reading entire text (used if tail is NULL)
+ * @param source - argument of read
+ * @param size - size of entire text (not less than size of indexed text)
+ * @param options - settings of indexing (NULL means default ones, mode is ignored)
+ *
+ * OUT:
+ * index gets lines of entire text, lines lengths histogram is dropped if there's not enough memory for it
+ * (arrays of index loaded from cache file are copied into memory first)
+ * @return code of error occured during indexing (index is unchanged if it's not ERR_NO)
+ */
+ErrorType AppendLineIndex(LineIndex * index, char const * tail, TextReader read, void * source, long long size,
+                          IndexerOptions const * options) {
+    IndexerOptions flatOptions = { INDEXER_KERNEL_AUTO, 0, LINE_INDEX_FLAT };
+    ShiftedText shifted;
+    long long tailLine, tailBegin;
+    long long oldLinesNumber;   // lines number of indexed text
+    long long linesNumber;      // lines number of grown index
+    long long * beginnings = NULL;
+    long long removedLengths[2];    // lengths of rescanned lines
+    long long blockBegin, line;
+    LineIndex added;            // index of tail
+    ErrorType errorType;
+    BOOL histogram;
+
+    if (index == NULL || (tail == NULL && read == NULL) || index->unfinished)
+        return ERR_NULL_PTR;
+    oldLinesNumber = index->linesNumber;
+    tailLine  = GetLineIndexTail(index);
+    tailBegin = GetIndexedLineBeginning(index, tailLine);
+    if (size < GetIndexedLineBeginning(index, oldLinesNumber))
+        return ERR_READ;    // text is shorter than indexed one
+    errorType = DetachLineIndex(index);
+    if (errorType != ERR_NO)
+        return errorType;
+    histogram = (index->lengthCounts != NULL);
+
+    for (line = tailLine; line < oldLinesNumber; ++line)
+        removedLengths[line - tailLine] = GetLineContentEnd(index, line) - GetIndexedLineBeginning(index, line);
+
+    if (options != NULL) {
+        flatOptions.kernel        = options->kernel;
+        flatOptions.threadsNumber = options->threadsNumber;
+    }
+    if (tail != NULL)
+        errorType = BuildLineIndex(&added, tail, size - tailBegin, &flatOptions);
+    else {
+        shifted.read   = read;
+        shifted.source = source;
+        shifted.base   = tailBegin;
+        errorType = BuildStreamLineIndex(&added, ReadShiftedText, &shifted, size - tailBegin, &flatOptions);
+    }
+    if (errorType != ERR_NO)
+        return errorType;
+    linesNumber = tailLine + added.linesNumber;
+
+    if (!ReserveLines(index, linesNumber)) {
+        DestroyLineIndex(&added);
+        return ERR_NOMEM;
+    }
+
+    // packed blocks are rebuilt starting from the block of the first rescanned line
+    if (index->mode == LINE_INDEX_PACKED) {
+        blockBegin = tailLine & ~(long long)(LINE_BLOCK_SIZE - 1);
+        beginnings = FitsAddressSpace(linesNumber - blockBegin + 1, sizeof(long long)) ?
+                     (long long*)malloc((size_t)(linesNumber - blockBegin + 1) * sizeof(long long)) : NULL;
+        if (beginnings == NULL) {
+            DestroyLineIndex(&added);
+            return ERR_NOMEM;
+        }
+        for (line = blockBegin; line < tailLine; ++line)
+            beginnings[line - blockBegin] = GetIndexedLineBeginning(index, line);
+        for (line = tailLine; line < linesNumber; ++line)
+            beginnings[line - blockBegin] = added.lineBeginnings[line - tailLine] + tailBegin;
+        beginnings[linesNumber - blockBegin] = size;
+
+        errorType = PackLineBlocks(index, blockBegin >> LINE_BLOCK_SHIFT, beginnings, linesNumber + 1);
+        free(beginnings);
+        if (errorType != ERR_NO) {
+            DestroyLineIndex(&added);
+            return errorType;
+        }
+    }
+
+    if (index->mode == LINE_INDEX_FLAT) {
+        for (line = tailLine + 1; line < linesNumber; ++line)
+            index->lineBeginnings[line] = added.lineBeginnings[line - tailLine] + tailBegin;
+        index->lineBeginnings[linesNumber] = size;  // special value to check end of text
+    }
+    for (line = tailLine; line < oldLinesNumber; ++line)
+        index->crlfLines[line >> 3] &= (unsigned char)~(1 << (line & 7));
+    CopyBits(index->crlfLines, added.crlfLines, added.linesNumber, tailLine);
+    index->linesNumber = linesNumber;
+    if (index->maxLength < added.maxLength)
+        index->maxLength = added.maxLength;
+
+    // rescanned lines are counted again with their new lengths
+    for (line = tailLine; line < oldLinesNumber && histogram; ++line)
+        histogram = AddLineLength(index, removedLengths[line - tailLine], -1);
+    for (line = tailLine; line < linesNumber && histogram; ++line)
+        histogram = AddLineLength(index, GetLineContentEnd(index, line) - GetIndexedLineBeginning(index, line), 1);
+    if (!histogram) {
+        // without lengths histogram rows are counted line by line
+        free(index->lengthCounts);
+        free(index->longLengths);
+        index->lengthCounts  = NULL;
+        index->longLengths   = NULL;
+        index->lengthsNumber = 0;
+    }
+
+    DestroyLineIndex(&added);
+    return ERR_NO;
+}
+
+#define LINE_INDEX_MAGIC "LINEIDX1"     // beginning of cache file, the digit is version of it's format
+#define HASH_SAMPLES_NUMBER 64          // cached index is checked against hash of this number of text samples
+#define HASH_SAMPLE_SIZE 4096           // size of each sample in bytes
+
+// header of cache file, arrays of index follow it aligned to 8 bytes
+typedef struct {
+    char magic[8];              // LINE_INDEX_MAGIC (written after all arrays, so interrupted saving leaves it invalid)
+    long long layout;           // size of LineBlock: files written by builds with other layout aren't read
+    long long size;             // size of indexed text
+    long long modified;         // time of the last modification of text file when index has been saved
+    unsigned long long hash;    // hash of text samples (see HashTextSamples)
+    long long mode;             // LineIndexMode of saved index
+    long long linesNumber;      // number of lines
+    long long maxLength;        // length of the longest line content
+    long long deltasSize;       // size of deltas pool of packed index in bytes
+    long long lengthsNumber;    // number of long lengths in histogram (-1 if there's no histogram)
+} LineIndexFileHeader;
+
+/**
+ * Hashes samples spread evenly over text: changes of text of the same size and time of modification
+ * (like files restored from backups) are noticed without reading entire text.
+ * IN:
+ * @param data - text (NULL if it's read with read function)
+ * @param read - function reading text (used if data is NULL)
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ *
+ * OUT:
+ * @param hash - gets FNV-1a hash of samples
+ * @return FALSE if text can't be read, TRUE else
+ */
+static BOOL HashTextSamples(char const * data, TextReader read, void * source, long long size, unsigned long long * hash) {
+    char buffer[HASH_SAMPLE_SIZE];
+    char const * sample;
+    long long offset, length;
+    int i, j;
+
+    *hash = 14695981039346656037ULL;
+    length = min(size, HASH_SAMPLE_SIZE);
+    for (i = 0; i < HASH_SAMPLES_NUMBER; ++i) {
+        offset = (size - length) / (HASH_SAMPLES_NUMBER - 1) * i;
+        if (i == HASH_SAMPLES_NUMBER - 1)
+            offset = size - length;     // the end of text is sampled exactly
+        sample = data + offset;
+        if (data == NULL) {
+            if (length > 0 && !read(source, offset, buffer, (size_t)length))
+                return FALSE;
+            sample = buffer;
+        }
+        for (j = 0; j < length; ++j)
+            *hash = (*hash ^ (unsigned char)sample[j]) * 1099511628211ULL;
+    }
+    return TRUE;
+}
+
+/**
+ * Gives name of cache file of index of text file.
+ * IN:
+ * @param filename - name of text file
+ *
+ * OUT:
+ * @return allocated name (NULL if there's not enough memory)
+ */
+static char * GetLineIndexFilename(char const * filename) {
+    char * indexFilename = (char*)malloc(strlen(filename) + sizeof(LINE_INDEX_FILE_EXTENSION));
+
+    if (indexFilename != NULL) {
+        strcpy(indexFilename, filename);
+        strcat(indexFilename, LINE_INDEX_FILE_EXTENSION);
+    }
+    return indexFilename;
+}
+
+/**
+ * Gives size of array in cache file (arrays are aligned to 8 bytes).
+ * IN:
+ * @param size - size of array in bytes
+ *
+ * OUT:
+ * @return size of array with padding
+ */
+static long long AlignArraySize(long long size) {
+    return (size + 7) & ~7LL;
+}
+
+/**
+ * Writes array into cache file followed by padding up to 8 bytes.
+ * IN:
+ * @param file - cache file
+ * @param array - array to write (may be NULL if size is 0)
+ * @param size - size of array in bytes
+ *
+ * OUT:
+ * @return TRUE if successed, FALSE else
+ */
+static BOOL WriteArray(FILE * file, void const * array, long long size) {
+    static char const padding[8] = { 0 };
+
+    if (size > 0 && fwrite(array, 1, (size_t)size, file) != (size_t)size)
+        return FALSE;
+    size = AlignArraySize(size) - size;
+    return size == 0 || fwrite(padding, 1, (size_t)size, file) == (size_t)size;
+}
+
+/**
+ * Saves complete index next to text file, so the next opening of the same file doesn't scan it.
+ * IN:
+ * @param index - pointer to complete index of entire text
+ * @param filename - name of indexed text file
+ * @param data - text (NULL if it's read with read function)
+ * @param read - function reading text (used if data is NULL)
+ * @param source - argument of read
+ *
+ * OUT:
+ * @return code of error occured during saving (ERR_NO if successed), partially written file is removed
+ */
+ErrorType SaveLineIndex(LineIndex const * index, char const * filename, char const * data, TextReader read, void * source) {
+    LineIndexFileHeader header;
+    long long blocksNumber, fileSize;
+    char * indexFilename;
+    FILE * file;
+    BOOL written;
+
+    if (index == NULL || filename == NULL || index->linesNumber <= 0 || index->unfinished || (data == NULL && read == NULL))
+        return ERR_NULL_PTR;
+
+    memset(&header, 0, sizeof(LineIndexFileHeader));
+    header.layout        = sizeof(LineBlock);
+    header.size          = GetIndexedLineBeginning(index, index->linesNumber);
+    header.mode          = index->mode;
+    header.linesNumber   = index->linesNumber;
+    header.maxLength     = index->maxLength;
+    header.deltasSize    = (index->mode == LINE_INDEX_PACKED) ? (long long)GetDeltasSize(index) : 0;
+    header.lengthsNumber = (index->lengthCounts != NULL) ? index->lengthsNumber : -1;
+    blocksNumber = (index->linesNumber + LINE_BLOCK_SIZE) / LINE_BLOCK_SIZE;
+
+    // text changed since it has been indexed isn't described by index
+    if (GetFileStamp(filename, &fileSize, &header.modified) != ERR_NO)
+        return ERR_OPEN_FILE;
+    if (fileSize != header.size)
+        return ERR_READ;
+    if (!HashTextSamples(data, read, source, header.size, &header.hash))
+        return ERR_READ;
+
+    indexFilename = GetLineIndexFilename(filename);
+    if (indexFilename == NULL)
+        return ERR_NOMEM;
+    file = fopen(indexFilename, "wb");
+    if (file == NULL) {
+        free(indexFilename);
+        return ERR_OPEN_FILE;
+    }
+
+    written = fwrite(&header, sizeof(LineIndexFileHeader), 1, file) == 1;
+    if (index->mode == LINE_INDEX_FLAT)
+        written = written && WriteArray(file, index->lineBeginnings, (index->linesNumber + 1) * (long long)sizeof(long long));
+    else
+        written = written && WriteArray(file, index->blocks, blocksNumber * (long long)sizeof(LineBlock)) &&
+                  WriteArray(file, index->deltas, header.deltasSize);
+    written = written && WriteArray(file, index->crlfLines, index->linesNumber / 8 + 1);
+    if (index->lengthCounts != NULL)
+        written = written && WriteArray(file, index->lengthCounts, LENGTH_COUNTS_SIZE * (long long)sizeof(long long)) &&
+                  WriteArray(file, index->longLengths, index->lengthsNumber * (long long)sizeof(LengthCount));
+
+    // file becomes valid only when everything else is written
+    memcpy(header.magic, LINE_INDEX_MAGIC, sizeof(header.magic));
+    written = written && fflush(file) == 0 && SeekFile(file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(LineIndexFileHeader), 1, file) == 1;
+    if (fclose(file) != 0)
+        written = FALSE;
+    if (!written)
+        remove(indexFilename);
+    free(indexFilename);
+    return written ? ERR_NO : ERR_WRITE;
+}
+
+/**
+ * Finds group of long lines of specified length in histogram of lines lengths.
+ * IN:
+ * @param index - pointer to index with histogram built
+ * @param length - length of line content (not less than LENGTH_COUNTS_SIZE)
+ *
+ * OUT:
+ * @return number of group in index->longLengths (-1 if there's no such length)
+ */
+static long long FindLongLength(LineIndex const * index, long long length) {
+    long long left = 0;
+    long long right = index->lengthsNumber;
+    long long middle;
+
+    while (left < right) {
+        middle = left + (right - left) / 2;
+        if (index->longLengths[middle].length < length)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+    return (left < index->lengthsNumber && index->longLengths[left].length == length) ? left : -1;
+}
+
+/**
+ * Checks index loaded from cache file in a single pass, so damaged file can't make text be read out of it's bounds.
+ * Lengths of lines are counted again and compared with histogram, so most damages of line breaks are noticed too.
+ * IN:
+ * @param index - pointer to loaded index
+ * @param size - size of text
+ * @param deltasSize - size of loaded deltas pool of packed index in bytes
+ *
+ * OUT:
+ * @return TRUE if lines cover entire text in order and lengths match histogram,
+ * FALSE if index is damaged or there's not enough memory to check it
+ */
+static BOOL IsLineIndexConsistent(LineIndex const * index, long long size, size_t deltasSize) {
+    long long blocksNumber = (index->linesNumber + LINE_BLOCK_SIZE) / LINE_BLOCK_SIZE;
+    long long maxLength = 0;
+    long long * counts = NULL;  // recounted lengths: short ones, then long ones in order of histogram
+    long long block, line, entries, beginning, end, length, group;
+    size_t poolSize = 0;
+    BOOL consistent = TRUE;
+
+    // deltas of each block have to lie in pool one after another
+    for (block = 0; index->mode == LINE_INDEX_PACKED && block < blocksNumber; ++block) {
+        entries = min(LINE_BLOCK_SIZE, index->linesNumber + 1 - block * LINE_BLOCK_SIZE);
+        if (index->blocks[block].deltasOffset != poolSize ||
+            (index->blocks[block].deltaWidth != 2 && index->blocks[block].deltaWidth != 4 &&
+             index->blocks[block].deltaWidth != 8))
+            return FALSE;
+        poolSize += (size_t)entries * index->blocks[block].deltaWidth;
+    }
+    if (index->mode == LINE_INDEX_PACKED && poolSize != deltasSize)
+        return FALSE;
+
+    // long lengths have to be sorted for search
+    for (group = 0; index->lengthCounts != NULL && group < index->lengthsNumber; ++group) {
+        if (index->longLengths[group].length < LENGTH_COUNTS_SIZE ||
+            (group > 0 && index->longLengths[group].length <= index->longLengths[group - 1].length))
+            return FALSE;
+    }
+    if (index->lengthCounts != NULL) {
+        counts = (long long*)calloc((size_t)(LENGTH_COUNTS_SIZE + index->lengthsNumber), sizeof(long long));
+        if (counts == NULL)
+            return FALSE;
+    }
+
+    if (GetIndexedLineBeginning(index, 0) != 0 || GetIndexedLineBeginning(index, index->linesNumber) != size)
+        consistent = FALSE;
+    for (line = 0, beginning = 0; line < index->linesNumber && consistent; ++line, beginning = end) {
+        end = GetIndexedLineBeginning(index, line + 1);
+        length = end - beginning;
+        if (line < index->linesNumber - 1)
+            length -= 1 + ((index->crlfLines[line >> 3] >> (line & 7)) & 1);   // see GetLineContentEnd
+        if (end < beginning + (line < index->linesNumber - 1) || length < 0) {
+            consistent = FALSE;
+            break;
+        }
+        maxLength = max(maxLength, length);
+
+        if (counts == NULL)
+            continue;
+        if (length < LENGTH_COUNTS_SIZE)
+            counts[length]++;
+        else if ((group = FindLongLength(index, length)) >= 0)
+            counts[LENGTH_COUNTS_SIZE + group]++;
+        else
+            consistent = FALSE;
+    }
+    consistent = consistent && maxLength == index->maxLength;
+
+    for (length = 0; counts != NULL && length < LENGTH_COUNTS_SIZE && consistent; ++length)
+        consistent = (counts[length] == index->lengthCounts[length]);
+    for (group = 0; counts != NULL && group < index->lengthsNumber && consistent; ++group)
+        consistent = (counts[LENGTH_COUNTS_SIZE + group] == index->longLengths[group].linesNumber);
+    free(counts);
+    return consistent;
+}
+
+/**
+ * Loads index of text file saved next to it with SaveLineIndex. Cache file is mapped, so loading doesn't depend
+ * on number of lines except for one pass checking it. Cache file of other text (other size, time of modification
+ * or samples of text) or of other mode is removed, as well as damaged one.
+ * Does not print errors: caller is expected to build index if loading fails.
+ * IN:
+ * @param filename - name of text file
+ * @param data - text (NULL if it's read with read function)
+ * @param read - function reading text (used if data is NULL)
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ * @param mode - representation of index expected
+ *
+ * OUT:
+ * @param index - gets loaded index (arrays are parts of mapped cache file until index is changed)
+ * @return ERR_OPEN_FILE if there's no cache file, ERR_READ if it's stale or damaged (ERR_NO if successed)
+ */
+ErrorType LoadLineIndex(LineIndex * index, char const * filename, char const * data, TextReader read, void * source,
+                        long long size, LineIndexMode mode) {
+    LineIndexFileHeader header;
+    FileMapping * storage;
+    unsigned long long hash;
+    long long fileSize, modified, blocksNumber, expectedSize;
+    long long offset;
+    char * indexFilename;
+    FILE * file;
+    BOOL valid;
+
+    if (index == NULL || filename == NULL || (data == NULL && read == NULL))
+        return ERR_NULL_PTR;
+    if (GetFileStamp(filename, &fileSize, &modified) != ERR_NO)
+        return ERR_OPEN_FILE;
+    indexFilename = GetLineIndexFilename(filename);
+    if (indexFilename == NULL)
+        return ERR_NOMEM;
+    file = fopen(indexFilename, "rb");
+    if (file == NULL) {
+        free(indexFilename);
+        return ERR_OPEN_FILE;
+    }
+    valid = fread(&header, sizeof(LineIndexFileHeader), 1, file) == 1;
+    fclose(file);
+
+    valid = valid && memcmp(header.magic, LINE_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+            header.layout == sizeof(LineBlock) && header.size == size && header.size == fileSize &&
+            header.modified == modified && header.mode == mode && header.linesNumber > 0 &&
+            header.linesNumber <= size + 1 && header.deltasSize >= 0 && header.deltasSize <= (size + 1) * 8 &&
+            header.lengthsNumber >= -1 && header.lengthsNumber <= header.linesNumber &&
+            HashTextSamples(data, read, source, size, &hash) && header.hash == hash;
+
+    blocksNumber = (header.linesNumber + LINE_BLOCK_SIZE) / LINE_BLOCK_SIZE;
+    expectedSize = sizeof(LineIndexFileHeader) + AlignArraySize(header.linesNumber / 8 + 1);
+    if (header.mode == LINE_INDEX_FLAT)
+        expectedSize += AlignArraySize((header.linesNumber + 1) * (long long)sizeof(long long));
+    else
+        expectedSize += AlignArraySize(blocksNumber * (long long)sizeof(LineBlock)) + AlignArraySize(header.deltasSize);
+    if (header.lengthsNumber >= 0)
+        expectedSize += AlignArraySize(LENGTH_COUNTS_SIZE * (long long)sizeof(long long)) +
+                        AlignArraySize(header.lengthsNumber * (long long)sizeof(LengthCount));
+
+    storage = valid ? (FileMapping*)malloc(sizeof(FileMapping)) : NULL;
+    if (valid && storage == NULL) {
+        free(indexFilename);
+        return ERR_NOMEM;
+    }
+    valid = valid && MapFile(storage, indexFilename) == ERR_NO;
+    valid = valid && storage->size == expectedSize;
+    if (valid) {
+        memset(index, 0, sizeof(LineIndex));
+        index->mode        = (LineIndexMode)header.mode;
+        index->linesNumber = header.linesNumber;
+        index->capacity    = header.linesNumber;
+        index->maxLength   = header.maxLength;
+        index->storage     = storage;
+
+        offset = sizeof(LineIndexFileHeader);
+        if (index->mode == LINE_INDEX_FLAT) {
+            index->lineBeginnings = (long long*)(storage->view + offset);
+            offset += AlignArraySize((header.linesNumber + 1) * (long long)sizeof(long long));
+        }
+        else {
+            index->blocks = (LineBlock*)(storage->view + offset);
+            offset += AlignArraySize(blocksNumber * (long long)sizeof(LineBlock));
+            index->deltas = (unsigned char*)(storage->view + offset);
+            offset += AlignArraySize(header.deltasSize);
+        }
+        index->crlfLines = (unsigned char*)(storage->view + offset);
+        offset += AlignArraySize(header.linesNumber / 8 + 1);
+        if (header.lengthsNumber >= 0) {
+            index->lengthCounts = (long long*)(storage->view + offset);
+            offset += AlignArraySize(LENGTH_COUNTS_SIZE * (long long)sizeof(long long));
+            index->longLengths = (header.lengthsNumber > 0) ? (LengthCount*)(storage->view + offset) : NULL;
+            index->lengthsNumber = header.lengthsNumber;
+        }
+
+        valid = IsLineIndexConsistent(index, size, (size_t)header.deltasSize);
+    }
+
+    // stale or damaged cache file is thrown away
+    if (!valid) {
+        if (storage != NULL)
+            UnmapFile(storage);
+        free(storage);
+        memset(index, 0, sizeof(LineIndex));
+        remove(indexFilename);
+        free(indexFilename);
+        return ERR_READ;
+    }
+    free(indexFilename);
+    return ERR_NO;
+}
+
+#define FIRST_SEGMENT_SIZE (1LL << 20)  // the first screen is published after scanning this
+#define MAX_SEGMENT_SIZE (64LL << 20)   // segments grow twice up to this size
+#define MAX_STREAM_SEGMENT_SIZE (8LL << 20)     // limit of segments read into window buffer
+
+struct tag_LineIndexBuilder {
+    char const * data;          // text being indexed (NULL if it's read by segments)
+    TextReader read;            // function reading segments of text which isn't kept in memory
+    void * source;              // argument of read
+    char * window;              // buffer for segment read with one byte around it
+    long long maxSegmentSize;   // size segments grow up to
+    long long size;             // size of text
+    IndexerKernel kernel;       // supported kernel to scan text with
+    int threadsNumber;          // number of threads scanning each segment
+    LineIndexMode mode;         // representation of complete index
+    IndexerCallback notify;     // function called after each published snapshot (may be NULL)
+    void * context;             // argument of notify
+    ThreadHandle thread;        // background indexing thread
+    LineIndex live;             // lines found by indexing thread, the last one is unfinished
+
+    // fields below are guarded by mutex
+    Mutex mutex;
+    LineIndex snapshot;         // the latest published index (or complete one if finished)
+    void ** retired;            // arrays replaced by indexing thread which snapshots may still refer to
+    int retiredNumber;          // number of retired arrays
+    int retiredCapacity;        // number of items retired array is allocated for
+    long long scanned;          // number of bytes indexed
+    BOOL cancelled;             // set to stop indexing
+    BOOL finished;              // set when snapshot won't change anymore
+    BOOL handedOver;            // set when finished snapshot is taken and owned by caller
+    ErrorType errorType;        // result of indexing
+
+    // snapshot of a single empty line shown until the first lines are indexed
+    long long emptyBeginnings[2];
+    unsigned char emptyCrlfLines[1];
+};
+
+/**
+ * Saves arrays replaced by indexing thread until snapshots referring to them are taken.
+ * Either both arrays are saved or none of them.
+ * IN:
+ * @param builder - pointer to builder
+ * @param first, second - pointers to retired arrays (second may be NULL)
+ *
+ * OUT:
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL RetireArrays(LineIndexBuilder * builder, void * first, void * second) {
+    void ** retired;
+    int capacity;
+    BOOL successed = TRUE;
+
+    LockMutex(&builder->mutex);
+    if (builder->retiredNumber + 2 > builder->retiredCapacity) {
+        capacity = (builder->retiredCapacity == 0) ? 16 : builder->retiredCapacity * 2;
+        retired = (void**)realloc(builder->retired, capacity * sizeof(void*));
+        if (retired != NULL) {
+            builder->retired = retired;
+            builder->retiredCapacity = capacity;
+        }
+        else
+            successed = FALSE;
+    }
+    if (successed) {
+        builder->retired[builder->retiredNumber++] = first;
+        if (second != NULL)
+            builder->retired[builder->retiredNumber++] = second;
+    }
+    UnlockMutex(&builder->mutex);
+    return successed;
+}
+
+/**
+ * Makes sure live index of builder has room for specified number of lines.
+ * Arrays aren't reallocated in place: published snapshots keep reading old ones,
+ * which are retired and freed when newer snapshot is taken.
+ * IN:
+ * @param builder - pointer to builder
+ * @param linesNumber - number of lines to keep
+ *
+ * OUT:
+ * builder->live may get new arrays with copied content
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL GrowLiveIndex(LineIndexBuilder * builder, long long linesNumber) {
+    LineIndex * live = &builder->live;
+    long long capacity = live->capacity;
+    long long * lineBeginnings;
+    unsigned char * crlfLines;
+
+    if (linesNumber <= capacity)
+        return TRUE;
+    while (capacity < linesNumber)
+        capacity *= 2;
+
+    if (!FitsAddressSpace(capacity + 1, sizeof(long long)))
+        return FALSE;
+    lineBeginnings = (long long*)malloc((capacity + 1) * sizeof(long long));
+    crlfLines = (unsigned char*)calloc(capacity / 8 + 1, sizeof(unsigned char));
+    if (lineBeginnings == NULL || crlfLines == NULL) {
+        free(lineBeginnings);
+        free(crlfLines);
+        return FALSE;
+    }
+    memcpy(lineBeginnings, live->lineBeginnings, live->linesNumber * sizeof(long long));
+    memcpy(crlfLines, live->crlfLines, live->capacity / 8 + 1);
+
+    if (!RetireArrays(builder, live->lineBeginnings, live->crlfLines)) {
+        free(lineBeginnings);
+        free(crlfLines);
+        return FALSE;
+    }
+
+    live->lineBeginnings = lineBeginnings;
+    live->crlfLines      = crlfLines;
+    live->capacity       = capacity;
+    return TRUE;
+}
+
+/**
+ * Appends lines found in chunk to live index of builder.
+ * IN:
+ * @param builder - pointer to builder
+ * @param partial - pointer to lines found in chunk (lineBeginnings[0] is chunk beginning)
+ * @param base - index of text byte chunk positions are counted from
+ *
+ * OUT:
+ * builder->live gets lines beginning in chunk, it's maxLength is updated with lines finished in chunk
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL AppendChunk(LineIndexBuilder * builder, LineIndex const * partial, long long base) {
+    LineIndex * live = &builder->live;
+    long long linesNumber = partial->linesNumber - 1;   // lines beginning in chunk
+    long long line = live->linesNumber - 1;             // line finished in chunk
+    long long lineEnd, i;
+
+    if (linesNumber == 0)
+        return TRUE;    // the whole chunk belongs to unfinished line
+    if (!GrowLiveIndex(builder, live->linesNumber + linesNumber))
+        return FALSE;
+
+    for (i = 0; i < linesNumber; ++i)
+        live->lineBeginnings[live->linesNumber + i] = partial->lineBeginnings[i + 1] + base;
+    CopyBits(live->crlfLines, partial->crlfLines, linesNumber, line);
+    live->linesNumber += linesNumber;
+
+    // unfinished line may start in previous chunks, so it's length is counted here
+    lineEnd = live->lineBeginnings[line + 1] - 1;
+    if (live->crlfLines[line >> 3] & (1 << (line & 7)))
+        lineEnd--;
+    if (live->maxLength < lineEnd - live->lineBeginnings[line])
+        live->maxLength = lineEnd - live->lineBeginnings[line];
+    if (live->maxLength < partial->maxLength)
+        live->maxLength = partial->maxLength;
+    return TRUE;
+}
+
+/**
+ * Scans segment of text with several threads and appends found lines to live index of builder.
+ * IN:
+ * @param builder - pointer to builder
+ * @param data - text containing segment
+ * @param size - size of data (bytes after segment are only looked at to classify it's last line break)
+ * @param base - index of text byte data begins with
+ * @param begin - index of the first byte of segment in data
+ * @param end - index of the byte after segment in data
+ *
+ * OUT:
+ * builder->live gets lines beginning in segment
+ * @return code of error occured during scanning (ERR_NO if successed)
+ */
+static ErrorType ScanSegment(LineIndexBuilder * builder, char const * data, long long size, long long base,
+                             long long begin, long long end) {
+    IndexerTask tasks[64];
+    ErrorType errorType = ERR_NO;
+    int tasksNumber = builder->threadsNumber;
+    int i;
+
+    if (tasksNumber > (end - begin) / MIN_CHUNK_SIZE)
+        tasksNumber = (int)((end - begin) / MIN_CHUNK_SIZE);
+    if (tasksNumber > (int)(sizeof(tasks) / sizeof(tasks[0])))
+        tasksNumber = (int)(sizeof(tasks) / sizeof(tasks[0]));
+    if (tasksNumber < 1)
+        tasksNumber = 1;
+
+    memset(tasks, 0, sizeof(tasks));
+    for (i = 0; i < tasksNumber; ++i) {
+        tasks[i].data   = data;
+        tasks[i].size   = size;
+        tasks[i].begin  = begin + (long long)((double)(end - begin) * i / tasksNumber);
+        tasks[i].end    = begin + (long long)((double)(end - begin) * (i + 1) / tasksNumber);
+        tasks[i].kernel = builder->kernel;
+    }
+    tasks[tasksNumber - 1].end = end;
+
+    if (tasksNumber > 1)
+        errorType = RunThreadTasks(tasks, sizeof(IndexerTask), tasksNumber, ScanChunk);
+    else
+        ScanChunk(&tasks[0]);
+
+    for (i = 0; i < tasksNumber && errorType == ERR_NO; ++i) {
+        errorType = tasks[i].errorType;
+        if (errorType == ERR_NO && !AppendChunk(builder, &tasks[i].partial, base))
+            errorType = ERR_NOMEM;
+    }
+
+    for (i = 0; i < tasksNumber; ++i)
+        DestroyLineIndex(&tasks[i].partial);
+    return errorType;
+}
+
+/**
+ * Scans segment of text and appends found lines to live index of builder.
+ * Text which isn't kept in memory is read into window buffer with one byte before and after segment,
+ * so line breaks on segment borders are classified the same way as in memory.
+ * IN:
+ * @param builder - pointer to builder
+ * @param begin - index of the first byte of segment
+ * @param end - index of the byte after segment
+ *
+ * OUT:
+ * builder->live gets lines beginning in segment
+ * @return code of error occured during scanning (ERR_NO if successed)
+ */
+static ErrorType IndexSegment(LineIndexBuilder * builder, long long begin, long long end) {
+    long long base, size;
+
+    if (builder->data != NULL)
+        return ScanSegment(builder, builder->data, builder->size, 0, begin, end);
+
+    base = (begin > 0) ? begin - 1 : 0;
+    size = ((end < builder->size) ? end + 1 : end) - base;
+    if (!builder->read(builder->source, base, builder->window, (size_t)size))
+        return ERR_READ;
+    return ScanSegment(builder, builder->window, size, base, begin - base, end - base);
+}
+
+/**
+ * Reads text which size isn't known beforehand by segments and appends found lines to live index of builder.
+ * Each segment is scanned when the byte after it is read (or text has ended),
+ * so line breaks on segment borders are classified the same way as in memory.
+ * IN:
+ * @param builder - pointer to builder with window of MAX_STREAM_SEGMENT_SIZE + 2 bytes
+ * @param stream - function reading the next part of text
+ * @param source - argument of stream
+ *
+ * OUT:
+ * builder->live gets lines of text, builder->size gets size of text
+ * @return code of error occured during reading or scanning (ERR_NO if successed)
+ */
+static ErrorType IndexSequentialText(LineIndexBuilder * builder, TextStream stream, void * source) {
+    long long segmentSize = FIRST_SEGMENT_SIZE;
+    long long begin = 0;        // index of text byte segment begins with
+    long long head = 0;         // number of bytes before segment in window (the last byte of previous segment)
+    long long filled = 0;       // number of bytes in window
+    long long wanted, portion, end;
+    BOOL ended = FALSE;
+    ErrorType errorType;
+
+    for (;;) {
+        wanted = head + segmentSize + 1;
+        while (!ended && filled < wanted) {
+            portion = stream(source, builder->window + filled, (size_t)(wanted - filled));
+            if (portion < 0)
+                return ERR_READ;
+            ended   = (portion == 0);
+            filled += portion;
+        }
+        end = begin + min(segmentSize, filled - head);
+        if (end > begin) {
+            errorType = ScanSegment(builder, builder->window, filled, begin - head, head, head + end - begin);
+            if (errorType != ERR_NO)
+                return errorType;
+        }
+        if (head + end - begin == filled) {
+            builder->size = end;
+            return ERR_NO;
+        }
+
+        // the last byte of segment and the byte after it stay in window
+        memmove(builder->window, builder->window + head + end - begin - 1, (size_t)(filled - head - (end - begin) + 1));
+        filled -= head + (end - begin) - 1;
+        head    = 1;
+        begin   = end;
+        if (segmentSize < builder->maxSegmentSize)
+            segmentSize *= 2;
+    }
+}
+
+/**
+ * Publishes lines finished in live index as a new snapshot.
+ * Lines number is rounded down to multiple of 8, so bytes of line breaks flags
+ * seen by snapshot are never written by indexing thread again.
+ * IN:
+ * @param builder - pointer to builder
+ * @param scanned - number of bytes indexed
+ *
+ * OUT:
+ * builder->snapshot gets published index
+ */
+static void PublishSnapshot(LineIndexBuilder * builder, long long scanned) {
+    LineIndex * live = &builder->live;
+    long long linesNumber = (live->linesNumber - 1) & ~7LL;
+
+    LockMutex(&builder->mutex);
+    if (linesNumber > 0) {
+        builder->snapshot.mode           = LINE_INDEX_FLAT;
+        builder->snapshot.lineBeginnings = live->lineBeginnings;
+        builder->snapshot.crlfLines      = live->crlfLines;
+        builder->snapshot.linesNumber    = linesNumber;
+        builder->snapshot.capacity       = linesNumber;
+        builder->snapshot.maxLength      = live->maxLength;
+        builder->snapshot.unfinished     = TRUE;
+    }
+    builder->scanned = scanned;
+    UnlockMutex(&builder->mutex);
+
+    if (builder->notify != NULL)
+        builder->notify(builder->context);
+}
+
+/**
+ * Completes live index after the whole text is scanned: adds the last line,
+ * counts lengths and packs lines beginnings if it's asked.
+ * IN:
+ * @param builder - pointer to builder
+ *
+ * OUT:
+ * builder->live gets complete index
+ */
+static void CompleteLiveIndex(LineIndexBuilder * builder) {
+    LineIndex * live = &builder->live;
+
+    // the last line ends with the end of text
+    if (live->maxLength < builder->size - live->lineBeginnings[live->linesNumber - 1])
+        live->maxLength = builder->size - live->lineBeginnings[live->linesNumber - 1];
+    live->lineBeginnings[live->linesNumber] = builder->size;   // special value to check end of text
+
+    CountLineLengths(live);     // without lengths histogram rows are counted line by line
+    if (builder->mode != LINE_INDEX_PACKED || BuildLineBlocks(live, NULL) != ERR_NO)
+        return;                 // flat index is complete as well
+
+    // flat lines beginnings may be read by snapshot being displayed, so they are retired
+    if (RetireArrays(builder, live->lineBeginnings, NULL))
+        live->lineBeginnings = NULL;
+    else {
+        free(live->blocks);
+        free(live->deltas);
+        live->blocks = NULL;
+        live->deltas = NULL;
+        live->mode   = LINE_INDEX_FLAT;
+    }
+}
+
+/**
+ * Cuts live index to it's finished lines if indexing has been stopped.
+ * IN:
+ * @param builder - pointer to builder
+ *
+ * OUT:
+ * builder->live gets index of text part before the unfinished line
+ */
+static void CutLiveIndex(LineIndexBuilder * builder) {
+    LineIndex * live = &builder->live;
+
+    if (live->linesNumber > 1) {
+        live->linesNumber--;
+        live->unfinished = TRUE;
+    }
+    else
+        live->lineBeginnings[1] = live->lineBeginnings[0];  // single empty line
+    CountLineLengths(live);     // without lengths histogram rows are counted line by line
+}
+
+/**
+ * Thread routine indexing text by segments and publishing snapshots after each of them.
+ * IN:
+ * @param argument - pointer to LineIndexBuilder
+ *
+ * OUT:
+ * builder->snapshot gets complete index (or index of text part if indexing is cancelled or failed)
+ */
+static void BuildLineIndexInBackground(void * argument) {
+    LineIndexBuilder * builder = (LineIndexBuilder*)argument;
+    ErrorType errorType = ERR_NO;
+    long long segmentSize = FIRST_SEGMENT_SIZE;
+    long long begin, end;
+    BOOL cancelled = FALSE;
+
+    for (begin = 0; begin < builder->size; begin = end) {
+        LockMutex(&builder->mutex);
+        cancelled = builder->cancelled;
+        UnlockMutex(&builder->mutex);
+        if (cancelled)
+            break;
+
+        end = (builder->size - begin > segmentSize) ? begin + segmentSize : builder->size;
+        errorType = IndexSegment(builder, begin, end);
+        if (errorType != ERR_NO)
+            break;
+        if (end < builder->size)
+            PublishSnapshot(builder, end);
+        if (segmentSize < builder->maxSegmentSize)
+            segmentSize *= 2;
+    }
+
+    if (errorType == ERR_NO && !cancelled)
+        CompleteLiveIndex(builder);
+    else
+        CutLiveIndex(builder);
+
+    LockMutex(&builder->mutex);
+    builder->snapshot  = builder->live;
+    builder->scanned   = builder->size;
+    builder->finished  = TRUE;
+    builder->errorType = errorType;
+    UnlockMutex(&builder->mutex);
+
+    if (builder->notify != NULL)
+        builder->notify(builder->context);
+}
+
+/**
+ * Allocates builder and initializes it's fields. Text is either kept in memory or read by segments.
+ * IN:
+ * @param data - text to index (NULL if it's read with read function)
+ * @param read - function reading segments of text (used if data is NULL)
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ * @param options - settings of indexing (NULL means default ones)
+ * @param notify - function called from indexing thread after new snapshot is published (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param builder - gets pointer to builder (it has to be freed with FreeLineIndexBuilder)
+ * @return code of error occured during creating (ERR_NO if successed)
+ */
+static ErrorType CreateLineIndexBuilder(LineIndexBuilder ** builder, char const * data, TextReader read, void * source,
+                                        long long size, IndexerOptions const * options, IndexerCallback notify, void * context) {
+    LineIndexBuilder * created;
+    ErrorType errorType;
+
+    if (builder == NULL || size < 0 || (data == NULL && read == NULL && size > 0))
+        return ERR_NULL_PTR;
+
+    created = (LineIndexBuilder*)calloc(1, sizeof(LineIndexBuilder));
+    if (created == NULL)
+        return ERR_NOMEM;
+    created->data           = data;
+    created->read           = read;
+    created->source         = source;
+    created->maxSegmentSize = (data != NULL) ? MAX_SEGMENT_SIZE : MAX_STREAM_SEGMENT_SIZE;
+    created->size           = size;
+    created->kernel         = (options != NULL) ? options->kernel : INDEXER_KERNEL_AUTO;
+    created->threadsNumber  = (options != NULL) ? options->threadsNumber : 0;
+    created->mode           = (options != NULL) ? options->mode : LINE_INDEX_FLAT;
+    created->notify         = notify;
+    created->context        = context;
+    if (created->kernel == INDEXER_KERNEL_AUTO || !IsIndexerKernelSupported(created->kernel))
+        created->kernel = DetectIndexerKernel();
+    if (created->threadsNumber <= 0)
+        created->threadsNumber = GetHardwareConcurrency();
+
+    created->snapshot.mode           = LINE_INDEX_FLAT;
+    created->snapshot.lineBeginnings = created->emptyBeginnings;
+    created->snapshot.crlfLines      = created->emptyCrlfLines;
+    created->snapshot.linesNumber    = 1;
+    created->snapshot.capacity       = 1;
+
+    // window holds the biggest segment and a byte on each side of it
+    if (data == NULL) {
+        created->window = (char*)malloc((size_t)min(size, created->maxSegmentSize) + 2);
+        if (created->window == NULL) {
+            free(created);
+            return ERR_NOMEM;
+        }
+    }
+    if (!InitLineIndex(&created->live, INITIAL_LINES_CAPACITY, 0, NULL)) {
+        free(created->window);
+        free(created);
+        return ERR_NOMEM;
+    }
+    errorType = InitMutex(&created->mutex);
+    if (errorType != ERR_NO) {
+        DestroyLineIndex(&created->live);
+        free(created->window);
+        free(created);
+        return errorType;
+    }
+
+    *builder = created;
+    return ERR_NO;
+}
+
+/**
+ * Frees memory of builder whose indexing thread is finished or hasn't been started.
+ * Index arrays are freed as well unless final snapshot has been taken.
+ * IN:
+ * @param builder - pointer to builder
+ */
+static void FreeLineIndexBuilder(LineIndexBuilder * builder) {
+    int i;
+
+    for (i = 0; i < builder->retiredNumber; ++i)
+        free(builder->retired[i]);
+    free(builder->retired);
+    if (!builder->handedOver)
+        DestroyLineIndex(&builder->live);
+    DestroyMutex(&builder->mutex);
+    free(builder->window);
+    free(builder);
+}
+
+/**
+ * Builds index of text which isn't kept in memory: text is read by segments into window buffer,
+ * so memory taken besides index doesn't depend on text size.
+ * IN:
+ * @param read - function reading segments of text
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ * @param options - settings of indexing (NULL means default ones)
+ *
+ * OUT:
+ * @param index - gets built index (it has to be destroyed with DestroyLineIndex)
+ * @return code of error occured during indexing (ERR_NO if successed)
+ */
+ErrorType BuildStreamLineIndex(LineIndex * index, TextReader read, void * source, long long size, IndexerOptions const * options) {
+    LineIndexBuilder * builder;
+    ErrorType errorType;
+
+    if (index == NULL || read == NULL)
+        return ERR_NULL_PTR;
+    errorType = CreateLineIndexBuilder(&builder, NULL, read, source, size, options, NULL, NULL);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    // routine of background thread runs in calling thread
+    BuildLineIndexInBackground(builder);
+    TakeLineIndexSnapshot(builder, index, &errorType);
+    FreeLineIndexBuilder(builder);
+
+    if (errorType != ERR_NO)
+        DestroyLineIndex(index);
+    return errorType;
+}
+
+/**
+ * Builds index of text which size isn't known beforehand (e.g. text decompressed on the fly):
+ * text is read once in order by segments into window buffer, so memory taken besides index doesn't depend on text size.
+ * IN:
+ * @param stream - function reading the next part of text
+ * @param source - argument of stream
+ * @param options - settings of indexing (NULL means default ones)
+ *
+ * OUT:
+ * @param index - gets built index (it has to be destroyed with DestroyLineIndex)
+ * @return code of error occured during indexing (ERR_NO if successed)
+ */
+ErrorType BuildSequentialLineIndex(LineIndex * index, TextStream stream, void * source, IndexerOptions const * options) {
+    LineIndexBuilder * builder;
+    ErrorType errorType;
+    char * window;
+
+    if (index == NULL || stream == NULL)
+        return ERR_NULL_PTR;
+    errorType = CreateLineIndexBuilder(&builder, NULL, NULL, NULL, 0, options, NULL, NULL);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    // window is allocated for the biggest segment, since size of text isn't known
+    builder->maxSegmentSize = MAX_STREAM_SEGMENT_SIZE;
+    window = (char*)realloc(builder->window, (size_t)MAX_STREAM_SEGMENT_SIZE + 2);
+    if (window == NULL) {
+        FreeLineIndexBuilder(builder);
+        return ERR_NOMEM;
+    }
+    builder->window = window;
+
+    errorType = IndexSequentialText(builder, stream, source);
+    if (errorType == ERR_NO)
+        CompleteLiveIndex(builder);
+    builder->snapshot  = builder->live;
+    builder->finished  = TRUE;
+    builder->errorType = errorType;
+    TakeLineIndexSnapshot(builder, index, &errorType);
+    FreeLineIndexBuilder(builder);
+
+    if (errorType != ERR_NO)
+        DestroyLineIndex(index);
+    return errorType;
+}
+
+/**
+ * Starts indexing of text in background thread. Found lines are published in growing snapshots
+ * (see TakeLineIndexSnapshot), the first of them comes after scanning FIRST_SEGMENT_SIZE bytes.
+ * IN:
+ * @param data - text to index (it has to stay valid until builder is destroyed)
+ * @param size - size of text in bytes
+ * @param options - settings of indexing (NULL means default ones)
+ * @param notify - function called from indexing thread after new snapshot is published (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param builder - gets pointer to started builder (it has to be destroyed with DestroyLineIndexBuilder)
+ * @return code of error occured during starting (ERR_NO if successed)
+ */
+ErrorType StartLineIndexBuilder(LineIndexBuilder ** builder, char const * data, long long size,
+                                IndexerOptions const * options, IndexerCallback notify, void * context) {
+    ErrorType errorType;
+
+    if (data == NULL && size > 0)
+        return ERR_NULL_PTR;
+    errorType = CreateLineIndexBuilder(builder, data, NULL, NULL, size, options, notify, context);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    errorType = StartThread(&(*builder)->thread, BuildLineIndexInBackground, *builder);
+    if (errorType != ERR_NO)
+        FreeLineIndexBuilder(*builder);
+    return errorType;
+}
+
+/**
+ * Starts indexing of text which isn't kept in memory in background thread.
+ * Works like StartLineIndexBuilder, but text is read by segments with read function.
+ * IN:
+ * @param read - function reading segments of text (it's called from indexing thread)
+ * @param source - argument of read (it has to stay valid until builder is destroyed)
+ * @param size - size of text in bytes
+ * @param options - settings of indexing (NULL means default ones)
+ * @param notify - function called from indexing thread after new snapshot is published (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param builder - gets pointer to started builder (it has to be destroyed with DestroyLineIndexBuilder)
+ * @return code of error occured during starting (ERR_NO if successed)
+ */
+ErrorType StartStreamIndexBuilder(LineIndexBuilder ** builder, TextReader read, void * source, long long size,
+                                  IndexerOptions const * options, IndexerCallback notify, void * context) {
+    ErrorType errorType;
+
+    if (read == NULL)
+        return ERR_NULL_PTR;
+    errorType = CreateLineIndexBuilder(builder, NULL, read, source, size, options, notify, context);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    errorType = StartThread(&(*builder)->thread, BuildLineIndexInBackground, *builder);
+    if (errorType != ERR_NO)
+        FreeLineIndexBuilder(*builder);
+    return errorType;
+}
+
+/**
+ * Takes the latest snapshot of index being built. Snapshot arrays are owned by builder
+ * and previous snapshot becomes invalid, so the taken one has to replace it right away.
+ * The final snapshot is owned by caller, who has to destroy it with DestroyLineIndex.
+ * IN:
+ * @param builder - pointer to builder
+ *
+ * OUT:
+ * @param snapshot - gets index of indexed part of text
+ * @param errorType - gets code of error occured during indexing if snapshot is final (may be NULL)
+ * @return TRUE if snapshot is final (builder can be destroyed then), FALSE else
+ */
+BOOL TakeLineIndexSnapshot(LineIndexBuilder * builder, LineIndex * snapshot, ErrorType * errorType) {
+    BOOL finished;
+    int kept = 0;
+    int i;
+
+    LockMutex(&builder->mutex);
+    *snapshot = builder->snapshot;
+    finished = builder->finished;
+    if (finished) {
+        builder->handedOver = TRUE;
+        if (errorType != NULL)
+            *errorType = builder->errorType;
+    }
+
+    // retired arrays aren't referred anymore except the ones of taken snapshot
+    for (i = 0; i < builder->retiredNumber; ++i) {
+        if (builder->retired[i] == snapshot->lineBeginnings || builder->retired[i] == snapshot->crlfLines)
+            builder->retired[kept++] = builder->retired[i];
+        else
+            free(builder->retired[i]);
+    }
+    builder->retiredNumber = kept;
+    UnlockMutex(&builder->mutex);
+
+    return finished;
+}
+
+/**
+ * Gives part of text which is already indexed.
+ * IN:
+ * @param builder - pointer to builder
+ *
+ * OUT:
+ * @return number from 0 to 1
+ */
+double GetLineIndexProgress(LineIndexBuilder * builder) {
+    double progress;
+
+    LockMutex(&builder->mutex);
+    progress = (builder->size > 0) ? (double)builder->scanned / builder->size : 1.0;
+    UnlockMutex(&builder->mutex);
+    return progress;
+}
+
+/**
+ * Asks indexing thread to stop. Index of text part indexed so far becomes final snapshot.
+ * IN:
+ * @param builder - pointer to builder
+ */
+void CancelLineIndexBuilder(LineIndexBuilder * builder) {
+    LockMutex(&builder->mutex);
+    builder->cancelled = TRUE;
+    UnlockMutex(&builder->mutex);
+}
+
+/**
+ * Stops indexing, waits for indexing thread and frees memory of builder.
+ * Index arrays are freed as well unless final snapshot has been taken.
+ * IN:
+ * @param builder - pointer to builder (may be NULL)
+ */
+void DestroyLineIndexBuilder(LineIndexBuilder * builder) {
+    if (builder == NULL)
+        return;
+
+    CancelLineIndexBuilder(builder);
+    JoinThread(builder->thread);
+    FreeLineIndexBuilder(builder);
+}
@@ -0,0 +1,123 @@
+#ifndef LINEINDEXER_H_INCLUDED
+#define LINEINDEXER_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+#include "FileMapping.h"
+
+// kernels which can be used to scan text for line breaks
+typedef enum {
+    INDEXER_KERNEL_AUTO,        // the best kernel supported by CPU
+    INDEXER_KERNEL_SCALAR,
+    INDEXER_KERNEL_SSE2,
+    INDEXER_KERNEL_AVX2,
+    INDEXER_KERNEL_AVX512,
+    INDEXER_KERNEL_NEON,
+    INDEXER_KERNELS_NUMBER
+} IndexerKernel;
+
+// representations of lines beginnings array
+typedef enum {
+    LINE_INDEX_FLAT,            // one 64-bit offset per line: the fastest access
+    LINE_INDEX_PACKED           // blocks of lines with 64-bit anchor and 16/32-bit deltas: 2-4 bytes per line
+} LineIndexMode;
+
+typedef struct {
+    IndexerKernel kernel;       // kernel to scan text with
+    int threadsNumber;          // number of threads to use (0 means number of logical processors)
+    LineIndexMode mode;         // representation of built index
+} IndexerOptions;
+
+#define LINE_BLOCK_SHIFT 6
+#define LINE_BLOCK_SIZE (1 << LINE_BLOCK_SHIFT)    // number of lines in block of packed index
+
+typedef struct {
+    long long anchor;           // beginning of the first line of block
+    size_t deltasOffset;        // offset of block deltas in pool (in bytes)
+    unsigned int deltaWidth;    // size of each delta of block in bytes (2, 4 or 8)
+} LineBlock;
+
+#define LENGTH_COUNTS_SIZE 4096     // lines shorter than this are counted in dense array
+
+typedef struct {
+    long long length;           // length of line content
+    long long linesNumber;      // number of lines of this length
+} LengthCount;
+
+/* line breaks recognized by indexer: "\n", "\r\n" and lone "\r"
+ * line content ends right before it's line break */
+typedef struct {
+    LineIndexMode mode;         // Representation of lines beginnings
+    long long * lineBeginnings; // Flat mode: array of [linesNumber + 1] lines beginnings, the last one equals to text size
+    LineBlock * blocks;         // Packed mode: array of blocks of [LINE_BLOCK_SIZE] lines beginnings
+    unsigned char * deltas;     // Packed mode: pool of lines beginnings offsets from their block anchors
+    unsigned char * crlfLines;  // Bit array of [linesNumber] flags showing lines which end with "\r\n"
+    long long linesNumber;      // Number of lines in text (number of line breaks + 1)
+    long long capacity;         // Number of lines memory is allocated for
+    long long maxLength;        // Length of the longest line content
+    long long * lengthCounts;   // Array of [LENGTH_COUNTS_SIZE] numbers of lines of each short length
+    LengthCount * longLengths;  // Sorted array of distinct lengths not shorter than LENGTH_COUNTS_SIZE
+    long long lengthsNumber;    // Number of items in longLengths
+    BOOL unfinished;            // Set if text continues after the last line, so it's line break is indexed too
+    FileMapping * storage;      // Mapped cache file the arrays point into (NULL if they're allocated)
+} LineIndex;
+
+/* arrays of destroyed index kept to build the next one in: memory which is already
+ * allocated and touched is taken instead of fresh one (see BuildLineIndexReusing) */
+typedef struct {
+    long long * lineBeginnings; // Flat lines beginnings (NULL if nothing is kept)
+    long long capacity;         // Number of lines lineBeginnings has room for
+    LineBlock * blocks;         // Blocks of packed index (NULL if nothing is kept)
+    unsigned char * deltas;     // Pool of packed lines beginnings offsets (NULL if nothing is kept)
+    size_t memory;              // Size of kept arrays in bytes
+} LineIndexSpare;
+
+#define LINE_INDEX_FILE_EXTENSION ".lines"  // complete index is cached next to text file with this suffix
+
+typedef struct tag_LineIndexBuilder LineIndexBuilder;
+
+// function called by background indexing thread when new lines are available
+typedef void (*IndexerCallback)(void * context);
+
+// function reading part of text which isn't kept in memory (returns FALSE if reading fails)
+typedef BOOL (*TextReader)(void * source, long long offset, char * buffer, size_t size);
+
+// function reading the next part of text which size isn't known beforehand
+// (returns number of read bytes, 0 at the end of text, -1 if reading fails)
+typedef long long (*TextStream)(void * source, char * buffer, size_t size);
+
+ErrorType BuildLineIndex(LineIndex * index, char const * data, long long size, IndexerOptions const * options);
+ErrorType BuildLineIndexReusing(LineIndex * index, LineIndexSpare * spare, char const * data, long long size,
+                                IndexerOptions const * options);
+ErrorType PackLineIndex(LineIndex * index);
+ErrorType AppendLineIndex(LineIndex * index, char const * tail, TextReader read, void * source, long long size,
+                          IndexerOptions const * options);
+long long GetLineIndexTail(LineIndex const * index);
+void DestroyLineIndex(LineIndex * index);
+void RetainLineIndex(LineIndex * index, LineIndexSpare * spare);
+void ReleaseLineIndexSpare(LineIndexSpare * spare);
+long long GetIndexedLineBeginning(LineIndex const * index, long long lineNumber);
+long long GetLineContentEnd(LineIndex const * index, long long lineNumber);
+long long FindIndexedLine(LineIndex const * index, long long position);
+size_t GetLineIndexMemory(LineIndex const * index);
+BOOL CountLineLengths(LineIndex * index);
+BOOL AddLineLength(LineIndex * index, long long length, long long linesNumber);
+IndexerKernel DetectIndexerKernel(void);
+BOOL IsIndexerKernelSupported(IndexerKernel kernel);
+char const * GetIndexerKernelName(IndexerKernel kernel);
+ErrorType SaveLineIndex(LineIndex const * index, char const * filename, char const * data, TextReader read, void * source);
+ErrorType LoadLineIndex(LineIndex * index, char const * filename, char const * data, TextReader read, void * source,
+                        long long size, LineIndexMode mode);
+ErrorType BuildStreamLineIndex(LineIndex * index, TextReader read, void * source, long long size, IndexerOptions const * options);
+ErrorType BuildSequentialLineIndex(LineIndex * index, TextStream stream, void * source, IndexerOptions const * options);
+ErrorType StartLineIndexBuilder(LineIndexBuilder ** builder, char const * data, long long size,
+                                IndexerOptions const * options, IndexerCallback notify, void * context);
+ErrorType StartStreamIndexBuilder(LineIndexBuilder ** builder, TextReader read, void * source, long long size,
+                                  IndexerOptions const * options, IndexerCallback notify, void * context);
+BOOL TakeLineIndexSnapshot(LineIndexBuilder * builder, LineIndex * snapshot, ErrorType * errorType);
+double GetLineIndexProgress(LineIndexBuilder * builder);
+void CancelLineIndexBuilder(LineIndexBuilder * builder);
+void DestroyLineIndexBuilder(LineIndexBuilder * builder);
+
+#endif // LINEINDEXER_H_INCLUDED
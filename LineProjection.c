@@ -0,0 +1,213 @@
+#include "LineProjection.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define INITIAL_PROJECTION_CAPACITY 256
+
+/**
+ * Gives length of line of text.
+ * IN:
+ * @param textLines - pointer to index of text lines
+ * @param textLine - number of line in text
+ *
+ * OUT:
+ * @return length of line content in units of index
+ */
+static long long GetTextLineLength(LineIndex const * textLines, long long textLine) {
+    return GetLineContentEnd(textLines, textLine) - GetIndexedLineBeginning(textLines, textLine);
+}
+
+/**
+ * Drops histogram of projected lines lengths: rows of wrap mode are counted line by line without it.
+ * IN:
+ * @param projection - pointer to projection
+ *
+ * OUT:
+ * projection->lines.lengthCounts, projection->lines.longLengths set as NULL
+ */
+static void DropProjectedLengths(LineProjection * projection) {
+    free(projection->lines.lengthCounts);
+    free(projection->lines.longLengths);
+    projection->lines.lengthCounts  = NULL;
+    projection->lines.longLengths   = NULL;
+    projection->lines.lengthsNumber = 0;
+}
+
+/**
+ * Makes sure projection has room for one more line.
+ * IN:
+ * @param projection - pointer to projection to grow
+ *
+ * OUT:
+ * projection->textLines, projection->lines.lineBeginnings, projection->lines.crlfLines may be reallocated
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL ReserveProjectedLine(LineProjection * projection) {
+    long long capacity = projection->lines.capacity;
+    long long * textLines;
+    long long * lineBeginnings;
+    unsigned char * crlfLines;
+
+    if (projection->lines.linesNumber < capacity)
+        return TRUE;
+    capacity = max(INITIAL_PROJECTION_CAPACITY, capacity * 2);
+    if ((unsigned long long)capacity >= SIZE_MAX / sizeof(long long))
+        return FALSE;
+
+    textLines = (long long*)realloc(projection->textLines, (size_t)capacity * sizeof(long long));
+    if (textLines == NULL)
+        return FALSE;
+    projection->textLines = textLines;
+
+    lineBeginnings = (long long*)realloc(projection->lines.lineBeginnings, (size_t)(capacity + 1) * sizeof(long long));
+    if (lineBeginnings == NULL)
+        return FALSE;
+    projection->lines.lineBeginnings = lineBeginnings;
+
+    // projected line breaks take one column, so their flags stay clear
+    crlfLines = (unsigned char*)realloc(projection->lines.crlfLines, (size_t)(capacity / 8 + 1));
+    if (crlfLines == NULL)
+        return FALSE;
+    memset(crlfLines + projection->lines.capacity / 8 + 1, 0, (size_t)(capacity / 8 - projection->lines.capacity / 8));
+    projection->lines.crlfLines = crlfLines;
+
+    projection->lines.capacity = capacity;
+    return TRUE;
+}
+
+/**
+ * Initializes empty projection.
+ * IN:
+ * @param projection - pointer to projection to initialize
+ *
+ * OUT:
+ * fields of projection are set to projection without lines
+ * @return code of error occured during initialization (ERR_NO if successed)
+ */
+ErrorType InitLineProjection(LineProjection * projection) {
+    if (projection == NULL)
+        return ERR_NULL_PTR;
+    memset(projection, 0, sizeof(LineProjection));    // empty projection is safe to destroy on errors
+
+    projection->lines.mode           = LINE_INDEX_FLAT;
+    projection->lines.unfinished     = TRUE;
+    projection->lines.lineBeginnings = (long long*)malloc(sizeof(long long));
+    projection->lines.crlfLines      = (unsigned char*)calloc(1, 1);
+    projection->lines.lengthCounts   = (long long*)calloc(LENGTH_COUNTS_SIZE, sizeof(long long));
+    if (projection->lines.lineBeginnings == NULL || projection->lines.crlfLines == NULL ||
+        projection->lines.lengthCounts == NULL) {
+        DestroyLineProjection(projection);
+        return ERR_NOMEM;
+    }
+    projection->lines.lineBeginnings[0] = 0;
+    return ERR_NO;
+}
+
+/**
+ * Adds line of text after the last projected line.
+ * IN:
+ * @param projection - pointer to projection
+ * @param textLines - pointer to index of text lines in units projected lines are measured in
+ * @param textLine - number of line in text (greater than numbers of projected lines)
+ *
+ * OUT:
+ * projection gets line, lines lengths histogram is dropped if there's not enough memory for it
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+BOOL AddProjectedLine(LineProjection * projection, LineIndex const * textLines, long long textLine) {
+    LineIndex * lines = &projection->lines;
+    long long length = GetTextLineLength(textLines, textLine);
+
+    if (!ReserveProjectedLine(projection))
+        return FALSE;
+    projection->textLines[lines->linesNumber] = textLine;
+    lines->lineBeginnings[lines->linesNumber + 1] = lines->lineBeginnings[lines->linesNumber] + length + 1;
+    lines->linesNumber++;
+    lines->maxLength = max(lines->maxLength, length);
+    if (lines->lengthCounts != NULL && !AddLineLength(lines, length, 1))
+        DropProjectedLengths(projection);
+    return TRUE;
+}
+
+/**
+ * Measures projected lines again after lines of text have changed their lengths
+ * (text is measured in other units or it's tail is rescanned).
+ * IN:
+ * @param projection - pointer to projection
+ * @param textLines - pointer to index of text lines in units projected lines are measured in
+ * @param firstLine - number of the first line of text which may have changed
+ *
+ * OUT:
+ * projection->lines get lengths of changed lines
+ */
+void MeasureProjectedLines(LineProjection * projection, LineIndex const * textLines, long long firstLine) {
+    LineIndex * lines = &projection->lines;
+    long long line = FindProjectedLine(projection, firstLine);
+    long long beginning = lines->lineBeginnings[line];     // beginning of line before lines are moved
+    long long length, previous;
+
+    if (line == 0)
+        lines->maxLength = 0;
+    for (; line < lines->linesNumber; ++line) {
+        length    = GetTextLineLength(textLines, projection->textLines[line]);
+        previous  = lines->lineBeginnings[line + 1] - beginning - 1;
+        beginning = lines->lineBeginnings[line + 1];
+        if (lines->lengthCounts != NULL && (!AddLineLength(lines, previous, -1) || !AddLineLength(lines, length, 1)))
+            DropProjectedLengths(projection);
+        lines->lineBeginnings[line + 1] = lines->lineBeginnings[line] + length + 1;
+        lines->maxLength = max(lines->maxLength, length);
+    }
+}
+
+/**
+ * Finds the first projected line which isn't before line of text with binary search.
+ * IN:
+ * @param projection - pointer to projection
+ * @param textLine - number of line in text
+ *
+ * OUT:
+ * @return number of projected line (number of projected lines if all of them are before textLine)
+ */
+long long FindProjectedLine(LineProjection const * projection, long long textLine) {
+    long long low = 0;
+    long long high = projection->lines.linesNumber;
+    long long middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (projection->textLines[middle] < textLine)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * Gives number of bytes occupied by projection.
+ * IN:
+ * @param projection - pointer to projection
+ *
+ * OUT:
+ * @return size of projection arrays in bytes
+ */
+size_t GetLineProjectionMemory(LineProjection const * projection) {
+    return GetLineIndexMemory(&projection->lines) + (size_t)projection->lines.capacity * sizeof(long long);
+}
+
+/**
+ * Frees memory allocated for projection.
+ * IN:
+ * @param projection - pointer to projection to destroy
+ *
+ * OUT:
+ * fields of projection are set to empty projection
+ */
+void DestroyLineProjection(LineProjection * projection) {
+    if (projection == NULL)
+        return;
+    DestroyLineIndex(&projection->lines);
+    free(projection->textLines);
+    memset(projection, 0, sizeof(LineProjection));
+}
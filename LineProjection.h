@@ -0,0 +1,23 @@
+#ifndef LINEPROJECTION_H_INCLUDED
+#define LINEPROJECTION_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+#include "LineIndexer.h"
+
+/* lines of text shown by filter: their numbers in text and flat index of their lengths where they follow one another,
+ * each line break takes one column. Rows of wrap mode, cursors and scrollbars count projected lines like lines of text */
+typedef struct {
+    long long * textLines;      // Array of [lines.linesNumber] numbers of projected lines in text (ascending)
+    LineIndex lines;            // Flat index of projected lines in columns (unfinished, so the last line has break too)
+} LineProjection;
+
+ErrorType InitLineProjection(LineProjection * projection);
+BOOL AddProjectedLine(LineProjection * projection, LineIndex const * textLines, long long textLine);
+void MeasureProjectedLines(LineProjection * projection, LineIndex const * textLines, long long firstLine);
+long long FindProjectedLine(LineProjection const * projection, long long textLine);
+size_t GetLineProjectionMemory(LineProjection const * projection);
+void DestroyLineProjection(LineProjection * projection);
+
+#endif // LINEPROJECTION_H_INCLUDED
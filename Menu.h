@@ -1,10 +1,28 @@
-#ifndef MENU_H_INCLUDED
-#define MENU_H_INCLUDED
-
-#define IDM_FILE_OPEN     0x10
-#define IDM_FILE_EXIT     0x20
-
-#define IDM_VIEW_STANDARD 0x100
-#define IDM_VIEW_WRAP     0x200
-
-#endif // MENU_H_INCLUDED
+#ifndef MENU_H_INCLUDED
+#define MENU_H_INCLUDED
+
+#define IDM_FILE_OPEN     0x10
+#define IDM_FILE_EXIT     0x20
+#define IDM_FILE_CLOSE    0x08
+
+#define IDM_VIEW_STANDARD 0x100
+#define IDM_VIEW_WRAP     0x200
+#define IDM_VIEW_FOLLOW   0x400
+#define IDM_VIEW_UTF8     0x080
+#define IDM_VIEW_TABS     0x040
+#define IDM_VIEW_HIGHLIGHT 0x500
+#define IDM_VIEW_FILTER    0x600
+#define IDM_VIEW_REFINE    0x700
+#define IDM_VIEW_UNFILTER  0x900
+
+#define IDM_SEARCH_FIND     0x1000
+#define IDM_SEARCH_NEXT     0x2000
+#define IDM_SEARCH_PREVIOUS 0x4000
+#define IDM_SEARCH_REGEX    0x8000
+#define IDM_SEARCH_INDEX    0x0800
+
+#define IDM_WINDOW_NEXT     0x01
+#define IDM_WINDOW_PREVIOUS 0x02
+#define IDM_WINDOW_MEMORY   0x04
+
+#endif // MENU_H_INCLUDED
@@ -0,0 +1,763 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TextModel.h"
+#include "DocumentManager.h"
+#include "DisplayList.h"
+#include "LineIndexer.h"
+#include "Error.h"
+#include "Trace.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define DEFAULT_MODEL_CORPUS_SIZE (64LL << 20)
+#define MODEL_BENCHMARK_FILE "ModelBenchmark.txt"   // temporary file corpora are written into
+#define BUILD_REPEATS_NUMBER 3
+#define SCREEN_COLUMNS 120
+#define SCREEN_ROWS 50
+#define HEADLESS_ROW_SIZE (SCREEN_COLUMNS * 4)     // row of UTF-8 characters takes at most 4 bytes per column
+#define SCROLLS_NUMBER 2000
+#define FILTER_PATTERN "a="        // lines shown by filter, refined with REFINE_PATTERN
+#define REFINE_PATTERN "b"
+#define MODEL_BENCHMARK_TRACE "ModelBenchmark.trace.json"   // trace written by build with tracing
+
+// kinds of generated text
+typedef enum {
+    CORPUS_SHORT_LINES,         // log-like lines of up to 100 symbols
+    CORPUS_LONG_LINES,          // lines of thousands of symbols
+    CORPUS_MINIFIED,            // lines of megabytes without breaks (like minified scripts)
+    CORPUS_MIXED,               // mostly short lines with some long and huge ones, tabs and UTF-8 characters
+    CORPORA_NUMBER
+} CorpusKind;
+
+// measured operations of text model
+typedef enum {
+    OPERATION_BUILD,            // BuildTextModel: loading and indexing of file
+    OPERATION_REBUILD,          // RebuildTextModel: reopening of file in memory of replaced model
+    OPERATION_METRICS,          // UpdateModelMetrics in standard mode
+    OPERATION_PAINT,            // GetLineStandard for each row of screen
+    OPERATION_SCROLL,           // scrollToIncrementY with UpdateModelStandardY for thumb jump
+    OPERATION_METRICS_WRAP,     // UpdateModelMetrics in wrap mode after width change (rows are recounted)
+    OPERATION_LINE_WRAP,        // UpdateModelWrapY by a row down
+    OPERATION_PAGE_WRAP,        // UpdateModelWrapY by a screen down
+    OPERATION_SCROLL_WRAP,      // scrollToIncrementY with UpdateModelWrapY for thumb jump
+    OPERATION_PAINT_WRAP,       // GetLineWrap for each row of screen
+    OPERATION_FRAME,            // BuildDisplayList with DiffDisplayList after scrolling by line
+    OPERATION_ROWS_LINE,        // rows repainted after scrolling by line
+    OPERATION_ROWS_COLUMN,      // rows repainted after scrolling by column
+    OPERATION_ROWS_LINE_WRAP,   // rows repainted after scrolling by row in wrap mode
+    OPERATION_HIGHLIGHT,        // BuildDisplayList with GetDisplayRowRuns for each row of screen at random line
+    OPERATION_HIGHLIGHT_LINE,   // BuildDisplayList with GetDisplayRowRuns after scrolling by line
+    OPERATION_FILTER,           // StartFilter until all matching lines are shown
+    OPERATION_REFINE,           // StartFilter refining shown lines until all of them are filtered
+    OPERATION_SHOW,             // ShowDocument of document kept in memory
+    OPERATION_SHOW_UNLOADED,    // ShowDocument of document unloaded to fit into budget
+    OPERATIONS_NUMBER
+} Operation;
+
+static char const * const corpusNames[CORPORA_NUMBER] = { "short", "long", "minified", "mixed" };
+static char const * const operationNames[OPERATIONS_NUMBER] = {
+    "BuildTextModel ms", "RebuildTextModel ms", "UpdateModelMetrics us", "GetLineStandard screen us", "scrollToIncrementY us",
+    "UpdateModelMetrics wrap us", "UpdateModelWrapY row us", "UpdateModelWrapY page us", "scrollToIncrementY wrap us", "GetLineWrap screen us",
+    "display list frame us", "rows per line scroll", "rows per column scroll", "rows per line scroll wrap",
+    "highlighted screen us", "highlighted line scroll us", "StartFilter ms", "refined filter ms",
+    "ShowDocument us", "ShowDocument unloaded ms"
+};
+
+// text screen frames are painted on instead of window, so repainting is checked without GDI
+typedef struct {
+    char text[SCREEN_ROWS][HEADLESS_ROW_SIZE];
+    long long lengths[SCREEN_ROWS];
+} HeadlessScreen;
+
+/**
+ * Gives current value of monotonic clock.
+ * OUT:
+ * @return time in seconds
+ */
+static double GetSeconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+ * Gives the next pseudo-random number.
+ * INOUT:
+ * @param seed - state of generator
+ *
+ * OUT:
+ * @return number from 0 to 32767
+ */
+static unsigned int NextRandom(unsigned int * seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7FFF;
+}
+
+/**
+ * Fills buffer with text of specified kind.
+ * IN:
+ * @param kind - kind of text
+ * @param size - size of buffer
+ *
+ * OUT:
+ * @param buffer - gets generated text
+ */
+static void GenerateModelCorpus(CorpusKind kind, char * buffer, long long size) {
+    static char const alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789 =:[]";
+    static char const minified[] = "{}[](),;:=+-*/<>!?\"'.abcdefghijklmnopqrstuvwxyz0123456789";
+    static char const * const symbols[] = { "a", "b", "=", " ", " ", "\t", "\xD0\x96", "\xE2\x82\xAC" };
+    unsigned int seed = 2020 + (unsigned int)kind;
+    long long position = 0;
+    long long lineEnd;
+    unsigned int choice;
+    char const * symbol;
+
+    while (position < size) {
+        choice = NextRandom(&seed);
+        switch (kind) {
+        case CORPUS_SHORT_LINES:
+            lineEnd = position + choice % 100;
+            break;
+        case CORPUS_LONG_LINES:
+            lineEnd = position + 1000 + (long long)choice % 5000;
+            break;
+        case CORPUS_MINIFIED:
+            lineEnd = position + (1LL << 20) + (long long)choice * 96;
+            break;
+        default:
+            // 1 of 100 lines is long, 1 of 10000 is huge
+            lineEnd = position + choice % 100;
+            if (choice % 100 == 0)
+                lineEnd += 2000 + NextRandom(&seed) % 3000;
+            if (choice % 10000 == 0)
+                lineEnd += 1LL << 20;
+            break;
+        }
+
+        while (position < lineEnd && position < size) {
+            choice = NextRandom(&seed);
+            if (kind == CORPUS_MINIFIED)
+                buffer[position++] = minified[choice % (sizeof(minified) - 1)];
+            else if (kind != CORPUS_MIXED)
+                buffer[position++] = alphabet[choice % (sizeof(alphabet) - 1)];
+            else {
+                symbol = symbols[choice % (sizeof(symbols) / sizeof(symbols[0]))];
+                if (position + (long long)strlen(symbol) > size)
+                    symbol = "a";   // characters aren't cut by the end of buffer
+                while (*symbol != '\0')
+                    buffer[position++] = *symbol++;
+            }
+        }
+        if (position < size)
+            buffer[position++] = '\n';
+    }
+}
+
+/**
+ * Writes text into file.
+ * IN:
+ * @param filename - name of file
+ * @param data - text
+ * @param size - size of text in bytes
+ *
+ * OUT:
+ * @return code of error occured during writing (ERR_NO if successed)
+ */
+static ErrorType WriteCorpus(char const * filename, char const * data, long long size) {
+    FILE * file = fopen(filename, "wb");
+    ErrorType errorType = ERR_NO;
+
+    if (file == NULL)
+        return ERR_OPEN_FILE;
+    if (fwrite(data, 1, (size_t)size, file) != (size_t)size)
+        errorType = ERR_WRITE;
+    if (fclose(file) != 0)
+        errorType = ERR_WRITE;
+    return errorType;
+}
+
+/**
+ * Removes line index saved next to file, so the next model is built by indexing file again.
+ * IN:
+ * @param filename - name of text file
+ */
+static void RemoveSavedIndex(char const * filename) {
+    char indexFilename[FILENAME_MAX];
+
+    snprintf(indexFilename, sizeof(indexFilename), "%s%s", filename, LINE_INDEX_FILE_EXTENSION);
+    remove(indexFilename);
+}
+
+/**
+ * Sets client area of displayed model like window of specified size in characters does.
+ * IN:
+ * @param displayed - pointer to displayed model
+ * @param columns - width of client area in characters
+ * @param rows - height of client area in characters
+ */
+static void ResizeClientArea(DisplayedModel * displayed, int columns, int rows) {
+    displayed->charPixelsX    = 8;
+    displayed->charPixelsY    = 16;
+    displayed->capacityCharsX = columns;
+    displayed->capacityCharsY = rows;
+    displayed->clientAreaX    = columns * displayed->charPixelsX;
+    displayed->clientAreaY    = rows * displayed->charPixelsY;
+}
+
+/**
+ * Prints row of frame on headless screen.
+ * IN:
+ * @param model - pointer to text model
+ * @param list - pointer to frame
+ * @param row - number of row of screen
+ *
+ * OUT:
+ * @param text - gets printed text (at most HEADLESS_ROW_SIZE bytes)
+ * @return length of printed text
+ */
+static long long PrintHeadlessRow(TextModel const * model, DisplayList const * list, int row, char * text) {
+    long long length = 0;
+    char const * line = NULL;
+
+    if (row < list->rowsNumber)
+        line = GetDisplayRowText(model->stored, model->displayed, &list->rows[row], &length);
+    if (line == NULL)
+        return 0;
+    length = min(length, HEADLESS_ROW_SIZE);
+    memcpy(text, line, (size_t)length);
+    return length;
+}
+
+/**
+ * Shows frame for current position in text on headless screen the way window shows it (see ShowDisplayList):
+ * rows are moved by shift and only rows which have changed are printed again.
+ * IN:
+ * @param model - pointer to text model
+ * @param shift - number of rows text has been moved up by (negative moves it down)
+ *
+ * INOUT:
+ * @param screen - pointer to screen showing the previous frame
+ * @param shown - pointer to the previous frame, gets the new frame
+ * @param next - pointer to list the new frame is built in, gets the previous frame
+ *
+ * OUT:
+ * @param frameTime - time of building and comparing frames is added to it
+ * @return number of printed rows
+ */
+static int ShowHeadlessFrame(TextModel const * model, long long shift, HeadlessScreen * screen,
+                             DisplayList * shown, DisplayList * next, double * frameTime) {
+    HeadlessScreen moved;
+    DisplayList temp;
+    double startTime = GetSeconds();
+    int row, count;
+
+    if (BuildDisplayList(model->stored, model->displayed, next) != ERR_NO)
+        return 0;
+    DiffDisplayList(shown, next, shift);
+    *frameTime += GetSeconds() - startTime;
+
+    // rows kept on screen are moved, uncovered rows are changed ones
+    for (row = 0; row < SCREEN_ROWS; ++row) {
+        if (row + shift >= 0 && row + shift < SCREEN_ROWS) {
+            memcpy(moved.text[row], screen->text[row + shift], (size_t)screen->lengths[row + shift]);
+            moved.lengths[row] = screen->lengths[row + shift];
+        }
+        else
+            moved.lengths[row] = 0;
+    }
+    for (row = GetDirtyRows(next, 0, &count); count != 0; row = GetDirtyRows(next, row + count, &count)) {
+        for (; count != 0; ++row, --count)
+            moved.lengths[row] = PrintHeadlessRow(model, next, row, moved.text[row]);
+    }
+    for (row = 0; row < SCREEN_ROWS; ++row) {
+        memcpy(screen->text[row], moved.text[row], (size_t)moved.lengths[row]);
+        screen->lengths[row] = moved.lengths[row];
+    }
+
+    temp   = *shown;
+    *shown = *next;
+    *next  = temp;
+    return shown->dirtyNumber;
+}
+
+/**
+ * Checks whether headless screen shows the same text as screen printed from scratch.
+ * IN:
+ * @param model - pointer to text model
+ * @param screen - pointer to screen
+ * @param list - pointer to frame shown on screen
+ *
+ * OUT:
+ * @return TRUE if all rows are the same
+ */
+static BOOL CheckHeadlessScreen(TextModel const * model, HeadlessScreen const * screen, DisplayList const * list) {
+    char text[HEADLESS_ROW_SIZE];
+    long long length;
+    int row;
+
+    for (row = 0; row < SCREEN_ROWS; ++row) {
+        length = PrintHeadlessRow(model, list, row, text);
+        if (length != screen->lengths[row] || memcmp(text, screen->text[row], (size_t)length) != 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Counts rows repainted after scrolling by one line or column from random positions,
+ * checking that repainted screen shows what is painted from scratch.
+ * IN:
+ * @param model - pointer to text model in view mode to measure
+ * @param horizontal - text is scrolled by column (in standard mode only), else by line
+ *
+ * INOUT:
+ * @param seed - state of random generator
+ *
+ * OUT:
+ * @param frameTime - gets average time of building and comparing frame in microseconds
+ * @return average number of repainted rows
+ */
+static double CountRepaintedRows(TextModel * model, BOOL horizontal, unsigned int * seed, double * frameTime) {
+    static HeadlessScreen screen;
+    DisplayedModel * displayed = model->displayed;
+    DisplayList shown, next;
+    long long rowsNumber = 0;
+    long long scrollsNumber = 0;
+    long long shift, moved;
+    double elapsed = 0;
+    int scroll;
+
+    InitDisplayList(&shown);
+    InitDisplayList(&next);
+    for (scroll = 0; scroll < SCROLLS_NUMBER; ++scroll) {
+        // screen at random position is painted from scratch
+        shift = scrollToIncrementY(model->stored, displayed, (int)(NextRandom(seed) % (unsigned int)(displayed->scrollMaxY + 1)));
+        if (displayed->viewMode == VIEW_MODE_WRAP)
+            UpdateModelWrapY(model->stored, displayed, shift);
+        else {
+            UpdateModelStandardY(model->stored, displayed, shift);
+            UpdateModelStandardX(model->stored, displayed, (long long)(NextRandom(seed) % 200) - displayed->firstSymbol);
+        }
+        DestroyDisplayList(&shown);
+        ShowHeadlessFrame(model, 0, &screen, &shown, &next, &elapsed);
+
+        // text is moved by one line or column, as arrow keys do
+        shift = (NextRandom(seed) % 4 == 0) ? -1 : 1;
+        if (horizontal)
+            moved = UpdateModelStandardX(model->stored, displayed, shift);
+        else if (displayed->viewMode == VIEW_MODE_WRAP)
+            moved = UpdateModelWrapY(model->stored, displayed, shift);
+        else
+            moved = UpdateModelStandardY(model->stored, displayed, shift);
+        // text which can't be moved isn't repainted
+        if (moved == 0)
+            continue;
+
+        rowsNumber += ShowHeadlessFrame(model, horizontal ? 0 : moved, &screen, &shown, &next, &elapsed);
+        scrollsNumber++;
+        if (!CheckHeadlessScreen(model, &screen, &shown))
+            printf("screen at line %lld is repainted wrong\n", displayed->firstLine);
+    }
+    DestroyDisplayList(&shown);
+    DestroyDisplayList(&next);
+    *frameTime = elapsed * 1e6 / (SCROLLS_NUMBER + scrollsNumber);
+    return (scrollsNumber != 0) ? (double)rowsNumber / scrollsNumber : 0.0;
+}
+
+/**
+ * Builds frame of screen and gets highlighted runs of it's rows, as client area is painted.
+ * IN:
+ * @param model - text model with highlighting switched on
+ *
+ * INOUT:
+ * @param list - frame of screen
+ *
+ * OUT:
+ * @return number of highlighted runs
+ */
+static long long HighlightScreen(TextModel const * model, DisplayList * list) {
+    HighlightRun runs[MAX_LINE_TOKENS];
+    long long runsTotal = 0;
+    int row, runsNumber, run;
+
+    if (BuildDisplayList(model->stored, model->displayed, list) != ERR_NO)
+        return 0;
+    for (row = 0; row < list->rowsNumber; ++row) {
+        runsNumber = GetDisplayRowRuns(model->stored, model->displayed, &list->rows[row], runs, MAX_LINE_TOKENS);
+        for (run = 0; run < runsNumber; ++run) {
+            if (runs[run].column < 0 || runs[run].columns <= 0 ||
+                runs[run].column + runs[run].columns > list->rows[row].columns)
+                printf("run of line %lld is out of row\n", list->rows[row].line);
+        }
+        runsTotal += runsNumber;
+    }
+    return runsTotal;
+}
+
+/**
+ * Measures highlighting of screens: screens at random lines are mostly tokenized from scratch,
+ * screens scrolled by line take tokens of the most lines from cache.
+ * IN:
+ * @param model - text model
+ *
+ * INOUT:
+ * @param seed - state of generator of random numbers
+ *
+ * OUT:
+ * @param results - gets time of highlighting operations (see operationNames for units)
+ * @return total number of highlighted runs
+ */
+static long long MeasureHighlighting(TextModel * model, unsigned int * seed, double results[OPERATIONS_NUMBER]) {
+    DisplayedModel * displayed = model->displayed;
+    DisplayList list;
+    long long runsTotal = 0;
+    double startTime;
+    int screen;
+
+    InitDisplayList(&list);
+    SwitchHighlighting(model->stored, TRUE);
+    startTime = GetSeconds();
+    for (screen = 0; screen < SCROLLS_NUMBER; ++screen) {
+        UpdateModelStandardY(model->stored, displayed,
+                             scrollToIncrementY(model->stored, displayed,
+                                                (int)(NextRandom(seed) % (unsigned int)(displayed->scrollMaxY + 1))));
+        runsTotal += HighlightScreen(model, &list);
+    }
+    results[OPERATION_HIGHLIGHT] = (GetSeconds() - startTime) * 1e6 / SCROLLS_NUMBER;
+
+    startTime = GetSeconds();
+    for (screen = 0; screen < SCROLLS_NUMBER; ++screen) {
+        if (UpdateModelStandardY(model->stored, displayed, 1) == 0)
+            UpdateModelStandardY(model->stored, displayed, -displayed->firstLine);
+        runsTotal += HighlightScreen(model, &list);
+    }
+    results[OPERATION_HIGHLIGHT_LINE] = (GetSeconds() - startTime) * 1e6 / SCROLLS_NUMBER;
+    SwitchHighlighting(model->stored, FALSE);
+    DestroyDisplayList(&list);
+    return runsTotal;
+}
+
+/**
+ * Lets other threads run for about a millisecond.
+ */
+static void PauseThread(void) {
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec pause = { 0, 1000000 };
+    nanosleep(&pause, NULL);
+#endif
+}
+
+/**
+ * Shows lines matching filter pattern, then refines them, each time waiting until all matching lines are shown.
+ * Lines are polled instead of notifications window gets.
+ * IN:
+ * @param model - pointer to text model in standard mode
+ *
+ * OUT:
+ * @param results - gets time of filter operations (see operationNames for units)
+ * @return number of lines shown by refined filter
+ */
+static long long MeasureFiltering(TextModel * model, double results[OPERATIONS_NUMBER]) {
+    Operation operations[2] = { OPERATION_FILTER, OPERATION_REFINE };
+    char const * patterns[2] = { FILTER_PATTERN, REFINE_PATTERN };
+    long long linesNumber = 0;
+    double startTime;
+    ErrorType errorType;
+    int step;
+
+    results[OPERATION_FILTER] = results[OPERATION_REFINE] = -1.0;
+    for (step = 0; step < 2; ++step) {
+        startTime = GetSeconds();
+        errorType = StartFilter(model->stored, model->displayed, patterns[step], strlen(patterns[step]), FALSE, step > 0);
+        if (errorType != ERR_NO) {
+            PrintError(NULL, errorType, __FILE__, __LINE__);
+            break;
+        }
+        while (GetFilterState(model->stored, &linesNumber) < 1.0) {
+            if (!UpdateFilterProgress(model->stored, model->displayed))
+                PauseThread();
+        }
+        results[operations[step]] = (GetSeconds() - startTime) * 1e3;
+    }
+    ClearFilter(model->stored, model->displayed);
+    return linesNumber;
+}
+
+/**
+ * Measures operations of text model on text of file.
+ * IN:
+ * @param filename - name of file with text
+ *
+ * OUT:
+ * @param results - gets time of each operation (see operationNames for units)
+ * @return code of error occured during building model (ERR_NO if successed)
+ */
+static ErrorType BenchmarkTextModel(char const * filename, double results[OPERATIONS_NUMBER]) {
+    TextModel model;
+    DisplayedModel * displayed;
+    ErrorType errorType;
+    double startTime, elapsed;
+    long long screen, row, length, firstSymbol, firstLine, increment;
+    long long checksum = 0;
+    long long screensNumber = 2000;
+    unsigned int seed = 99;
+    char const * line;
+    int repeat;
+
+    // the best of several builds (index saved by previous build isn't loaded)
+    results[OPERATION_BUILD] = -1.0;
+    for (repeat = 0; repeat < BUILD_REPEATS_NUMBER; ++repeat) {
+        RemoveSavedIndex(filename);
+        startTime = GetSeconds();
+        errorType = BuildTextModel(&model, filename);
+        elapsed = GetSeconds() - startTime;
+        if (errorType != ERR_NO)
+            return errorType;
+        if (results[OPERATION_BUILD] < 0 || elapsed * 1e3 < results[OPERATION_BUILD])
+            results[OPERATION_BUILD] = elapsed * 1e3;
+        if (repeat + 1 < BUILD_REPEATS_NUMBER)
+            DestroyTextModel(&model);
+    }
+
+    // the same file is opened again while it's shown
+    results[OPERATION_REBUILD] = -1.0;
+    for (repeat = 0; repeat < BUILD_REPEATS_NUMBER; ++repeat) {
+        RemoveSavedIndex(filename);
+        startTime = GetSeconds();
+        errorType = RebuildTextModel(&model, filename);
+        elapsed = GetSeconds() - startTime;
+        if (errorType != ERR_NO) {
+            DestroyTextModel(&model);
+            return errorType;
+        }
+        if (results[OPERATION_REBUILD] < 0 || elapsed * 1e3 < results[OPERATION_REBUILD])
+            results[OPERATION_REBUILD] = elapsed * 1e3;
+    }
+    RemoveSavedIndex(filename);
+    displayed = model.displayed;
+    ResizeClientArea(displayed, SCREEN_COLUMNS, SCREEN_ROWS);
+
+    startTime = GetSeconds();
+    for (screen = 0; screen < screensNumber; ++screen)
+        UpdateModelMetrics(model.stored, displayed, displayed->capacityCharsX);
+    results[OPERATION_METRICS] = (GetSeconds() - startTime) * 1e6 / screensNumber;
+
+    // screens at random lines, some of them scrolled to the right
+    startTime = GetSeconds();
+    for (screen = 0; screen < screensNumber; ++screen) {
+        firstLine = ((long long)NextRandom(&seed) << 15 | NextRandom(&seed)) % max(1, displayed->scrollMaxY);
+        firstSymbol = (screen % 4 == 0) ? NextRandom(&seed) % 2000 : 0;
+        for (row = 0; row < displayed->capacityCharsY; ++row) {
+            line = GetLineStandard(model.stored, firstLine + row, firstSymbol, displayed->capacityCharsX, &length);
+            if (line == NULL)
+                break;
+            checksum += length;
+        }
+    }
+    results[OPERATION_PAINT] = (GetSeconds() - startTime) * 1e6 / screensNumber;
+
+    startTime = GetSeconds();
+    for (screen = 0; screen < screensNumber; ++screen) {
+        increment = scrollToIncrementY(model.stored, displayed, (int)(NextRandom(&seed) % (unsigned int)(displayed->scrollMaxY + 1)));
+        checksum += UpdateModelStandardY(model.stored, displayed, increment);
+    }
+    results[OPERATION_SCROLL] = (GetSeconds() - startTime) * 1e6 / screensNumber;
+
+    results[OPERATION_ROWS_LINE]   = CountRepaintedRows(&model, FALSE, &seed, &results[OPERATION_FRAME]);
+    results[OPERATION_ROWS_COLUMN] = CountRepaintedRows(&model, TRUE, &seed, &elapsed);
+    UpdateModelStandardX(model.stored, displayed, -displayed->firstSymbol);
+    checksum += MeasureHighlighting(&model, &seed, results);
+    checksum += MeasureFiltering(&model, results);
+
+    // width changes make rows be recounted, wrap index is rebuilt on the next scrolling
+    SwitchMode(model.stored, displayed, VIEW_MODE_WRAP);
+    startTime = GetSeconds();
+    for (screen = 0; screen < 200; ++screen) {
+        ResizeClientArea(displayed, (screen % 2 == 0) ? SCREEN_COLUMNS - 20 : SCREEN_COLUMNS, SCREEN_ROWS);
+        UpdateModelMetrics(model.stored, displayed, (screen % 2 == 0) ? SCREEN_COLUMNS : SCREEN_COLUMNS - 20);
+    }
+    results[OPERATION_METRICS_WRAP] = (GetSeconds() - startTime) * 1e6 / 200;
+    PrepareWrapIndex(model.stored, displayed);
+
+    startTime = GetSeconds();
+    for (screen = 0; screen < screensNumber; ++screen) {
+        if (UpdateModelWrapY(model.stored, displayed, 1) == 0)
+            UpdateModelWrapY(model.stored, displayed, -displayed->linesNumberWrap);
+    }
+    results[OPERATION_LINE_WRAP] = (GetSeconds() - startTime) * 1e6 / screensNumber;
+
+    startTime = GetSeconds();
+    for (screen = 0; screen < screensNumber; ++screen) {
+        if (UpdateModelWrapY(model.stored, displayed, displayed->capacityCharsY) == 0)
+            UpdateModelWrapY(model.stored, displayed, -displayed->linesNumberWrap);
+    }
+    results[OPERATION_PAGE_WRAP] = (GetSeconds() - startTime) * 1e6 / screensNumber;
+
+    startTime = GetSeconds();
+    for (screen = 0; screen < screensNumber; ++screen) {
+        increment = scrollToIncrementY(model.stored, displayed, (int)(NextRandom(&seed) % (unsigned int)(displayed->scrollMaxY + 1)));
+        checksum += UpdateModelWrapY(model.stored, displayed, increment);
+    }
+    results[OPERATION_SCROLL_WRAP] = (GetSeconds() - startTime) * 1e6 / screensNumber;
+
+    // screens at random rows are painted the way client area is
+    elapsed = 0;
+    for (screen = 0; screen < screensNumber; ++screen) {
+        increment = scrollToIncrementY(model.stored, displayed, (int)(NextRandom(&seed) % (unsigned int)(displayed->scrollMaxY + 1)));
+        UpdateModelWrapY(model.stored, displayed, increment);
+        startTime = GetSeconds();
+        firstLine   = displayed->firstLine;
+        firstSymbol = displayed->firstSymbol;
+        line = GetLineWrap(model.stored, displayed, 0, &length, &firstSymbol, &firstLine);
+        for (row = 1; line != NULL && row < displayed->capacityCharsY; ++row) {
+            checksum += length;
+            line = GetLineWrap(model.stored, displayed, 1, &length, &firstSymbol, &firstLine);
+        }
+        elapsed += GetSeconds() - startTime;
+    }
+    results[OPERATION_PAINT_WRAP] = elapsed * 1e6 / screensNumber;
+    results[OPERATION_ROWS_LINE_WRAP] = CountRepaintedRows(&model, FALSE, &seed, &elapsed);
+
+    printf("(%lld rows in wrap mode, checksum %lld)\n", displayed->linesNumberWrap, checksum);
+    DestroyTextModel(&model);
+    ReleaseRetainedBuffers();
+    return ERR_NO;
+}
+
+/**
+ * Measures switching between file and blank document: document kept in memory is shown at once,
+ * unloaded one is read again and it's position is checked.
+ * IN:
+ * @param filename - name of text file
+ *
+ * OUT:
+ * @param results - gets time of document operations (see operationNames for units)
+ * @return code of error occured during opening documents (ERR_NO if successed)
+ */
+static ErrorType BenchmarkDocuments(char const * filename, double results[OPERATIONS_NUMBER]) {
+    DocumentManager manager;
+    TextModel * model;
+    ErrorType errorType;
+    double startTime, elapsed;
+    long long firstLine;
+    int repeat;
+
+    InitDocumentManager(&manager, DEFAULT_DOCUMENTS_BUDGET);
+    errorType = OpenDocument(&manager, filename);
+    if (errorType == ERR_NO) {
+        ResizeClientArea(GetShownModel(&manager)->displayed, SCREEN_COLUMNS, SCREEN_ROWS);
+        errorType = OpenDocument(&manager, NULL);
+    }
+    if (errorType != ERR_NO) {
+        DestroyDocumentManager(&manager);
+        return errorType;
+    }
+
+    startTime = GetSeconds();
+    for (repeat = 0; repeat < SCROLLS_NUMBER; ++repeat)
+        ShowDocument(&manager, repeat % 2);
+    results[OPERATION_SHOW] = (GetSeconds() - startTime) * 1e6 / SCROLLS_NUMBER;
+
+    // budget fits only the shown document, so hidden file is unloaded
+    manager.budget = 1;
+    results[OPERATION_SHOW_UNLOADED] = -1.0;
+    for (repeat = 0; repeat < BUILD_REPEATS_NUMBER && errorType == ERR_NO; ++repeat) {
+        model = GetShownModel(&manager);
+        UpdateModelStandardY(model->stored, model->displayed, model->displayed->capacityCharsY * (repeat + 1));
+        firstLine = model->displayed->firstLine;
+        ShowDocument(&manager, 1);
+        if (manager.documents[0].model.stored != NULL)
+            printf("hidden document isn't unloaded\n");
+
+        startTime = GetSeconds();
+        errorType = ShowDocument(&manager, 0);
+        elapsed = GetSeconds() - startTime;
+        if (errorType == ERR_NO && GetShownModel(&manager)->displayed->firstLine != firstLine)
+            printf("position of unloaded document is lost\n");
+        if (results[OPERATION_SHOW_UNLOADED] < 0 || elapsed * 1e3 < results[OPERATION_SHOW_UNLOADED])
+            results[OPERATION_SHOW_UNLOADED] = elapsed * 1e3;
+    }
+
+    DestroyDocumentManager(&manager);
+    ReleaseRetainedBuffers();
+    RemoveSavedIndex(filename);
+    return errorType;
+}
+
+/**
+ * Measures text model operations on generated corpora of each kind and prints comparable table.
+ * Usage: ModelBenchmark [size of corpus in megabytes]
+ */
+int main(int argc, char * argv[]) {
+    double results[CORPORA_NUMBER][OPERATIONS_NUMBER];
+    long long size = DEFAULT_MODEL_CORPUS_SIZE;
+    char * corpus;
+    ErrorType errorType;
+    int kind, operation;
+
+    if (argc > 1 && atoll(argv[1]) > 0)
+        size = atoll(argv[1]) << 20;
+    corpus = (char*)malloc((size_t)size);
+    if (corpus == NULL) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return ERR_NOMEM;
+    }
+#ifdef TRACE_ENABLED
+    errorType = StartTrace();
+    if (errorType != ERR_NO)
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+#endif
+
+    for (kind = 0; kind < CORPORA_NUMBER; ++kind) {
+        printf("%s corpus of %.0f MB ", corpusNames[kind], size / 1048576.0);
+        fflush(stdout);
+        GenerateModelCorpus((CorpusKind)kind, corpus, size);
+        errorType = WriteCorpus(MODEL_BENCHMARK_FILE, corpus, size);
+        if (errorType == ERR_NO)
+            errorType = BenchmarkTextModel(MODEL_BENCHMARK_FILE, results[kind]);
+        if (errorType == ERR_NO)
+            errorType = BenchmarkDocuments(MODEL_BENCHMARK_FILE, results[kind]);
+        remove(MODEL_BENCHMARK_FILE);
+        if (errorType != ERR_NO) {
+            PrintError(NULL, errorType, __FILE__, __LINE__);
+            free(corpus);
+            return errorType;
+        }
+    }
+    free(corpus);
+
+    printf("\n%-28s", "operation");
+    for (kind = 0; kind < CORPORA_NUMBER; ++kind)
+        printf(" %12s", corpusNames[kind]);
+    printf("\n");
+    for (operation = 0; operation < OPERATIONS_NUMBER; ++operation) {
+        printf("%-28s", operationNames[operation]);
+        for (kind = 0; kind < CORPORA_NUMBER; ++kind)
+            printf(" %12.3f", results[kind][operation]);
+        printf("\n");
+    }
+
+#ifdef TRACE_ENABLED
+    printf("\ntrace of operations is written into %s\n", MODEL_BENCHMARK_TRACE);
+    errorType = SaveTrace(MODEL_BENCHMARK_TRACE);
+    if (errorType != ERR_NO)
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+    PrintTraceSummary(stdout);
+    DestroyTrace();
+#endif
+    return ERR_NO;
+}
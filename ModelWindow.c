@@ -0,0 +1,190 @@
+#include "ModelWindow.h"
+#include "Trace.h"
+#include <stdlib.h>
+
+// colors of highlighted tokens (see TokenKind)
+static COLORREF const tokenColors[TOKEN_KINDS_NUMBER] = {
+    RGB(0, 0, 0),               // plain text
+    RGB(0, 128, 128),           // timestamp
+    RGB(192, 0, 0),             // error
+    RGB(192, 112, 0),           // warning
+    RGB(0, 128, 0),             // info
+    RGB(128, 128, 128),         // debug
+    RGB(0, 0, 192),             // key
+    RGB(128, 0, 128)            // value
+};
+
+/**
+ * Sets window's scrollbars ranges and positions according to displayed model.
+ * IN:
+ * @param hWindow - handler of window
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ */
+void UpdateScrollBars(HWND hWindow, StoredModel const * stored, DisplayedModel const * displayed) {
+    SetScrollRange(hWindow, SB_HORZ, 0, displayed->scrollMaxX, TRUE);
+    SetScrollRange(hWindow, SB_VERT, 0, displayed->scrollMaxY, TRUE);
+    SetScrollPos(hWindow, SB_HORZ, countScrollPositionX(stored, displayed), TRUE);
+    SetScrollPos(hWindow, SB_VERT, countScrollPositionY(stored, displayed), TRUE);
+}
+
+/**
+ * Updates displayed model metrics (see UpdateModelMetrics) and shows them on window's scrollbars.
+ * IN:
+ * @param hWindow - handler of window
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param prevCapacityCharsX - previous value needed to find out
+ * whether there is necessity to change firstSymbol and linesNumberWrap fields
+ *
+ * OUT:
+ * displayed->scrollMaxX, displayed->scrollMaxY, displayed->firstSymbol, displayed->linesNumberWrap get relevant values
+ */
+void UpdateWindowMetrics(HWND hWindow, StoredModel const * stored, DisplayedModel * displayed, int prevCapacityCharsX) {
+    UpdateModelMetrics(stored, displayed, prevCapacityCharsX);
+    UpdateScrollBars(hWindow, stored, displayed);
+}
+
+/**
+ * Prints part of row in color. Each character of row takes one column.
+ * IN:
+ * @param hDeviceContext - handler of device context
+ * @param y - top side of printed text
+ * @param charPixelsX - width of column
+ * @param line - text of row (used if wide is NULL)
+ * @param wide - text of row converted from UTF-8 (NULL if row isn't converted)
+ * @param first - the first character to print
+ * @param count - number of characters to print
+ * @param color - color of text
+ */
+static void PrintRun(HDC hDeviceContext, int y, int charPixelsX, char const * line, WCHAR const * wide,
+                     int first, int count, COLORREF color) {
+    SetTextColor(hDeviceContext, color);
+    if (wide != NULL)
+        TextOutW(hDeviceContext, first * charPixelsX, y, wide + first, count);
+    else
+        TextOut(hDeviceContext, first * charPixelsX, y, line + first, count);
+}
+
+/**
+ * Prints part of line with colored runs. Parts of multibyte lines are converted from UTF-8,
+ * so each character takes one column.
+ * IN:
+ * @param hDeviceContext - handler of device context
+ * @param y - top side of printed text
+ * @param charPixelsX - width of column
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line text belongs to
+ * @param line - text to print
+ * @param lineLength - length of text in bytes
+ * @param runs - colored runs of text in order of their columns (see GetDisplayRowRuns)
+ * @param runsNumber - number of items in runs (text between runs is plain)
+ */
+static void PrintLine(HDC hDeviceContext, int y, int charPixelsX, StoredModel const * stored, long long lineNumber,
+                      char const * line, long long lineLength, HighlightRun const * runs, int runsNumber) {
+    WCHAR * wide = NULL;
+    int length = (int)lineLength;
+    int position, end, i;
+
+    // UTF-16 text takes no more units than UTF-8 one takes bytes
+    if (IsMultibyteLine(stored, lineNumber) && lineLength > 0 &&
+        (wide = (WCHAR*)malloc((size_t)lineLength * sizeof(WCHAR))) != NULL)
+        length = MultiByteToWideChar(CP_UTF8, 0, line, (int)lineLength, wide, (int)lineLength);
+
+    // plain text between runs is printed in parts too, so each character is printed once
+    for (position = 0, i = 0; position < length; ++i) {
+        end = (i < runsNumber) ? min(max(runs[i].column, position), length) : length;
+        if (end > position)
+            PrintRun(hDeviceContext, y, charPixelsX, line, wide, position, end - position, tokenColors[TOKEN_PLAIN]);
+        position = end;
+        if (i == runsNumber)
+            break;
+        end = min(runs[i].column + runs[i].columns, length);
+        if (end > position)
+            PrintRun(hDeviceContext, y, charPixelsX, line, wide, position, end - position, tokenColors[runs[i].kind]);
+        position = max(position, end);
+    }
+    SetTextColor(hDeviceContext, tokenColors[TOKEN_PLAIN]);
+    free(wide);
+}
+
+/**
+ * Prints rows of frame crossing invalid rectangle of client area.
+ * IN:
+ * @param hDeviceContext - handler of device context
+ * @param invalidRectangle - pointer to rectangle to paint
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param list - pointer to frame built for current position in text (see BuildDisplayList)
+ */
+void PaintDisplayList(HDC hDeviceContext, RECT const * invalidRectangle, StoredModel const * stored,
+                      DisplayedModel const * displayed, DisplayList const * list) {
+    HighlightRun runs[MAX_LINE_TOKENS];
+    long long lineLength;
+    char const * line;
+    int row, lastRow, runsNumber;
+    TRACE_START(start);
+
+    row     = invalidRectangle->top / displayed->charPixelsY;
+    lastRow = min(list->rowsNumber, (invalidRectangle->bottom + displayed->charPixelsY - 1) / displayed->charPixelsY);
+    for (; row < lastRow; ++row) {
+        line = GetDisplayRowText(stored, displayed, &list->rows[row], &lineLength);
+        if (line == NULL)
+            break;
+        runsNumber = GetDisplayRowRuns(stored, displayed, &list->rows[row], runs, MAX_LINE_TOKENS);
+        PrintLine(hDeviceContext, row * displayed->charPixelsY, displayed->charPixelsX, stored, list->rows[row].line,
+                  line, lineLength, runs, runsNumber);
+    }
+    TRACE_STOP("PaintDisplayList", start);
+    TRACE_COUNTER("rows painted", row - invalidRectangle->top / displayed->charPixelsY);
+}
+
+/**
+ * Shows frame for current position in text after text has been moved by specified number of rows:
+ * rows kept in client area are scrolled, only rows which have changed are invalidated.
+ * IN:
+ * @param hWindow - handler of window
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param shift - number of rows text has been moved up by (negative moves it down, 0 if it has been moved horizontally)
+ *
+ * INOUT:
+ * @param shown - pointer to frame shown in client area, gets the new frame
+ * @param next - pointer to list the new frame is built in, gets the previous frame
+ */
+void ShowDisplayList(HWND hWindow, StoredModel const * stored, DisplayedModel const * displayed, long long shift,
+                     DisplayList * shown, DisplayList * next) {
+    DisplayList temp;
+    RECT rowsRectangle;
+    RECT invalidRectangle;
+    ErrorType errorType;
+    int row, count;
+
+    errorType = BuildDisplayList(stored, displayed, next);
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        InvalidateRect(hWindow, NULL, TRUE);
+        return;
+    }
+    DiffDisplayList(shown, next, shift);
+    TRACE_COUNTER("rows invalidated", next->dirtyNumber);
+
+    // uncovered rows aren't invalidated by scrolling, they're changed rows of the new frame
+    rowsRectangle.left   = 0;
+    rowsRectangle.top    = 0;
+    rowsRectangle.right  = displayed->clientAreaX;
+    rowsRectangle.bottom = displayed->capacityCharsY * displayed->charPixelsY;
+    if (shift != 0 && shift < displayed->capacityCharsY && -shift < displayed->capacityCharsY)
+        ScrollWindowEx(hWindow, 0, -(int)shift * displayed->charPixelsY, &rowsRectangle, &rowsRectangle, NULL, NULL, 0);
+
+    invalidRectangle = rowsRectangle;
+    for (row = GetDirtyRows(next, 0, &count); count != 0; row = GetDirtyRows(next, row + count, &count)) {
+        invalidRectangle.top    = row * displayed->charPixelsY;
+        invalidRectangle.bottom = (row + count) * displayed->charPixelsY;
+        InvalidateRect(hWindow, &invalidRectangle, TRUE);
+    }
+
+    temp   = *shown;
+    *shown = *next;
+    *next  = temp;
+}
@@ -0,0 +1,14 @@
+#ifndef MODELWINDOW_H_INCLUDED
+#define MODELWINDOW_H_INCLUDED
+
+#include <windows.h>
+#include "TextModel.h"
+
+void UpdateWindowMetrics(HWND hWindow, StoredModel const * stored, DisplayedModel * displayed, int prevCapacityCharsX);
+void UpdateScrollBars(HWND hWindow, StoredModel const * stored, DisplayedModel const * displayed);
+void PaintDisplayList(HDC hDeviceContext, RECT const * invalidRectangle, StoredModel const * stored,
+                      DisplayedModel const * displayed, DisplayList const * list);
+void ShowDisplayList(HWND hWindow, StoredModel const * stored, DisplayedModel const * displayed, long long shift,
+                     DisplayList * shown, DisplayList * next);
+
+#endif // MODELWINDOW_H_INCLUDED
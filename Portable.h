@@ -0,0 +1,26 @@
+#ifndef PORTABLE_H_INCLUDED
+#define PORTABLE_H_INCLUDED
+
+/* basic types the text model is written with, so it's built without Win32 headers
+ * on other systems (on Windows they come from windows.h and mix with window code) */
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    typedef int BOOL;
+
+    #ifndef TRUE
+        #define TRUE 1
+    #endif
+    #ifndef FALSE
+        #define FALSE 0
+    #endif
+
+    #ifndef min
+        #define min(a, b) (((a) < (b)) ? (a) : (b))
+    #endif
+    #ifndef max
+        #define max(a, b) (((a) > (b)) ? (a) : (b))
+    #endif
+#endif
+
+#endif // PORTABLE_H_INCLUDED
@@ -0,0 +1,1241 @@
+#include "Regex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PATTERN_LENGTH 4096     // longer patterns are rejected (parser is recursive)
+#define MAX_REPEAT_COUNT 1000       // the biggest number of repetitions in "{m,n}"
+#define MAX_NFA_NODES 100000        // limit of NFA size (bounded repetitions are expanded)
+#define MAX_LITERAL_LENGTH 64       // the longest required literal extracted for prefilter
+#define DFA_CACHE_SIZE (1 << 20)    // memory of transitions of lazily built DFA states of one matcher in bytes
+#define DFA_STATES_NUMBER (DFA_CACHE_SIZE / (256 * (int)sizeof(int)))
+
+// special values of DFA transitions (transitions to built states are offsets of their transitions)
+#define DFA_UNKNOWN    -1           // transition isn't built yet
+#define DFA_LINE_BREAK -2           // symbol ends line
+#define DFA_MATCHED    -3           // line matches
+#define DFA_DEAD       -4           // the rest of line can't match
+#define DFA_FAILED     -5           // there's not enough memory to build state
+
+typedef struct {
+    unsigned char bits[32];     // flags of 256 byte values
+} ByteSet;
+
+typedef enum {
+    AST_EMPTY,                  // matches empty string
+    AST_SET,                    // matches one byte of set
+    AST_CONCAT,                 // matches left operand followed by right one
+    AST_ALTERNATE,              // matches either operand
+    AST_REPEAT,                 // matches operand repeated from min to max times
+    AST_LINE_BEGIN,             // matches empty string at the beginning of line
+    AST_LINE_END                // matches empty string at the end of line
+} AstType;
+
+typedef struct {
+    AstType type;
+    int set;                    // AST_SET: number of byte set
+    int left;                   // AST_CONCAT, AST_ALTERNATE: the first operand, AST_REPEAT: repeated node
+    int right;                  // AST_CONCAT, AST_ALTERNATE: the second operand
+    int min;                    // AST_REPEAT: the least number of repetitions
+    int max;                    // AST_REPEAT: the biggest number of repetitions (-1 if it's unbounded)
+} AstNode;
+
+typedef enum {
+    NFA_BYTES,                  // passes one byte of set
+    NFA_SPLIT,                  // passes to both next nodes without input
+    NFA_LINE_BEGIN,             // passes without input at the beginning of line only
+    NFA_LINE_END,               // passes without input at the end of line only
+    NFA_MATCH                   // pattern is matched
+} NfaType;
+
+typedef struct {
+    NfaType type;
+    int set;                    // NFA_BYTES: number of byte set
+    int out;                    // next node
+    int out2;                   // NFA_SPLIT: alternative next node
+} NfaNode;
+
+struct tag_Regex {
+    NfaNode * nodes;            // Thompson NFA of pattern
+    int nodesNumber;
+    int nodesCapacity;
+    ByteSet * sets;             // byte sets of NFA_BYTES nodes
+    int setsNumber;
+    int setsCapacity;
+    int start;                  // the first node of NFA
+    char literal[MAX_LITERAL_LENGTH];   // string every match contains
+    size_t literalLength;       // length of literal (0 if there's no such string)
+};
+
+typedef struct {
+    char const * pattern;       // parsed pattern
+    size_t length;              // length of pattern
+    size_t position;            // index of the next symbol to parse
+    AstNode * nodes;            // parsed nodes
+    int nodesNumber;
+    int nodesCapacity;
+    Regex * regex;              // regex getting byte sets
+    ErrorType errorType;        // ERR_REGEX for syntax errors, ERR_NOMEM if there's not enough memory
+} RegexParser;
+
+struct tag_RegexMatcher {
+    Regex const * regex;        // compiled pattern
+    int * transitions;          // [DFA_STATES_NUMBER * 256] transitions of built states
+    unsigned char * eolMatching;    // [DFA_STATES_NUMBER] flags of states which match at the end of line
+    unsigned int * hashes;      // [DFA_STATES_NUMBER] hashes of states NFA sets
+    int * setOffsets;           // [DFA_STATES_NUMBER + 1] offsets of states NFA sets in pool
+    int * pool;                 // NFA nodes of states (sorted for each state)
+    int poolSize;
+    int poolCapacity;
+    int statesNumber;           // number of built states
+    int * buckets;              // hash table of states numbers (-1 for empty bucket)
+    int bucketsMask;
+    int lineStart;              // state at the beginning of line (DFA_UNKNOWN if it isn't built yet)
+    int idleOffset;             // offset of transitions of state without started matches (-1 if it isn't built)
+    unsigned char stopBytes[256];   // flags of bytes which may leave idle state
+    int * stack;                // [nodesNumber] work arrays of closure
+    int * collected;            // [nodesNumber]
+    unsigned int * marks;       // [nodesNumber] generations nodes have been visited in
+    unsigned int generation;
+    BOOL failed;                // set if there's not enough memory for states
+};
+
+/**
+ * Adds byte to set.
+ * IN:
+ * @param set - pointer to set
+ * @param byte - value to add
+ */
+static void AddByte(ByteSet * set, unsigned char byte) {
+    set->bits[byte >> 3] |= (unsigned char)(1u << (byte & 7));
+}
+
+/**
+ * Checks whether set contains byte.
+ * IN:
+ * @param set - pointer to set
+ * @param byte - value to check
+ *
+ * OUT:
+ * @return TRUE if byte is in set
+ */
+static BOOL HasByte(ByteSet const * set, unsigned char byte) {
+    return (set->bits[byte >> 3] & (1u << (byte & 7))) != 0;
+}
+
+/**
+ * Adds range of bytes to set.
+ * IN:
+ * @param set - pointer to set
+ * @param first, last - bounds of range (both are included)
+ */
+static void AddByteRange(ByteSet * set, unsigned char first, unsigned char last) {
+    int byte;
+
+    for (byte = first; byte <= last; ++byte)
+        AddByte(set, (unsigned char)byte);
+}
+
+/**
+ * Replaces set with it's complement.
+ * IN:
+ * @param set - pointer to set
+ */
+static void InvertByteSet(ByteSet * set) {
+    int i;
+
+    for (i = 0; i < 32; ++i)
+        set->bits[i] = (unsigned char)~set->bits[i];
+}
+
+/**
+ * Gives the only byte of set.
+ * IN:
+ * @param set - pointer to set
+ *
+ * OUT:
+ * @return value of byte if set has exactly one byte, -1 else
+ */
+static int GetSingleByte(ByteSet const * set) {
+    int byte, found = -1;
+
+    for (byte = 0; byte < 256; ++byte) {
+        if (HasByte(set, (unsigned char)byte)) {
+            if (found >= 0)
+                return -1;
+            found = byte;
+        }
+    }
+    return found;
+}
+
+/**
+ * Adds empty byte set to regex.
+ * IN:
+ * @param regex - pointer to regex
+ *
+ * OUT:
+ * @return number of added set (-1 if there's not enough memory)
+ */
+static int AddByteSet(Regex * regex) {
+    ByteSet * sets;
+    int capacity;
+
+    if (regex->setsNumber == regex->setsCapacity) {
+        capacity = (regex->setsCapacity > 0) ? regex->setsCapacity * 2 : 16;
+        sets = (ByteSet*)realloc(regex->sets, capacity * sizeof(ByteSet));
+        if (sets == NULL)
+            return -1;
+        regex->sets = sets;
+        regex->setsCapacity = capacity;
+    }
+    memset(&regex->sets[regex->setsNumber], 0, sizeof(ByteSet));
+    return regex->setsNumber++;
+}
+
+/**
+ * Adds syntax tree node to parser.
+ * IN:
+ * @param parser - pointer to parser
+ * @param type - type of node
+ * @param left, right - operands of node (-1 if they aren't used)
+ *
+ * OUT:
+ * @return number of added node (-1 if there's not enough memory)
+ */
+static int AddAstNode(RegexParser * parser, AstType type, int left, int right) {
+    AstNode * nodes;
+    int capacity;
+
+    if (parser->nodesNumber == parser->nodesCapacity) {
+        capacity = (parser->nodesCapacity > 0) ? parser->nodesCapacity * 2 : 64;
+        nodes = (AstNode*)realloc(parser->nodes, capacity * sizeof(AstNode));
+        if (nodes == NULL) {
+            parser->errorType = ERR_NOMEM;
+            return -1;
+        }
+        parser->nodes = nodes;
+        parser->nodesCapacity = capacity;
+    }
+    nodes = &parser->nodes[parser->nodesNumber];
+    nodes->type  = type;
+    nodes->set   = -1;
+    nodes->left  = left;
+    nodes->right = right;
+    nodes->min   = 0;
+    nodes->max   = 0;
+    return parser->nodesNumber++;
+}
+
+/**
+ * Adds node matching one byte of new set.
+ * IN:
+ * @param parser - pointer to parser
+ *
+ * OUT:
+ * @return number of added node (-1 if there's not enough memory), it's set is empty
+ */
+static int AddSetNode(RegexParser * parser) {
+    int node = AddAstNode(parser, AST_SET, -1, -1);
+
+    if (node < 0)
+        return -1;
+    parser->nodes[node].set = AddByteSet(parser->regex);
+    if (parser->nodes[node].set < 0) {
+        parser->errorType = ERR_NOMEM;
+        return -1;
+    }
+    return node;
+}
+
+/**
+ * Checks whether the next symbol of pattern is specified one.
+ * IN:
+ * @param parser - pointer to parser
+ * @param symbol - expected symbol
+ *
+ * OUT:
+ * @return TRUE if the next symbol is expected one
+ */
+static BOOL PeekSymbol(RegexParser const * parser, char symbol) {
+    return parser->position < parser->length && parser->pattern[parser->position] == symbol;
+}
+
+/**
+ * Gives value of hexadecimal digit.
+ * IN:
+ * @param symbol - digit
+ *
+ * OUT:
+ * @return value of digit (-1 if symbol isn't a hexadecimal digit)
+ */
+static int GetHexDigit(char symbol) {
+    if (symbol >= '0' && symbol <= '9')
+        return symbol - '0';
+    if (symbol >= 'a' && symbol <= 'f')
+        return symbol - 'a' + 10;
+    if (symbol >= 'A' && symbol <= 'F')
+        return symbol - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Parses escape sequence after backslash and adds bytes it matches to set.
+ * IN:
+ * @param parser - pointer to parser (position is after backslash)
+ * @param set - pointer to set
+ *
+ * OUT:
+ * @return the only byte escape matches, -1 if it matches a class, -2 if it's malformed
+ */
+static int ParseEscape(RegexParser * parser, ByteSet * set) {
+    ByteSet escaped;
+    char symbol;
+    int high, low, i;
+
+    if (parser->position >= parser->length)
+        return -2;
+    symbol = parser->pattern[parser->position++];
+
+    memset(&escaped, 0, sizeof(ByteSet));
+    switch (symbol) {
+    case 'd': case 'D':
+        AddByteRange(&escaped, '0', '9');
+        break;
+    case 'w': case 'W':
+        AddByteRange(&escaped, '0', '9');
+        AddByteRange(&escaped, 'a', 'z');
+        AddByteRange(&escaped, 'A', 'Z');
+        AddByte(&escaped, '_');
+        break;
+    case 's': case 'S':
+        AddByte(&escaped, ' ');
+        AddByteRange(&escaped, '\t', '\r');
+        break;
+    case 't':
+        AddByte(set, '\t');
+        return '\t';
+    case 'x':
+        if (parser->position + 2 > parser->length)
+            return -2;
+        high = GetHexDigit(parser->pattern[parser->position]);
+        low  = GetHexDigit(parser->pattern[parser->position + 1]);
+        if (high < 0 || low < 0)
+            return -2;
+        parser->position += 2;
+        AddByte(set, (unsigned char)(high * 16 + low));
+        return high * 16 + low;
+    default:
+        // escaped special symbol or any other symbol matches itself
+        AddByte(set, (unsigned char)symbol);
+        return (unsigned char)symbol;
+    }
+
+    if (symbol == 'D' || symbol == 'W' || symbol == 'S')
+        InvertByteSet(&escaped);
+    for (i = 0; i < 32; ++i)
+        set->bits[i] |= escaped.bits[i];
+    return -1;
+}
+
+/**
+ * Parses bracket class "[...]".
+ * IN:
+ * @param parser - pointer to parser (position is after '[')
+ *
+ * OUT:
+ * @return number of node (-1 if class is malformed or there's not enough memory)
+ */
+static int ParseClass(RegexParser * parser) {
+    int node = AddSetNode(parser);
+    ByteSet * set;
+    BOOL negated = FALSE;
+    BOOL first = TRUE;
+    int low, high;
+
+    if (node < 0)
+        return -1;
+    set = &parser->regex->sets[parser->nodes[node].set];
+    if (PeekSymbol(parser, '^')) {
+        negated = TRUE;
+        parser->position++;
+    }
+
+    // ']' right after '[' or "[^" is a usual symbol
+    while (parser->position < parser->length && (first || !PeekSymbol(parser, ']'))) {
+        first = FALSE;
+        if (PeekSymbol(parser, '\\')) {
+            parser->position++;
+            low = ParseEscape(parser, set);
+        }
+        else {
+            low = (unsigned char)parser->pattern[parser->position++];
+            AddByte(set, (unsigned char)low);
+        }
+        if (low == -2)
+            break;
+
+        // range of symbols
+        if (low >= 0 && PeekSymbol(parser, '-') && parser->position + 1 < parser->length &&
+            parser->pattern[parser->position + 1] != ']') {
+            parser->position++;
+            if (PeekSymbol(parser, '\\')) {
+                parser->position++;
+                high = ParseEscape(parser, set);
+            }
+            else
+                high = (unsigned char)parser->pattern[parser->position++];
+            if (high < low)
+                break;
+            AddByteRange(set, (unsigned char)low, (unsigned char)high);
+        }
+    }
+    if (!PeekSymbol(parser, ']')) {
+        parser->errorType = ERR_REGEX;
+        return -1;
+    }
+    parser->position++;
+
+    if (negated)
+        InvertByteSet(set);
+    return node;
+}
+
+static int ParseAlternation(RegexParser * parser);
+
+/**
+ * Parses a single symbol, class, anchor or group.
+ * IN:
+ * @param parser - pointer to parser
+ *
+ * OUT:
+ * @return number of node (-1 if pattern is malformed or there's not enough memory)
+ */
+static int ParseAtom(RegexParser * parser) {
+    char symbol;
+    int node;
+
+    if (parser->position >= parser->length) {
+        parser->errorType = ERR_REGEX;
+        return -1;
+    }
+    symbol = parser->pattern[parser->position++];
+
+    switch (symbol) {
+    case '(':
+        // groups don't capture anything, so "(?:" is the same as "("
+        if (PeekSymbol(parser, '?') && parser->position + 1 < parser->length &&
+            parser->pattern[parser->position + 1] == ':')
+            parser->position += 2;
+        node = ParseAlternation(parser);
+        if (node < 0)
+            return -1;
+        if (!PeekSymbol(parser, ')')) {
+            parser->errorType = ERR_REGEX;
+            return -1;
+        }
+        parser->position++;
+        return node;
+
+    case '[':
+        return ParseClass(parser);
+
+    case '.':
+        node = AddSetNode(parser);
+        if (node >= 0) {
+            InvertByteSet(&parser->regex->sets[parser->nodes[node].set]);
+        }
+        return node;
+
+    case '^':
+        return AddAstNode(parser, AST_LINE_BEGIN, -1, -1);
+
+    case '$':
+        return AddAstNode(parser, AST_LINE_END, -1, -1);
+
+    case '\\':
+        node = AddSetNode(parser);
+        if (node >= 0 && ParseEscape(parser, &parser->regex->sets[parser->nodes[node].set]) == -2) {
+            parser->errorType = ERR_REGEX;
+            return -1;
+        }
+        return node;
+
+    case '*': case '+': case '?': case '{': case ')':
+        // repetition of nothing
+        parser->errorType = ERR_REGEX;
+        return -1;
+
+    default:
+        node = AddSetNode(parser);
+        if (node >= 0)
+            AddByte(&parser->regex->sets[parser->nodes[node].set], (unsigned char)symbol);
+        return node;
+    }
+}
+
+/**
+ * Parses decimal number of repetitions.
+ * IN:
+ * @param parser - pointer to parser
+ *
+ * OUT:
+ * @return parsed number (-1 if there's no digits or number is too big)
+ */
+static int ParseCount(RegexParser * parser) {
+    int count = -1;
+
+    while (parser->position < parser->length &&
+           parser->pattern[parser->position] >= '0' && parser->pattern[parser->position] <= '9') {
+        count = ((count < 0) ? 0 : count * 10) + (parser->pattern[parser->position++] - '0');
+        if (count > MAX_REPEAT_COUNT)
+            return -1;
+    }
+    return count;
+}
+
+/**
+ * Parses atom followed by repetition operators.
+ * IN:
+ * @param parser - pointer to parser
+ *
+ * OUT:
+ * @return number of node (-1 if pattern is malformed or there's not enough memory)
+ */
+static int ParseRepeat(RegexParser * parser) {
+    int node = ParseAtom(parser);
+    int min, max;
+
+    while (node >= 0 && parser->position < parser->length) {
+        switch (parser->pattern[parser->position]) {
+        case '*':
+            min = 0;
+            max = -1;
+            break;
+        case '+':
+            min = 1;
+            max = -1;
+            break;
+        case '?':
+            min = 0;
+            max = 1;
+            break;
+        case '{':
+            parser->position++;
+            min = max = ParseCount(parser);
+            if (PeekSymbol(parser, ',')) {
+                parser->position++;
+                max = PeekSymbol(parser, '}') ? -1 : ParseCount(parser);
+                if (max < -1 || (max >= 0 && max < min) || (max == -1 && !PeekSymbol(parser, '}')))
+                    min = -1;
+            }
+            if (min < 0 || !PeekSymbol(parser, '}')) {
+                parser->errorType = ERR_REGEX;
+                return -1;
+            }
+            break;
+        default:
+            return node;
+        }
+        parser->position++;
+
+        node = AddAstNode(parser, AST_REPEAT, node, -1);
+        if (node >= 0) {
+            parser->nodes[node].min = min;
+            parser->nodes[node].max = max;
+        }
+    }
+    return node;
+}
+
+/**
+ * Parses sequence of repeated atoms.
+ * IN:
+ * @param parser - pointer to parser
+ *
+ * OUT:
+ * @return number of node (-1 if pattern is malformed or there's not enough memory)
+ */
+static int ParseConcat(RegexParser * parser) {
+    int node = AddAstNode(parser, AST_EMPTY, -1, -1);
+    int item;
+
+    while (node >= 0 && parser->position < parser->length && !PeekSymbol(parser, '|') && !PeekSymbol(parser, ')')) {
+        item = ParseRepeat(parser);
+        if (item < 0)
+            return -1;
+        node = (parser->nodes[node].type == AST_EMPTY) ? item : AddAstNode(parser, AST_CONCAT, node, item);
+    }
+    return node;
+}
+
+/**
+ * Parses alternatives separated with '|'.
+ * IN:
+ * @param parser - pointer to parser
+ *
+ * OUT:
+ * @return number of node (-1 if pattern is malformed or there's not enough memory)
+ */
+static int ParseAlternation(RegexParser * parser) {
+    int node = ParseConcat(parser);
+    int alternative;
+
+    while (node >= 0 && PeekSymbol(parser, '|')) {
+        parser->position++;
+        alternative = ParseConcat(parser);
+        if (alternative < 0)
+            return -1;
+        node = AddAstNode(parser, AST_ALTERNATE, node, alternative);
+    }
+    return node;
+}
+
+/**
+ * Adds NFA node to regex.
+ * IN:
+ * @param regex - pointer to regex
+ * @param type - type of node
+ * @param set - number of byte set (-1 if node doesn't pass bytes)
+ * @param out, out2 - next nodes (-1 if they aren't used)
+ *
+ * OUT:
+ * @return number of added node (-1 if NFA is too big or there's not enough memory)
+ */
+static int AddNfaNode(Regex * regex, NfaType type, int set, int out, int out2) {
+    NfaNode * nodes;
+    int capacity;
+
+    if (regex->nodesNumber == regex->nodesCapacity) {
+        if (regex->nodesCapacity >= MAX_NFA_NODES)
+            return -1;
+        capacity = (regex->nodesCapacity > 0) ? regex->nodesCapacity * 2 : 64;
+        nodes = (NfaNode*)realloc(regex->nodes, capacity * sizeof(NfaNode));
+        if (nodes == NULL)
+            return -1;
+        regex->nodes = nodes;
+        regex->nodesCapacity = capacity;
+    }
+    nodes = &regex->nodes[regex->nodesNumber];
+    nodes->type = type;
+    nodes->set  = set;
+    nodes->out  = out;
+    nodes->out2 = out2;
+    return regex->nodesNumber++;
+}
+
+/**
+ * Builds NFA fragment of syntax tree node. Fragments are built from the end of pattern,
+ * so each one is linked with it's continuation right away.
+ * IN:
+ * @param regex - pointer to regex getting nodes
+ * @param ast - array of syntax tree nodes
+ * @param node - number of syntax tree node
+ * @param next - the first node of continuation
+ *
+ * OUT:
+ * @return the first node of fragment (-1 if NFA is too big or there's not enough memory)
+ */
+static int CompileAstNode(Regex * regex, AstNode const * ast, int node, int next) {
+    AstNode const * item = &ast[node];
+    int start, body, i;
+
+    switch (item->type) {
+    case AST_EMPTY:
+        return next;
+    case AST_SET:
+        return AddNfaNode(regex, NFA_BYTES, item->set, next, -1);
+    case AST_LINE_BEGIN:
+        return AddNfaNode(regex, NFA_LINE_BEGIN, -1, next, -1);
+    case AST_LINE_END:
+        return AddNfaNode(regex, NFA_LINE_END, -1, next, -1);
+    case AST_CONCAT:
+        start = CompileAstNode(regex, ast, item->right, next);
+        return (start < 0) ? -1 : CompileAstNode(regex, ast, item->left, start);
+    case AST_ALTERNATE:
+        start = CompileAstNode(regex, ast, item->left, next);
+        body  = (start < 0) ? -1 : CompileAstNode(regex, ast, item->right, next);
+        return (body < 0) ? -1 : AddNfaNode(regex, NFA_SPLIT, -1, start, body);
+    default:
+        break;
+    }
+
+    // repetition: optional copies go after mandatory ones
+    if (item->max < 0) {
+        start = AddNfaNode(regex, NFA_SPLIT, -1, -1, next);
+        body  = (start < 0) ? -1 : CompileAstNode(regex, ast, item->left, start);
+        if (body < 0)
+            return -1;
+        regex->nodes[start].out = body;
+    }
+    else {
+        for (start = next, i = item->min; i < item->max && start >= 0; ++i) {
+            body  = CompileAstNode(regex, ast, item->left, start);
+            start = (body < 0) ? -1 : AddNfaNode(regex, NFA_SPLIT, -1, body, next);
+        }
+    }
+    for (i = 0; i < item->min && start >= 0; ++i)
+        start = CompileAstNode(regex, ast, item->left, start);
+    return start;
+}
+
+static void FindRequiredLiteral(Regex * regex, AstNode const * ast, int node);
+
+/**
+ * Offers string as required literal: the longest one is kept.
+ * IN:
+ * @param regex - pointer to regex
+ * @param literal - string every match contains
+ * @param literalLength - length of string
+ */
+static void OfferLiteral(Regex * regex, char const * literal, size_t literalLength) {
+    if (literalLength > regex->literalLength) {
+        memcpy(regex->literal, literal, literalLength);
+        regex->literalLength = literalLength;
+    }
+}
+
+/**
+ * Finds strings every match of concatenation contains: runs of single symbols
+ * and required literals of operands repeated at least once.
+ * IN:
+ * @param regex - pointer to regex getting the longest literal
+ * @param ast - array of syntax tree nodes
+ * @param node - number of concatenation node
+ * @param run - buffer of current run of single symbols
+ * @param runLength - length of current run
+ *
+ * OUT:
+ * @return length of run after the last operand of node
+ */
+static size_t FindConcatLiterals(Regex * regex, AstNode const * ast, int node, char * run, size_t runLength) {
+    AstNode const * item = &ast[node];
+    int byte;
+
+    switch (item->type) {
+    case AST_CONCAT:
+        runLength = FindConcatLiterals(regex, ast, item->left, run, runLength);
+        return FindConcatLiterals(regex, ast, item->right, run, runLength);
+    case AST_EMPTY:
+    case AST_LINE_BEGIN:
+    case AST_LINE_END:
+        return runLength;       // empty matches don't split runs
+    case AST_SET:
+        byte = GetSingleByte(&regex->sets[item->set]);
+        if (byte >= 0 && runLength < MAX_LITERAL_LENGTH) {
+            run[runLength++] = (char)byte;
+            OfferLiteral(regex, run, runLength);
+            return runLength;
+        }
+        return 0;
+    default:
+        FindRequiredLiteral(regex, ast, node);
+        return 0;
+    }
+}
+
+/**
+ * Finds the longest string every match of syntax tree node contains.
+ * IN:
+ * @param regex - pointer to regex getting the longest literal
+ * @param ast - array of syntax tree nodes
+ * @param node - number of node
+ */
+static void FindRequiredLiteral(Regex * regex, AstNode const * ast, int node) {
+    char run[MAX_LITERAL_LENGTH];
+
+    switch (ast[node].type) {
+    case AST_CONCAT:
+    case AST_SET:
+        FindConcatLiterals(regex, ast, node, run, 0);
+        break;
+    case AST_REPEAT:
+        if (ast[node].min > 0)
+            FindRequiredLiteral(regex, ast, ast[node].left);
+        break;
+    default:
+        break;     // alternatives may have no common strings
+    }
+}
+
+/**
+ * Compiles regular expression into NFA and finds string all matches contain.
+ * IN:
+ * @param pattern - regular expression (see syntax in Regex.h)
+ * @param patternLength - length of pattern
+ *
+ * OUT:
+ * @param regex - gets pointer to compiled regex (it has to be destroyed with DestroyRegex)
+ * @return ERR_REGEX if pattern is malformed or too big, other code of error occured during compiling (ERR_NO if successed)
+ */
+ErrorType CompileRegex(Regex ** regex, char const * pattern, size_t patternLength) {
+    RegexParser parser;
+    Regex * compiled;
+    int root, match;
+
+    if (regex == NULL || pattern == NULL)
+        return ERR_NULL_PTR;
+    if (patternLength > MAX_PATTERN_LENGTH)
+        return ERR_REGEX;
+
+    compiled = (Regex*)calloc(1, sizeof(Regex));
+    if (compiled == NULL)
+        return ERR_NOMEM;
+
+    memset(&parser, 0, sizeof(RegexParser));
+    parser.pattern   = pattern;
+    parser.length    = patternLength;
+    parser.regex     = compiled;
+    parser.errorType = ERR_NO;
+    root = ParseAlternation(&parser);
+    if (root >= 0 && parser.position < parser.length)
+        parser.errorType = ERR_REGEX;   // unbalanced ')'
+    if (root < 0 || parser.errorType != ERR_NO) {
+        free(parser.nodes);
+        DestroyRegex(compiled);
+        return (parser.errorType != ERR_NO) ? parser.errorType : ERR_REGEX;
+    }
+
+    match = AddNfaNode(compiled, NFA_MATCH, -1, -1, -1);
+    compiled->start = (match < 0) ? -1 : CompileAstNode(compiled, parser.nodes, root, match);
+    if (compiled->start < 0) {
+        root = (compiled->nodesCapacity >= MAX_NFA_NODES);
+        free(parser.nodes);
+        DestroyRegex(compiled);
+        return root ? ERR_REGEX : ERR_NOMEM;
+    }
+    FindRequiredLiteral(compiled, parser.nodes, root);
+
+    free(parser.nodes);
+    *regex = compiled;
+    return ERR_NO;
+}
+
+/**
+ * Frees memory of compiled regex.
+ * IN:
+ * @param regex - pointer to regex (may be NULL)
+ */
+void DestroyRegex(Regex * regex) {
+    if (regex == NULL)
+        return;
+    free(regex->nodes);
+    free(regex->sets);
+    free(regex);
+}
+
+/**
+ * Gives string every match contains, it can be searched before regex is run.
+ * IN:
+ * @param regex - pointer to regex
+ *
+ * OUT:
+ * @param literalLength - gets length of string (0 if there's no such string)
+ * @return pointer to string (not terminated with '\0')
+ */
+char const * GetRegexLiteral(Regex const * regex, size_t * literalLength) {
+    *literalLength = regex->literalLength;
+    return regex->literal;
+}
+
+/**
+ * Forgets all built DFA states when there's no room for a new one.
+ * IN:
+ * @param matcher - pointer to matcher
+ */
+static void FlushDfaStates(RegexMatcher * matcher) {
+    int i;
+
+    matcher->statesNumber  = 0;
+    matcher->poolSize      = 0;
+    matcher->setOffsets[0] = 0;
+    matcher->lineStart     = DFA_UNKNOWN;
+    matcher->idleOffset    = -1;
+    for (i = 0; i <= matcher->bucketsMask; ++i)
+        matcher->buckets[i] = -1;
+}
+
+/**
+ * Starts new generation of visited nodes marks.
+ * IN:
+ * @param matcher - pointer to matcher
+ */
+static void ResetMarks(RegexMatcher * matcher) {
+    if (++matcher->generation == 0) {
+        memset(matcher->marks, 0, matcher->regex->nodesNumber * sizeof(unsigned int));
+        matcher->generation = 1;
+    }
+}
+
+/**
+ * Compares numbers of NFA nodes for sorting.
+ */
+static int CompareNodes(void const * first, void const * second) {
+    return *(int const *)first - *(int const *)second;
+}
+
+/**
+ * Finds NFA nodes reachable without input from nodes on stack.
+ * Only nodes which pass bytes, check line end or match are collected.
+ * IN:
+ * @param matcher - pointer to matcher (stack keeps seeds)
+ * @param seedsNumber - number of seeds on stack
+ * @param lineBegin - TRUE if it's the beginning of line
+ *
+ * OUT:
+ * matcher->collected gets sorted nodes
+ * @return number of collected nodes
+ */
+static int CollectClosure(RegexMatcher * matcher, int seedsNumber, BOOL lineBegin) {
+    NfaNode const * nodes = matcher->regex->nodes;
+    int collectedNumber = 0;
+    int top = seedsNumber;
+    int node;
+
+    ResetMarks(matcher);
+    while (top > 0) {
+        node = matcher->stack[--top];
+        if (node < 0 || matcher->marks[node] == matcher->generation)
+            continue;
+        matcher->marks[node] = matcher->generation;
+
+        switch (nodes[node].type) {
+        case NFA_SPLIT:
+            matcher->stack[top++] = nodes[node].out2;
+            matcher->stack[top++] = nodes[node].out;
+            break;
+        case NFA_LINE_BEGIN:
+            if (lineBegin)
+                matcher->stack[top++] = nodes[node].out;
+            break;
+        default:
+            matcher->collected[collectedNumber++] = node;
+            break;
+        }
+    }
+    qsort(matcher->collected, collectedNumber, sizeof(int), CompareNodes);
+    return collectedNumber;
+}
+
+/**
+ * Checks whether set of NFA nodes matches if line ends here.
+ * IN:
+ * @param matcher - pointer to matcher
+ * @param set - sorted NFA nodes of state
+ * @param setSize - number of nodes
+ *
+ * OUT:
+ * @return TRUE if match is reachable through line end checks
+ */
+static BOOL IsMatchingAtLineEnd(RegexMatcher * matcher, int const * set, int setSize) {
+    NfaNode const * nodes = matcher->regex->nodes;
+    int top = 0;
+    int node, i;
+
+    ResetMarks(matcher);
+    for (i = 0; i < setSize; ++i) {
+        if (nodes[set[i]].type == NFA_LINE_END)
+            matcher->stack[top++] = set[i];
+    }
+    while (top > 0) {
+        node = matcher->stack[--top];
+        if (node < 0 || matcher->marks[node] == matcher->generation)
+            continue;
+        matcher->marks[node] = matcher->generation;
+
+        switch (nodes[node].type) {
+        case NFA_MATCH:
+            return TRUE;
+        case NFA_SPLIT:
+            matcher->stack[top++] = nodes[node].out2;
+            matcher->stack[top++] = nodes[node].out;
+            break;
+        case NFA_LINE_END:
+            matcher->stack[top++] = nodes[node].out;
+            break;
+        default:
+            break;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Gives DFA state of collected NFA nodes, builds it if it isn't built yet.
+ * IN:
+ * @param matcher - pointer to matcher (collected keeps sorted nodes)
+ * @param setSize - number of collected nodes
+ *
+ * OUT:
+ * @return number of state, DFA_MATCHED, DFA_DEAD or DFA_FAILED
+ */
+static int GetDfaState(RegexMatcher * matcher, int setSize) {
+    NfaNode const * nodes = matcher->regex->nodes;
+    unsigned int hash = 2166136261u;
+    int * transitions;
+    int * pool;
+    int bucket, state, i;
+
+    if (setSize == 0)
+        return DFA_DEAD;
+    for (i = 0; i < setSize; ++i) {
+        if (nodes[matcher->collected[i]].type == NFA_MATCH)
+            return DFA_MATCHED;
+        hash = (hash ^ (unsigned int)matcher->collected[i]) * 16777619u;
+    }
+
+    for (bucket = hash & matcher->bucketsMask; (state = matcher->buckets[bucket]) >= 0;
+         bucket = (bucket + 1) & matcher->bucketsMask) {
+        if (matcher->hashes[state] == hash &&
+            matcher->setOffsets[state + 1] - matcher->setOffsets[state] == setSize &&
+            memcmp(matcher->pool + matcher->setOffsets[state], matcher->collected, setSize * sizeof(int)) == 0)
+            return state;
+    }
+
+    // new state
+    if (matcher->statesNumber == DFA_STATES_NUMBER) {
+        FlushDfaStates(matcher);
+        for (bucket = hash & matcher->bucketsMask; matcher->buckets[bucket] >= 0; bucket = (bucket + 1) & matcher->bucketsMask)
+            ;
+    }
+    if (matcher->poolSize + setSize > matcher->poolCapacity) {
+        pool = (int*)realloc(matcher->pool, (matcher->poolSize + setSize) * 2 * sizeof(int));
+        if (pool == NULL) {
+            matcher->failed = TRUE;
+            return DFA_FAILED;
+        }
+        matcher->pool = pool;
+        matcher->poolCapacity = (matcher->poolSize + setSize) * 2;
+    }
+
+    state = matcher->statesNumber++;
+    memcpy(matcher->pool + matcher->poolSize, matcher->collected, setSize * sizeof(int));
+    matcher->poolSize += setSize;
+    matcher->setOffsets[state + 1] = matcher->poolSize;
+    matcher->hashes[state]  = hash;
+    matcher->buckets[bucket] = state;
+    matcher->eolMatching[state] = (unsigned char)IsMatchingAtLineEnd(matcher, matcher->collected, setSize);
+
+    transitions = matcher->transitions + (size_t)state * 256;
+    for (i = 0; i < 256; ++i)
+        transitions[i] = DFA_UNKNOWN;
+    transitions['\n'] = DFA_LINE_BREAK;
+    transitions['\r'] = DFA_LINE_BREAK;
+    return state;
+}
+
+/**
+ * Gives DFA state at the beginning of line. Idle state (no matches are started inside line)
+ * is built together with it, so both of them survive until cache is flushed.
+ * IN:
+ * @param matcher - pointer to matcher
+ *
+ * OUT:
+ * @return number of state, DFA_MATCHED, DFA_DEAD or DFA_FAILED
+ */
+static int GetLineStartState(RegexMatcher * matcher) {
+    int idle;
+
+    if (matcher->lineStart == DFA_UNKNOWN) {
+        if (matcher->statesNumber + 2 > DFA_STATES_NUMBER)
+            FlushDfaStates(matcher);
+        matcher->stack[0] = matcher->regex->start;
+        idle = GetDfaState(matcher, CollectClosure(matcher, 1, FALSE));
+        matcher->idleOffset = (idle >= 0) ? idle * 256 : -1;
+        matcher->stack[0] = matcher->regex->start;
+        matcher->lineStart = GetDfaState(matcher, CollectClosure(matcher, 1, TRUE));
+    }
+    return matcher->lineStart;
+}
+
+/**
+ * Builds transition of DFA state by byte. Pattern may begin at each position of line,
+ * so the first node of NFA is added to every state.
+ * IN:
+ * @param matcher - pointer to matcher
+ * @param state - number of built state
+ * @param byte - input byte (not a line break)
+ *
+ * OUT:
+ * @return number of the next state, DFA_MATCHED, DFA_DEAD or DFA_FAILED
+ */
+static int BuildDfaTransition(RegexMatcher * matcher, int state, unsigned char byte) {
+    Regex const * regex = matcher->regex;
+    int const * set = matcher->pool + matcher->setOffsets[state];
+    int setSize = matcher->setOffsets[state + 1] - matcher->setOffsets[state];
+    int seedsNumber = 0;
+    int statesNumber = matcher->statesNumber;
+    int next, i;
+
+    for (i = 0; i < setSize; ++i) {
+        if (regex->nodes[set[i]].type == NFA_BYTES && HasByte(&regex->sets[regex->nodes[set[i]].set], byte))
+            matcher->stack[seedsNumber++] = regex->nodes[set[i]].out;
+    }
+    matcher->stack[seedsNumber++] = regex->start;
+
+    next = GetDfaState(matcher, CollectClosure(matcher, seedsNumber, FALSE));
+
+    // state is lost if cache has been flushed
+    if (next != DFA_FAILED && matcher->statesNumber >= statesNumber)
+        matcher->transitions[(size_t)state * 256 + byte] = (next >= 0) ? next * 256 : next;
+    return next;
+}
+
+/**
+ * Creates matcher which runs regex as DFA built lazily within fixed memory.
+ * Matcher isn't thread safe: each thread needs it's own one.
+ * IN:
+ * @param regex - pointer to compiled regex (it has to live longer than matcher)
+ *
+ * OUT:
+ * @param matcher - gets pointer to matcher (it has to be destroyed with DestroyRegexMatcher)
+ * @return code of error occured during creating (ERR_NO if successed)
+ */
+ErrorType CreateRegexMatcher(RegexMatcher ** matcher, Regex const * regex) {
+    RegexMatcher * created;
+    NfaNode const * node;
+    int bucketsNumber = DFA_STATES_NUMBER * 2;
+    int nodesNumber = regex->nodesNumber;
+    int byte, i;
+
+    if (matcher == NULL || regex == NULL)
+        return ERR_NULL_PTR;
+    created = (RegexMatcher*)calloc(1, sizeof(RegexMatcher));
+    if (created == NULL)
+        return ERR_NOMEM;
+
+    created->regex       = regex;
+    created->bucketsMask = bucketsNumber - 1;
+    created->transitions = (int*)malloc((size_t)DFA_STATES_NUMBER * 256 * sizeof(int));
+    created->eolMatching = (unsigned char*)malloc(DFA_STATES_NUMBER);
+    created->hashes      = (unsigned int*)malloc(DFA_STATES_NUMBER * sizeof(unsigned int));
+    created->setOffsets  = (int*)malloc((DFA_STATES_NUMBER + 1) * sizeof(int));
+    created->buckets     = (int*)malloc(bucketsNumber * sizeof(int));
+    created->stack       = (int*)malloc(nodesNumber * 2 * sizeof(int));
+    created->collected   = (int*)malloc(nodesNumber * sizeof(int));
+    created->marks       = (unsigned int*)calloc(nodesNumber, sizeof(unsigned int));
+    if (created->transitions == NULL || created->eolMatching == NULL || created->hashes == NULL ||
+        created->setOffsets == NULL || created->buckets == NULL || created->stack == NULL ||
+        created->collected == NULL || created->marks == NULL) {
+        DestroyRegexMatcher(created);
+        return ERR_NOMEM;
+    }
+    FlushDfaStates(created);
+
+    // bytes passed by the first nodes of pattern and line breaks stop skipping in idle state
+    created->stack[0] = regex->start;
+    for (i = CollectClosure(created, 1, FALSE) - 1; i >= 0; --i) {
+        node = &regex->nodes[created->collected[i]];
+        for (byte = 0; byte < 256 && node->type == NFA_BYTES; ++byte)
+            created->stopBytes[byte] |= (unsigned char)HasByte(&regex->sets[node->set], (unsigned char)byte);
+    }
+    created->stopBytes['\n'] = created->stopBytes['\r'] = 1;
+
+    *matcher = created;
+    return ERR_NO;
+}
+
+/**
+ * Finds the first line which contains match of regex. Lines are separated
+ * with "\n", "\r\n" or "\r", the last line ends at the end of text.
+ * IN:
+ * @param matcher - pointer to matcher
+ * @param text - text to search
+ * @param begin - beginning of the first line to check
+ * @param end - lines beginning at this position and after it aren't checked
+ * @param size - size of text (the last checked line may continue after end)
+ *
+ * OUT:
+ * @return beginning of matching line (-1 if there's no such line or there's not enough memory)
+ */
+long long FindRegexLine(RegexMatcher * matcher, char const * text, long long begin, long long end, long long size) {
+    unsigned char const * bytes = (unsigned char const *)text;
+    int const * transitions = matcher->transitions;
+    unsigned char const * stopBytes = matcher->stopBytes;
+    long long lineBegin = begin;
+    long long position = begin;
+    int state, offset, next = DFA_UNKNOWN;
+
+    if (begin >= end)
+        return -1;
+
+    state = GetLineStartState(matcher);
+    while (state != DFA_FAILED) {
+        if (state == DFA_MATCHED)
+            return lineBegin;
+
+        if (state >= 0) {
+            // the hottest loop: walk through built transitions, bytes which don't start matches are skipped faster
+            for (offset = state * 256; position < size && (next = transitions[offset + bytes[position]]) >= 0; ) {
+                offset = next;
+                ++position;
+                if (offset == matcher->idleOffset) {
+                    while (position + 4 <= size && !(stopBytes[bytes[position]] | stopBytes[bytes[position + 1]] |
+                                                     stopBytes[bytes[position + 2]] | stopBytes[bytes[position + 3]]))
+                        position += 4;
+                    while (position < size && !stopBytes[bytes[position]])
+                        ++position;
+                }
+            }
+            state = offset / 256;
+            if (position < size && next == DFA_UNKNOWN) {
+                state = BuildDfaTransition(matcher, state, bytes[position++]);
+                continue;
+            }
+            if (position < size && next != DFA_LINE_BREAK) {
+                state = next;
+                ++position;
+                continue;
+            }
+            if (matcher->eolMatching[state])
+                return lineBegin;
+        }
+        else {
+            // the rest of line can't match
+            while (position < size && bytes[position] != '\n' && bytes[position] != '\r')
+                ++position;
+        }
+
+        // go to the next line
+        if (position >= size)
+            return -1;
+        if (bytes[position] == '\r' && position + 1 < size && bytes[position + 1] == '\n')
+            ++position;
+        lineBegin = ++position;
+        if (lineBegin >= end)
+            return -1;
+        state = GetLineStartState(matcher);
+    }
+    return -1;
+}
+
+/**
+ * Checks whether matcher has failed to build DFA state.
+ * IN:
+ * @param matcher - pointer to matcher
+ *
+ * OUT:
+ * @return TRUE if there has been not enough memory
+ */
+BOOL IsRegexMatcherFailed(RegexMatcher const * matcher) {
+    return matcher->failed;
+}
+
+/**
+ * Frees memory of matcher.
+ * IN:
+ * @param matcher - pointer to matcher (may be NULL)
+ */
+void DestroyRegexMatcher(RegexMatcher * matcher) {
+    if (matcher == NULL)
+        return;
+    free(matcher->transitions);
+    free(matcher->eolMatching);
+    free(matcher->hashes);
+    free(matcher->setOffsets);
+    free(matcher->buckets);
+    free(matcher->pool);
+    free(matcher->stack);
+    free(matcher->collected);
+    free(matcher->marks);
+    free(matcher);
+}
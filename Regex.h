@@ -0,0 +1,24 @@
+#ifndef REGEX_H_INCLUDED
+#define REGEX_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+
+/* supported syntax: literals, ".", "[...]" and "[^...]" classes with ranges,
+ * escapes \d \D \w \W \s \S \t \xHH and escaped special symbols,
+ * grouping "(...)", alternation "|", repetitions "*", "+", "?", "{m}", "{m,}", "{m,n}",
+ * line anchors "^" and "$"; matches never cross line breaks */
+
+typedef struct tag_Regex Regex;
+typedef struct tag_RegexMatcher RegexMatcher;
+
+ErrorType CompileRegex(Regex ** regex, char const * pattern, size_t patternLength);
+void DestroyRegex(Regex * regex);
+char const * GetRegexLiteral(Regex const * regex, size_t * literalLength);
+ErrorType CreateRegexMatcher(RegexMatcher ** matcher, Regex const * regex);
+long long FindRegexLine(RegexMatcher * matcher, char const * text, long long begin, long long end, long long size);
+BOOL IsRegexMatcherFailed(RegexMatcher const * matcher);
+void DestroyRegexMatcher(RegexMatcher * matcher);
+
+#endif // REGEX_H_INCLUDED
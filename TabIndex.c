@@ -0,0 +1,438 @@
+#include "TabIndex.h"
+#include "ColumnIndex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_TAB_CHECKPOINTS_CAPACITY 16
+
+/**
+ * Initializes empty index of lines display widths.
+ * IN:
+ * @param tabs - pointer to structure to initialize
+ * @param tabSize - distance between tab stops in columns (from 1 to MAX_TAB_SIZE)
+ *
+ * OUT:
+ * fields of tabs are initialized
+ * @return ERR_NOMEM if there's not enough memory for slots (ERR_NO if successed)
+ */
+ErrorType CreateTabIndex(TabIndex * tabs, int tabSize) {
+    int slot;
+
+    if (tabs == NULL || tabSize < 1 || tabSize > MAX_TAB_SIZE)
+        return ERR_NULL_PTR;
+    memset(tabs, 0, sizeof(TabIndex));
+    tabs->tabSize = tabSize;
+    tabs->lines = (TabLine*)calloc(TAB_CACHE_SIZE, sizeof(TabLine));
+    if (tabs->lines == NULL)
+        return ERR_NOMEM;
+    for (slot = 0; slot < TAB_CACHE_SIZE; ++slot)
+        tabs->lines[slot].line = -1;
+    return ERR_NO;
+}
+
+/**
+ * Frees memory allocated for index of lines display widths.
+ * IN:
+ * @param tabs - pointer to index to destroy
+ *
+ * OUT:
+ * fields of tabs are set to empty index
+ */
+void DestroyTabIndex(TabIndex * tabs) {
+    int slot;
+
+    if (tabs == NULL)
+        return;
+    if (tabs->lines != NULL) {
+        for (slot = 0; slot < TAB_CACHE_SIZE; ++slot)
+            free(tabs->lines[slot].checkpoints);
+        free(tabs->lines);
+    }
+    free(tabs->scratch);
+    memset(tabs, 0, sizeof(TabIndex));
+}
+
+/**
+ * Gives number of bytes occupied by index of lines display widths.
+ * IN:
+ * @param tabs - pointer to index
+ *
+ * OUT:
+ * @return size of slots, checkpoints and scratch buffer in bytes
+ */
+size_t GetTabIndexMemory(TabIndex const * tabs) {
+    size_t memory = tabs->scratchSize;
+    int slot;
+
+    if (tabs->lines == NULL)
+        return memory;
+    memory += TAB_CACHE_SIZE * sizeof(TabLine);
+    for (slot = 0; slot < TAB_CACHE_SIZE; ++slot)
+        memory += (size_t)tabs->lines[slot].checkpointsCapacity * sizeof(TabCheckpoint);
+    return memory;
+}
+
+/**
+ * Empties slot of line.
+ * IN:
+ * @param line - pointer to slot
+ *
+ * OUT:
+ * line->line sets as -1, checkpoints of line are freed
+ */
+static void ClearTabLine(TabLine * line) {
+    free(line->checkpoints);
+    memset(line, 0, sizeof(TabLine));
+    line->line = -1;
+}
+
+/**
+ * Forgets widths of lines which have changed (when text has grown or it's encoding has been switched).
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param firstLine - the first changed line (0 forgets all lines and the biggest width)
+ *
+ * OUT:
+ * slots of lines starting from firstLine are emptied
+ */
+void ForgetTabLines(TabIndex * tabs, long long firstLine) {
+    int slot;
+
+    for (slot = 0; slot < TAB_CACHE_SIZE; ++slot) {
+        if (tabs->lines[slot].line >= firstLine)
+            ClearTabLine(&tabs->lines[slot]);
+    }
+    if (firstLine == 0)
+        tabs->maxWidth = 0;
+}
+
+/**
+ * Finds measured line.
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @return pointer to measured line (NULL if line isn't measured or it has been evicted)
+ */
+TabLine * FindTabLine(TabIndex * tabs, long long lineNumber) {
+    TabLine * line = &tabs->lines[lineNumber % TAB_CACHE_SIZE];
+
+    return (line->line == lineNumber) ? line : NULL;
+}
+
+/**
+ * Starts measuring line: it takes slot of line measured before. Line content is given with AddTabText
+ * and measuring is finished with FinishTabLine.
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @return pointer to slot of line
+ */
+TabLine * StartTabLine(TabIndex * tabs, long long lineNumber) {
+    TabLine * line = &tabs->lines[lineNumber % TAB_CACHE_SIZE];
+
+    ClearTabLine(line);
+    line->line = lineNumber;
+    return line;
+}
+
+/**
+ * Saves checkpoint of line.
+ * IN:
+ * @param line - pointer to line being measured
+ * @param offset - offset of character from line beginning
+ * @param column - display column character starts at
+ *
+ * OUT:
+ * line->checkpoints gets checkpoint
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL AddTabCheckpoint(TabLine * line, long long offset, long long column) {
+    TabCheckpoint * checkpoints;
+    long long capacity;
+
+    if (line->checkpointsNumber == line->checkpointsCapacity) {
+        capacity = (line->checkpointsCapacity > 0) ? line->checkpointsCapacity * 2 : INITIAL_TAB_CHECKPOINTS_CAPACITY;
+        checkpoints = (TabCheckpoint*)realloc(line->checkpoints, (size_t)capacity * sizeof(TabCheckpoint));
+        if (checkpoints == NULL)
+            return FALSE;
+        line->checkpoints         = checkpoints;
+        line->checkpointsCapacity = capacity;
+    }
+    line->checkpoints[line->checkpointsNumber].offset = offset;
+    line->checkpoints[line->checkpointsNumber].column = column;
+    line->checkpointsNumber++;
+    return TRUE;
+}
+
+/**
+ * Measures part of line content: tabs move column to the next tab stop, other characters take one column.
+ * Parts have to be given in order, they may split UTF-8 characters.
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param line - pointer to line being measured (see StartTabLine)
+ * @param text - part of line content
+ * @param size - size of part in bytes
+ * @param offset - offset of part from line beginning
+ * @param utf8 - TRUE if line is valid UTF-8 with multibyte characters, FALSE if it's characters are bytes
+ *
+ * OUT:
+ * line->width gets display width of line content measured so far, line->checkpoints get checkpoints of part
+ * @return TRUE if successed, FALSE if there's not enough memory (line has to be forgotten)
+ */
+BOOL AddTabText(TabIndex * tabs, TabLine * line, char const * text, long long size, long long offset, BOOL utf8) {
+    long long checkpoint = (line->checkpointsNumber + 1) * TAB_CHECKPOINT_STEP;
+    long long position = 0;
+    long long stop, columns, skip;
+    char const * tab;
+
+    while (position < size) {
+        // characters between tabs are counted with vector kernels
+        tab  = (char const *)memchr(text + position, '\t', (size_t)(size - position));
+        stop = (tab != NULL) ? tab - text : size;
+        columns = utf8 ? CountColumns(text + position, stop - position, INDEXER_KERNEL_AUTO) : stop - position;
+        for (; checkpoint < line->width + columns; checkpoint += TAB_CHECKPOINT_STEP) {
+            // the first character of run starts after checkpoint column if tab has stepped over it
+            skip = max(0, checkpoint - line->width);
+            if (!AddTabCheckpoint(line, offset + position +
+                                  (utf8 ? SkipColumns(text + position, stop - position, skip, INDEXER_KERNEL_AUTO) : skip),
+                                  line->width + skip))
+                return FALSE;
+        }
+        line->width += columns;
+        if (tab == NULL)
+            break;
+
+        line->tabs = TRUE;
+        if (checkpoint <= line->width) {
+            if (!AddTabCheckpoint(line, offset + stop, line->width))
+                return FALSE;
+            checkpoint += TAB_CHECKPOINT_STEP;
+        }
+        line->width = (line->width / tabs->tabSize + 1) * tabs->tabSize;
+        position = stop + 1;
+    }
+    return TRUE;
+}
+
+/**
+ * Finishes measuring line: it's width is taken into account in the biggest width.
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param line - pointer to measured line
+ *
+ * OUT:
+ * tabs->maxWidth gets width of line if it's bigger, checkpoints of line without tabs are freed
+ */
+void FinishTabLine(TabIndex * tabs, TabLine * line) {
+    if (!line->tabs) {
+        // columns of line without tabs are converted without checkpoints
+        free(line->checkpoints);
+        line->checkpoints         = NULL;
+        line->checkpointsNumber   = 0;
+        line->checkpointsCapacity = 0;
+    }
+    if (tabs->maxWidth < line->width)
+        tabs->maxWidth = line->width;
+}
+
+/**
+ * Gives the nearest checkpoint of line not after display column.
+ * IN:
+ * @param line - pointer to measured line
+ * @param column - display column
+ *
+ * OUT:
+ * @param offset - gets offset of checkpoint character from line beginning
+ * @return display column checkpoint character starts at (0 for line beginning)
+ */
+long long GetTabCheckpoint(TabLine const * line, long long column, long long * offset) {
+    long long low = 0;
+    long long high = line->checkpointsNumber;
+    long long middle;
+
+    // number of checkpoints not after column
+    while (low < high) {
+        middle = low + (high - low + 1) / 2;
+        if (line->checkpoints[middle - 1].column <= column)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    *offset = (low > 0) ? line->checkpoints[low - 1].offset : 0;
+    return (low > 0) ? line->checkpoints[low - 1].column : 0;
+}
+
+/**
+ * Gives the nearest checkpoint of line not after byte offset.
+ * IN:
+ * @param line - pointer to measured line
+ * @param offset - offset from line beginning
+ *
+ * OUT:
+ * @param column - gets display column checkpoint character starts at (0 for line beginning)
+ * @return offset of checkpoint character from line beginning
+ */
+long long GetTabOffsetCheckpoint(TabLine const * line, long long offset, long long * column) {
+    long long low = 0;
+    long long high = line->checkpointsNumber;
+    long long middle;
+
+    while (low < high) {
+        middle = low + (high - low + 1) / 2;
+        if (line->checkpoints[middle - 1].offset <= offset)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    *column = (low > 0) ? line->checkpoints[low - 1].column : 0;
+    return (low > 0) ? line->checkpoints[low - 1].offset : 0;
+}
+
+/**
+ * Counts display column after text.
+ * IN:
+ * @param text - text of line beginning with character
+ * @param size - size of text in bytes
+ * @param column - display column text starts at
+ * @param tabSize - distance between tab stops
+ * @param utf8 - TRUE if text is UTF-8 with multibyte characters, FALSE if it's characters are bytes
+ *
+ * OUT:
+ * @return display column after the last character of text
+ */
+long long AdvanceTabColumns(char const * text, long long size, long long column, int tabSize, BOOL utf8) {
+    long long position;
+
+    for (position = 0; position < size; ++position) {
+        if (text[position] == '\t')
+            column = (column / tabSize + 1) * tabSize;
+        else if (!utf8 || (text[position] & 0xC0) != 0x80)
+            column++;
+    }
+    return column;
+}
+
+/**
+ * Makes sure scratch buffer has specified size.
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param size - needed size
+ *
+ * OUT:
+ * tabs->scratch may be reallocated
+ * @return TRUE if successed, FALSE if there's not enough memory
+ */
+static BOOL ReserveTabScratch(TabIndex * tabs, size_t size) {
+    char * scratch;
+
+    if (size <= tabs->scratchSize)
+        return TRUE;
+    scratch = (char*)realloc(tabs->scratch, size);
+    if (scratch == NULL)
+        return FALSE;
+    tabs->scratch     = scratch;
+    tabs->scratchSize = size;
+    return TRUE;
+}
+
+/**
+ * Gives part of line visible in window of display columns with tabs expanded to spaces.
+ * Tab crossing window border gives only it's visible spaces.
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param text - text of line beginning with character not after window
+ * @param size - size of text in bytes (it may go beyond window)
+ * @param column - display column text starts at
+ * @param first - the first display column of window
+ * @param width - number of display columns in window
+ * @param utf8 - TRUE if text is UTF-8 with multibyte characters, FALSE if it's characters are bytes
+ *
+ * OUT:
+ * @param length - gets length of returned text in bytes (0 if there's not enough memory)
+ * @return pointer to expanded text (it stays valid until the next call)
+ */
+char const * ExpandTabs(TabIndex * tabs, char const * text, long long size, long long column,
+                        long long first, long long width, BOOL utf8, long long * length) {
+    long long end = first + width;
+    long long position = 0;
+    long long next, stop, columns;
+    char const * tab;
+    BOOL visible = FALSE;       // set if the last character is copied, so are it's continuation bytes
+    size_t copied = 0;
+
+    // every visible column takes at most 4 bytes
+    *length = 0;
+    if (width <= 0 || !ReserveTabScratch(tabs, (size_t)width * 4))
+        return "";
+
+    // characters before window are skipped by runs between tabs (tab crossing window border is expanded below)
+    while (utf8 && position < size && (text[position] & 0xC0) == 0x80)
+        position++;
+    while (position < size && column < first) {
+        tab  = (char const *)memchr(text + position, '\t', (size_t)(size - position));
+        stop = (tab != NULL) ? tab - text : size;
+        columns = utf8 ? CountColumns(text + position, stop - position, INDEXER_KERNEL_AUTO) : stop - position;
+        if (column + columns > first) {
+            position += utf8 ? SkipColumns(text + position, stop - position, first - column, INDEXER_KERNEL_AUTO) :
+                               first - column;
+            column = first;
+            break;
+        }
+        column  += columns;
+        position = stop;
+        next = (column / tabs->tabSize + 1) * tabs->tabSize;
+        if (tab == NULL || next > first)
+            break;
+        column = next;
+        position++;
+    }
+
+    for (; position < size; ++position) {
+        if (utf8 && (text[position] & 0xC0) == 0x80) {
+            if (visible)
+                tabs->scratch[copied++] = text[position];
+            continue;
+        }
+        if (column >= end)
+            break;
+        if (text[position] == '\t') {
+            next = (column / tabs->tabSize + 1) * tabs->tabSize;
+            for (column = max(column, first); column < min(next, end); ++column)
+                tabs->scratch[copied++] = ' ';
+            column  = next;
+            visible = FALSE;
+        }
+        else {
+            visible = (column >= first);
+            if (visible)
+                tabs->scratch[copied++] = text[position];
+            column++;
+        }
+    }
+    *length = (long long)copied;
+    return tabs->scratch;
+}
+
+/**
+ * Gives text with each tab replaced by one space (for view modes where tab takes one column).
+ * IN:
+ * @param tabs - pointer to index of lines display widths
+ * @param text - text to show
+ * @param length - length of text in bytes
+ *
+ * OUT:
+ * @return text itself if it has no tabs, else pointer to it's copy (it stays valid until the next call)
+ */
+char const * HideTabs(TabIndex * tabs, char const * text, long long length) {
+    long long position;
+
+    if (length <= 0 || memchr(text, '\t', (size_t)length) == NULL || !ReserveTabScratch(tabs, (size_t)length))
+        return text;
+    for (position = 0; position < length; ++position)
+        tabs->scratch[position] = (text[position] == '\t') ? ' ' : text[position];
+    return tabs->scratch;
+}
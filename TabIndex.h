@@ -0,0 +1,52 @@
+#ifndef TABINDEX_H_INCLUDED
+#define TABINDEX_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+
+#define DEFAULT_TAB_SIZE 8
+#define MAX_TAB_SIZE 16
+#define TAB_CHECKPOINT_STEP 4096    // long lines with tabs keep byte offset of every this display column
+#define TAB_CACHE_SIZE 4096         // number of lines display widths are kept for
+
+typedef struct {
+    long long offset;           // offset from line beginning of the first character starting at or after checkpoint column
+    long long column;           // display column this character starts at
+} TabCheckpoint;
+
+typedef struct {
+    long long line;             // number of measured line (-1 if slot is empty)
+    long long width;            // display width of line content
+    BOOL tabs;                  // set if line has tabs (else it's display columns are it's columns)
+    TabCheckpoint * checkpoints;            // Checkpoints of every TAB_CHECKPOINT_STEP-th display column (NULL if there are none)
+    long long checkpointsNumber;            // Number of items in checkpoints
+    long long checkpointsCapacity;          // Number of items memory of checkpoints is allocated for
+} TabLine;
+
+/* display widths of lines with tabs expanded to tab stops, measured when lines are shown:
+ * each line is kept in the slot of it's number modulo TAB_CACHE_SIZE, so visible lines never evict each other */
+typedef struct {
+    int tabSize;                // Distance between tab stops in columns
+    TabLine * lines;            // Array of [TAB_CACHE_SIZE] slots of measured lines
+    long long maxWidth;         // The biggest display width of measured lines
+    char * scratch;             // Buffer where expanded text is put, it's reused by every call
+    size_t scratchSize;         // Size of scratch buffer
+} TabIndex;
+
+ErrorType CreateTabIndex(TabIndex * tabs, int tabSize);
+void DestroyTabIndex(TabIndex * tabs);
+size_t GetTabIndexMemory(TabIndex const * tabs);
+void ForgetTabLines(TabIndex * tabs, long long firstLine);
+TabLine * FindTabLine(TabIndex * tabs, long long lineNumber);
+TabLine * StartTabLine(TabIndex * tabs, long long lineNumber);
+BOOL AddTabText(TabIndex * tabs, TabLine * line, char const * text, long long size, long long offset, BOOL utf8);
+void FinishTabLine(TabIndex * tabs, TabLine * line);
+long long GetTabCheckpoint(TabLine const * line, long long column, long long * offset);
+long long GetTabOffsetCheckpoint(TabLine const * line, long long offset, long long * column);
+long long AdvanceTabColumns(char const * text, long long size, long long column, int tabSize, BOOL utf8);
+char const * ExpandTabs(TabIndex * tabs, char const * text, long long size, long long column,
+                        long long first, long long width, BOOL utf8, long long * length);
+char const * HideTabs(TabIndex * tabs, char const * text, long long length);
+
+#endif // TABINDEX_H_INCLUDED
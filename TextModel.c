@@ -1,692 +1,3030 @@
-#include "TextModel.h"
-#include <string.h>
-#include <limits.h>
-#include <math.h>
-
-struct tag_StoredModel {
-    long fileSize;              // Size of processed file in bytes
-    long linesNumber;           // Number of lines in the file (number of linebreaks symbols + 1)
-    long maxLength;             // Length of the longest line in file
-    long * lineBeginnings;      // Array of [linesNumber] indexes showing each line start point
-    char * data;                // Buffer with processed file data
-};
-
-/**
- * Allocates memory for text model.
- * IN:
- * @param model - pointer to TextModel structure to allocate memory for
- * @param linesNumber - number of lines in initial file
- * 
- * OUT:
- * model->stored gets pointer to memory allocated
- * model->displayed gets pointer to memory allocated
- * model->stored->lineBeginnings gets pointer to memory allocated
- * @return TRUE if successed, FALSE else
- */
-static BOOL AllocateTextModel(TextModel * model, long linesNumber) {
-    model->stored = (StoredModel*)malloc(sizeof(StoredModel));
-    if (model->stored == NULL)
-        return FALSE;
-    model->stored->lineBeginnings = (long*)malloc((linesNumber + 1) * sizeof(long));
-    if (model->stored->lineBeginnings == NULL) {
-        free(model->stored);
-        return FALSE;
-    }
-    model->displayed = (DisplayedModel*)malloc(sizeof(DisplayedModel));
-    if (model->displayed == NULL) {
-        free(model->stored->lineBeginnings);
-        free(model->stored);
-        return FALSE;
-    }
-    return TRUE;
-}
-
-/**
- * Count number of lines of file in wrap view mode with specified size until number of specified line.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param capacityCharsX - capacity of chars of client area width
- * @param stopLine - number of line in initial file until which counting will continue
- * 
- * OUT:
- * @return number of lines in wrap mode
- */
-static long CountLinesNumberWrap(StoredModel const * stored, int capacityCharsX, long stopLine) {
-    int counter = 0;
-    int i, j;
-
-    for (i = 0; i < stopLine; ++i) {
-        for (j = stored->lineBeginnings[i]; j < stored->lineBeginnings[i + 1]; j += capacityCharsX)
-            ++counter;
-    }
-
-    return counter;
-}
-
-/**
- * Frees memory allocated for text model.
- * IN:
- * @param model - pointer to model structure of text file
- * 
- * OUT:
- * model->stored sets as NULL
- * model->displayed variables sets as NULL
- */
-void DestroyTextModel(TextModel * model) {
-    if (model == NULL)
-        return;
-
-    // destroy stored model
-    if (model->stored != NULL) {
-        if (model->stored->data != NULL)
-            free(model->stored->data);
-        if (model->stored->lineBeginnings != NULL)
-            free(model->stored->lineBeginnings);
-        free(model->stored);
-    }
-
-    // destroy displayed model
-    if (model->displayed != NULL)
-        free(model->displayed);
-    
-    model->stored = NULL;
-    model->displayed = NULL;
-}
-
-/** 
- * Builds TextModel structure of file with specified name.
- * IN:
- * @param model - pointer to structure to save information in
- * @param inputFilename - name of file to process
- * 
- * OUT:
- * model->stored gets pointer to allocated memory
- * model->displayed gets pointer to allocated memory
- * fields of model->stored, model->displayed structures initialized with built text model parameters
- * @return code of error occured during building model (ERR_NO if successed)
- */
-ErrorType BuildTextModel(TextModel * model, char const * inputFilename) {
-    FILE * file = NULL;
-    char * data = NULL;
-    long fileSize;
-    long linesNumber;
-    long maxLength;
-    long i, j;
-
-    if (model == NULL) { // REMOVED 30/11/2019: || inputFilename == NULL) {
-        PrintError(NULL, ERR_NULL_PTR, __FILE__, __LINE__);
-        return ERR_NULL_PTR;
-    }
-
-    file = fopen(inputFilename, "rb");
-
-    // REMOVED 30/11/2019:
-    // if (file == NULL) {
-    //     PrintError(NULL, ERR_OPEN_FILE, __FILE__, __LINE__);
-    //     return ERR_OPEN_FILE;
-    // }
-
-    if (file != NULL) {
-        fseek(file, 0, SEEK_END);
-        fileSize = ftell(file);
-        fseek(file, 0, SEEK_SET);
-
-        data = (char*)calloc(fileSize + 1, sizeof(char));
-        if (data == NULL) {
-            PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
-            return ERR_NOMEM;
-        }
-
-        if (fread((void*)data, sizeof(char), fileSize, file) != fileSize) {
-            if (feof(file)) {
-                PrintError(NULL, ERR_EOF, __FILE__, __LINE__);
-                return ERR_EOF;
-            }
-            PrintError(NULL, ERR_READ, __FILE__, __LINE__);
-            return ERR_READ;
-        }
-        fclose(file);
-    }
-    // ADDED 30/11/2019: else build blank model
-    else {
-        fileSize = 0;
-        data = (char*)calloc(fileSize + 1, sizeof(char));
-        if (data == NULL) {
-            PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
-            return ERR_NOMEM;
-        }
-    }
-
-    data[fileSize] = '\0';
-
-    // start building model
-    for (linesNumber = 1, i = 0; i < fileSize; ++i) {
-        if (data[i] == '\n')
-            linesNumber++;
-    }
-
-    // memory allocation
-    if (!AllocateTextModel(model, linesNumber)) {
-        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
-        return ERR_NOMEM;
-    }
-
-    // fill structs field
-    model->stored->data = data;
-    model->stored->linesNumber = linesNumber;
-    model->stored->fileSize = fileSize;
-
-    model->stored->lineBeginnings[0] = 0;
-    for (i = 0, j = 0; i < fileSize; ++i) {
-        if (data[i] == '\n')
-            model->stored->lineBeginnings[++j] = i + 1;     // after '\n' symbol
-    }
-    model->stored->lineBeginnings[linesNumber] = fileSize;  // special value to check end of file
-
-    for (maxLength = 0, j = 0; j < linesNumber - 1; ++j) {
-        if (maxLength < model->stored->lineBeginnings[j + 1] - model->stored->lineBeginnings[j])
-            maxLength = model->stored->lineBeginnings[j + 1] - model->stored->lineBeginnings[j];
-    }
-    model->stored->maxLength = maxLength;
-
-    // displayed model fields initialization
-    // TODO: refactor with calloc
-    model->displayed->capacityCharsX  = 0;
-    model->displayed->capacityCharsY  = 0;
-    model->displayed->clientAreaX     = 0;
-    model->displayed->clientAreaY     = 0;
-    model->displayed->charPixelsX     = 0;
-    model->displayed->charPixelsY     = 0;
-    model->displayed->viewMode        = VIEW_MODE_STANDARD;
-    model->displayed->firstLine       = 0;
-    model->displayed->firstSymbol     = 0;
-    model->displayed->scrollX         = 0;
-    model->displayed->scrollY         = 0;
-    model->displayed->scrollMaxX      = 0;
-    model->displayed->scrollMaxY      = 0;
-    model->displayed->linesNumberWrap = 0;
-
-    return ERR_NO;
-}
-
-/** 
- * Builds new TextModel structure of file with specified name and destroys previous one.
- * IN:
- * @param model - pointer to structure to save information in
- * @param inputFilename - name of file to process
- * 
- * OUT:
- * model->stored gets pointer to new allocated memory
- * model->displayed gets pointer to new allocated memory
- * fields of model->stored, model->displayed structures initialized with new built text model parameters
- * @return code of error occured during building model (ERR_NO if successed)
- */
-ErrorType RebuildTextModel(TextModel * model, char const * inputFilename) {
-    DisplayedModel tempDisplayed;
-    ErrorType errorType;
-
-    if (model == NULL) { // REMOVED || inputFilename == NULL) {
-        PrintError(NULL, ERR_NULL_PTR, __FILE__, __LINE__);
-        return ERR_NULL_PTR;
-    }
-    
-    // save previous displayed model settings in local variable
-    tempDisplayed = *model->displayed;
-
-    // destroy previous model
-    DestroyTextModel(model);
-
-    // build new model
-    errorType = BuildTextModel(model, inputFilename);
-    if (errorType != ERR_NO)
-        return errorType;
-    
-    // initialize new displayed model fields with previous settings
-    model->displayed->capacityCharsX = tempDisplayed.capacityCharsX;
-    model->displayed->capacityCharsY = tempDisplayed.capacityCharsY;
-    model->displayed->charPixelsX    = tempDisplayed.charPixelsX;
-    model->displayed->charPixelsY    = tempDisplayed.charPixelsY;
-    model->displayed->clientAreaX    = tempDisplayed.clientAreaX;
-    model->displayed->clientAreaY    = tempDisplayed.clientAreaY;
-    model->displayed->viewMode       = tempDisplayed.viewMode;
-
-    // set initial position in file
-    model->displayed->firstLine      = 0;
-    model->displayed->firstSymbol    = 0;
-    model->displayed->scrollX        = 0;
-    model->displayed->scrollY        = 0;
-
-    return ERR_NO;
-}
-
-/**
- * Gives pointer to string for printing in standard view mode. Saves it's length in lineLength.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param lineNumber - number of line where to search substring
- * @param position - position of first symbol in line to print
- * @param capacityCharsX - capacity of chars of client area width
- * 
- * OUT:
- * @param lineLength - gets length of substring returned
- * @return pointer to desired substring (NULL if no string found)
- */
-char const * GetLineStandard(StoredModel const * stored, long lineNumber, long position, int capacityCharsX, long * lineLength) {
-    long firstSymbol;   // index of the first visible symbol in invalid region
-    long tempLength;    // returned length of the line to output
-
-    if (lineNumber >= stored->linesNumber)
-        return NULL;
-
-    firstSymbol = stored->lineBeginnings[lineNumber] + position;
-
-    // set possible length of the line to output
-    if (lineNumber == stored->linesNumber - 1)
-        tempLength = stored->fileSize - firstSymbol;        // last line length
-    else
-        tempLength = stored->lineBeginnings[lineNumber + 1] - firstSymbol;
-
-    if (lineLength != NULL)
-       *lineLength = (tempLength > capacityCharsX) ?
-                      capacityCharsX : max(0, tempLength);  // check if length is valid
-
-    return &stored->data[firstSymbol];                      // return pointer to the string
-}
-
-/**
- * Gives pointer to string for printing in wrap view mode. Saves it's length in lineLength.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param linesToSkip - number of lines to skip counting from prevLine either firstLine of displayed model
- * @param prevLine - number of previous processed line in text
- * 
- * INOUT:
- * @param prevSymbol - number of symbol in text of previous processed line, gets index of returned substring beginning
- * @param prevLine - number of previous processed line in text, gets number of line which returned substring belongs to
- * 
- * OUT:
- * @param lineLength - gets length of substring returned
- * @return pointer to desired substring (NULL if no string found)
- */
-char const * GetLineWrap(StoredModel const * stored, DisplayedModel const * displayed, long linesToSkip, long * lineLength, long * prevSymbol, long * prevLine) {
-    long currLine   =   (prevLine == NULL) ? displayed->firstLine   : *prevLine;
-    long currSymbol = (prevSymbol == NULL) ? displayed->firstSymbol : *prevSymbol;
-
-    // skip lines till the first visible line of invalid rectangle
-    while (linesToSkip != 0) {
-        if (currSymbol +  displayed->capacityCharsX < stored->lineBeginnings[currLine + 1])
-            currSymbol += displayed->capacityCharsX;
-        else {
-            currLine++;
-            currSymbol = stored->lineBeginnings[currLine];
-        }
-
-        if (currSymbol >= stored->fileSize)
-            return NULL;
-        linesToSkip--;
-    }
-
-    // set valid length
-    if (lineLength != NULL)
-       *lineLength = min(stored->lineBeginnings[currLine + 1] - currSymbol, displayed->capacityCharsX);
-    // set invalid rectangle's current visible line beginning
-    if (prevSymbol != NULL)
-       *prevSymbol = currSymbol;
-    // set invalid rectangle's current visible line number
-    if (prevLine != NULL)
-       *prevLine = currLine;
-    return &stored->data[currSymbol];    // return pointer to the string
-}
-
-/**
- * Updates displayed model firstSymbol field in standard mode 
- * according to received desired horizontal shift (in characters) of client area.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param incrementX - desired horizontal shift of client area
- * 
- * OUT:
- * displayed->firstSymbol gets position of new first visible symbol
- * @return actual possible horizontal shift of client area
- */
-long UpdateModelStandardX(StoredModel const * stored, DisplayedModel * displayed, int incrementX) {
-    long temp;
-    if (incrementX < 0)
-        incrementX = -min(displayed->firstSymbol, -incrementX);
-    else {
-        temp = stored->maxLength - displayed->firstSymbol - displayed->capacityCharsX;
-        if (temp < 0)
-            temp = 0;
-        incrementX = min(temp, incrementX);
-    }
-
-    displayed->firstSymbol += incrementX;
-    return incrementX;
-}
-
-/**
- * Updates displayed model firstLine field in standard mode
- * according to received desired vertical shift (in characters) of client area.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param incrementY - desired vertical shift of client area
- * 
- * OUT:
- * displayed->firstLine gets number of new first visible line
- * @return actual possible vertical shift of client area
- */
-long UpdateModelStandardY(StoredModel const * stored, DisplayedModel * displayed, int incrementY) {
-    long temp;
-    if (incrementY < 0)
-        incrementY = -min(displayed->firstLine, -incrementY);
-    else {
-        temp = stored->linesNumber - displayed->firstLine - displayed->capacityCharsY;
-        if (temp < 0)
-            temp = 0;
-        incrementY = min(temp, incrementY);
-    }
-
-    displayed->firstLine += incrementY;
-    return incrementY;
-}
-
-/**
- * Updates displayed model firstLine and firstSymbol fields in wrap mode 
- * according to received desired vertical shift (in characters) of client area.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param incrementY - desired vertical shift of client area
- * 
- * OUT:
- * displayed->firstSymbol gets index of new first visible symbol in text
- * displayed->firstLine gets number of new first visible line firstSymbol belongs to
- * @return actual possible vertical shift of client area
- */
-long UpdateModelWrapY(StoredModel const * stored, DisplayedModel * displayed, long incrementY) {
-    long remainingLineLength;       // length of the line which we're going to cut
-    long shiftsLeft = incrementY;   // temp variable: shifts left to do
-
-    if (incrementY > 0) {
-        // if we shift up (incrementY > 0) client area then remainingLineLength equals:
-        remainingLineLength = stored->lineBeginnings[displayed->firstLine + 1] -
-                              displayed->firstSymbol;
-        // then we try to cut into pieces our lines in the cycle until it's length allows to do so
-        for (shiftsLeft = incrementY;
-             // while there are shifts left to do and we still have lines to cut
-             // (GetLineWrap returns NULL, if there are no lines left)
-             shiftsLeft != 0 && GetLineWrap(stored, displayed, displayed->capacityCharsY, NULL, NULL, NULL) != NULL;
-             shiftsLeft--) {
-            // if it's possible to cut current line then decrease it's length in capacity (of characters) of client area width
-            if (remainingLineLength >= displayed->capacityCharsX) {
-                remainingLineLength -= displayed->capacityCharsX;
-                displayed->firstSymbol += displayed->capacityCharsX;
-            }
-            // else update firstLine field (which means we go to the next line)
-            else {
-                displayed->firstSymbol += remainingLineLength;
-                displayed->firstLine++;
-                // get next line length
-                remainingLineLength = stored->lineBeginnings[displayed->firstLine + 1] -
-                                      displayed->firstSymbol;
-            }
-        }
-    } else {
-        // if we shift down (incrementY < 0) client area then remainingLineLength equals:
-        remainingLineLength = displayed->firstSymbol -
-                              stored->lineBeginnings[displayed->firstLine];
-        // then we try to cut into pieces our lines in the cycle until it's length allows to do so
-        
-        // while there are shifts left to do and we still have lines to cut
-        // (firstSymbol equals to the index of first visible symbol in entire file for wrap mode (see DisplayedModel declarataion))
-        for (shiftsLeft = incrementY; shiftsLeft != 0 && displayed->firstSymbol > 0; ++shiftsLeft) {
-            // if it's possible to cut current line then decrease it's length in capacity (of characters) of client area width
-            if (remainingLineLength >= displayed->capacityCharsX) {
-                remainingLineLength -= displayed->capacityCharsX;
-                displayed->firstSymbol -= displayed->capacityCharsX;
-            }
-            // else update firstLine field (which means we go to the previous line) 
-            else {
-                // get next line length
-                remainingLineLength = stored->lineBeginnings[displayed->firstLine] -
-                                      stored->lineBeginnings[displayed->firstLine - 1];
-                displayed->firstSymbol -= remainingLineLength % displayed->capacityCharsX;
-                displayed->firstLine--;
-            }
-        }
-    }
-
-    return incrementY - shiftsLeft;    // return number of successfull shifts (signed)
-}
-
-/**
- * Receives horizontal scrollbar position 
- * and converts it into needed size of horizontal shift (in characters) to perform.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param scroll - horizontal scrollbar position from 0 to scrollMaxX of displayed model struct
- * 
- * OUT:
- * @return size of horizontal shift to perform
- */
-long scrollToIncrementX(StoredModel const * stored, DisplayedModel const * displayed, int scroll) {
-    double temp;
-    if (displayed->viewMode != VIEW_MODE_STANDARD)
-        return 0;
-    temp  = (double)scroll / displayed->scrollMaxX;
-    temp *= (stored->maxLength - displayed->capacityCharsX + 1);
-    return (long)round(temp) - displayed->firstSymbol;
-}
-
-/**
- * Receives vertical scrollbar position 
- * and converts it into needed size of vertical shift (in characters) to perform.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param scroll - vertical scrollbar position from 0 to scrollMaxY of displayed model struct
- * 
- * OUT:
- * @return size of vertical shift to perform
- */
-long scrollToIncrementY(StoredModel const * stored, DisplayedModel const * displayed, int scroll) {
-    double temp = (double)scroll / displayed->scrollMaxY;
-    switch (displayed->viewMode) {
-    case VIEW_MODE_STANDARD:
-        temp *= (stored->linesNumber - displayed->capacityCharsY + 1);
-        return (long)round(temp) - displayed->firstLine;
-    case VIEW_MODE_WRAP:
-        temp *= (displayed->linesNumberWrap - displayed->capacityCharsY + 1);
-        return (long)round(temp) - CountLinesNumberWrap(stored, displayed->capacityCharsX, displayed->firstLine);
-    default:
-        return 0;
-    }
-}
-
-/**
- * Counts horizontal scrollbar position according to current position in text:
- * firstSymbol field of displayed model struct.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * 
- * OUT:
- * @return horizontal scrollbar position from 0 to scrollMaxX of displayed model struct
- */
-int countScrollPositionX(StoredModel const * stored, DisplayedModel const * displayed) {
-    double temp;
-    if (displayed->viewMode != VIEW_MODE_STANDARD)
-        return 0;
-    temp  = (double)displayed->firstSymbol / (stored->maxLength - displayed->capacityCharsX + 1);
-    temp *= displayed->scrollMaxX;
-
-    if (temp < 0)
-        return 0;
-    else if (temp > displayed->scrollMaxX)
-        return displayed->scrollMaxX;
-    else
-        return (int)round(temp);
-}
-
-/**
- * Counts vertical scrollbar position according to current position in text:
- * firstLine field of displayed model struct (for standard mode),
- * firstLine and linesNumberWrap fields of displayed model struct (for wrap mode).
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * 
- * OUT:
- * @return vertical scrollbar position from 0 to scrollMaxY of displayed model struct
- */
-int countScrollPositionY(StoredModel const * stored, DisplayedModel const * displayed) {
-    double temp;
-    switch (displayed->viewMode) {
-    case VIEW_MODE_STANDARD:
-        temp  = (double)displayed->firstLine / (stored->linesNumber - displayed->capacityCharsY + 1);
-        temp *= displayed->scrollMaxY;
-        break;
-
-    case VIEW_MODE_WRAP:
-        temp  = (double)CountLinesNumberWrap(stored, displayed->capacityCharsX, displayed->firstLine) /
-                (displayed->linesNumberWrap - displayed->capacityCharsY);
-        temp *= displayed->scrollMaxY;
-        break;
-    default:
-        return 0;
-    }
-
-    if (temp < 0)
-        return 0;
-    else if (temp > displayed->scrollMaxY)
-        return displayed->scrollMaxY;
-    else
-        return (int)round(temp);
-}
-
-/** 
- * Updates displayed model fields (scrollMaxX, scrollMaxY, firstSymbol and linesNumberWrap) to relevant.
- * Sets relevant window's scrollbars ranges and positions.
- * IN:
- * @param hWindow - handler of window
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param prevCapacityCharsX - previous value needed to find out 
- * whether there is necessity to change firstSymbol and linesNumberWrap fields
- * 
- * OUT:
- * displayed->scrollMaxX gets new horizontal scrollbar range
- * displayed->scrollMaxY gets new vertical scrollbar range
- * displayed->firstSymbol may be changed to it's line beginning
- * displayed->linesNumberWrap may be recounted to new number of lines in wrap mode
- */
-void UpdateModelMetrics(HWND hWindow, StoredModel const * stored, DisplayedModel * displayed, int prevCapacityCharsX) {
-    long temp;
-
-    temp = stored->maxLength - displayed->capacityCharsX + 1;
-    if (temp < 0)
-        temp = 0;
-    displayed->scrollMaxX = min(SHRT_MAX, temp);
-
-    if (displayed->viewMode == VIEW_MODE_STANDARD) {
-        temp = stored->linesNumber - displayed->capacityCharsY + 1;
-        if (temp < 0)
-            temp = 0;
-        displayed->scrollMaxY = min(SHRT_MAX, temp);
-    }
-    if (displayed->viewMode == VIEW_MODE_WRAP) {
-        // for wrap mode it's not possible to change window width
-        // without jumping to the line beginning
-        if (displayed->capacityCharsX != prevCapacityCharsX) {
-            displayed->firstSymbol = stored->lineBeginnings[displayed->firstLine];
-            displayed->linesNumberWrap = CountLinesNumberWrap(stored, displayed->capacityCharsX, stored->linesNumber);
-        }
-        temp = displayed->linesNumberWrap - displayed->capacityCharsY + 1;
-        if (temp < 0)
-            temp = 0;
-        displayed->scrollMaxY = min(SHRT_MAX, temp);
-    }
-    SetScrollRange(hWindow, SB_HORZ, 0, displayed->scrollMaxX, TRUE);
-    SetScrollRange(hWindow, SB_VERT, 0, displayed->scrollMaxY, TRUE);
-    SetScrollPos(hWindow, SB_HORZ, countScrollPositionX(stored, displayed), TRUE);
-    SetScrollPos(hWindow, SB_VERT, countScrollPositionY(stored, displayed), TRUE);
-}
-
-/**
- * Switches text view mode.
- * IN:
- * @param stored - pointer to stored model structure of text file
- * @param displayed - pointer to displayed model structure of text file
- * @param viewMode - new view mode to set
- * 
- * OUT:
- * displayed->viewMode gets new view mode (see enum ViewMode)
- * displayed->firstSymbol gets new value dependently on view mode
- * displayed->scrollX gets 0 for wrap view mode
- */
-void SwitchMode(StoredModel const * stored, DisplayedModel * displayed, int viewMode) {
-    if (viewMode == VIEW_MODE_STANDARD) {
-        displayed->viewMode = VIEW_MODE_STANDARD;
-        displayed->firstSymbol = 0;
-    }
-    else if (viewMode == VIEW_MODE_WRAP) {
-        displayed->viewMode  = VIEW_MODE_WRAP;
-        displayed->firstSymbol = stored->lineBeginnings[displayed->firstLine];
-        displayed->scrollX = 0;
-    }
-}
-
-
-/**
- * Calculates borders of invalid rectangle according to received horizontal shift (in characters) of client area.
- * IN:
- * @param displayed - pointer to displayed model structure of text file
- * @param incrementCharsX - horizontal shift of client area
- * 
- * OUT:
- * @param rectangle - pointer to RECT struct, fills with invalid rectangel borders
- */
-void SetInvalidRectagleX(DisplayedModel const * displayed, long incrementCharsX, RECT * rectangle) {
-    if (abs(incrementCharsX) > displayed->capacityCharsX) {
-        rectangle->left = 0;
-        rectangle->right = displayed->charPixelsX * displayed->capacityCharsX;
-    }
-    else if (incrementCharsX > 0) {
-        rectangle->left = displayed->charPixelsX * (displayed->capacityCharsX - incrementCharsX);
-        rectangle->right = displayed->charPixelsX * displayed->capacityCharsX;
-    } else {
-        rectangle->left = 0;
-        rectangle->right = displayed->charPixelsX * incrementCharsX;
-    }
-    rectangle->top = 0;
-    rectangle->bottom = displayed->charPixelsY * displayed->capacityCharsY;
-}
-
-/**
- * Calculates borders of invalid rectangle according to received vertical shift (in characters) of client area.
- * IN:
- * @param displayed - pointer to displayed model structure of text file
- * @param incrementCharsX - vertical shift of client area
- * 
- * OUT:
- * @param rectangle - pointer to RECT struct, fills with invalid rectangel borders
- */
-void SetInvalidRectagleY(DisplayedModel const * displayed, long incrementCharsY, RECT * rectangle) {
-    if (abs(incrementCharsY) > displayed->capacityCharsY) {
-        rectangle->top = 0;
-        rectangle->bottom = displayed->charPixelsY * displayed->capacityCharsY;
-    }
-    else if (incrementCharsY > 0) {
-        rectangle->top = displayed->charPixelsY * (displayed->capacityCharsY - incrementCharsY);
-        rectangle->bottom = displayed->charPixelsY * displayed->capacityCharsY;
-    } else {
-        rectangle->top = 0;
-        rectangle->bottom = displayed->charPixelsY * incrementCharsY;
-    }
-    rectangle->left = 0;
-    rectangle->right = displayed->charPixelsX * displayed->capacityCharsX;
-}
+#include "TextModel.h"
+#include "FileMapping.h"
+#include "LineIndexer.h"
+#include "BlockCache.h"
+#include "TextSearch.h"
+#include "TrigramIndex.h"
+#include "ColumnIndex.h"
+#include "TabIndex.h"
+#include "CompressedFile.h"
+#include "LineProjection.h"
+#include "Trace.h"
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <math.h>
+
+#define READ_PORTION_SIZE (64LL << 20)  // size of file portion read at once by stdio fallback
+#define BACKGROUND_INDEXING_SIZE (16LL << 20)   // smaller files are indexed before they're shown
+#define INDEX_CACHING_SIZE (16LL << 20)         // indexes of smaller files aren't saved next to them
+#define TAB_MEASURE_SIZE (1LL << 20)            // size of line part measured at once when tabs are expanded
+#define RETAINED_INDEX_SIZE (64LL << 20)        // bigger arrays of replaced index aren't kept
+#define FILTER_SHOWING_PROGRESS 0.999           // progress of filter which has searched text but hasn't shown it's lines
+
+typedef enum {
+    DATA_OWNER_HEAP,            // data is allocated with malloc and has to be freed
+    DATA_OWNER_MAPPING,         // data is a view of mapped file and has to be unmapped
+    DATA_OWNER_CACHE            // data isn't kept in memory, file is read by blocks through cache
+} DataOwner;
+
+struct tag_StoredModel {
+    long long fileSize;         // Size of processed file in bytes
+    LineIndex index;            // Lines beginnings and ends, number of lines and length of the longest one
+    char const * data;          // Buffer with processed file data (NULL if dataOwner is DATA_OWNER_CACHE)
+    DataOwner dataOwner;        // Shows the way data buffer has to be released
+    FileMapping mapping;        // Mapping of processed file (used if dataOwner is DATA_OWNER_MAPPING)
+    BlockCache * cache;         // Blocks of processed file (used if dataOwner is DATA_OWNER_CACHE)
+    CompressedIndex * compressed;           // Restart points of decompressor (NULL if file isn't compressed)
+    CompressedReader * compressedReader;    // Decompressor of file blocks read through cache (NULL if file isn't compressed)
+    LineIndexBuilder * builder; // Background indexing of file (NULL if index is complete), it owns index arrays
+    FILE * indexedFile;         // File read by background indexing thread if data isn't kept in memory
+    char * filename;            // Name of processed file (NULL for blank model)
+    TextSearch * search;        // Search of string in file (NULL if nothing is searched)
+    void * searchedFile;        // Source of text read by search thread if data isn't kept in memory
+    long long hitNumber;        // Number of the shown hit (-1 if no hit is shown yet)
+    long long searchOrigin;     // Position in file the first shown hit is searched from
+    TrigramIndex * trigrams;    // Blocks of lines containing each trigram (NULL if index isn't built or loaded)
+    TrigramIndexBuilder * trigramBuilder;   // Background building of trigram index (NULL if it isn't running)
+    void * trigramFile;         // Source of text read by trigram indexing thread if data isn't kept in memory
+    long long trigramStamp;     // Modification time of file when trigram indexing has started
+    ColumnIndex * columns;      // Lines measured in UTF-8 characters (NULL if text is shown byte per column)
+    BOOL utf8;                  // Set if text has to be shown as UTF-8 (columns are measured when index is complete)
+    TabIndex * tabs;            // Display widths of shown lines with tabs expanded (NULL if tab takes one column)
+    Highlighter * highlighter;  // Tokens of shown lines (NULL if text isn't highlighted)
+    LineProjection * projection;    // Lines matching filter shown instead of all lines (NULL if text isn't filtered)
+    TextSearch * filter;        // Search of lines matching filter (NULL if all it's lines are shown)
+    void * filteredFile;        // Source of text read by filter thread if data isn't kept in memory
+};
+
+// settings of file data storage
+static StorageMode storageMode = STORAGE_AUTO;
+static long long cacheBudget = DEFAULT_CACHE_BUDGET;
+
+/**
+ * Sets the way files opened afterwards are kept in memory.
+ * IN:
+ * @param mode - STORAGE_AUTO to map files, STORAGE_STREAMED to read them by blocks
+ * @param budget - memory blocks of file may take in bytes (0 means DEFAULT_CACHE_BUDGET)
+ */
+void SetStorageMode(StorageMode mode, long long budget) {
+    storageMode = mode;
+    cacheBudget = (budget > 0) ? budget : DEFAULT_CACHE_BUDGET;
+}
+
+// memory of replaced models kept to load the next files in (see RebuildTextModel)
+static char * retainedData = NULL;      // heap buffer of file data (NULL if nothing is kept)
+static size_t retainedDataSize = 0;     // size of retainedData in bytes
+static LineIndexSpare retainedIndex;    // arrays of line index
+
+/**
+ * Takes kept heap buffer if it has room for file data and isn't much bigger, else allocates new one.
+ * IN:
+ * @param size - number of bytes buffer has to hold
+ *
+ * OUT:
+ * @return pointer to buffer of size bytes (NULL if there's not enough memory)
+ */
+static char * TakeDataBuffer(size_t size) {
+    char * buffer = NULL;
+
+    // kept buffer is shrunk in place, so it's pages aren't touched again
+    if (retainedData != NULL && retainedDataSize >= size && retainedDataSize / 2 <= size) {
+        buffer = (char*)realloc(retainedData, size * sizeof(char));
+        if (buffer == NULL)
+            free(retainedData);
+        retainedData = NULL;
+        retainedDataSize = 0;
+    }
+    if (buffer == NULL)
+        buffer = (char*)malloc(size * sizeof(char));
+    return buffer;
+}
+
+/**
+ * Frees memory kept from replaced models.
+ * Kept memory is reused by the next opened files, so it's freed only when no file is opened anymore.
+ */
+void ReleaseRetainedBuffers(void) {
+    free(retainedData);
+    retainedData = NULL;
+    retainedDataSize = 0;
+    ReleaseLineIndexSpare(&retainedIndex);
+}
+
+/**
+ * Reads entire file with specified name into heap buffer.
+ * Used as a fallback for files which can't be mapped into memory.
+ * IN:
+ * @param inputFilename - name of file to read
+ *
+ * OUT:
+ * @param data - gets pointer to allocated buffer with file data (one extra byte is set to '\0')
+ * @param fileSize - gets size of file in bytes (0 if file can't be opened)
+ * @return code of error occured during reading (ERR_NO if successed)
+ */
+static ErrorType ReadFileData(char const * inputFilename, char ** data, long long * fileSize) {
+    FILE * file = NULL;
+    char * buffer = NULL;
+    long long size = 0;
+    long long position;
+    size_t portion;
+
+    if (inputFilename != NULL)
+        file = fopen(inputFilename, "rb");
+
+    // if file can't be opened blank model is built
+    if (file != NULL) {
+        SeekFile(file, 0, SEEK_END);
+        size = TellFile(file);
+        SeekFile(file, 0, SEEK_SET);
+        if (size < 0)
+            size = 0;
+    }
+
+    // no need to zero-fill memory which is overwritten right away
+    if ((unsigned long long)size >= SIZE_MAX)
+        buffer = NULL;      // file doesn't fit into address space
+    else
+        buffer = TakeDataBuffer((size_t)(size + 1));
+    if (buffer == NULL) {
+        if (file != NULL)
+            fclose(file);
+        return ERR_NOMEM;
+    }
+
+    // read by portions: some C runtimes fail reading gigabytes at once
+    for (position = 0; file != NULL && position < size; position += portion) {
+        portion = (size_t)min(size - position, READ_PORTION_SIZE);
+        if (fread((void*)(buffer + position), sizeof(char), portion, file) != portion) {
+            ErrorType errorType = feof(file) ? ERR_EOF : ERR_READ;
+            fclose(file);
+            free(buffer);
+            return errorType;
+        }
+    }
+    if (file != NULL)
+        fclose(file);
+
+    buffer[size] = '\0';
+    TRACE_COUNTER("bytes read", size);
+    *data = buffer;
+    *fileSize = size;
+    return ERR_NO;
+}
+
+/**
+ * Prepares compressed file to be read by blocks through cache. Size of text isn't known
+ * until file is decompressed once (see IndexFileData).
+ * IN:
+ * @param stored - pointer to stored model structure to load data in
+ * @param inputFilename - name of compressed file
+ *
+ * OUT:
+ * stored->compressed, stored->compressedReader get decompressor of file
+ * stored->cache gets memory for blocks (it's opened when size of text is known)
+ * @return code of error occured during opening (ERR_NO if successed)
+ */
+static ErrorType LoadCompressedData(StoredModel * stored, char const * inputFilename) {
+    ErrorType errorType;
+
+    stored->compressed = (CompressedIndex*)malloc(sizeof(CompressedIndex));
+    stored->cache      = (BlockCache*)calloc(1, sizeof(BlockCache));
+    if (stored->compressed == NULL || stored->cache == NULL) {
+        free(stored->compressed);
+        free(stored->cache);
+        stored->compressed = NULL;
+        stored->cache      = NULL;
+        return ERR_NOMEM;
+    }
+    errorType = CreateCompressedIndex(stored->compressed, inputFilename);
+    if (errorType == ERR_NO) {
+        errorType = OpenCompressedReader(&stored->compressedReader, inputFilename, stored->compressed);
+        if (errorType == ERR_NO) {
+            stored->data      = NULL;
+            stored->fileSize  = 0;
+            stored->dataOwner = DATA_OWNER_CACHE;
+            return ERR_NO;
+        }
+        DestroyCompressedIndex(stored->compressed);
+    }
+    free(stored->compressed);
+    free(stored->cache);
+    stored->compressed = NULL;
+    stored->cache      = NULL;
+    return errorType;
+}
+
+/**
+ * Loads data of file with specified name into stored model.
+ * File is mapped into memory if possible, else it's read into heap buffer.
+ * Files which don't fit into cache budget aren't read at once: their blocks are read through cache
+ * when they are shown, so memory they take doesn't depend on file size.
+ * Text of gzip and zstd files is decompressed by blocks through cache too.
+ * IN:
+ * @param stored - pointer to stored model structure to load data in
+ * @param inputFilename - name of file to load
+ *
+ * OUT:
+ * stored->data gets pointer to file data
+ * stored->fileSize gets size of file in bytes
+ * stored->dataOwner, stored->mapping, stored->cache get information about the way data has to be released
+ * @return code of error occured during loading (ERR_NO if successed)
+ */
+static ErrorType LoadFileData(StoredModel * stored, char const * inputFilename) {
+    ErrorType errorType;
+    char * buffer = NULL;
+    long long fileSize = 0;
+
+    stored->cache            = NULL;
+    stored->compressed       = NULL;
+    stored->compressedReader = NULL;
+    if (DetectCompression(inputFilename) != COMPRESSION_NONE)
+        return LoadCompressedData(stored, inputFilename);
+
+    if (storageMode != STORAGE_STREAMED && MapFile(&stored->mapping, inputFilename) == ERR_NO) {
+        stored->data      = stored->mapping.view;
+        stored->fileSize  = stored->mapping.size;
+        stored->dataOwner = DATA_OWNER_MAPPING;
+        return ERR_NO;
+    }
+
+    // read file by blocks if it's asked or if it doesn't fit into budget
+    stored->cache = (BlockCache*)malloc(sizeof(BlockCache));
+    if (stored->cache == NULL)
+        return ERR_NOMEM;
+    errorType = OpenBlockCache(stored->cache, inputFilename, cacheBudget);
+    if (errorType == ERR_NO && (storageMode == STORAGE_STREAMED || stored->cache->fileSize > cacheBudget)) {
+        stored->data      = NULL;
+        stored->fileSize  = stored->cache->fileSize;
+        stored->dataOwner = DATA_OWNER_CACHE;
+        return ERR_NO;
+    }
+    CloseBlockCache(stored->cache);
+    free(stored->cache);
+    stored->cache = NULL;
+
+    // fall back to reading file with stdio
+    errorType = ReadFileData(inputFilename, &buffer, &fileSize);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    stored->data      = buffer;
+    stored->fileSize  = fileSize;
+    stored->dataOwner = DATA_OWNER_HEAP;
+    return ERR_NO;
+}
+
+/**
+ * Releases data of stored model according to the way it has been loaded.
+ * IN:
+ * @param stored - pointer to stored model structure
+ *
+ * OUT:
+ * stored->data sets as NULL
+ */
+static void ReleaseFileData(StoredModel * stored) {
+    if (stored->dataOwner == DATA_OWNER_MAPPING)
+        UnmapFile(&stored->mapping);
+    else if (stored->dataOwner == DATA_OWNER_CACHE) {
+        // cache reads blocks through decompressor, so it's closed first
+        CloseBlockCache(stored->cache);
+        free(stored->cache);
+        stored->cache = NULL;
+        CloseCompressedReader(stored->compressedReader);
+        DestroyCompressedIndex(stored->compressed);
+        free(stored->compressed);
+        stored->compressedReader = NULL;
+        stored->compressed       = NULL;
+    }
+    else if (stored->data != NULL)
+        free((void*)stored->data);
+    stored->data = NULL;
+    stored->fileSize = 0;
+}
+
+// settings of files indexing
+static IndexerOptions indexerOptions = {
+    INDEXER_KERNEL_AUTO,        // the fastest kernel supported by CPU
+    0,                          // number of logical processors
+    LINE_INDEX_PACKED           // lines beginnings take 2-4 bytes per line
+};
+
+/**
+ * Sets number of threads used to index files.
+ * IN:
+ * @param threadsNumber - number of threads (0 means number of logical processors)
+ */
+void SetIndexingThreadsNumber(int threadsNumber) {
+    indexerOptions.threadsNumber = (threadsNumber < 0) ? 0 : threadsNumber;
+}
+
+// function called from indexing thread when new lines of file are indexed
+static IndexerCallback indexingNotify = NULL;
+static void * indexingContext = NULL;
+
+/**
+ * Sets function called from background indexing thread when new lines are indexed.
+ * It's expected to make UI thread call UpdateIndexingProgress.
+ * IN:
+ * @param notify - function to call (NULL if files have to be indexed before they're shown)
+ * @param context - argument of notify
+ */
+void SetIndexingNotification(IndexerCallback notify, void * context) {
+    indexingNotify  = notify;
+    indexingContext = context;
+}
+
+// function called from search thread when new hits are found
+static IndexerCallback searchNotify = NULL;
+static void * searchContext = NULL;
+
+/**
+ * Sets function called from search thread when new hits are found.
+ * It's expected to make UI thread call UpdateSearchProgress.
+ * IN:
+ * @param notify - function to call (may be NULL)
+ * @param context - argument of notify
+ */
+void SetSearchNotification(IndexerCallback notify, void * context) {
+    searchNotify  = notify;
+    searchContext = context;
+}
+
+// function called from filter thread when new lines are found
+static IndexerCallback filterNotify = NULL;
+static void * filterContext = NULL;
+
+/**
+ * Sets function called from filter thread when new matching lines are found.
+ * It's expected to make UI thread call UpdateFilterProgress.
+ * IN:
+ * @param notify - function to call (may be NULL)
+ * @param context - argument of notify
+ */
+void SetFilterNotification(IndexerCallback notify, void * context) {
+    filterNotify  = notify;
+    filterContext = context;
+}
+
+// function called from trigram indexing thread when it's progress changes
+static IndexerCallback trigramNotify = NULL;
+static void * trigramContext = NULL;
+
+/**
+ * Sets function called from trigram indexing thread when it's progress changes.
+ * It's expected to make UI thread call UpdateTrigramIndexing.
+ * IN:
+ * @param notify - function to call (may be NULL)
+ * @param context - argument of notify
+ */
+void SetTrigramNotification(IndexerCallback notify, void * context) {
+    trigramNotify  = notify;
+    trigramContext = context;
+}
+
+/**
+ * Sets representation of lines beginnings of files indexed afterwards.
+ * IN:
+ * @param mode - LINE_INDEX_FLAT for the fastest access, LINE_INDEX_PACKED for the least memory
+ */
+void SetLineIndexMode(LineIndexMode mode) {
+    indexerOptions.mode = mode;
+}
+
+/**
+ * Allocates memory for text model.
+ * IN:
+ * @param model - pointer to TextModel structure to allocate memory for
+ * 
+ * OUT:
+ * model->stored gets pointer to memory allocated
+ * model->displayed gets pointer to memory allocated
+ * @return TRUE if successed, FALSE else
+ */
+static BOOL AllocateTextModel(TextModel * model) {
+    model->stored = (StoredModel*)malloc(sizeof(StoredModel));
+    if (model->stored == NULL)
+        return FALSE;
+    model->displayed = (DisplayedModel*)malloc(sizeof(DisplayedModel));
+    if (model->displayed == NULL) {
+        free(model->stored);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Gives number of shown lines. Lines of view are numbered among shown lines: if text is filtered
+ * they're lines matching filter (see GetTextLine), else they're lines of text.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @return number of lines matching filter if text is filtered, else number of lines of text
+ */
+static long long GetShownLinesNumber(StoredModel const * stored) {
+    return (stored->projection != NULL) ? stored->projection->lines.linesNumber : stored->index.linesNumber;
+}
+
+/**
+ * Gives number of shown line in text.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of shown line (it has to exist)
+ *
+ * OUT:
+ * @return number of line in text
+ */
+static long long GetTextLine(StoredModel const * stored, long long lineNumber) {
+    return (stored->projection != NULL) ? stored->projection->textLines[lineNumber] : lineNumber;
+}
+
+/**
+ * Gives index of the first symbol of line in text.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of shown line
+ *
+ * OUT:
+ * @return index of line beginning (file size if there's no such line)
+ */
+long long GetLineBeginning(StoredModel const * stored, long long lineNumber) {
+    if (lineNumber >= GetShownLinesNumber(stored))
+        return stored->fileSize;
+    return GetIndexedLineBeginning(&stored->index, GetTextLine(stored, lineNumber));
+}
+
+/**
+ * Gives index of the symbol after line content in text (line break symbols are not included).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @return index of line content end
+ */
+static long long GetLineEnd(StoredModel const * stored, long long lineNumber) {
+    return GetLineContentEnd(&stored->index, GetTextLine(stored, lineNumber));
+}
+
+/**
+ * Gives text of file range either from memory or through block cache.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param offset - index of the first symbol of range
+ *
+ * INOUT:
+ * @param length - number of symbols in range, sets as 0 if they can't be read
+ *
+ * OUT:
+ * @return pointer to text of range (text read through cache stays valid until the next call only)
+ */
+static char const * GetText(StoredModel const * stored, long long offset, long long * length) {
+    char const * text;
+
+    if (stored->dataOwner != DATA_OWNER_CACHE)
+        return &stored->data[offset];
+
+    text = ReadCachedText(stored->cache, offset, *length);
+    if (text == NULL) {
+        *length = 0;    // unreadable text is shown as empty rows
+        return "";
+    }
+    return text;
+}
+
+/**
+ * Reads part of file for indexing, when file data isn't kept in memory.
+ * IN:
+ * @param source - file stream
+ * @param offset - index of the first byte to read
+ * @param size - number of bytes to read
+ *
+ * OUT:
+ * @param buffer - gets read bytes
+ * @return TRUE if successed, FALSE else
+ */
+static BOOL ReadIndexedText(void * source, long long offset, char * buffer, size_t size) {
+    return ReadFileRange((FILE*)source, offset, buffer, size) == 0;
+}
+
+/**
+ * Opens own source of text for background thread, when file data isn't kept in memory
+ * (the source of cache belongs to UI thread).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @param source - gets file stream or decompressor of file (NULL if file can't be opened)
+ * @return function reading ranges of text from source
+ */
+static TextReader OpenTextSource(StoredModel const * stored, void ** source) {
+    CompressedReader * reader;
+
+    *source = NULL;
+    if (stored->compressed != NULL) {
+        if (OpenCompressedReader(&reader, stored->filename, stored->compressed) == ERR_NO)
+            *source = reader;
+        return ReadCompressedText;
+    }
+    *source = fopen(stored->filename, "rb");
+    return ReadIndexedText;
+}
+
+/**
+ * Closes source of text opened with OpenTextSource.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param source - file stream or decompressor of file (may be NULL)
+ */
+static void CloseTextSource(StoredModel const * stored, void * source) {
+    if (source == NULL)
+        return;
+    if (stored->compressed != NULL)
+        CloseCompressedReader((CompressedReader*)source);
+    else
+        fclose((FILE*)source);
+}
+
+/**
+ * Gives counters of block cache of file which isn't kept in memory.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @param stats - gets counters of cache
+ * @return TRUE if file is read through block cache, FALSE else
+ */
+BOOL GetStorageStats(StoredModel const * stored, BlockCacheStats * stats) {
+    if (stored->dataOwner != DATA_OWNER_CACHE)
+        return FALSE;
+    *stats = stored->cache->stats;
+    return TRUE;
+}
+
+/**
+ * Gives index of lines of text measured in columns.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @return column index lines in UTF-8 mode, else index of lines in bytes
+ */
+static LineIndex const * GetTextColumnLines(StoredModel const * stored) {
+    return (stored->columns != NULL) ? &stored->columns->lines : &stored->index;
+}
+
+/**
+ * Gives index of shown lines measured in columns: positions of both view modes are counted in columns.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @return index of projected lines if text is filtered, else index of lines of text in columns
+ */
+static LineIndex const * GetColumnLines(StoredModel const * stored) {
+    return (stored->projection != NULL) ? &stored->projection->lines : GetTextColumnLines(stored);
+}
+
+/**
+ * Gives column of the first symbol of line counting from the beginning of shown text.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of shown line
+ *
+ * OUT:
+ * @return column of line beginning (number of columns of shown text if there's no such line)
+ */
+static long long GetColumnBeginning(StoredModel const * stored, long long lineNumber) {
+    LineIndex const * lines = GetColumnLines(stored);
+
+    if (lines == &stored->index)
+        return GetLineBeginning(stored, lineNumber);
+    lineNumber = min(lineNumber, lines->linesNumber);
+    return GetIndexedLineBeginning(lines, lineNumber);
+}
+
+/**
+ * Gives column after line content counting from the beginning of text.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * @return column of line content end
+ */
+static long long GetColumnEnd(StoredModel const * stored, long long lineNumber) {
+    return GetLineContentEnd(GetColumnLines(stored), lineNumber);
+}
+
+/**
+ * Converts column of line to offset of it's symbol in bytes. Multibyte lines are scanned
+ * from the nearest checkpoint, so cost doesn't depend on column.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line
+ * @param column - column counting from line beginning (columns after line content are bytes)
+ *
+ * OUT:
+ * @return offset from line beginning in bytes
+ */
+static long long ColumnToOffset(StoredModel const * stored, long long lineNumber, long long column) {
+    long long columns, size, checkpoint, offset;
+    char const * text;
+
+    if (stored->columns == NULL || lineNumber >= GetShownLinesNumber(stored) ||
+        IsAsciiLine(stored->columns, GetTextLine(stored, lineNumber)))
+        return column;
+    columns = GetColumnEnd(stored, lineNumber) - GetColumnBeginning(stored, lineNumber);
+    size    = GetLineEnd(stored, lineNumber) - GetLineBeginning(stored, lineNumber);
+    if (column >= columns)
+        return size + (column - columns);
+
+    // UTF-8 character takes at most 4 bytes
+    checkpoint = GetColumnCheckpoint(stored->columns, GetTextLine(stored, lineNumber), column, &offset);
+    size = min(size - offset, (column - checkpoint) * 4);
+    text = GetText(stored, GetLineBeginning(stored, lineNumber) + offset, &size);
+    return offset + SkipColumns(text, size, column - checkpoint, indexerOptions.kernel);
+}
+
+/**
+ * Converts offset of symbol in line to it's column.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line
+ * @param offset - offset from line beginning in bytes (offsets after line content are columns)
+ *
+ * OUT:
+ * @return column counting from line beginning
+ */
+static long long OffsetToColumn(StoredModel const * stored, long long lineNumber, long long offset) {
+    long long size, checkpoint, column;
+    char const * text;
+
+    if (stored->columns == NULL || lineNumber >= GetShownLinesNumber(stored) ||
+        IsAsciiLine(stored->columns, GetTextLine(stored, lineNumber)))
+        return offset;
+    size = GetLineEnd(stored, lineNumber) - GetLineBeginning(stored, lineNumber);
+    if (offset >= size)
+        return GetColumnEnd(stored, lineNumber) - GetColumnBeginning(stored, lineNumber) + (offset - size);
+
+    checkpoint = GetOffsetCheckpoint(stored->columns, GetTextLine(stored, lineNumber), offset, &column);
+    size = offset - checkpoint;
+    text = GetText(stored, GetLineBeginning(stored, lineNumber) + checkpoint, &size);
+    return column + CountColumns(text, size, indexerOptions.kernel);
+}
+
+/**
+ * Checks whether line has to be converted from UTF-8 before it's shown.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of shown line
+ *
+ * OUT:
+ * @return TRUE if text is shown as UTF-8 and line has multibyte characters
+ */
+BOOL IsMultibyteLine(StoredModel const * stored, long long lineNumber) {
+    return stored->columns != NULL && lineNumber >= 0 && lineNumber < GetShownLinesNumber(stored) &&
+           !IsAsciiLine(stored->columns, GetTextLine(stored, lineNumber));
+}
+
+/**
+ * Measures lines of text in UTF-8 characters. Lines have to be indexed completely.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->columns gets built column index (NULL if it can't be built)
+ * @return TRUE if successed
+ */
+static BOOL BuildColumns(StoredModel * stored) {
+    ErrorType errorType;
+
+    if (stored->builder != NULL || stored->index.unfinished)
+        return FALSE;
+    stored->columns = (ColumnIndex*)malloc(sizeof(ColumnIndex));
+    if (stored->columns == NULL) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return FALSE;
+    }
+    errorType = BuildColumnIndex(stored->columns, &stored->index, stored->data, ReadUncachedText,
+                                 (stored->dataOwner == DATA_OWNER_CACHE) ? stored->cache : NULL, &indexerOptions);
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        free(stored->columns);
+        stored->columns = NULL;
+        return FALSE;
+    }
+    // lines with multibyte characters are measured in other columns now
+    if (stored->tabs != NULL)
+        ForgetTabLines(stored->tabs, 0);
+    if (stored->projection != NULL)
+        MeasureProjectedLines(stored->projection, GetTextColumnLines(stored), 0);
+    return TRUE;
+}
+
+/**
+ * Frees column index, so text is shown byte per column.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->columns sets as NULL
+ */
+static void DestroyColumns(StoredModel * stored) {
+    DestroyColumnIndex(stored->columns);
+    free(stored->columns);
+    stored->columns = NULL;
+    if (stored->tabs != NULL)
+        ForgetTabLines(stored->tabs, 0);
+    if (stored->projection != NULL)
+        MeasureProjectedLines(stored->projection, GetTextColumnLines(stored), 0);
+}
+
+/**
+ * Gives display width of line with tabs expanded, measuring it if it isn't measured yet.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line
+ *
+ * OUT:
+ * stored->tabs may get width of line
+ * @return pointer to measured line if it has tabs (NULL if line's display columns are it's columns)
+ */
+static TabLine * GetTabLine(StoredModel const * stored, long long lineNumber) {
+    long long begin, size, offset, length;
+    char const * text;
+    TabLine * line;
+    BOOL utf8;
+
+    if (stored->tabs == NULL || lineNumber < 0 || lineNumber >= GetShownLinesNumber(stored))
+        return NULL;
+    // widths are kept for lines of text, so they stay valid when filter changes
+    line = FindTabLine(stored->tabs, GetTextLine(stored, lineNumber));
+    if (line != NULL)
+        return line->tabs ? line : NULL;
+
+    // long lines are measured by parts, so they aren't read through cache at once
+    line  = StartTabLine(stored->tabs, GetTextLine(stored, lineNumber));
+    begin = GetLineBeginning(stored, lineNumber);
+    size  = GetLineEnd(stored, lineNumber) - begin;
+    utf8  = IsMultibyteLine(stored, lineNumber);
+    for (offset = 0; offset < size; offset += length) {
+        length = min(size - offset, TAB_MEASURE_SIZE);
+        text = GetText(stored, begin + offset, &length);
+        if (length == 0 || !AddTabText(stored->tabs, line, text, length, offset, utf8)) {
+            if (length != 0)
+                PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+            // line which can't be measured is shown without expanding tabs
+            line->tabs  = FALSE;
+            line->width = 0;
+            break;
+        }
+    }
+    FinishTabLine(stored->tabs, line);
+    return line->tabs ? line : NULL;
+}
+
+/**
+ * Converts offset of symbol in line to it's display column (tabs are expanded to tab stops).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line
+ * @param offset - offset from line beginning in bytes (offsets after line content are columns)
+ *
+ * OUT:
+ * @return display column counting from line beginning
+ */
+static long long OffsetToDisplay(StoredModel const * stored, long long lineNumber, long long offset) {
+    TabLine const * line = GetTabLine(stored, lineNumber);
+    long long size, checkpoint, column;
+    char const * text;
+
+    if (line == NULL)
+        return OffsetToColumn(stored, lineNumber, offset);
+    size = GetLineEnd(stored, lineNumber) - GetLineBeginning(stored, lineNumber);
+    if (offset >= size)
+        return line->width + (offset - size);
+
+    checkpoint = GetTabOffsetCheckpoint(line, offset, &column);
+    size = offset - checkpoint;
+    text = GetText(stored, GetLineBeginning(stored, lineNumber) + checkpoint, &size);
+    return AdvanceTabColumns(text, size, column, stored->tabs->tabSize, IsMultibyteLine(stored, lineNumber));
+}
+
+/**
+ * Gives width of the longest line in standard mode. Display widths of lines with tabs are known
+ * when lines have been shown, so width may grow as text is scrolled.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @return the biggest width of lines in display columns known so far
+ */
+long long GetMaxLineWidth(StoredModel const * stored) {
+    long long width = GetColumnLines(stored)->maxLength;
+
+    return (stored->tabs != NULL) ? max(width, stored->tabs->maxWidth) : width;
+}
+
+/**
+ * Creates index of lines display widths.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param tabSize - distance between tab stops (1 means tab takes one column and no index is needed)
+ *
+ * OUT:
+ * stored->tabs gets created index (NULL if it isn't needed or can't be created)
+ * @return TRUE if successed
+ */
+static BOOL CreateTabs(StoredModel * stored, int tabSize) {
+    ErrorType errorType;
+
+    stored->tabs = NULL;
+    if (tabSize <= 1)
+        return TRUE;
+    stored->tabs = (TabIndex*)malloc(sizeof(TabIndex));
+    if (stored->tabs == NULL) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return FALSE;
+    }
+    errorType = CreateTabIndex(stored->tabs, tabSize);
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        DestroyTabIndex(stored->tabs);
+        free(stored->tabs);
+        stored->tabs = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Frees index of lines display widths.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->tabs sets as NULL
+ */
+static void DestroyTabs(StoredModel * stored) {
+    DestroyTabIndex(stored->tabs);
+    free(stored->tabs);
+    stored->tabs = NULL;
+}
+
+/**
+ * Reads beginning of line for highlighter (see LineTextReader).
+ * IN:
+ * @param source - pointer to stored model structure of text file
+ * @param lineNumber - number of line in text
+ *
+ * INOUT:
+ * @param length - the most bytes to read, gets number of bytes read
+ *
+ * OUT:
+ * @param lineSize - gets size of line content in bytes
+ * @return pointer to text of line (NULL if line doesn't exist)
+ */
+static char const * ReadHighlightedLine(void * source, long long lineNumber, long long * length, long long * lineSize) {
+    StoredModel const * stored = (StoredModel const*)source;
+    long long begin;
+
+    // highlighter passes lines of text, entries continue through lines hidden by filter
+    if (lineNumber >= stored->index.linesNumber)
+        return NULL;
+    begin     = GetIndexedLineBeginning(&stored->index, lineNumber);
+    *lineSize = GetLineContentEnd(&stored->index, lineNumber) - begin;
+    *length   = min(*length, *lineSize);
+    return GetText(stored, begin, length);
+}
+
+/**
+ * Frees tokens of highlighted lines.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->highlighter sets as NULL
+ */
+static void DestroyHighlighting(StoredModel * stored) {
+    DestroyHighlighter(stored->highlighter);
+    free(stored->highlighter);
+    stored->highlighter = NULL;
+}
+
+/**
+ * Count number of rows line takes in wrap view mode (empty line takes one row).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line
+ * @param capacityCharsX - capacity of chars of client area width
+ *
+ * OUT:
+ * @return number of rows in wrap mode
+ */
+static long long CountLineRowsWrap(StoredModel const * stored, long long lineNumber, int capacityCharsX) {
+    return CountWrapRows(GetColumnLines(stored), lineNumber, capacityCharsX);
+}
+
+/**
+ * Checks whether wrap index of displayed model is built for current client area width.
+ * IN:
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * @return TRUE if wrap index can be used
+ */
+static BOOL IsWrapIndexValid(DisplayedModel const * displayed) {
+    return displayed->wrapIndex.width != 0 && displayed->wrapIndex.width == max(1, displayed->capacityCharsX);
+}
+
+/**
+ * Gives number of the first visible row in wrap view mode counting from the beginning of text.
+ * Takes logarithmic time if wrap index is valid, else the row is estimated by the first symbol position.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * @return number of the first visible row
+ */
+static long long GetFirstRowWrap(StoredModel const * stored, DisplayedModel const * displayed) {
+    long long position = displayed->firstSymbol - GetColumnBeginning(stored, displayed->firstLine);
+    long long columns = GetColumnBeginning(stored, GetShownLinesNumber(stored));
+
+    if (IsWrapIndexValid(displayed))
+        return GetWrapRow(&displayed->wrapIndex, GetColumnLines(stored), displayed->firstLine, position);
+    if (columns == 0)
+        return 0;
+    return (long long)((double)displayed->firstSymbol / columns * displayed->linesNumberWrap);
+}
+
+/**
+ * Drops rows of wrap mode found for previous columns or lengths of lines.
+ * IN:
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * displayed->wrapIndex is destroyed, displayed->lastRowDistance sets as -1
+ */
+static void DropWrapRows(DisplayedModel * displayed) {
+    DestroyWrapIndex(&displayed->wrapIndex);
+    displayed->lastRowDistance = -1;
+}
+
+/**
+ * Finds the last visible row in wrap mode for current position. Rows found for the same first row are kept,
+ * so scrolling by rows moves them instead of walking through client area again.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * INOUT:
+ * @param displayed - pointer to displayed model structure of text file,
+ * displayed->firstRowWrap, displayed->lastRowWrap, displayed->lastRowDistance get rows of current position
+ */
+static void PrepareWrapCursors(StoredModel const * stored, DisplayedModel * displayed) {
+    long long distance = max(0, displayed->capacityCharsY - 1);
+    WrapCursor first;
+
+    first.line     = displayed->firstLine;
+    first.position = displayed->firstSymbol - GetColumnBeginning(stored, displayed->firstLine);
+    if (displayed->lastRowDistance < 0 || displayed->cursorsWidth != displayed->capacityCharsX ||
+        displayed->firstRowWrap.line != first.line || displayed->firstRowWrap.position != first.position) {
+        displayed->firstRowWrap    = first;
+        displayed->lastRowWrap     = first;
+        displayed->lastRowDistance = 0;
+        displayed->cursorsWidth    = displayed->capacityCharsX;
+    }
+
+    // rows of lines indexed since the previous call and rows of resized client area are added (or removed)
+    displayed->lastRowDistance += MoveWrapCursor(&displayed->lastRowWrap, GetColumnLines(stored), displayed->capacityCharsX,
+                                                 distance - displayed->lastRowDistance);
+}
+
+/**
+ * Saves complete index of big file next to it, so the file isn't scanned when it's opened next time.
+ * Failures are ignored: saved index only speeds up opening (and directory of file may be read-only).
+ * IN:
+ * @param stored - pointer to stored model structure with complete index
+ * @param filename - name of indexed file
+ */
+static void CacheLineIndex(StoredModel const * stored, char const * filename) {
+    if (filename == NULL || stored->fileSize < INDEX_CACHING_SIZE || stored->index.storage != NULL ||
+        stored->compressed != NULL)
+        return;
+    SaveLineIndex(&stored->index, filename, stored->data, ReadUncachedText,
+                  (stored->dataOwner == DATA_OWNER_CACHE) ? stored->cache : NULL);
+}
+
+/**
+ * Stops filter thread, lines found so far stay shown.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->filter, stored->filteredFile set as NULL
+ */
+static void StopFilter(StoredModel * stored) {
+    DestroyTextSearch(stored->filter);
+    CloseTextSource(stored, stored->filteredFile);
+    stored->filter       = NULL;
+    stored->filteredFile = NULL;
+}
+
+/**
+ * Shows lines found by filter since the previous call: lines which are indexed already are projected
+ * and their rows are added to wrap mode metrics. Filter is stopped when all it's lines are shown.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * stored->projection gets new lines, stored->filter is stopped when it's finished
+ * displayed->linesNumberWrap, displayed->wrapIndex get rows of new lines
+ * @return TRUE if shown lines or state of filter have changed
+ */
+static BOOL TakeFilteredLines(StoredModel * stored, DisplayedModel * displayed) {
+    LineProjection * projection = stored->projection;
+    ErrorType errorType = ERR_NO;
+    long long previous = projection->lines.linesNumber;
+    long long hitsNumber, position, textLine, line;
+    BOOL finished;
+
+    if (stored->filter == NULL)
+        return FALSE;
+
+    // hits are published before search is finished, so none of them is missed after it's finished
+    finished   = IsTextSearchFinished(stored->filter, &errorType);
+    hitsNumber = GetSearchHitsNumber(stored->filter);
+    textLine   = (previous > 0) ? projection->textLines[previous - 1] : -1;
+    while (projection->lines.linesNumber < hitsNumber) {
+        position = GetSearchHit(stored->filter, projection->lines.linesNumber);
+        if (stored->index.unfinished && position >= GetIndexedLineBeginning(&stored->index, stored->index.linesNumber))
+            break;      // line is shown when it's indexed
+        // hits are line beginnings, matching lines often follow one another
+        if (++textLine >= stored->index.linesNumber || GetIndexedLineBeginning(&stored->index, textLine) != position)
+            textLine = FindIndexedLine(&stored->index, position);
+        if (!AddProjectedLine(projection, GetTextColumnLines(stored), textLine)) {
+            errorType = ERR_NOMEM;
+            finished  = TRUE;
+            break;
+        }
+    }
+
+    for (line = previous; line < projection->lines.linesNumber; ++line)
+        displayed->linesNumberWrap += CountLineRowsWrap(stored, line, displayed->capacityCharsX);
+    if (IsWrapIndexValid(displayed) && projection->lines.linesNumber > previous)
+        ExtendWrapIndex(&displayed->wrapIndex, GetColumnLines(stored), previous);
+
+    if (!finished || (errorType == ERR_NO && projection->lines.linesNumber < hitsNumber))
+        return projection->lines.linesNumber > previous;
+    if (errorType != ERR_NO)
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+    StopFilter(stored);
+    return TRUE;
+}
+
+/**
+ * Shows lines indexed in background since the previous call: takes the latest index snapshot
+ * and adds rows of new lines to wrap mode metrics. Has to be called from UI thread
+ * after notification set with SetIndexingNotification.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * stored->index gets the latest snapshot, stored->builder is destroyed when index is complete
+ * stored->columns gets lines measured in UTF-8 characters when index is complete if they're asked
+ * stored->projection gets lines found by filter in new lines
+ * displayed->linesNumberWrap, displayed->wrapIndex get rows of new lines
+ * @return TRUE if index has changed (scrollbars and client area have to be updated)
+ */
+BOOL UpdateIndexingProgress(StoredModel * stored, DisplayedModel * displayed) {
+    LineIndex previous = stored->index;     // arrays of previous snapshot may be freed already
+    ErrorType errorType = ERR_NO;
+    BOOL finished;
+    long long line;
+
+    if (stored->builder == NULL)
+        return FALSE;
+
+    finished = TakeLineIndexSnapshot(stored->builder, &stored->index, &errorType);
+    if (finished) {
+        DestroyLineIndexBuilder(stored->builder);
+        stored->builder = NULL;
+        if (stored->indexedFile != NULL)
+            fclose(stored->indexedFile);
+        stored->indexedFile = NULL;
+        if (errorType != ERR_NO)
+            PrintError(NULL, errorType, __FILE__, __LINE__);
+        else if (!stored->index.unfinished)
+            CacheLineIndex(stored, stored->filename);
+        // positions counted in bytes so far are moved to line beginning
+        if (stored->utf8 && BuildColumns(stored))
+            displayed->firstSymbol = (displayed->viewMode == VIEW_MODE_WRAP) ?
+                                     GetColumnBeginning(stored, displayed->firstLine) : 0;
+    }
+    else if (stored->index.linesNumber == previous.linesNumber)
+        return FALSE;
+
+    // filtered text shows new lines only if they match filter, their rows are added when they're projected
+    if (stored->projection != NULL) {
+        if (finished) {
+            DropWrapRows(displayed);
+            displayed->linesNumberWrap = CountTotalWrapRows(GetColumnLines(stored), displayed->capacityCharsX);
+        }
+        TakeFilteredLines(stored, displayed);
+        return TRUE;
+    }
+
+    // lines of unfinished snapshot stay the same in the next ones, so only rows of new lines are counted
+    if (previous.unfinished && stored->columns == NULL) {
+        for (line = previous.linesNumber; line < stored->index.linesNumber; ++line)
+            displayed->linesNumberWrap += CountWrapRows(&stored->index, line, displayed->capacityCharsX);
+        if (IsWrapIndexValid(displayed))
+            ExtendWrapIndex(&displayed->wrapIndex, &stored->index, previous.linesNumber);
+    }
+    else {
+        DropWrapRows(displayed);
+        displayed->linesNumberWrap = CountTotalWrapRows(GetColumnLines(stored), displayed->capacityCharsX);
+    }
+    return TRUE;
+}
+
+/**
+ * Gives part of file which is already indexed.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @return number from 0 to 1 (1 if index is complete)
+ */
+double GetIndexingProgress(StoredModel const * stored) {
+    return (stored->builder != NULL) ? GetLineIndexProgress(stored->builder) : 1.0;
+}
+
+/**
+ * Stops background indexing: only lines indexed so far are shown.
+ * Final snapshot still comes with notification. Building of trigram index is stopped too.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ */
+void CancelIndexing(StoredModel * stored) {
+    if (stored->builder != NULL)
+        CancelLineIndexBuilder(stored->builder);
+    if (stored->trigramBuilder != NULL)
+        CancelTrigramIndexBuilder(stored->trigramBuilder);
+}
+
+/**
+ * Builds wrap index for current client area width if it isn't built yet.
+ * Width changes only recount number of rows, so index is rebuilt once
+ * on the first scrolling after resize instead of every resize step.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * displayed->wrapIndex gets index for displayed->capacityCharsX
+ * (if there's not enough memory scrolling in wrap mode walks through rows)
+ */
+void PrepareWrapIndex(StoredModel const * stored, DisplayedModel * displayed) {
+    TRACE_START(start);
+
+    if (displayed->viewMode != VIEW_MODE_WRAP || IsWrapIndexValid(displayed))
+        return;
+    if (BuildWrapIndex(&displayed->wrapIndex, GetColumnLines(stored), displayed->capacityCharsX) != ERR_NO)
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+    TRACE_STOP("BuildWrapIndex", start);
+}
+
+/**
+ * Indexes lines of loaded file data. Big files are indexed in background
+ * and shown by parts (see UpdateIndexingProgress) if indexing notification is set.
+ * Index saved by previous opening of the same unchanged file is loaded instead.
+ * Compressed file is decompressed once right away: lines and restart points of decompressor are found
+ * in the same pass, then it's blocks are read through cache.
+ * IN:
+ * @param stored - pointer to stored model structure with loaded file data
+ * @param inputFilename - name of loaded file
+ *
+ * OUT:
+ * stored->index gets index of file (or the first snapshot of index being built)
+ * stored->builder, stored->indexedFile get background indexing information (NULL if index is complete)
+ * @return code of error occured during indexing (ERR_NO if successed)
+ */
+static ErrorType IndexFileData(StoredModel * stored, char const * inputFilename) {
+    ErrorType errorType = ERR_THREAD;
+    BOOL background = (indexingNotify != NULL && stored->fileSize > BACKGROUND_INDEXING_SIZE);
+
+    stored->builder     = NULL;
+    stored->indexedFile = NULL;
+    if (stored->compressed != NULL) {
+        errorType = BuildSequentialLineIndex(&stored->index, ScanCompressedText, stored->compressedReader,
+                                             &indexerOptions);
+        if (errorType != ERR_NO)
+            return errorType;
+        stored->fileSize = stored->compressed->size;
+        errorType = OpenReaderCache(stored->cache, ReadCompressedText, stored->compressedReader, stored->fileSize,
+                                    cacheBudget);
+        if (errorType != ERR_NO)
+            DestroyLineIndex(&stored->index);
+        return errorType;
+    }
+
+    if (inputFilename != NULL && stored->fileSize >= INDEX_CACHING_SIZE &&
+        LoadLineIndex(&stored->index, inputFilename, stored->data, ReadUncachedText,
+                      (stored->dataOwner == DATA_OWNER_CACHE) ? stored->cache : NULL,
+                      stored->fileSize, indexerOptions.mode) == ERR_NO)
+        return ERR_NO;
+
+    if (stored->dataOwner != DATA_OWNER_CACHE) {
+        if (background)
+            errorType = StartLineIndexBuilder(&stored->builder, stored->data, stored->fileSize,
+                                              &indexerOptions, indexingNotify, indexingContext);
+        if (errorType != ERR_NO) {
+            // index of replaced file is reused, flat array it's packed from is kept for the next one
+            errorType = BuildLineIndexReusing(&stored->index, &retainedIndex, stored->data, stored->fileSize,
+                                              &indexerOptions);
+            if (retainedIndex.memory > RETAINED_INDEX_SIZE)
+                ReleaseLineIndexSpare(&retainedIndex);
+            if (errorType == ERR_NO)
+                CacheLineIndex(stored, inputFilename);
+            return errorType;
+        }
+    }
+    else {
+        // indexing thread reads file with it's own stream, the stream of cache belongs to UI thread
+        if (background && (stored->indexedFile = fopen(inputFilename, "rb")) != NULL) {
+            errorType = StartStreamIndexBuilder(&stored->builder, ReadIndexedText, stored->indexedFile, stored->fileSize,
+                                                &indexerOptions, indexingNotify, indexingContext);
+            if (errorType != ERR_NO) {
+                fclose(stored->indexedFile);
+                stored->indexedFile = NULL;
+            }
+        }
+        if (errorType != ERR_NO) {
+            errorType = BuildStreamLineIndex(&stored->index, ReadUncachedText, stored->cache, stored->fileSize,
+                                             &indexerOptions);
+            if (errorType == ERR_NO)
+                CacheLineIndex(stored, inputFilename);
+            return errorType;
+        }
+    }
+
+    TakeLineIndexSnapshot(stored->builder, &stored->index, NULL);
+    return ERR_NO;
+}
+
+/**
+ * Gets bytes appended to file since it has been loaded.
+ * IN:
+ * @param stored - pointer to stored model structure with loaded file data
+ *
+ * OUT:
+ * stored->data, stored->mapping, stored->cache get access to appended bytes (stored->fileSize isn't changed)
+ * @return size of file data available now (stored->fileSize if file hasn't grown or it can't be read)
+ */
+static long long GrowFileData(StoredModel * stored) {
+    FILE * file;
+    char * buffer;
+    long long size = stored->fileSize;
+
+    if (stored->dataOwner == DATA_OWNER_MAPPING) {
+        if (RemapFile(&stored->mapping) != ERR_NO)
+            return stored->fileSize;
+        stored->data = stored->mapping.view;
+        return max(stored->mapping.size, stored->fileSize);
+    }
+    if (stored->dataOwner == DATA_OWNER_CACHE) {
+        if (RefreshBlockCache(stored->cache) != ERR_NO)
+            return stored->fileSize;
+        return max(stored->cache->fileSize, stored->fileSize);
+    }
+
+    // heap buffer gets only appended bytes, the ones read before stay in place
+    if (stored->filename == NULL || (file = fopen(stored->filename, "rb")) == NULL)
+        return stored->fileSize;
+    if (SeekFile(file, 0, SEEK_END) == 0)
+        size = TellFile(file);
+    if (size > stored->fileSize && (unsigned long long)size < SIZE_MAX &&
+        (buffer = (char*)realloc((void*)stored->data, (size_t)(size + 1) * sizeof(char))) != NULL) {
+        stored->data = buffer;
+        if (ReadFileRange(file, stored->fileSize, buffer + stored->fileSize, (size_t)(size - stored->fileSize)) != 0)
+            size = stored->fileSize;
+        buffer[size] = '\0';
+    }
+    else
+        size = stored->fileSize;
+    fclose(file);
+    return size;
+}
+
+/**
+ * Shows bytes appended to file since the previous call (file is followed like with "tail -f").
+ * Only appended bytes and the last lines are scanned, so the cost doesn't depend on file size.
+ * View stays at the end of text if it has been there. Filtered text keeps it's lines:
+ * appended lines are filtered when filter is applied again.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * stored->index, stored->columns, stored->fileSize get appended lines
+ * displayed->linesNumberWrap, displayed->wrapIndex get rows of appended lines
+ * displayed->firstLine, displayed->firstSymbol get the last page if it has been shown
+ * @return TRUE if text has grown (scrollbars and client area have to be updated)
+ */
+BOOL FollowFile(StoredModel * stored, DisplayedModel * displayed) {
+    ErrorType errorType;
+    long long size, tailLine, tailBegin, shownTail, line;
+    long long rows = 0;
+    BOOL measured = TRUE;
+    BOOL atBottom;
+    BOOL cached;
+
+    // index is owned by indexing thread until it's complete, data is read by search, filter
+    // and trigram indexing threads until they're finished
+    if (stored->builder != NULL || stored->trigramBuilder != NULL || stored->filter != NULL ||
+        (stored->search != NULL && !IsTextSearchFinished(stored->search, NULL)))
+        return FALSE;
+    size = GrowFileData(stored);
+    if (size <= stored->fileSize)
+        return FALSE;
+
+    if (displayed->viewMode == VIEW_MODE_WRAP)
+        atBottom = (GetFirstRowWrap(stored, displayed) + displayed->capacityCharsY >= displayed->linesNumberWrap);
+    else
+        atBottom = (displayed->firstLine + displayed->capacityCharsY >= GetShownLinesNumber(stored));
+
+    // the last lines are rescanned with appended bytes, their rows are recounted
+    tailLine  = GetLineIndexTail(&stored->index);
+    tailBegin = GetIndexedLineBeginning(&stored->index, tailLine);
+    for (line = tailLine; line < stored->index.linesNumber && stored->projection == NULL; ++line)
+        rows += CountLineRowsWrap(stored, line, displayed->capacityCharsX);
+
+    // text of cache is read by segments right from file, so scratch buffer of cache doesn't grow with appended text
+    cached = (stored->dataOwner == DATA_OWNER_CACHE);
+    errorType = AppendLineIndex(&stored->index, cached ? NULL : stored->data + tailBegin, ReadUncachedText,
+                                cached ? stored->cache : NULL, size, &indexerOptions);
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        return FALSE;
+    }
+    stored->fileSize = size;
+
+    // appended lines are measured in characters too, if it fails text is shown byte per column
+    if (stored->columns != NULL) {
+        errorType = AppendColumnIndex(stored->columns, &stored->index, tailLine, stored->data, ReadUncachedText,
+                                      (stored->dataOwner == DATA_OWNER_CACHE) ? stored->cache : NULL,
+                                      &indexerOptions);
+        if (errorType != ERR_NO) {
+            PrintError(NULL, errorType, __FILE__, __LINE__);
+            DestroyColumns(stored);
+            measured = FALSE;
+        }
+    }
+
+    // widths and tokens of rescanned lines are found again when they're shown
+    if (stored->tabs != NULL)
+        ForgetTabLines(stored->tabs, tailLine);
+    if (stored->highlighter != NULL)
+        ForgetHighlightedLines(stored->highlighter, tailLine);
+
+    // trigram index doesn't cover appended lines (it's saved copy is thrown away when it's loaded next time)
+    DestroyTrigramIndex(stored->trigrams);
+    stored->trigrams = NULL;
+
+    // projected lines stay the same, the rescanned ones are measured again
+    shownTail = tailLine;
+    if (stored->projection != NULL) {
+        MeasureProjectedLines(stored->projection, GetTextColumnLines(stored), tailLine);
+        shownTail = FindProjectedLine(stored->projection, tailLine);
+    }
+
+    if (measured && stored->projection == NULL) {
+        for (line = tailLine; line < stored->index.linesNumber; ++line)
+            rows -= CountLineRowsWrap(stored, line, displayed->capacityCharsX);
+        displayed->linesNumberWrap -= rows;
+        if (IsWrapIndexValid(displayed))
+            ExtendWrapIndex(&displayed->wrapIndex, GetColumnLines(stored), tailLine);
+    }
+    else {
+        DropWrapRows(displayed);
+        displayed->linesNumberWrap = CountTotalWrapRows(GetColumnLines(stored), displayed->capacityCharsX);
+        // positions counted in columns are moved to line beginning
+        if (!measured)
+            displayed->firstSymbol = (displayed->viewMode == VIEW_MODE_WRAP) ?
+                                     GetColumnBeginning(stored, displayed->firstLine) : 0;
+    }
+
+    // beginning of rescanned line may move if "\r\n" has been split
+    if (displayed->firstLine > shownTail) {
+        displayed->firstLine   = min(displayed->firstLine, GetShownLinesNumber(stored) - 1);
+        displayed->firstSymbol = GetColumnBeginning(stored, displayed->firstLine);
+    }
+    if (atBottom) {
+        if (displayed->viewMode == VIEW_MODE_WRAP)
+            UpdateModelWrapY(stored, displayed, displayed->linesNumberWrap);
+        else
+            UpdateModelStandardY(stored, displayed, GetShownLinesNumber(stored));
+    }
+    return TRUE;
+}
+
+/**
+ * Stops search and forgets it's hits.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->search, stored->searchedFile set as NULL
+ */
+static void StopSearch(StoredModel * stored) {
+    DestroyTextSearch(stored->search);
+    CloseTextSource(stored, stored->searchedFile);
+    stored->search       = NULL;
+    stored->searchedFile = NULL;
+    stored->hitNumber    = -1;
+}
+
+/**
+ * Starts searching all occurences of string (or all lines matching regular expression) in file.
+ * Hits are found in background (see UpdateSearchProgress), the first one after the first visible line
+ * is shown as soon as it's found.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param pattern - string or regular expression to find
+ * @param patternLength - length of pattern (0 stops previous search only)
+ * @param regex - TRUE if pattern is regular expression (see syntax in Regex.h)
+ *
+ * OUT:
+ * stored->search gets started search, previous search is stopped
+ * @return code of error occured during starting search (ERR_NO if successed)
+ */
+ErrorType StartSearch(StoredModel * stored, DisplayedModel const * displayed, char const * pattern, size_t patternLength,
+                      BOOL regex) {
+    ErrorType errorType;
+    TextReader read;
+
+    StopSearch(stored);
+    if (patternLength == 0)
+        return ERR_NO;
+
+    stored->searchOrigin = GetLineBeginning(stored, displayed->firstLine);
+    if (displayed->viewMode == VIEW_MODE_WRAP)
+        stored->searchOrigin += ColumnToOffset(stored, displayed->firstLine,
+                                               displayed->firstSymbol - GetColumnBeginning(stored, displayed->firstLine));
+    if (stored->dataOwner != DATA_OWNER_CACHE) {
+        if (regex)
+            return StartRegexSearch(&stored->search, stored->data, NULL, NULL, stored->fileSize, pattern, patternLength,
+                                    stored->trigrams, &indexerOptions, searchNotify, searchContext);
+        return StartTextSearch(&stored->search, stored->data, NULL, NULL, stored->fileSize, pattern, patternLength,
+                               stored->trigrams, &indexerOptions, searchNotify, searchContext);
+    }
+
+    // search thread reads file with it's own stream, the stream of cache belongs to UI thread
+    if (stored->filename == NULL)
+        return ERR_OPEN_FILE;
+    read = OpenTextSource(stored, &stored->searchedFile);
+    if (stored->searchedFile == NULL)
+        return ERR_OPEN_FILE;
+    if (regex)
+        errorType = StartRegexSearch(&stored->search, NULL, read, stored->searchedFile, stored->fileSize,
+                                     pattern, patternLength, stored->trigrams, &indexerOptions, searchNotify, searchContext);
+    else
+        errorType = StartTextSearch(&stored->search, NULL, read, stored->searchedFile, stored->fileSize,
+                                    pattern, patternLength, stored->trigrams, &indexerOptions, searchNotify, searchContext);
+    if (errorType != ERR_NO) {
+        CloseTextSource(stored, stored->searchedFile);
+        stored->searchedFile = NULL;
+    }
+    return errorType;
+}
+
+/**
+ * Gives number of shown line hit belongs to.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param position - index of the first byte of hit in text (it has to be indexed)
+ *
+ * OUT:
+ * @return number of shown line (-1 if line is hidden by filter)
+ */
+static long long FindHitLine(StoredModel const * stored, long long position) {
+    long long line = FindIndexedLine(&stored->index, position);
+    long long shown;
+
+    if (stored->projection == NULL)
+        return line;
+    shown = FindProjectedLine(stored->projection, line);
+    if (shown == stored->projection->lines.linesNumber || stored->projection->textLines[shown] != line)
+        return -1;
+    return shown;
+}
+
+/**
+ * Skips hits in lines hidden by filter: search jumps to hits of the next shown line,
+ * so hidden hits aren't passed one by one.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param hitNumber - number of the first hit to check
+ * @param forward - TRUE to skip hits forward, FALSE to skip them backward
+ *
+ * OUT:
+ * @return number of the first hit which isn't hidden (it may be out of range of found hits)
+ */
+static long long SkipHiddenHits(StoredModel const * stored, long long hitNumber, BOOL forward) {
+    LineProjection const * projection = stored->projection;
+    long long position, line, shown;
+
+    if (projection == NULL)
+        return hitNumber;
+    // hits in text which isn't indexed yet aren't known to be hidden
+    while ((position = GetSearchHit(stored->search, hitNumber)) >= 0 &&
+           (!stored->index.unfinished || position < GetIndexedLineBeginning(&stored->index, stored->index.linesNumber)) &&
+           FindHitLine(stored, position) < 0) {
+        shown = FindProjectedLine(projection, FindIndexedLine(&stored->index, position));
+        if (forward && shown == projection->lines.linesNumber)
+            return GetSearchHitsNumber(stored->search);
+        if (!forward && shown == 0)
+            return -1;
+        // the first hit of the next shown line or the last hit of the previous one
+        line      = forward ? projection->textLines[shown] : projection->textLines[shown - 1] + 1;
+        hitNumber = FindSearchHit(stored->search, GetIndexedLineBeginning(&stored->index, line)) - (forward ? 0 : 1);
+    }
+    return hitNumber;
+}
+
+/**
+ * Shows hit of search: it's line becomes the first visible one.
+ * Hits in text which isn't indexed yet and hits in lines hidden by filter aren't shown.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param hitNumber - number of hit in order of their positions in file
+ *
+ * OUT:
+ * displayed->firstLine, displayed->firstSymbol get position of hit
+ * stored->hitNumber gets number of shown hit
+ * @return TRUE if hit is shown (scrollbars and client area have to be updated)
+ */
+BOOL ShowSearchHit(StoredModel * stored, DisplayedModel * displayed, long long hitNumber) {
+    long long position, line, offset, column;
+    long long length, width;
+
+    if (stored->search == NULL || (position = GetSearchHit(stored->search, hitNumber)) < 0)
+        return FALSE;
+    if (stored->index.unfinished && position >= GetIndexedLineBeginning(&stored->index, stored->index.linesNumber))
+        return FALSE;
+
+    line = FindHitLine(stored, position);
+    if (line < 0)
+        return FALSE;
+    offset = position - GetLineBeginning(stored, line);
+    width  = max(1, displayed->capacityCharsX);
+    if (displayed->viewMode == VIEW_MODE_WRAP) {
+        column = OffsetToColumn(stored, line, offset);
+        displayed->firstLine   = line;
+        displayed->firstSymbol = GetColumnBeginning(stored, line) + column / width * width;
+    }
+    else {
+        // standard mode counts positions in display columns
+        column = OffsetToDisplay(stored, line, offset);
+        length = OffsetToDisplay(stored, line, offset + (long long)GetSearchPatternLength(stored->search)) - column;
+        displayed->firstLine = max(0, min(line, GetShownLinesNumber(stored) - displayed->capacityCharsY));
+        if (column < displayed->firstSymbol || column + length > displayed->firstSymbol + width)
+            displayed->firstSymbol = max(0, min(column - width / 2, GetMaxLineWidth(stored) - width));
+    }
+    stored->hitNumber = hitNumber;
+    return TRUE;
+}
+
+/**
+ * Shows hit next to the shown one (or to the first visible line if no hit is shown yet).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param forward - TRUE to show the next hit, FALSE to show the previous one
+ *
+ * OUT:
+ * displayed->firstLine, displayed->firstSymbol get position of hit
+ * @return TRUE if hit is shown (scrollbars and client area have to be updated)
+ */
+BOOL ShowNextSearchHit(StoredModel * stored, DisplayedModel * displayed, BOOL forward) {
+    long long hitNumber = stored->hitNumber;
+
+    if (stored->search == NULL)
+        return FALSE;
+    if (hitNumber < 0)
+        hitNumber = FindSearchHit(stored->search, stored->searchOrigin) - (forward ? 1 : 0);
+    hitNumber = forward ? hitNumber + 1 : hitNumber - 1;
+    return ShowSearchHit(stored, displayed, SkipHiddenHits(stored, hitNumber, forward));
+}
+
+/**
+ * Shows the first hit after the first visible line as soon as it's found and indexed.
+ * Has to be called from UI thread after notifications set with SetSearchNotification
+ * and SetIndexingNotification.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * displayed->firstLine, displayed->firstSymbol get position of the first hit if it's shown
+ * @return TRUE if hit is shown (scrollbars and client area have to be updated)
+ */
+BOOL UpdateSearchProgress(StoredModel * stored, DisplayedModel * displayed) {
+    ErrorType errorType = ERR_NO;
+    long long hitNumber;
+
+    if (stored->search == NULL || stored->hitNumber >= 0)
+        return FALSE;
+
+    hitNumber = SkipHiddenHits(stored, FindSearchHit(stored->search, stored->searchOrigin), TRUE);
+    if (hitNumber < GetSearchHitsNumber(stored->search))
+        return ShowSearchHit(stored, displayed, hitNumber);
+
+    // if there are no hits after origin search continues from the beginning of file
+    if (!IsTextSearchFinished(stored->search, &errorType))
+        return FALSE;
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        StopSearch(stored);
+        return FALSE;
+    }
+    return ShowSearchHit(stored, displayed, SkipHiddenHits(stored, 0, TRUE));
+}
+
+/**
+ * Gives state of search to show.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @param hitNumber - gets number of shown hit (-1 if no hit is shown)
+ * @param hitsNumber - gets number of hits found so far
+ * @return part of file already searched from 0 to 1 (-1 if nothing is searched)
+ */
+double GetSearchState(StoredModel const * stored, long long * hitNumber, long long * hitsNumber) {
+    if (stored->search == NULL)
+        return -1.0;
+    *hitNumber  = stored->hitNumber;
+    *hitsNumber = GetSearchHitsNumber(stored->search);
+    return IsTextSearchFinished(stored->search, NULL) ? 1.0 : GetSearchProgress(stored->search);
+}
+
+/**
+ * Stops search thread. Hits found so far stay available.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ */
+void CancelSearch(StoredModel * stored) {
+    if (stored->search != NULL)
+        CancelTextSearch(stored->search);
+}
+
+/**
+ * Frees lines matching filter, so all lines of text are shown again.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->projection sets as NULL, filter is stopped
+ */
+static void DestroyProjection(StoredModel * stored) {
+    StopFilter(stored);
+    DestroyLineProjection(stored->projection);
+    free(stored->projection);
+    stored->projection = NULL;
+}
+
+/**
+ * Collects runs of lines shown by filter, so refined filter searches only them.
+ * IN:
+ * @param stored - pointer to stored model structure of filtered text
+ *
+ * OUT:
+ * @param ranges - gets array of [2 * rangesNumber] beginnings and ends of runs in text (NULL if no line is shown)
+ * @param rangesNumber - gets number of runs
+ * @return code of error occured during collecting (ERR_NO if successed)
+ */
+static ErrorType CollectProjectedRanges(StoredModel const * stored, long long ** ranges, long long * rangesNumber) {
+    LineProjection const * projection = stored->projection;
+    long long const * textLines = projection->textLines;
+    long long number = 0;
+    long long line;
+
+    *ranges       = NULL;
+    *rangesNumber = 0;
+    for (line = 0; line < projection->lines.linesNumber; ++line) {
+        if (line == 0 || textLines[line] != textLines[line - 1] + 1)
+            ++number;
+    }
+    if (number == 0)
+        return ERR_NO;
+    if ((unsigned long long)number >= SIZE_MAX / (2 * sizeof(long long)) ||
+        (*ranges = (long long*)malloc((size_t)number * 2 * sizeof(long long))) == NULL)
+        return ERR_NOMEM;
+
+    // consecutive lines make one run, it ends with the beginning of the line after it
+    for (line = 0; line < projection->lines.linesNumber; ++line) {
+        if (line == 0 || textLines[line] != textLines[line - 1] + 1)
+            (*ranges)[2 * (*rangesNumber)++] = GetIndexedLineBeginning(&stored->index, textLines[line]);
+        (*ranges)[2 * *rangesNumber - 1] = GetIndexedLineBeginning(&stored->index, textLines[line] + 1);
+    }
+    return ERR_NO;
+}
+
+/**
+ * Starts showing only lines containing string (or lines matching regular expression). Lines are found
+ * in background (see UpdateFilterProgress) and shown as soon as they're found, view moves to the first of them.
+ * Scrolling, wrap mode and scrollbars count shown lines like lines of text. Refined filter searches only lines
+ * shown by current filter (the ones found so far if it's still running), so narrowing filter doesn't scan text again.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param pattern - string or regular expression shown lines have to contain
+ * @param patternLength - length of pattern (0 shows all lines again)
+ * @param regex - TRUE if pattern is regular expression (see syntax in Regex.h)
+ * @param refine - TRUE to search lines shown by current filter only
+ *
+ * OUT:
+ * stored->projection gets empty projection filled by stored->filter, previous filter is dropped
+ * displayed->firstLine, displayed->firstSymbol get the top of filtered text
+ * @return code of error occured during starting filter (model is unchanged if it isn't ERR_NO)
+ */
+ErrorType StartFilter(StoredModel * stored, DisplayedModel * displayed, char const * pattern, size_t patternLength,
+                      BOOL regex, BOOL refine) {
+    LineProjection * projection;
+    TextSearch * filter = NULL;
+    void * filteredFile = NULL;
+    long long * ranges = NULL;
+    long long rangesNumber = 0;
+    TextReader read = NULL;
+    ErrorType errorType;
+
+    if (patternLength == 0) {
+        ClearFilter(stored, displayed);
+        return ERR_NO;
+    }
+
+    refine = refine && stored->projection != NULL;
+    if (refine) {
+        errorType = CollectProjectedRanges(stored, &ranges, &rangesNumber);
+        if (errorType != ERR_NO)
+            return errorType;
+    }
+    projection = (LineProjection*)malloc(sizeof(LineProjection));
+    if (projection == NULL || InitLineProjection(projection) != ERR_NO) {
+        free(projection);
+        free(ranges);
+        return ERR_NOMEM;
+    }
+
+    // if refined filter shows no lines there's nothing to search
+    if (!refine || rangesNumber > 0) {
+        // filter thread reads file with it's own stream, the stream of cache belongs to UI thread
+        if (stored->dataOwner == DATA_OWNER_CACHE && stored->filename != NULL)
+            read = OpenTextSource(stored, &filteredFile);
+        if (stored->dataOwner != DATA_OWNER_CACHE || filteredFile != NULL)
+            errorType = StartLineSearch(&filter, stored->data, read, filteredFile, stored->fileSize, pattern, patternLength,
+                                        regex, ranges, rangesNumber, stored->trigrams, &indexerOptions,
+                                        filterNotify, filterContext);
+        else {
+            free(ranges);
+            errorType = ERR_OPEN_FILE;
+        }
+        if (errorType != ERR_NO) {
+            CloseTextSource(stored, filteredFile);
+            DestroyLineProjection(projection);
+            free(projection);
+            return errorType;
+        }
+    }
+
+    DestroyProjection(stored);
+    stored->projection   = projection;
+    stored->filter       = filter;
+    stored->filteredFile = filteredFile;
+
+    displayed->firstLine       = 0;
+    displayed->firstSymbol     = 0;
+    displayed->linesNumberWrap = 0;
+    DropWrapRows(displayed);
+    return ERR_NO;
+}
+
+/**
+ * Shows lines found by filter since the previous call. Has to be called from UI thread
+ * after notifications set with SetFilterNotification and SetIndexingNotification.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * stored->projection gets new lines, filter is stopped when all it's lines are shown
+ * displayed->linesNumberWrap, displayed->wrapIndex get rows of new lines
+ * @return TRUE if shown lines or state of filter have changed (scrollbars and client area have to be updated)
+ */
+BOOL UpdateFilterProgress(StoredModel * stored, DisplayedModel * displayed) {
+    if (stored->projection == NULL)
+        return FALSE;
+    return TakeFilteredLines(stored, displayed);
+}
+
+/**
+ * Gives state of filter to show.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @param linesNumber - gets number of lines shown by filter
+ * @return part of file already filtered from 0 to 1, 1 when all matching lines are shown (-1 if text isn't filtered)
+ */
+double GetFilterState(StoredModel const * stored, long long * linesNumber) {
+    if (stored->projection == NULL)
+        return -1.0;
+    *linesNumber = stored->projection->lines.linesNumber;
+    // lines of searched text are shown after notification, filter is stopped then
+    return (stored->filter != NULL) ? min(GetSearchProgress(stored->filter), FILTER_SHOWING_PROGRESS) : 1.0;
+}
+
+/**
+ * Stops filter thread. Lines found so far stay shown, final lines still come with notification.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ */
+void CancelFilter(StoredModel * stored) {
+    if (stored->filter != NULL)
+        CancelTextSearch(stored->filter);
+}
+
+/**
+ * Shows all lines of text again. The first visible line stays at the top of client area.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * stored->projection sets as NULL, filter is stopped
+ * displayed->firstLine, displayed->firstSymbol get position of the first visible line in text
+ * displayed->linesNumberWrap, displayed->wrapIndex are recounted
+ * @return TRUE if text has been filtered (scrollbars and client area have to be updated)
+ */
+BOOL ClearFilter(StoredModel * stored, DisplayedModel * displayed) {
+    long long line = 0;
+    long long position = 0;
+
+    if (stored->projection == NULL)
+        return FALSE;
+    if (displayed->firstLine < GetShownLinesNumber(stored)) {
+        line     = GetTextLine(stored, displayed->firstLine);
+        position = displayed->firstSymbol - GetColumnBeginning(stored, displayed->firstLine);
+    }
+    DestroyProjection(stored);
+
+    displayed->firstLine = line;
+    if (displayed->viewMode == VIEW_MODE_WRAP)
+        displayed->firstSymbol = GetColumnBeginning(stored, line) + position;
+    DropWrapRows(displayed);
+    displayed->linesNumberWrap = CountTotalWrapRows(GetColumnLines(stored), displayed->capacityCharsX);
+    return TRUE;
+}
+
+/**
+ * Stops building of trigram index and closes it's file.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->trigramBuilder, stored->trigramFile set as NULL
+ */
+static void StopTrigramIndexing(StoredModel * stored) {
+    DestroyTrigramIndexBuilder(stored->trigramBuilder);
+    CloseTextSource(stored, stored->trigramFile);
+    stored->trigramBuilder = NULL;
+    stored->trigramFile    = NULL;
+}
+
+/**
+ * Starts building trigram index of file in background (see UpdateTrigramIndexing).
+ * Searches started after index is built check only blocks of lines which may contain searched string.
+ * Nothing is done while lines are indexed, trigram index is built already or file has no name.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->trigramBuilder gets started builder
+ * @return code of error occured during starting (ERR_NO if successed)
+ */
+ErrorType StartTrigramIndexing(StoredModel * stored) {
+    ErrorType errorType;
+    TextReader read;
+    long long size;
+
+    if (stored->builder != NULL || stored->trigramBuilder != NULL || stored->trigrams != NULL ||
+        stored->filename == NULL)
+        return ERR_NO;
+
+    // time of modification is taken before reading, so changes made during building make saved index stale
+    errorType = GetFileStamp(stored->filename, &size, &stored->trigramStamp);
+    if (errorType != ERR_NO)
+        return errorType;
+    if (stored->dataOwner != DATA_OWNER_CACHE)
+        return StartTrigramIndexBuilder(&stored->trigramBuilder, stored->data, NULL, NULL, &stored->index,
+                                        stored->fileSize, &indexerOptions, trigramNotify, trigramContext);
+
+    // indexing thread reads file with it's own stream, the stream of cache belongs to UI thread
+    read = OpenTextSource(stored, &stored->trigramFile);
+    if (stored->trigramFile == NULL)
+        return ERR_OPEN_FILE;
+    errorType = StartTrigramIndexBuilder(&stored->trigramBuilder, NULL, read, stored->trigramFile,
+                                         &stored->index, stored->fileSize, &indexerOptions, trigramNotify, trigramContext);
+    if (errorType != ERR_NO) {
+        CloseTextSource(stored, stored->trigramFile);
+        stored->trigramFile = NULL;
+    }
+    return errorType;
+}
+
+/**
+ * Takes trigram index when it's built and saves it next to file. Has to be called from UI thread
+ * after notification set with SetTrigramNotification.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * stored->trigrams gets built index, stored->trigramBuilder is destroyed when building is finished
+ * @return TRUE if building is finished
+ */
+BOOL UpdateTrigramIndexing(StoredModel * stored) {
+    TrigramIndex * trigrams = NULL;
+    ErrorType errorType = ERR_NO;
+
+    if (stored->trigramBuilder == NULL || !TakeTrigramIndex(stored->trigramBuilder, &trigrams, &errorType))
+        return FALSE;
+    StopTrigramIndexing(stored);
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        return TRUE;
+    }
+
+    // index isn't saved if building is cancelled, failure of saving leaves index for this session only
+    if (trigrams != NULL) {
+        stored->trigrams = trigrams;
+        errorType = SaveTrigramIndex(trigrams, stored->filename, stored->trigramStamp);
+        if (errorType != ERR_NO)
+            PrintError(NULL, errorType, __FILE__, __LINE__);
+    }
+    return TRUE;
+}
+
+/**
+ * Gives part of file which is already indexed by trigrams.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ *
+ * OUT:
+ * @return number from 0 to 1 (-1 if trigram index isn't being built)
+ */
+double GetTrigramIndexingProgress(StoredModel const * stored) {
+    return (stored->trigramBuilder != NULL) ? GetTrigramIndexProgress(stored->trigramBuilder) : -1.0;
+}
+
+/**
+ * Frees memory allocated for text model, index and data buffer may be kept to load the next file in.
+ * IN:
+ * @param model - pointer to model structure of text file
+ * @param retain - TRUE to keep memory of index and heap data buffer (see ReleaseRetainedBuffers)
+ *
+ * OUT:
+ * model->stored sets as NULL
+ * model->displayed variables sets as NULL
+ */
+static void ReleaseTextModel(TextModel * model, BOOL retain) {
+    if (model == NULL)
+        return;
+
+    // destroy stored model (indexing and search threads are stopped before file data is released)
+    if (model->stored != NULL) {
+        StopSearch(model->stored);
+        DestroyProjection(model->stored);
+        StopTrigramIndexing(model->stored);
+        DestroyTrigramIndex(model->stored->trigrams);
+        DestroyColumns(model->stored);
+        DestroyTabs(model->stored);
+        DestroyHighlighting(model->stored);
+        if (model->stored->builder != NULL)
+            DestroyLineIndexBuilder(model->stored->builder);
+        else if (retain) {
+            RetainLineIndex(&model->stored->index, &retainedIndex);
+            if (retainedIndex.memory > RETAINED_INDEX_SIZE)
+                ReleaseLineIndexSpare(&retainedIndex);
+        }
+        else
+            DestroyLineIndex(&model->stored->index);
+        if (model->stored->indexedFile != NULL)
+            fclose(model->stored->indexedFile);
+        if (retain && model->stored->dataOwner == DATA_OWNER_HEAP && model->stored->data != NULL &&
+            model->stored->fileSize < cacheBudget) {
+            free(retainedData);
+            retainedData     = (char*)model->stored->data;
+            retainedDataSize = (size_t)model->stored->fileSize + 1;
+            model->stored->data = NULL;
+        }
+        ReleaseFileData(model->stored);
+        free(model->stored->filename);
+        free(model->stored);
+    }
+
+    // destroy displayed model
+    if (model->displayed != NULL) {
+        DestroyWrapIndex(&model->displayed->wrapIndex);
+        free(model->displayed);
+    }
+    
+    model->stored = NULL;
+    model->displayed = NULL;
+}
+
+/**
+ * Frees memory allocated for text model.
+ * IN:
+ * @param model - pointer to model structure of text file
+ * 
+ * OUT:
+ * model->stored sets as NULL
+ * model->displayed variables sets as NULL
+ */
+void DestroyTextModel(TextModel * model) {
+    ReleaseTextModel(model, FALSE);
+}
+
+/** 
+ * Builds TextModel structure of file with specified name.
+ * IN:
+ * @param model - pointer to structure to save information in
+ * @param inputFilename - name of file to process
+ * 
+ * OUT:
+ * model->stored gets pointer to allocated memory
+ * model->displayed gets pointer to allocated memory
+ * fields of model->stored, model->displayed structures initialized with built text model parameters
+ * @return code of error occured during building model (ERR_NO if successed)
+ */
+ErrorType BuildTextModel(TextModel * model, char const * inputFilename) {
+    StoredModel loaded;         // temp storage of loaded file data
+    ErrorType errorType;
+    TRACE_START(start);         // failed builds aren't traced
+
+    if (model == NULL) { // REMOVED 30/11/2019: || inputFilename == NULL) {
+        PrintError(NULL, ERR_NULL_PTR, __FILE__, __LINE__);
+        return ERR_NULL_PTR;
+    }
+
+    // map file into memory (or read it if mapping is impossible)
+    // ADDED 30/11/2019: blank model is built if file can't be opened
+    errorType = LoadFileData(&loaded, inputFilename);
+    if (errorType != ERR_NO) {
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        return errorType;
+    }
+
+    // start building model: find lines beginnings and the longest line in a single parallel pass
+    errorType = IndexFileData(&loaded, inputFilename);
+    if (errorType != ERR_NO) {
+        ReleaseFileData(&loaded);
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+        return errorType;
+    }
+
+    // memory allocation
+    if (!AllocateTextModel(model)) {
+        if (loaded.builder != NULL)
+            DestroyLineIndexBuilder(loaded.builder);
+        else
+            DestroyLineIndex(&loaded.index);
+        if (loaded.indexedFile != NULL)
+            fclose(loaded.indexedFile);
+        ReleaseFileData(&loaded);
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return ERR_NOMEM;
+    }
+
+    // fill structs field (name is kept to follow file growth)
+    *model->stored = loaded;
+    model->stored->filename       = NULL;
+    model->stored->search         = NULL;
+    model->stored->searchedFile   = NULL;
+    model->stored->hitNumber      = -1;
+    model->stored->searchOrigin   = 0;
+    model->stored->trigrams       = NULL;
+    model->stored->trigramBuilder = NULL;
+    model->stored->trigramFile    = NULL;
+    model->stored->trigramStamp   = 0;
+    model->stored->columns        = NULL;
+    model->stored->utf8           = FALSE;
+    model->stored->highlighter    = NULL;
+    model->stored->projection     = NULL;
+    model->stored->filter         = NULL;
+    model->stored->filteredFile   = NULL;
+    CreateTabs(model->stored, DEFAULT_TAB_SIZE);
+    if (inputFilename != NULL && (model->stored->filename = (char*)malloc(strlen(inputFilename) + 1)) != NULL)
+        strcpy(model->stored->filename, inputFilename);
+
+    // trigram index saved for previous version of file is thrown away
+    if (model->stored->filename != NULL) {
+        errorType = LoadTrigramIndex(&model->stored->trigrams, model->stored->filename);
+        if (errorType != ERR_NO)
+            PrintError(NULL, errorType, __FILE__, __LINE__);
+        if (model->stored->trigrams != NULL && GetTrigramIndexedSize(model->stored->trigrams) != model->stored->fileSize) {
+            DestroyTrigramIndex(model->stored->trigrams);
+            model->stored->trigrams = NULL;
+        }
+    }
+
+    // displayed model fields initialization
+    // TODO: refactor with calloc
+    model->displayed->capacityCharsX  = 0;
+    model->displayed->capacityCharsY  = 0;
+    model->displayed->clientAreaX     = 0;
+    model->displayed->clientAreaY     = 0;
+    model->displayed->charPixelsX     = 0;
+    model->displayed->charPixelsY     = 0;
+    model->displayed->viewMode        = VIEW_MODE_STANDARD;
+    model->displayed->firstLine       = 0;
+    model->displayed->firstSymbol     = 0;
+    model->displayed->scrollX         = 0;
+    model->displayed->scrollY         = 0;
+    model->displayed->scrollMaxX      = 0;
+    model->displayed->scrollMaxY      = 0;
+    model->displayed->linesNumberWrap = 0;
+    memset(&model->displayed->wrapIndex, 0, sizeof(WrapIndex));
+    model->displayed->lastRowDistance = -1;
+    model->displayed->cursorsWidth    = 0;
+
+    TRACE_STOP("BuildTextModel", start);
+    return ERR_NO;
+}
+
+/**
+ * Applies window settings of shown model to other model: size of client area, font metrics,
+ * view mode, encoding and tab size. Position in text is kept where view mode allows it.
+ * IN:
+ * @param source - pointer to model settings are taken from
+ *
+ * INOUT:
+ * @param model - pointer to model to apply settings to
+ */
+void InheritModelSettings(TextModel * model, TextModel const * source) {
+    DisplayedModel * displayed = model->displayed;
+    int prevCapacityCharsX = displayed->capacityCharsX;
+
+    displayed->capacityCharsX = source->displayed->capacityCharsX;
+    displayed->capacityCharsY = source->displayed->capacityCharsY;
+    displayed->charPixelsX    = source->displayed->charPixelsX;
+    displayed->charPixelsY    = source->displayed->charPixelsY;
+    displayed->clientAreaX    = source->displayed->clientAreaX;
+    displayed->clientAreaY    = source->displayed->clientAreaY;
+    if (displayed->viewMode != source->displayed->viewMode)
+        SwitchMode(model->stored, displayed, source->displayed->viewMode);
+
+    SwitchEncoding(model->stored, displayed, source->stored->utf8);
+    SwitchTabSize(model->stored, displayed, (source->stored->tabs != NULL) ? source->stored->tabs->tabSize : 1);
+    SwitchHighlighting(model->stored, source->stored->highlighter != NULL);
+    UpdateModelMetrics(model->stored, displayed, prevCapacityCharsX);
+}
+
+/** 
+ * Builds new TextModel structure of file with specified name and destroys previous one.
+ * New model is built while previous one is still shown and replaces it only if it's built,
+ * memory of previous model is kept to load the next file in (see ReleaseRetainedBuffers).
+ * IN:
+ * @param model - pointer to structure to save information in
+ * @param inputFilename - name of file to process
+ * 
+ * OUT:
+ * model->stored gets pointer to new allocated memory
+ * model->displayed gets pointer to new allocated memory
+ * fields of model->stored, model->displayed structures initialized with new built text model parameters
+ * (model is unchanged if building failed)
+ * @return code of error occured during building model (ERR_NO if successed)
+ */
+ErrorType RebuildTextModel(TextModel * model, char const * inputFilename) {
+    TextModel built;
+    TextModel previous;
+    ErrorType errorType;
+
+    if (model == NULL) { // REMOVED || inputFilename == NULL) {
+        PrintError(NULL, ERR_NULL_PTR, __FILE__, __LINE__);
+        return ERR_NULL_PTR;
+    }
+
+    // build new model next to previous one
+    errorType = BuildTextModel(&built, inputFilename);
+    if (errorType != ERR_NO)
+        return errorType;
+    
+    // view mode, encoding and tab size are kept for the next files
+    InheritModelSettings(&built, model);
+
+    // swap models at once, so complete model is always shown
+    previous = *model;
+    *model = built;
+    ReleaseTextModel(&previous, TRUE);
+    return ERR_NO;
+}
+
+/**
+ * Drops structures of text model which are rebuilt when they're needed: wrap index, lines display widths
+ * and tokens of highlighted lines.
+ * IN:
+ * @param model - pointer to model structure of text file
+ *
+ * OUT:
+ * model->displayed->wrapIndex is destroyed, measured lines of model->stored->tabs are forgotten,
+ * memory of model->stored->highlighter is freed
+ */
+void TrimTextModel(TextModel * model) {
+    if (model->displayed != NULL)
+        DropWrapRows(model->displayed);
+    if (model->stored != NULL && model->stored->tabs != NULL)
+        ForgetTabLines(model->stored->tabs, 0);
+    if (model->stored != NULL && model->stored->highlighter != NULL)
+        ForgetHighlightedLines(model->stored->highlighter, 0);
+}
+
+/**
+ * Releases file data and indexes of text model keeping it's displayed model, so it's shown
+ * at the same position after it's reloaded (see ReloadTextModel). Memory is freed rather than kept to load
+ * the next file in, since budget of documents counts unloaded model as gone. Filter is dropped, reloaded model shows all lines.
+ * IN:
+ * @param model - pointer to model structure of text file
+ *
+ * OUT:
+ * model->stored sets as NULL, wrap index of model->displayed is destroyed
+ */
+void UnloadTextModel(TextModel * model) {
+    TextModel unloaded = { model->stored, NULL };
+
+    if (model->stored == NULL)
+        return;
+    ClearFilter(model->stored, model->displayed);
+    ReleaseTextModel(&unloaded, FALSE);
+    DropWrapRows(model->displayed);
+    model->stored = NULL;
+}
+
+/**
+ * Builds stored model of unloaded text model again. Position is kept unless file has become shorter.
+ * Encoding and tab size are default ones (see InheritModelSettings).
+ * IN:
+ * @param inputFilename - name of file model has been built of
+ *
+ * INOUT:
+ * @param model - pointer to model unloaded by UnloadTextModel (model is unchanged if building failed)
+ *
+ * OUT:
+ * @return code of error occured during building model (ERR_NO if successed)
+ */
+ErrorType ReloadTextModel(TextModel * model, char const * inputFilename) {
+    DisplayedModel * displayed = model->displayed;
+    TextModel built;
+    ErrorType errorType;
+    long long lineBegin;
+
+    if (model->stored != NULL)
+        return ERR_NO;
+    errorType = BuildTextModel(&built, inputFilename);
+    if (errorType != ERR_NO)
+        return errorType;
+    model->stored = built.stored;
+    built.stored = NULL;
+    DestroyTextModel(&built);
+
+    // file may have changed while it's been unloaded
+    displayed->firstLine = max(0, min(displayed->firstLine, model->stored->index.linesNumber - 1));
+    if (displayed->viewMode == VIEW_MODE_WRAP) {
+        lineBegin = GetColumnBeginning(model->stored, displayed->firstLine);
+        if (displayed->firstSymbol < lineBegin || displayed->firstSymbol > GetColumnEnd(model->stored, displayed->firstLine))
+            displayed->firstSymbol = lineBegin;
+    }
+    displayed->linesNumberWrap = CountTotalWrapRows(GetColumnLines(model->stored), displayed->capacityCharsX);
+    return ERR_NO;
+}
+
+/**
+ * Gives memory taken by text model.
+ * IN:
+ * @param model - pointer to model structure of text file (model->stored is NULL if model is unloaded)
+ *
+ * OUT:
+ * @param memory - gets memory taken by each kind of structures
+ * @return memory charged to model in bytes: text, indexes and caches
+ */
+long long GetTextModelMemory(TextModel const * model, ModelMemory * memory) {
+    StoredModel const * stored = model->stored;
+    BlockCacheStats stats;
+
+    memset(memory, 0, sizeof(ModelMemory));
+    if (model->displayed != NULL)
+        memory->caches += model->displayed->wrapIndex.blocksNumber * (long long)sizeof(long long);
+    if (stored == NULL)
+        return memory->caches;
+
+    if (stored->dataOwner == DATA_OWNER_MAPPING)
+        memory->mapped = stored->fileSize;
+    else if (GetStorageStats(stored, &stats))
+        memory->text = stats.residentSize;
+    else if (stored->data != NULL)
+        memory->text = stored->fileSize + 1;
+
+    memory->index = (long long)GetLineIndexMemory(&stored->index);
+    if (stored->columns != NULL)
+        memory->index += (long long)GetColumnIndexMemory(stored->columns);
+    if (stored->trigrams != NULL)
+        memory->index += (long long)GetTrigramIndexMemory(stored->trigrams);
+    if (stored->compressed != NULL)
+        memory->index += (long long)GetCompressedIndexMemory(stored->compressed);
+    if (stored->projection != NULL)
+        memory->index += (long long)GetLineProjectionMemory(stored->projection);
+    if (stored->tabs != NULL)
+        memory->caches += (long long)GetTabIndexMemory(stored->tabs);
+    if (stored->highlighter != NULL)
+        memory->caches += (long long)GetHighlighterMemory(stored->highlighter);
+    return memory->text + memory->index + memory->caches;
+}
+
+/**
+ * Finds bytes of line which row of standard view mode is read from.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line (it has to exist)
+ * @param position - column of first symbol in line to show
+ * @param capacityCharsX - capacity of chars of client area width
+ *
+ * OUT:
+ * @param tabLine - gets measured line with tabs, then span is expanded from it's checkpoint (NULL if span is shown as it is)
+ * @param column - gets display column span begins at
+ * @param length - gets length of span in bytes
+ * @return index of the first symbol of span in text
+ */
+static long long GetSpanStandard(StoredModel const * stored, long long lineNumber, long long position, int capacityCharsX,
+                                 TabLine const ** tabLine, long long * column, long long * length) {
+    long long firstSymbol;   // index of the first visible symbol in invalid region
+    long long lastSymbol;    // index of the symbol after the last visible one
+    long long offset;
+
+    // line with tabs is read from the nearest checkpoint
+    *tabLine = GetTabLine(stored, lineNumber);
+    if (*tabLine != NULL) {
+        *column = GetTabCheckpoint(*tabLine, position, &offset);
+        // each character before the end of window takes at least one column and at most 4 bytes
+        *length = min(GetLineEnd(stored, lineNumber) - GetLineBeginning(stored, lineNumber) - offset,
+                      (position + capacityCharsX - *column) * 4);
+        *length = max(0, *length);
+        return GetLineBeginning(stored, lineNumber) + offset;
+    }
+
+    // position and width are counted in columns, they're converted to bytes of multibyte lines
+    firstSymbol = GetLineBeginning(stored, lineNumber) + ColumnToOffset(stored, lineNumber, position);
+    lastSymbol  = GetLineBeginning(stored, lineNumber) + ColumnToOffset(stored, lineNumber, position + capacityCharsX);
+
+    // set possible length of the line to output (line break symbols are not printed)
+    *length = min(GetLineEnd(stored, lineNumber), lastSymbol) - firstSymbol;
+
+    if (*length <= 0)
+        firstSymbol = GetLineBeginning(stored, lineNumber);
+    *length = max(0, *length);                              // check if length is valid
+    *column = position;
+    return firstSymbol;
+}
+
+/**
+ * Gives pointer to string for printing in standard view mode. Saves it's length in lineLength.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param lineNumber - number of line where to search substring
+ * @param position - column of first symbol in line to print
+ * @param capacityCharsX - capacity of chars of client area width
+ * 
+ * OUT:
+ * @param lineLength - gets length of substring returned in bytes
+ * @return pointer to desired substring (NULL if no string found)
+ */
+char const * GetLineStandard(StoredModel const * stored, long long lineNumber, long long position, int capacityCharsX, long long * lineLength) {
+    long long firstSymbol;   // index of the first symbol read from text
+    long long tempLength;    // returned length of the line to output
+    long long column;
+    TabLine const * tabLine;
+    char const * line;
+
+    if (lineNumber >= GetShownLinesNumber(stored))
+        return NULL;
+
+    firstSymbol = GetSpanStandard(stored, lineNumber, position, capacityCharsX, &tabLine, &column, &tempLength);
+    line = GetText(stored, firstSymbol, &tempLength);       // pointer to the string
+    // line with tabs is expanded into scratch buffer of tab index
+    if (tabLine != NULL)
+        line = ExpandTabs(stored->tabs, line, tempLength, column, position, capacityCharsX,
+                          IsMultibyteLine(stored, lineNumber), &tempLength);
+    if (lineLength != NULL)
+       *lineLength = tempLength;
+    return line;
+}
+
+/**
+ * Finds bytes of line which row of wrap view mode is read from.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param capacityCharsX - capacity of chars of client area width
+ * @param lineNumber - number of line
+ * @param column - column of the first symbol of row counting from line beginning
+ *
+ * OUT:
+ * @param columns - gets number of columns shown in row
+ * @param length - gets length of span in bytes
+ * @return offset of span from line beginning
+ */
+static long long GetSpanWrap(StoredModel const * stored, int capacityCharsX, long long lineNumber, long long column,
+                             long long * columns, long long * length) {
+    long long offset;
+
+    // row is counted in columns, it's converted to bytes of multibyte lines
+    *columns = max(0, min(GetColumnEnd(stored, lineNumber) - GetColumnBeginning(stored, lineNumber) - column, capacityCharsX));
+    offset   = ColumnToOffset(stored, lineNumber, column);
+    *length  = ColumnToOffset(stored, lineNumber, column + *columns) - offset;
+    return offset;
+}
+
+/**
+ * Gives pointer to string for printing in wrap view mode. Saves it's length in lineLength.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param linesToSkip - number of lines to skip counting from prevLine either firstLine of displayed model
+ * @param prevLine - number of previous processed line in text
+ * 
+ * INOUT:
+ * @param prevSymbol - column in text of previous processed line, gets column of returned substring beginning
+ * @param prevLine - number of previous processed line in text, gets number of line which returned substring belongs to
+ * 
+ * OUT:
+ * @param lineLength - gets length of substring returned in bytes
+ * @return pointer to desired substring (NULL if no string found)
+ */
+char const * GetLineWrap(StoredModel const * stored, DisplayedModel const * displayed, long long linesToSkip, long long * lineLength, long long * prevSymbol, long long * prevLine) {
+    long long currLine   =   (prevLine == NULL) ? displayed->firstLine   : *prevLine;
+    long long currSymbol = (prevSymbol == NULL) ? displayed->firstSymbol : *prevSymbol;
+    long long length = 0;   // text isn't read if only position is needed
+    long long column, columns, offset = 0;
+    WrapCursor cursor;
+    char const * line;
+
+    // skip lines till the first visible line of invalid rectangle
+    if (linesToSkip != 0) {
+        cursor.line     = currLine;
+        cursor.position = currSymbol - GetColumnBeginning(stored, currLine);
+        if (MoveWrapCursor(&cursor, GetColumnLines(stored), displayed->capacityCharsX, linesToSkip) != linesToSkip)
+            return NULL;
+        currLine   = cursor.line;
+        currSymbol = GetColumnBeginning(stored, currLine) + cursor.position;
+    }
+
+    // set valid length
+    column = currSymbol - GetColumnBeginning(stored, currLine);
+    if (lineLength != NULL)
+        offset = GetSpanWrap(stored, displayed->capacityCharsX, currLine, column, &columns, &length);
+    else
+        offset = column;    // pointer is only checked for NULL
+    line = GetText(stored, GetLineBeginning(stored, currLine) + offset, &length);
+    // rows are counted with tab taking one column, so it's shown as space
+    if (lineLength != NULL && stored->tabs != NULL)
+        line = HideTabs(stored->tabs, line, length);
+    if (lineLength != NULL)
+       *lineLength = length;
+    // set invalid rectangle's current visible line beginning
+    if (prevSymbol != NULL)
+       *prevSymbol = currSymbol;
+    // set invalid rectangle's current visible line number
+    if (prevLine != NULL)
+       *prevLine = currLine;
+    return line;    // return pointer to the string
+}
+
+/**
+ * Lays out rows of client area for current position in text. Rows keep positions of their text only,
+ * so frames are compared without reading text (see DiffDisplayList).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ *
+ * OUT:
+ * @param list - gets visible rows from the top of client area
+ * @return code of error occured during building (ERR_NO if successed)
+ */
+ErrorType BuildDisplayList(StoredModel const * stored, DisplayedModel const * displayed, DisplayList * list) {
+    DisplayRow * row;
+    TabLine const * tabLine;
+    long long lineNumber, width, column;
+    WrapCursor cursor;
+    ErrorType errorType;
+    TRACE_START(start);
+
+    errorType = ReserveDisplayRows(list, displayed->capacityCharsY);
+    if (errorType != ERR_NO)
+        return errorType;
+
+    switch (displayed->viewMode) {
+    case VIEW_MODE_STANDARD:
+        for (lineNumber = displayed->firstLine;
+             list->rowsNumber < list->screenRows && lineNumber < GetShownLinesNumber(stored); ++lineNumber) {
+            row = &list->rows[list->rowsNumber++];
+            row->line   = lineNumber;
+            row->column = displayed->firstSymbol;
+            row->offset = GetSpanStandard(stored, lineNumber, displayed->firstSymbol, displayed->capacityCharsX,
+                                          &tabLine, &column, &row->length);
+            width = (tabLine != NULL) ? tabLine->width : GetColumnEnd(stored, lineNumber) - GetColumnBeginning(stored, lineNumber);
+            row->columns = max(0, min(width - row->column, displayed->capacityCharsX));
+        }
+        break;
+
+    case VIEW_MODE_WRAP:
+        if (displayed->firstLine >= GetShownLinesNumber(stored))
+            break;
+        // rows are passed the way text is scrolled
+        cursor.line     = displayed->firstLine;
+        cursor.position = displayed->firstSymbol - GetColumnBeginning(stored, displayed->firstLine);
+        while (list->rowsNumber < list->screenRows) {
+            row = &list->rows[list->rowsNumber++];
+            row->line   = cursor.line;
+            row->column = cursor.position;
+            row->offset = GetLineBeginning(stored, cursor.line) +
+                          GetSpanWrap(stored, displayed->capacityCharsX, cursor.line, cursor.position, &row->columns, &row->length);
+            if (MoveWrapCursor(&cursor, GetColumnLines(stored), displayed->capacityCharsX, 1) != 1)
+                break;
+        }
+        break;
+
+    default:
+        break;
+    }
+    TRACE_STOP("BuildDisplayList", start);
+    return ERR_NO;
+}
+
+/**
+ * Gives pointer to string for printing row of display list (see GetLineStandard and GetLineWrap).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure list is built for
+ * @param row - pointer to row of display list
+ *
+ * OUT:
+ * @param lineLength - gets length of substring returned in bytes
+ * @return pointer to text of row (NULL if line doesn't exist any more)
+ */
+char const * GetDisplayRowText(StoredModel const * stored, DisplayedModel const * displayed, DisplayRow const * row,
+                               long long * lineLength) {
+    long long lineNumber = row->line;
+    long long symbol;
+
+    if (displayed->viewMode == VIEW_MODE_STANDARD)
+        return GetLineStandard(stored, row->line, row->column, displayed->capacityCharsX, lineLength);
+    if (lineNumber >= GetShownLinesNumber(stored))
+        return NULL;
+    symbol = GetColumnBeginning(stored, lineNumber) + row->column;
+    return GetLineWrap(stored, displayed, 0, lineLength, &symbol, &lineNumber);
+}
+
+/**
+ * Gives colored runs of row of display list. Only tokens of shown lines are found,
+ * so highlighting costs at most MAX_LINE_TOKENS runs per row.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure list is built for
+ * @param row - pointer to row of display list
+ * @param runsCapacity - number of items runs can take
+ *
+ * OUT:
+ * @param runs - gets runs in order of their columns counting from row beginning (the rest of row is plain text)
+ * @return number of runs (0 if text isn't highlighted)
+ */
+int GetDisplayRowRuns(StoredModel const * stored, DisplayedModel const * displayed, DisplayRow const * row,
+                      HighlightRun * runs, int runsCapacity) {
+    TokenSpan const * tokens;
+    long long first, last;
+    int tokensNumber, runsNumber = 0, i;
+
+    if (stored->highlighter == NULL || row->columns <= 0 || row->line >= GetShownLinesNumber(stored))
+        return 0;
+    tokens = GetLineTokens(stored->highlighter, GetTextLine(stored, row->line), &tokensNumber);
+
+    // offsets of tokens are converted to columns the row is shown in (tabs take one column in wrap mode)
+    for (i = 0; i < tokensNumber && runsNumber < runsCapacity; ++i) {
+        first = (displayed->viewMode == VIEW_MODE_STANDARD) ? OffsetToDisplay(stored, row->line, tokens[i].offset) :
+                                                              OffsetToColumn(stored, row->line, tokens[i].offset);
+        first -= row->column;
+        if (first >= row->columns)
+            break;
+        last = (displayed->viewMode == VIEW_MODE_STANDARD) ?
+               OffsetToDisplay(stored, row->line, (long long)tokens[i].offset + tokens[i].length) :
+               OffsetToColumn(stored, row->line, (long long)tokens[i].offset + tokens[i].length);
+        last -= row->column;
+        if (last <= 0)
+            continue;
+        runs[runsNumber].column  = (int)max(0, first);
+        runs[runsNumber].columns = (int)(min(last, row->columns) - runs[runsNumber].column);
+        runs[runsNumber].kind    = tokens[i].kind;
+        runsNumber++;
+    }
+    return runsNumber;
+}
+
+/**
+ * Updates displayed model firstSymbol field in standard mode 
+ * according to received desired horizontal shift (in characters) of client area.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param incrementX - desired horizontal shift of client area
+ * 
+ * OUT:
+ * displayed->firstSymbol gets position of new first visible symbol
+ * @return actual possible horizontal shift of client area
+ */
+long long UpdateModelStandardX(StoredModel const * stored, DisplayedModel * displayed, long long incrementX) {
+    long long temp;
+    if (incrementX < 0)
+        incrementX = -min(displayed->firstSymbol, -incrementX);
+    else {
+        temp = GetMaxLineWidth(stored) - displayed->firstSymbol - displayed->capacityCharsX;
+        if (temp < 0)
+            temp = 0;
+        incrementX = min(temp, incrementX);
+    }
+
+    displayed->firstSymbol += incrementX;
+    return incrementX;
+}
+
+/**
+ * Updates displayed model firstLine field in standard mode
+ * according to received desired vertical shift (in characters) of client area.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param incrementY - desired vertical shift of client area
+ * 
+ * OUT:
+ * displayed->firstLine gets number of new first visible line
+ * @return actual possible vertical shift of client area
+ */
+long long UpdateModelStandardY(StoredModel const * stored, DisplayedModel * displayed, long long incrementY) {
+    long long temp;
+    if (incrementY < 0)
+        incrementY = -min(displayed->firstLine, -incrementY);
+    else {
+        temp = GetShownLinesNumber(stored) - displayed->firstLine - displayed->capacityCharsY;
+        if (temp < 0)
+            temp = 0;
+        incrementY = min(temp, incrementY);
+    }
+
+    displayed->firstLine += incrementY;
+    return incrementY;
+}
+
+/**
+ * Updates displayed model firstLine and firstSymbol fields in wrap mode 
+ * according to received desired vertical shift (in characters) of client area.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param incrementY - desired vertical shift of client area
+ * 
+ * OUT:
+ * displayed->firstSymbol gets index of new first visible symbol in text
+ * displayed->firstLine gets number of new first visible line firstSymbol belongs to
+ * displayed->firstRowWrap, displayed->lastRowWrap get visible rows if they're moved by rows
+ * @return actual possible vertical shift of client area
+ */
+long long UpdateModelWrapY(StoredModel const * stored, DisplayedModel * displayed, long long incrementY) {
+    long long distance = max(0, displayed->capacityCharsY - 1);    // rows from the first visible row to the last one
+    long long firstRow, lastRow, position;
+    TRACE_START(start);
+
+    // with wrap index far position is found directly without walking through rows
+    PrepareWrapIndex(stored, displayed);
+    if (IsWrapIndexValid(displayed) && (incrementY > distance || -incrementY > distance)) {
+        firstRow = GetFirstRowWrap(stored, displayed);
+        lastRow  = max(firstRow, displayed->wrapIndex.rowsNumber - displayed->capacityCharsY);
+        if (incrementY > 0)
+            incrementY = min(incrementY, max(0, lastRow - firstRow));
+        else
+            incrementY = -min(firstRow, -incrementY);
+
+        displayed->firstLine   = FindWrapRow(&displayed->wrapIndex, GetColumnLines(stored), firstRow + incrementY, &position);
+        displayed->firstSymbol = GetColumnBeginning(stored, displayed->firstLine) + position;
+        TRACE_STOP("UpdateModelWrapY", start);
+        return incrementY;
+    }
+
+    // else the first and the last visible rows are moved, so it takes time proportional to number of passed lines
+    PrepareWrapCursors(stored, displayed);
+    if (incrementY > 0) {
+        // text is moved up while there are rows below the last visible one
+        if (displayed->lastRowDistance < distance)
+            incrementY = 0;
+        incrementY = MoveWrapCursor(&displayed->lastRowWrap, GetColumnLines(stored), displayed->capacityCharsX, incrementY);
+        MoveWrapCursor(&displayed->firstRowWrap, GetColumnLines(stored), displayed->capacityCharsX, incrementY);
+    }
+    else {
+        // the last visible row stays the last row of text if text ends above the bottom of client area
+        incrementY = MoveWrapCursor(&displayed->firstRowWrap, GetColumnLines(stored), displayed->capacityCharsX, incrementY);
+        displayed->lastRowDistance -= incrementY;
+        displayed->lastRowDistance += MoveWrapCursor(&displayed->lastRowWrap, GetColumnLines(stored), displayed->capacityCharsX,
+                                                     distance - displayed->lastRowDistance);
+    }
+
+    displayed->firstLine   = displayed->firstRowWrap.line;
+    displayed->firstSymbol = GetColumnBeginning(stored, displayed->firstLine) + displayed->firstRowWrap.position;
+    TRACE_STOP("UpdateModelWrapY", start);
+    return incrementY;
+}
+
+/**
+ * Receives horizontal scrollbar position 
+ * and converts it into needed size of horizontal shift (in characters) to perform.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param scroll - horizontal scrollbar position from 0 to scrollMaxX of displayed model struct
+ * 
+ * OUT:
+ * @return size of horizontal shift to perform
+ */
+long long scrollToIncrementX(StoredModel const * stored, DisplayedModel const * displayed, int scroll) {
+    double temp;
+    // scrollbar without range (whole text fits client area) gives no shift
+    if (displayed->viewMode != VIEW_MODE_STANDARD || displayed->scrollMaxX == 0)
+        return 0;
+    temp  = (double)scroll / displayed->scrollMaxX;
+    temp *= (GetMaxLineWidth(stored) - displayed->capacityCharsX + 1);
+    return (long long)round(temp) - displayed->firstSymbol;
+}
+
+/**
+ * Receives vertical scrollbar position 
+ * and converts it into needed size of vertical shift (in characters) to perform.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param scroll - vertical scrollbar position from 0 to scrollMaxY of displayed model struct
+ * 
+ * OUT:
+ * @return size of vertical shift to perform
+ */
+long long scrollToIncrementY(StoredModel const * stored, DisplayedModel const * displayed, int scroll) {
+    double temp;
+    if (displayed->scrollMaxY == 0)
+        return 0;
+    temp = (double)scroll / displayed->scrollMaxY;
+    switch (displayed->viewMode) {
+    case VIEW_MODE_STANDARD:
+        temp *= (GetShownLinesNumber(stored) - displayed->capacityCharsY + 1);
+        return (long long)round(temp) - displayed->firstLine;
+    case VIEW_MODE_WRAP:
+        temp *= (displayed->linesNumberWrap - displayed->capacityCharsY + 1);
+        return (long long)round(temp) - GetFirstRowWrap(stored, displayed);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Counts horizontal scrollbar position according to current position in text:
+ * firstSymbol field of displayed model struct.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * 
+ * OUT:
+ * @return horizontal scrollbar position from 0 to scrollMaxX of displayed model struct
+ */
+int countScrollPositionX(StoredModel const * stored, DisplayedModel const * displayed) {
+    double temp;
+    if (displayed->viewMode != VIEW_MODE_STANDARD)
+        return 0;
+    temp  = (double)displayed->firstSymbol / (GetMaxLineWidth(stored) - displayed->capacityCharsX + 1);
+    temp *= displayed->scrollMaxX;
+
+    if (temp < 0)
+        return 0;
+    else if (temp > displayed->scrollMaxX)
+        return displayed->scrollMaxX;
+    else
+        return (int)round(temp);
+}
+
+/**
+ * Counts vertical scrollbar position according to current position in text:
+ * firstLine field of displayed model struct (for standard mode),
+ * firstLine and linesNumberWrap fields of displayed model struct (for wrap mode).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * 
+ * OUT:
+ * @return vertical scrollbar position from 0 to scrollMaxY of displayed model struct
+ */
+int countScrollPositionY(StoredModel const * stored, DisplayedModel const * displayed) {
+    double temp;
+    // scrollbar without range (e.g. filter has found no lines yet) stays at the top
+    if (displayed->scrollMaxY == 0)
+        return 0;
+    switch (displayed->viewMode) {
+    case VIEW_MODE_STANDARD:
+        temp  = (double)displayed->firstLine / (GetShownLinesNumber(stored) - displayed->capacityCharsY + 1);
+        temp *= displayed->scrollMaxY;
+        break;
+
+    case VIEW_MODE_WRAP:
+        temp  = (double)GetFirstRowWrap(stored, displayed) /
+                (displayed->linesNumberWrap - displayed->capacityCharsY);
+        temp *= displayed->scrollMaxY;
+        break;
+    default:
+        return 0;
+    }
+
+    if (temp < 0)
+        return 0;
+    else if (temp > displayed->scrollMaxY)
+        return displayed->scrollMaxY;
+    else
+        return (int)round(temp);
+}
+
+/** 
+ * Updates displayed model fields (scrollMaxX, scrollMaxY, firstSymbol and linesNumberWrap) to relevant.
+ * Scrollbars of window are set by caller (see UpdateWindowMetrics).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param prevCapacityCharsX - previous value needed to find out 
+ * whether there is necessity to change firstSymbol and linesNumberWrap fields
+ * 
+ * OUT:
+ * displayed->scrollMaxX gets new horizontal scrollbar range
+ * displayed->scrollMaxY gets new vertical scrollbar range
+ * displayed->firstSymbol may be changed to it's line beginning
+ * displayed->linesNumberWrap may be recounted to new number of lines in wrap mode
+ */
+void UpdateModelMetrics(StoredModel const * stored, DisplayedModel * displayed, int prevCapacityCharsX) {
+    long long temp;
+    TRACE_START(start);
+
+    temp = GetMaxLineWidth(stored) - displayed->capacityCharsX + 1;
+    if (temp < 0)
+        temp = 0;
+    displayed->scrollMaxX = min(SHRT_MAX, temp);
+
+    if (displayed->viewMode == VIEW_MODE_STANDARD) {
+        temp = GetShownLinesNumber(stored) - displayed->capacityCharsY + 1;
+        if (temp < 0)
+            temp = 0;
+        displayed->scrollMaxY = min(SHRT_MAX, temp);
+    }
+    if (displayed->viewMode == VIEW_MODE_WRAP) {
+        // for wrap mode it's not possible to change window width
+        // without jumping to the line beginning
+        if (displayed->capacityCharsX != prevCapacityCharsX) {
+            displayed->firstSymbol = GetColumnBeginning(stored, displayed->firstLine);
+            // lines aren't scanned here: rows are counted by lines lengths histogram
+            // and wrap index is rebuilt on demand (see PrepareWrapIndex)
+            displayed->linesNumberWrap = CountTotalWrapRows(GetColumnLines(stored), displayed->capacityCharsX);
+        }
+        temp = displayed->linesNumberWrap - displayed->capacityCharsY + 1;
+        if (temp < 0)
+            temp = 0;
+        displayed->scrollMaxY = min(SHRT_MAX, temp);
+    }
+    TRACE_STOP("UpdateModelMetrics", start);
+}
+
+/**
+ * Switches text view mode.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param viewMode - new view mode to set
+ * 
+ * OUT:
+ * displayed->viewMode gets new view mode (see enum ViewMode)
+ * displayed->firstSymbol gets new value dependently on view mode
+ * displayed->scrollX gets 0 for wrap view mode
+ */
+void SwitchMode(StoredModel const * stored, DisplayedModel * displayed, int viewMode) {
+    if (viewMode == VIEW_MODE_STANDARD) {
+        displayed->viewMode = VIEW_MODE_STANDARD;
+        displayed->firstSymbol = 0;
+    }
+    else if (viewMode == VIEW_MODE_WRAP) {
+        displayed->viewMode  = VIEW_MODE_WRAP;
+        displayed->firstSymbol = GetColumnBeginning(stored, displayed->firstLine);
+        displayed->scrollX = 0;
+    }
+}
+
+/**
+ * Switches the way text is shown: byte per column or UTF-8 character per column.
+ * Lines are measured in characters synchronously if index is complete, else when indexing is finished
+ * (see UpdateIndexingProgress). Lines which aren't valid UTF-8 are shown byte per column.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param utf8 - TRUE to show text as UTF-8
+ *
+ * OUT:
+ * stored->columns gets built column index (or it's destroyed)
+ * displayed->firstSymbol gets line beginning in wrap mode and 0 in standard mode
+ * displayed->linesNumberWrap, displayed->wrapIndex are recounted
+ * @return TRUE if columns have changed (scrollbars and client area have to be updated)
+ */
+BOOL SwitchEncoding(StoredModel * stored, DisplayedModel * displayed, BOOL utf8) {
+    stored->utf8 = utf8;
+    if (utf8 == (stored->columns != NULL))
+        return FALSE;
+    if (!utf8)
+        DestroyColumns(stored);
+    else if (!BuildColumns(stored))
+        return FALSE;
+
+    // positions are counted in other columns now
+    displayed->firstSymbol = (displayed->viewMode == VIEW_MODE_WRAP) ? GetColumnBeginning(stored, displayed->firstLine) : 0;
+    DropWrapRows(displayed);
+    displayed->linesNumberWrap = CountTotalWrapRows(GetColumnLines(stored), displayed->capacityCharsX);
+    return TRUE;
+}
+
+/**
+ * Switches distance between tab stops. Tabs are expanded in standard mode only: rows of wrap mode are counted
+ * by lines lengths, so there tab takes one column and it's shown as space.
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param displayed - pointer to displayed model structure of text file
+ * @param tabSize - distance between tab stops in columns (1 to show tabs as they are)
+ *
+ * OUT:
+ * stored->tabs gets new index of lines display widths (NULL for tab size 1)
+ * displayed->firstSymbol gets 0 in standard mode
+ * @return TRUE if tab size has changed (scrollbars and client area have to be updated)
+ */
+BOOL SwitchTabSize(StoredModel * stored, DisplayedModel * displayed, int tabSize) {
+    TabIndex * tabs = stored->tabs;
+
+    tabSize = max(1, min(tabSize, MAX_TAB_SIZE));
+    if (tabSize == ((tabs != NULL) ? tabs->tabSize : 1))
+        return FALSE;
+    if (!CreateTabs(stored, tabSize)) {
+        stored->tabs = tabs;
+        return FALSE;
+    }
+    DestroyTabIndex(tabs);
+    free(tabs);
+
+    // positions are counted in other display columns now
+    if (displayed->viewMode == VIEW_MODE_STANDARD)
+        displayed->firstSymbol = 0;
+    return TRUE;
+}
+
+/**
+ * Switches highlighting of log lines. Lines are tokenized when they're shown (see GetDisplayRowRuns).
+ * IN:
+ * @param stored - pointer to stored model structure of text file
+ * @param highlight - TRUE to highlight text
+ *
+ * OUT:
+ * stored->highlighter gets empty highlighter (NULL if text isn't highlighted)
+ * @return TRUE if highlighting has changed (client area has to be repainted)
+ */
+BOOL SwitchHighlighting(StoredModel * stored, BOOL highlight) {
+    if (highlight == (stored->highlighter != NULL))
+        return FALSE;
+    if (!highlight) {
+        DestroyHighlighting(stored);
+        return TRUE;
+    }
+    stored->highlighter = (Highlighter*)malloc(sizeof(Highlighter));
+    if (stored->highlighter == NULL) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return FALSE;
+    }
+    InitHighlighter(stored->highlighter, ReadHighlightedLine, stored);
+    return TRUE;
+}
@@ -1,75 +1,146 @@
-#ifndef TEXTMODEL_H_INCLUDED
-#define TEXTMODEL_H_INCLUDED
-
-#include <windows.h>
-#include <stdlib.h>
-#include "Error.h"
-
-typedef struct tag_StoredModel StoredModel;
-typedef struct tag_DisplayedModel DisplayedModel;
-
-typedef enum {
-    VIEW_MODE_STANDARD,
-    VIEW_MODE_WRAP
-} ViewMode;
-
-struct tag_DisplayedModel {
-    // capacity of client area in SYSTEM_FIXED_FONT characters
-    int capacityCharsX;
-    int capacityCharsY;
-
-    // size of client area
-    int clientAreaX;
-    int clientAreaY;
-
-    // character metrics of SYSTEM_FIXED_FONT
-    int charPixelsX;
-    int charPixelsY;
-
-    ViewMode viewMode;
-    
-    /* current position in text definition depends on view mode:
-
-     * VIEW_MODE_STANDARD:
-     * defined with number of the first visible line
-     * and it's position to the right from the first symbol
-
-     * VIEW_MODE_WRAP:
-     * defined with the first visible symbol index in entire text file
-     * and number of the line it belongs to */
-
-    long firstLine;
-    long firstSymbol;
-
-    // scrollbar position calculation necessary info
-    int scrollX;
-    int scrollY;
-    int scrollMaxX;
-    int scrollMaxY;
-    long linesNumberWrap;   // number of lines in wrap view mode
-};
-
-typedef struct {
-    StoredModel * stored;
-    DisplayedModel * displayed;
-} TextModel;
-
-ErrorType   BuildTextModel(TextModel * model, char const * inputFilename);
-ErrorType RebuildTextModel(TextModel * model, char const * inputFilename);
-char const * GetLineStandard(StoredModel const * stored, long lineNumber, long position, int capacityCharsX, long * lineLength);
-char const * GetLineWrap(StoredModel const * stored, DisplayedModel const * displayed, long linesToSkip, long * lineLength, long * prevSymbol, long * prevLine);
-long GetLineBeginning(StoredModel const * stored, long lineNumber);
-long UpdateModelStandardX(StoredModel const * stored, DisplayedModel * displayed, int incrementX);
-long UpdateModelStandardY(StoredModel const * stored, DisplayedModel * displayed, int incrementY);
-long UpdateModelWrapY(StoredModel const * stored, DisplayedModel * displayed, long incrementY);
-long scrollToIncrementX(StoredModel const * stored, DisplayedModel const * displayed, int scroll);
-long scrollToIncrementY(StoredModel const * stored, DisplayedModel const * displayed, int scroll);
-int countScrollPositionX(StoredModel const * stored, DisplayedModel const * displayed);
-int countScrollPositionY(StoredModel const * stored, DisplayedModel const * displayed);
-void SwitchMode(StoredModel const * stored, DisplayedModel * displayed, int viewMode);
-void UpdateModelMetrics(HWND hWindow, StoredModel const * stored, DisplayedModel * displayed, int prevCapacityCharsX);
-void SetInvalidRectagleX(DisplayedModel const * displayed, long incrementCharsX, RECT * rectangle);
-void SetInvalidRectagleY(DisplayedModel const * displayed, long incrementCharsY, RECT * rectangle);
-void DestroyTextModel(TextModel * textModel);
-
-#endif // TEXTMODEL_H_INCLUDED
+#ifndef TEXTMODEL_H_INCLUDED
+#define TEXTMODEL_H_INCLUDED
+
+#include "Portable.h"
+#include <stdlib.h>
+#include "Error.h"
+#include "LineIndexer.h"
+#include "WrapIndex.h"
+#include "BlockCache.h"
+#include "DisplayList.h"
+#include "Highlighter.h"
+
+typedef struct tag_StoredModel StoredModel;
+typedef struct tag_DisplayedModel DisplayedModel;
+
+// ways of keeping file data in memory
+typedef enum {
+    STORAGE_AUTO,               // file is mapped, if it can't be mapped it's read at once unless it's bigger than cache budget
+    STORAGE_STREAMED            // file is read by blocks through cache, memory doesn't depend on file size
+} StorageMode;
+
+typedef enum {
+    VIEW_MODE_STANDARD,
+    VIEW_MODE_WRAP
+} ViewMode;
+
+struct tag_DisplayedModel {
+    // capacity of client area in SYSTEM_FIXED_FONT characters
+    int capacityCharsX;
+    int capacityCharsY;
+
+    // size of client area
+    int clientAreaX;
+    int clientAreaY;
+
+    // character metrics of SYSTEM_FIXED_FONT
+    int charPixelsX;
+    int charPixelsY;
+
+    ViewMode viewMode;
+    
+    /* current position in text definition depends on view mode:
+
+     * VIEW_MODE_STANDARD:
+     * defined with number of the first visible line
+     * and it's position to the right from the first symbol
+
+     * VIEW_MODE_WRAP:
+     * defined with the first visible symbol index in entire text file
+     * and number of the line it belongs to */
+
+    long long firstLine;
+    long long firstSymbol;
+
+    // scrollbar position calculation necessary info
+    int scrollX;
+    int scrollY;
+    int scrollMaxX;
+    int scrollMaxY;
+    long long linesNumberWrap;   // number of lines in wrap view mode
+
+    // prefix sums of rows in wrap mode for current capacityCharsX (built in wrap mode only)
+    WrapIndex wrapIndex;
+
+    // the first and the last visible rows in wrap mode, kept between scrollings (see UpdateModelWrapY)
+    WrapCursor firstRowWrap;
+    WrapCursor lastRowWrap;
+    long long lastRowDistance;  // number of rows from firstRowWrap to lastRowWrap (-1 if rows aren't found)
+    int cursorsWidth;           // capacityCharsX rows are found for
+};
+
+typedef struct {
+    StoredModel * stored;
+    DisplayedModel * displayed;
+} TextModel;
+
+// memory taken by text model in bytes (see GetTextModelMemory)
+typedef struct {
+    long long text;             // Heap buffer of file data or blocks of file read through cache
+    long long mapped;           // Mapped view of file (system drops it's pages itself, so it isn't charged)
+    long long index;            // Line, column, trigram and decompressor indexes, lines shown by filter
+    long long caches;           // Wrap index, lines display widths and tokens (they're rebuilt when they're needed)
+} ModelMemory;
+
+ErrorType   BuildTextModel(TextModel * model, char const * inputFilename);
+ErrorType RebuildTextModel(TextModel * model, char const * inputFilename);
+void InheritModelSettings(TextModel * model, TextModel const * source);
+void TrimTextModel(TextModel * model);
+void UnloadTextModel(TextModel * model);
+ErrorType ReloadTextModel(TextModel * model, char const * inputFilename);
+long long GetTextModelMemory(TextModel const * model, ModelMemory * memory);
+char const * GetLineStandard(StoredModel const * stored, long long lineNumber, long long position, int capacityCharsX, long long * lineLength);
+char const * GetLineWrap(StoredModel const * stored, DisplayedModel const * displayed, long long linesToSkip, long long * lineLength, long long * prevSymbol, long long * prevLine);
+long long GetLineBeginning(StoredModel const * stored, long long lineNumber);
+ErrorType BuildDisplayList(StoredModel const * stored, DisplayedModel const * displayed, DisplayList * list);
+char const * GetDisplayRowText(StoredModel const * stored, DisplayedModel const * displayed, DisplayRow const * row,
+                               long long * lineLength);
+int GetDisplayRowRuns(StoredModel const * stored, DisplayedModel const * displayed, DisplayRow const * row,
+                      HighlightRun * runs, int runsCapacity);
+long long UpdateModelStandardX(StoredModel const * stored, DisplayedModel * displayed, long long incrementX);
+long long UpdateModelStandardY(StoredModel const * stored, DisplayedModel * displayed, long long incrementY);
+long long UpdateModelWrapY(StoredModel const * stored, DisplayedModel * displayed, long long incrementY);
+void PrepareWrapIndex(StoredModel const * stored, DisplayedModel * displayed);
+long long scrollToIncrementX(StoredModel const * stored, DisplayedModel const * displayed, int scroll);
+long long scrollToIncrementY(StoredModel const * stored, DisplayedModel const * displayed, int scroll);
+int countScrollPositionX(StoredModel const * stored, DisplayedModel const * displayed);
+int countScrollPositionY(StoredModel const * stored, DisplayedModel const * displayed);
+void SwitchMode(StoredModel const * stored, DisplayedModel * displayed, int viewMode);
+BOOL SwitchEncoding(StoredModel * stored, DisplayedModel * displayed, BOOL utf8);
+BOOL IsMultibyteLine(StoredModel const * stored, long long lineNumber);
+BOOL SwitchTabSize(StoredModel * stored, DisplayedModel * displayed, int tabSize);
+BOOL SwitchHighlighting(StoredModel * stored, BOOL highlight);
+long long GetMaxLineWidth(StoredModel const * stored);
+void UpdateModelMetrics(StoredModel const * stored, DisplayedModel * displayed, int prevCapacityCharsX);
+void DestroyTextModel(TextModel * textModel);
+void ReleaseRetainedBuffers(void);
+void SetIndexingThreadsNumber(int threadsNumber);
+void SetLineIndexMode(LineIndexMode mode);
+void SetStorageMode(StorageMode mode, long long budget);
+BOOL GetStorageStats(StoredModel const * stored, BlockCacheStats * stats);
+void SetIndexingNotification(IndexerCallback notify, void * context);
+BOOL UpdateIndexingProgress(StoredModel * stored, DisplayedModel * displayed);
+double GetIndexingProgress(StoredModel const * stored);
+void CancelIndexing(StoredModel * stored);
+BOOL FollowFile(StoredModel * stored, DisplayedModel * displayed);
+void SetSearchNotification(IndexerCallback notify, void * context);
+ErrorType StartSearch(StoredModel * stored, DisplayedModel const * displayed, char const * pattern, size_t patternLength,
+                      BOOL regex);
+BOOL UpdateSearchProgress(StoredModel * stored, DisplayedModel * displayed);
+BOOL ShowSearchHit(StoredModel * stored, DisplayedModel * displayed, long long hitNumber);
+BOOL ShowNextSearchHit(StoredModel * stored, DisplayedModel * displayed, BOOL forward);
+double GetSearchState(StoredModel const * stored, long long * hitNumber, long long * hitsNumber);
+void CancelSearch(StoredModel * stored);
+void SetFilterNotification(IndexerCallback notify, void * context);
+ErrorType StartFilter(StoredModel * stored, DisplayedModel * displayed, char const * pattern, size_t patternLength,
+                      BOOL regex, BOOL refine);
+BOOL UpdateFilterProgress(StoredModel * stored, DisplayedModel * displayed);
+double GetFilterState(StoredModel const * stored, long long * linesNumber);
+void CancelFilter(StoredModel * stored);
+BOOL ClearFilter(StoredModel * stored, DisplayedModel * displayed);
+void SetTrigramNotification(IndexerCallback notify, void * context);
+ErrorType StartTrigramIndexing(StoredModel * stored);
+BOOL UpdateTrigramIndexing(StoredModel * stored);
+double GetTrigramIndexingProgress(StoredModel const * stored);
+
+#endif // TEXTMODEL_H_INCLUDED
@@ -0,0 +1,1022 @@
+#include "TextSearch.h"
+#include "Thread.h"
+#include "Regex.h"
+#include "TrigramIndex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SEARCH_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// vector kernels are compiled for their instruction sets regardless of compiler flags
+// and are called only if CPU supports them (see IsIndexerKernelSupported)
+#ifdef __GNUC__
+    #define SEARCH_TARGET(features) __attribute__((target(features)))
+    #define SEARCH_INLINE static inline __attribute__((always_inline))
+#else
+    #define SEARCH_TARGET(features)
+    #define SEARCH_INLINE static __forceinline
+#endif
+
+#define FIRST_SEARCH_SEGMENT_SIZE (1LL << 20)   // the first hits are published after searching this
+#define MAX_SEARCH_SEGMENT_SIZE (64LL << 20)    // segments grow twice up to this size
+#define MAX_STREAM_SEARCH_SEGMENT_SIZE (8LL << 20)  // limit of segments read into window buffer
+#define MIN_SEARCH_CHUNK_SIZE (1LL << 20)       // smaller chunks aren't worth a thread
+#define INITIAL_HITS_CAPACITY 256
+#define MAX_SEARCH_TASKS 64                     // the biggest number of chunks segment is splitted into
+#define MIN_PREFILTER_LENGTH 2                  // shorter literals of regex find too many candidates
+#define PREFILTER_BLOCK_SIZE (64LL << 10)       // candidates of regex are collected for this part of chunk at once
+
+typedef struct tag_SearchTask SearchTask;
+
+// function finding hits of chunk
+typedef void (*SearchKernel)(SearchTask * task);
+
+// part of segment searched by one thread
+struct tag_SearchTask {
+    char const * text;          // text of segment
+    long long base;             // index of text byte text begins with
+    long long begin;            // the first position of text hits may begin at
+    long long end;              // the position after the last one hits may begin at
+    long long size;             // size of text (the last line of chunk may continue after end up to it)
+    char const * pattern;       // searched string (required literal for regex search)
+    size_t patternLength;       // length of pattern (at least 1 unless it's regex search)
+    long long * hits;           // beginnings of found hits in entire text (ascending)
+    long long hitsNumber;       // number of found hits
+    long long capacity;         // number of hits memory is allocated for
+    SearchKernel kernel;        // function to search chunk with
+    SearchKernel literalKernel; // function finding candidates of regex by literal (NULL if literal isn't used)
+    RegexMatcher * matcher;     // regex checking lines of chunk (NULL if lines containing literal are hits)
+    long long const * ranges;   // runs of lines searched in entire text (NULL if whole chunk is searched)
+    long long rangesNumber;     // number of runs in ranges
+    BOOL failed;                // set if hits array can't grow
+};
+
+struct tag_TextSearch {
+    char const * data;          // searched text (NULL if it's read by segments)
+    TextReader read;            // function reading segments of text which isn't kept in memory
+    void * source;              // argument of read
+    char * window;              // buffer for segment read with pattern length bytes after it
+    long long maxSegmentSize;   // size segments grow up to
+    long long size;             // size of text
+    char * pattern;             // copy of searched string (required literal for regex search)
+    size_t patternLength;       // length of pattern
+    SearchKernel kernel;        // function checking candidates of chunk
+    Regex * regex;              // searched regex (NULL for string search)
+    BOOL lineHits;              // set if hits are beginnings of lines (regex and line search)
+    TrigramIndex const * trigrams;  // index of text blocks (NULL if all blocks are searched)
+    unsigned int * candidates;  // bitmap of blocks which may contain pattern (NULL if all blocks are searched)
+    long long * ranges;         // Array of [2 * rangesNumber] beginnings and ends of searched runs of lines (NULL if whole text is searched)
+    long long rangesNumber;     // number of runs in ranges
+    RegexMatcher * matchers[MAX_SEARCH_TASKS];  // matchers of chunks (created when they are needed)
+    int threadsNumber;          // number of threads searching each segment
+    IndexerCallback notify;     // function called after each searched segment (may be NULL)
+    void * context;             // argument of notify
+    ThreadHandle thread;        // background search thread
+
+    // fields below are guarded by mutex
+    Mutex mutex;
+    long long * hits;           // beginnings of hits found so far (ascending)
+    long long hitsNumber;       // number of found hits
+    long long capacity;         // number of hits memory is allocated for
+    long long scanned;          // number of bytes searched
+    BOOL cancelled;             // set to stop search
+    BOOL finished;              // set when hits won't change anymore
+    ErrorType errorType;        // result of search
+};
+
+/**
+ * Counts trailing zero bits of non-zero mask.
+ * IN:
+ * @param mask - mask to process (mustn't be 0)
+ *
+ * OUT:
+ * @return index of the lowest set bit
+ */
+SEARCH_INLINE int CountTrailingZeros(unsigned int mask) {
+#ifdef __GNUC__
+    return __builtin_ctz(mask);
+#else
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (int)bit;
+#endif
+}
+
+/**
+ * Saves hit found by kernel.
+ * IN:
+ * @param task - pointer to task of chunk
+ * @param position - index of the first byte of hit in segment text
+ *
+ * OUT:
+ * task->hits gets hit beginning in entire text
+ * task->failed is set if there's not enough memory
+ */
+static void AddHit(SearchTask * task, long long position) {
+    long long capacity;
+    long long * hits;
+
+    if (task->hitsNumber == task->capacity) {
+        capacity = (task->capacity > 0) ? task->capacity * 2 : INITIAL_HITS_CAPACITY;
+        hits = (long long*)realloc(task->hits, (size_t)capacity * sizeof(long long));
+        if (hits == NULL) {
+            task->failed = TRUE;
+            return;
+        }
+        task->hits     = hits;
+        task->capacity = capacity;
+    }
+    task->hits[task->hitsNumber++] = task->base + position;
+}
+
+/**
+ * Finds candidates by the first byte of pattern with memchr and verifies them.
+ * IN:
+ * @param task - pointer to task of chunk
+ *
+ * OUT:
+ * task->hits gets hits of chunk
+ */
+static void SearchScalar(SearchTask * task) {
+    char const * text = task->text;
+    char const * found;
+    long long position = task->begin;
+
+    while (position < task->end && !task->failed) {
+        found = (char const *)memchr(text + position, task->pattern[0], (size_t)(task->end - position));
+        if (found == NULL)
+            break;
+        position = found - text;
+        if (memcmp(found + 1, task->pattern + 1, task->patternLength - 1) == 0)
+            AddHit(task, position);
+        ++position;
+    }
+}
+
+#ifdef SEARCH_X86
+/* vector kernels compare the first and the last bytes of pattern with 16 or 32 positions at once,
+ * so only positions matching both of them are verified: rare for real text even if the first byte is common */
+
+SEARCH_TARGET("sse2")
+static void SearchSse2(SearchTask * task) {
+    char const * text = task->text;
+    size_t last = task->patternLength - 1;
+    __m128i const first = _mm_set1_epi8(task->pattern[0]);
+    __m128i const final = _mm_set1_epi8(task->pattern[last]);
+    unsigned int mask;
+    long long position, candidate;
+
+    for (position = task->begin; position + 16 <= task->end; position += 16) {
+        mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+                   _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const *)(text + position)), first),
+                   _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const *)(text + position + last)), final)));
+        for (; mask != 0; mask &= mask - 1) {
+            candidate = position + CountTrailingZeros(mask);
+            if (memcmp(text + candidate + 1, task->pattern + 1, last) == 0)
+                AddHit(task, candidate);
+        }
+        if (task->failed)
+            return;
+    }
+    task->begin = position;
+    SearchScalar(task);
+}
+
+SEARCH_TARGET("avx2")
+static void SearchAvx2(SearchTask * task) {
+    char const * text = task->text;
+    size_t last = task->patternLength - 1;
+    __m256i const first = _mm256_set1_epi8(task->pattern[0]);
+    __m256i const final = _mm256_set1_epi8(task->pattern[last]);
+    unsigned int mask;
+    long long position, candidate;
+
+    for (position = task->begin; position + 32 <= task->end; position += 32) {
+        mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(
+                   _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const *)(text + position)), first),
+                   _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const *)(text + position + last)), final)));
+        for (; mask != 0; mask &= mask - 1) {
+            candidate = position + CountTrailingZeros(mask);
+            if (memcmp(text + candidate + 1, task->pattern + 1, last) == 0)
+                AddHit(task, candidate);
+        }
+        if (task->failed)
+            return;
+    }
+    task->begin = position;
+    SearchScalar(task);
+}
+#endif // SEARCH_X86
+
+/**
+ * Gives search function for kernel chosen for indexing (search has no AVX-512 and NEON kernels).
+ * IN:
+ * @param kernel - supported kernel
+ *
+ * OUT:
+ * @return pointer to search function
+ */
+static SearchKernel GetSearchKernel(IndexerKernel kernel) {
+    switch (kernel) {
+#ifdef SEARCH_X86
+    case INDEXER_KERNEL_SSE2:
+        return SearchSse2;
+    case INDEXER_KERNEL_AVX2:
+    case INDEXER_KERNEL_AVX512:
+        return SearchAvx2;
+#endif
+    default:
+        return SearchScalar;
+    }
+}
+
+/**
+ * Checks whether line begins at position.
+ * IN:
+ * @param text - text of segment
+ * @param position - index of byte in text (it's line beginning if it's 0)
+ * @param size - size of text
+ *
+ * OUT:
+ * @return TRUE if position follows line break ("\r" followed by "\n" isn't a break)
+ */
+static BOOL IsLineBeginning(char const * text, long long position, long long size) {
+    return position == 0 || text[position - 1] == '\n' ||
+           (text[position - 1] == '\r' && (position == size || text[position] != '\n'));
+}
+
+/**
+ * Moves position forward to the nearest line beginning.
+ * IN:
+ * @param text - text of segment
+ * @param position - index of byte in text
+ * @param limit - position isn't moved after this index
+ *
+ * OUT:
+ * @return beginning of line (limit if there's no line beginning before it)
+ */
+static long long AlignToLine(char const * text, long long position, long long limit) {
+    while (position < limit && !IsLineBeginning(text, position, limit))
+        ++position;
+    return position;
+}
+
+/**
+ * Gives beginning of the line after one containing position.
+ * IN:
+ * @param text - text of segment
+ * @param position - index of byte in text
+ * @param size - size of text
+ *
+ * OUT:
+ * @return beginning of the next line (size if it's the last line)
+ */
+static long long SkipLine(char const * text, long long position, long long size) {
+    while (position < size && text[position] != '\n' && text[position] != '\r')
+        ++position;
+    if (position + 1 < size && text[position] == '\r' && text[position + 1] == '\n')
+        ++position;
+    return (position < size) ? position + 1 : size;
+}
+
+/**
+ * Finds lines of chunk matching regex: if regex has required literal lines containing it
+ * are found with string search kernel and only they are checked by regex.
+ * Without regex all lines containing literal are hits (line search).
+ * IN:
+ * @param task - pointer to task of chunk (chunk consists of whole lines)
+ *
+ * OUT:
+ * task->hits gets beginnings of matching lines
+ */
+static void SearchRegex(SearchTask * task) {
+    SearchTask candidates = *task;
+    char const * text = task->text;
+    long long checked = task->begin;    // lines before this position are checked
+    long long last = task->size - (long long)task->patternLength;
+    long long position, lineBegin, i;
+
+    if (task->literalKernel == NULL) {
+        for (position = task->begin; position < task->end && !task->failed; position = SkipLine(text, position, task->size)) {
+            position = FindRegexLine(task->matcher, text, position, task->end, task->size);
+            if (position < 0)
+                break;
+            AddHit(task, position);
+        }
+        task->failed |= IsRegexMatcherFailed(task->matcher);
+        return;
+    }
+
+    // candidates are collected by blocks, so their array stays small
+    candidates.base     = 0;
+    candidates.hits     = NULL;
+    candidates.capacity = 0;
+    for (position = task->begin; position < task->end && position <= last && !task->failed; position = candidates.end) {
+        candidates.begin      = position;
+        candidates.end        = min(min(position + PREFILTER_BLOCK_SIZE, task->end), last + 1);
+        candidates.hitsNumber = 0;
+        task->literalKernel(&candidates);
+        task->failed |= candidates.failed;
+
+        for (i = 0; i < candidates.hitsNumber && !task->failed; ++i) {
+            if (candidates.hits[i] < checked)
+                continue;       // line of candidate is already checked
+            for (lineBegin = candidates.hits[i]; lineBegin > checked && !IsLineBeginning(text, lineBegin, task->size); --lineBegin)
+                ;
+            if (task->matcher == NULL || FindRegexLine(task->matcher, text, lineBegin, lineBegin + 1, task->size) >= 0)
+                AddHit(task, lineBegin);
+            checked = SkipLine(text, candidates.hits[i], task->size);
+        }
+    }
+    if (task->matcher != NULL)
+        task->failed |= IsRegexMatcherFailed(task->matcher);
+    free(candidates.hits);
+}
+
+/**
+ * Finds the first run of lines which ends after position with binary search.
+ * IN:
+ * @param ranges - beginnings and ends of runs (ascending)
+ * @param rangesNumber - number of runs
+ * @param position - index of byte in text
+ *
+ * OUT:
+ * @return number of run (rangesNumber if all runs end before position)
+ */
+static long long FindSearchRange(long long const * ranges, long long rangesNumber, long long position) {
+    long long low = 0;
+    long long high = rangesNumber;
+    long long middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (ranges[2 * middle + 1] <= position)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * Thread routine searching chunk of segment. If search has runs of lines only their parts lying in chunk are searched.
+ * IN:
+ * @param argument - pointer to SearchTask
+ *
+ * OUT:
+ * task hits get hits beginning in chunk
+ */
+static void SearchChunk(void * argument) {
+    SearchTask * task = (SearchTask*)argument;
+    long long begin = task->begin;
+    long long end = task->end;
+    long long range;
+
+    if (task->ranges == NULL) {
+        task->kernel(task);
+        return;
+    }
+    for (range = FindSearchRange(task->ranges, task->rangesNumber, task->base + begin);
+         range < task->rangesNumber && task->ranges[2 * range] - task->base < end && !task->failed; ++range) {
+        task->begin = max(begin, task->ranges[2 * range] - task->base);
+        task->end   = min(end, task->ranges[2 * range + 1] - task->base);
+        task->kernel(task);
+    }
+    task->begin = begin;
+    task->end   = end;
+}
+
+/**
+ * Gives size of window part consisting of whole lines.
+ * IN:
+ * @param window - text read into window
+ * @param length - number of read bytes
+ *
+ * OUT:
+ * @return position after the last line break (length if there's no line break, so too long lines are splitted)
+ */
+static long long CutToLine(char const * window, long long length) {
+    long long position;
+
+    // "\r" at the end of window may be followed by "\n" of the next segment
+    if (length > 0 && window[length - 1] == '\n')
+        return length;
+    for (position = length - 1; position > 0; --position) {
+        if (IsLineBeginning(window, position, length))
+            return position;
+    }
+    return length;
+}
+
+/**
+ * Finds hits beginning in segment of text: segment is splitted into chunks searched simultaneously,
+ * their hits are published in order. Segments and chunks of regex and line search consist of whole lines.
+ * IN:
+ * @param search - pointer to search
+ * @param begin - index of the first byte of segment
+ * @param end - index of the byte after segment
+ *
+ * OUT:
+ * @param end - gets index of the byte after searched part (it's moved to line beginning for regex and line search)
+ * search->hits gets hits beginning in segment
+ * @return code of error occured during searching (ERR_NO if successed)
+ */
+static ErrorType SearchSegment(TextSearch * search, long long begin, long long * end) {
+    SearchTask tasks[MAX_SEARCH_TASKS];
+    ErrorType errorType = ERR_NO;
+    char const * text = search->data;
+    long long base = 0;         // index of text byte text begins with
+    long long size = search->size;  // size of text
+    long long last = search->size - (long long)search->patternLength;  // the last position hit may begin at
+    long long segmentEnd = *end;
+    long long hitsNumber = 0;
+    long long capacity, length;
+    long long * hits;
+    int tasksNumber = search->threadsNumber;
+    int i;
+
+    if (!search->lineHits && segmentEnd > last + 1)
+        segmentEnd = last + 1;
+    if (begin >= segmentEnd)
+        return ERR_NO;
+
+    // hits beginning at the end of segment continue after it, lines of regex and line search mustn't be cut
+    if (text == NULL) {
+        base   = begin;
+        length = !search->lineHits ? segmentEnd - base + (long long)search->patternLength - 1 : segmentEnd - base;
+        if (!search->read(search->source, base, search->window, (size_t)length))
+            return ERR_READ;
+        text = search->window;
+        size = length;
+        if (search->lineHits && segmentEnd < search->size) {
+            size = CutToLine(text, length);
+            segmentEnd = *end = base + size;
+        }
+    }
+    else if (search->lineHits)
+        segmentEnd = *end = AlignToLine(text, segmentEnd, size);
+    begin      -= base;
+    segmentEnd -= base;
+
+    if (tasksNumber > (segmentEnd - begin) / MIN_SEARCH_CHUNK_SIZE)
+        tasksNumber = (int)((segmentEnd - begin) / MIN_SEARCH_CHUNK_SIZE);
+    if (tasksNumber > MAX_SEARCH_TASKS)
+        tasksNumber = MAX_SEARCH_TASKS;
+    if (tasksNumber < 1)
+        tasksNumber = 1;
+
+    memset(tasks, 0, sizeof(tasks));
+    for (i = 0; i < tasksNumber; ++i) {
+        tasks[i].text          = text;
+        tasks[i].base          = base;
+        tasks[i].begin         = begin + (long long)((double)(segmentEnd - begin) * i / tasksNumber);
+        tasks[i].end           = begin + (long long)((double)(segmentEnd - begin) * (i + 1) / tasksNumber);
+        tasks[i].size          = size;
+        tasks[i].pattern       = search->pattern;
+        tasks[i].patternLength = search->patternLength;
+        tasks[i].kernel        = search->kernel;
+        tasks[i].ranges        = search->ranges;
+        tasks[i].rangesNumber  = search->rangesNumber;
+
+        if (search->lineHits) {
+            if (search->regex != NULL && search->matchers[i] == NULL &&
+                CreateRegexMatcher(&search->matchers[i], search->regex) != ERR_NO)
+                return ERR_NOMEM;
+            tasks[i].begin         = AlignToLine(text, tasks[i].begin, segmentEnd);
+            tasks[i].kernel        = SearchRegex;
+            tasks[i].literalKernel = (search->patternLength > 0) ? search->kernel : NULL;
+            tasks[i].matcher       = search->matchers[i];
+            if (i > 0)
+                tasks[i - 1].end = tasks[i].begin;
+        }
+    }
+    tasks[tasksNumber - 1].end = segmentEnd;
+
+    if (tasksNumber > 1)
+        errorType = RunThreadTasks(tasks, sizeof(SearchTask), tasksNumber, SearchChunk);
+    else
+        SearchChunk(&tasks[0]);
+
+    for (i = 0; i < tasksNumber; ++i) {
+        if (tasks[i].failed)
+            errorType = ERR_NOMEM;
+        hitsNumber += tasks[i].hitsNumber;
+    }
+
+    // chunks are ordered, so hits stay sorted
+    LockMutex(&search->mutex);
+    if (errorType == ERR_NO && search->hitsNumber + hitsNumber > search->capacity) {
+        for (capacity = max(search->capacity, INITIAL_HITS_CAPACITY); capacity < search->hitsNumber + hitsNumber; capacity *= 2)
+            ;
+        hits = (long long*)realloc(search->hits, (size_t)capacity * sizeof(long long));
+        if (hits != NULL) {
+            search->hits     = hits;
+            search->capacity = capacity;
+        }
+        else
+            errorType = ERR_NOMEM;
+    }
+    for (i = 0; i < tasksNumber && errorType == ERR_NO && hitsNumber > 0; ++i) {
+        memcpy(search->hits + search->hitsNumber, tasks[i].hits, (size_t)tasks[i].hitsNumber * sizeof(long long));
+        search->hitsNumber += tasks[i].hitsNumber;
+    }
+    UnlockMutex(&search->mutex);
+
+    for (i = 0; i < tasksNumber; ++i)
+        free(tasks[i].hits);
+    return errorType;
+}
+
+/**
+ * Checks empty line after line break at the end of text: it begins at the end of text, so segments don't visit it.
+ * Only regex without required literal can match empty line.
+ * IN:
+ * @param search - pointer to search which has searched the rest of text
+ *
+ * OUT:
+ * search->hits gets end of text if empty line matches regex
+ * @return code of error occured during checking (ERR_NO if successed)
+ */
+static ErrorType SearchEmptyLastLine(TextSearch * search) {
+    long long * hits;
+    char last;
+
+    if (search->regex == NULL || search->patternLength > 0 || search->size == 0 ||
+        (search->ranges != NULL && (search->rangesNumber == 0 || search->ranges[2 * search->rangesNumber - 2] != search->size)))
+        return ERR_NO;
+    if (search->data != NULL)
+        last = search->data[search->size - 1];
+    else if (!search->read(search->source, search->size - 1, &last, 1))
+        return ERR_READ;
+    if (last != '\n' && last != '\r')
+        return ERR_NO;
+
+    // lines are matched independently, so empty line is checked without text
+    if (search->matchers[0] == NULL && CreateRegexMatcher(&search->matchers[0], search->regex) != ERR_NO)
+        return ERR_NOMEM;
+    if (FindRegexLine(search->matchers[0], "", 0, 1, 0) < 0)
+        return IsRegexMatcherFailed(search->matchers[0]) ? ERR_NOMEM : ERR_NO;
+
+    LockMutex(&search->mutex);
+    if (search->hitsNumber == search->capacity) {
+        hits = (long long*)realloc(search->hits, (size_t)(search->capacity + 1) * sizeof(long long));
+        if (hits == NULL) {
+            UnlockMutex(&search->mutex);
+            return ERR_NOMEM;
+        }
+        search->hits = hits;
+        search->capacity++;
+    }
+    search->hits[search->hitsNumber++] = search->size;
+    UnlockMutex(&search->mutex);
+    return ERR_NO;
+}
+
+/**
+ * Thread routine searching text by segments and publishing hits after each of them.
+ * IN:
+ * @param argument - pointer to TextSearch
+ *
+ * OUT:
+ * search->hits get all hits (or hits of text part if search is cancelled or failed)
+ */
+static void SearchInBackground(void * argument) {
+    TextSearch * search = (TextSearch*)argument;
+    ErrorType errorType = ERR_NO;
+    long long segmentSize = FIRST_SEARCH_SEGMENT_SIZE;
+    long long limit = (search->candidates != NULL || search->ranges != NULL) ? 0 : search->size;    // end of current run
+    long long block = 0;
+    long long range = 0;
+    long long next;
+    long long blocksNumber = (search->candidates != NULL) ? GetTrigramBlocksNumber(search->trigrams) : 0;
+    long long begin, end;
+    BOOL cancelled = FALSE;
+
+    for (begin = 0; begin < search->size; begin = end) {
+        LockMutex(&search->mutex);
+        cancelled = search->cancelled;
+        UnlockMutex(&search->mutex);
+        if (cancelled)
+            break;
+
+        // segment begins with searched run of lines and takes the next runs which fit into it,
+        // so short runs are searched together (text between them is skipped by tasks)
+        if (search->ranges != NULL) {
+            while (range < search->rangesNumber && search->ranges[2 * range + 1] <= begin)
+                ++range;
+            if (range == search->rangesNumber)
+                break;
+            begin = max(begin, search->ranges[2 * range]);
+            limit = search->ranges[2 * range + 1];
+            for (next = range + 1; next < search->rangesNumber && search->ranges[2 * next + 1] - begin <= segmentSize; ++next)
+                limit = search->ranges[2 * next + 1];
+        }
+        // blocks without trigrams of pattern are skipped
+        else if (begin >= limit) {
+            while (block < blocksNumber && (search->candidates[block >> 5] & (1u << (block & 31))) == 0)
+                ++block;
+            if (block == blocksNumber)
+                break;
+            begin = GetTrigramBlockBeginning(search->trigrams, block);
+            while (block < blocksNumber && (search->candidates[block >> 5] & (1u << (block & 31))) != 0)
+                ++block;
+            limit = GetTrigramBlockBeginning(search->trigrams, block);
+        }
+
+        end = (limit - begin > segmentSize) ? begin + segmentSize : limit;
+        errorType = SearchSegment(search, begin, &end);
+        if (errorType != ERR_NO)
+            break;
+
+        if (end < search->size) {
+            LockMutex(&search->mutex);
+            search->scanned = end;
+            UnlockMutex(&search->mutex);
+            if (search->notify != NULL)
+                search->notify(search->context);
+        }
+        if (segmentSize < search->maxSegmentSize)
+            segmentSize *= 2;
+    }
+    if (errorType == ERR_NO && !cancelled)
+        errorType = SearchEmptyLastLine(search);
+
+    LockMutex(&search->mutex);
+    search->scanned   = search->size;
+    search->finished  = TRUE;
+    search->errorType = errorType;
+    UnlockMutex(&search->mutex);
+
+    if (search->notify != NULL)
+        search->notify(search->context);
+}
+
+/**
+ * Creates search and starts it's background thread.
+ * IN:
+ * @param data - text to search (NULL if it's read with read function)
+ * @param read - function reading segments of text (used if data is NULL)
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ * @param pattern - string to find or required literal of regex (it's copied)
+ * @param patternLength - length of pattern (0 if regex has no literal to find)
+ * @param regex - regex lines have to match (NULL for string search), search owns it even if it isn't started
+ * @param lineHits - TRUE if hits are beginnings of lines (it's set for regex search)
+ * @param ranges - runs of lines to search (NULL if whole text is searched), search owns it even if it isn't started
+ * @param rangesNumber - number of runs in ranges
+ * @param trigrams - index of text narrowing search to blocks containing pattern (may be NULL, unused with ranges)
+ * @param options - kernel and number of threads to search with (NULL means default ones)
+ * @param notify - function called from search thread after new hits are published (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param search - gets pointer to started search
+ * @return code of error occured during starting (ERR_NO if successed)
+ */
+static ErrorType CreateTextSearch(TextSearch ** search, char const * data, TextReader read, void * source, long long size,
+                                  char const * pattern, size_t patternLength, Regex * regex, BOOL lineHits,
+                                  long long * ranges, long long rangesNumber, TrigramIndex const * trigrams,
+                                  IndexerOptions const * options, IndexerCallback notify, void * context) {
+    TextSearch * created;
+    IndexerKernel kernel = (options != NULL) ? options->kernel : INDEXER_KERNEL_AUTO;
+    ErrorType errorType;
+
+    created = (TextSearch*)calloc(1, sizeof(TextSearch));
+    if (created == NULL) {
+        DestroyRegex(regex);
+        free(ranges);
+        return ERR_NOMEM;
+    }
+    created->data           = data;
+    created->read           = read;
+    created->source         = source;
+    created->maxSegmentSize = (data != NULL) ? MAX_SEARCH_SEGMENT_SIZE : MAX_STREAM_SEARCH_SEGMENT_SIZE;
+    created->size           = size;
+    created->patternLength  = patternLength;
+    created->regex          = regex;
+    created->lineHits       = lineHits || regex != NULL;
+    created->ranges         = ranges;
+    created->rangesNumber   = rangesNumber;
+    created->trigrams       = trigrams;
+    created->threadsNumber  = (options != NULL) ? options->threadsNumber : 0;
+    created->notify         = notify;
+    created->context        = context;
+    if (kernel == INDEXER_KERNEL_AUTO || !IsIndexerKernelSupported(kernel))
+        kernel = DetectIndexerKernel();
+    created->kernel = GetSearchKernel(kernel);
+    if (created->threadsNumber <= 0)
+        created->threadsNumber = GetHardwareConcurrency();
+
+    // window holds the biggest segment and the rest of hit beginning at it's end
+    created->pattern = (char*)malloc(patternLength + 1);
+    if (data == NULL)
+        created->window = (char*)malloc((size_t)min(size, created->maxSegmentSize) + patternLength + 1);
+    if (created->pattern == NULL || (data == NULL && created->window == NULL)) {
+        free(created->pattern);
+        free(created->window);
+        free(created);
+        DestroyRegex(regex);
+        free(ranges);
+        return ERR_NOMEM;
+    }
+    memcpy(created->pattern, pattern, patternLength);
+
+    // index of another version of file can't be used
+    if (trigrams != NULL && ranges == NULL && GetTrigramIndexedSize(trigrams) == size)
+        created->candidates = FindTrigramCandidates(trigrams, pattern, patternLength);
+
+    errorType = InitMutex(&created->mutex);
+    if (errorType == ERR_NO) {
+        errorType = StartThread(&created->thread, SearchInBackground, created);
+        if (errorType != ERR_NO)
+            DestroyMutex(&created->mutex);
+    }
+    if (errorType != ERR_NO) {
+        free(created->candidates);
+        free(created->pattern);
+        free(created->window);
+        free(created);
+        DestroyRegex(regex);
+        free(ranges);
+        return errorType;
+    }
+
+    *search = created;
+    return ERR_NO;
+}
+
+/**
+ * Starts background thread finding all occurences of string in text.
+ * Hits are published by segments in ascending order, so the first ones can be shown
+ * before the whole text is searched. Each segment is searched by several threads.
+ * IN:
+ * @param data - text to search (NULL if it's read with read function)
+ * @param read - function reading segments of text (used if data is NULL)
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ * @param pattern - string to find (it's copied)
+ * @param patternLength - length of pattern (at least 1)
+ * @param trigrams - index of text narrowing search to blocks containing pattern (may be NULL)
+ * @param options - kernel and number of threads to search with (NULL means default ones)
+ * @param notify - function called from search thread after new hits are published (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param search - gets pointer to started search (it has to be destroyed with DestroyTextSearch)
+ * @return code of error occured during starting (ERR_NO if successed)
+ */
+ErrorType StartTextSearch(TextSearch ** search, char const * data, TextReader read, void * source, long long size,
+                          char const * pattern, size_t patternLength, TrigramIndex const * trigrams,
+                          IndexerOptions const * options, IndexerCallback notify, void * context) {
+    if (search == NULL || pattern == NULL || patternLength == 0 || size < 0 || (data == NULL && read == NULL && size > 0))
+        return ERR_NULL_PTR;
+
+    return CreateTextSearch(search, data, read, source, size, pattern, patternLength, NULL, FALSE, NULL, 0, trigrams,
+                            options, notify, context);
+}
+
+/**
+ * Starts background thread finding all lines of text matching regular expression (see syntax in Regex.h).
+ * Hits are beginnings of matching lines, they are published like hits of string search.
+ * Lines containing required literal of regex are found by string search kernel before regex is run.
+ * IN:
+ * @param data - text to search (NULL if it's read with read function)
+ * @param read - function reading segments of text (used if data is NULL)
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ * @param pattern - regular expression
+ * @param patternLength - length of pattern
+ * @param trigrams - index of text narrowing search to blocks containing literal of regex (may be NULL)
+ * @param options - kernel and number of threads to search with (NULL means default ones)
+ * @param notify - function called from search thread after new hits are published (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param search - gets pointer to started search (it has to be destroyed with DestroyTextSearch)
+ * @return ERR_REGEX if pattern is malformed, other code of error occured during starting (ERR_NO if successed)
+ */
+ErrorType StartRegexSearch(TextSearch ** search, char const * data, TextReader read, void * source, long long size,
+                           char const * pattern, size_t patternLength, TrigramIndex const * trigrams,
+                           IndexerOptions const * options, IndexerCallback notify, void * context) {
+    Regex * regex;
+    ErrorType errorType;
+    char const * literal;
+    size_t literalLength;
+
+    if (search == NULL || pattern == NULL || size < 0 || (data == NULL && read == NULL && size > 0))
+        return ERR_NULL_PTR;
+
+    errorType = CompileRegex(&regex, pattern, patternLength);
+    if (errorType != ERR_NO)
+        return errorType;
+    literal = GetRegexLiteral(regex, &literalLength);
+    if (literalLength < MIN_PREFILTER_LENGTH)
+        literalLength = 0;
+
+    return CreateTextSearch(search, data, read, source, size, literal, literalLength, regex, TRUE, NULL, 0, trigrams,
+                            options, notify, context);
+}
+
+/**
+ * Starts background thread finding all lines of text containing string or matching regular expression.
+ * Hits are beginnings of found lines, they are published like hits of string search.
+ * Search may be narrowed to runs of lines (e.g. lines found by previous search), text between them isn't read.
+ * IN:
+ * @param data - text to search (NULL if it's read with read function)
+ * @param read - function reading segments of text (used if data is NULL)
+ * @param source - argument of read
+ * @param size - size of text in bytes
+ * @param pattern - string lines have to contain or regular expression they have to match
+ * @param patternLength - length of pattern (at least 1 for string)
+ * @param regex - TRUE if pattern is regular expression (see syntax in Regex.h)
+ * @param ranges - Array of [2 * rangesNumber] ascending beginnings and ends of runs of whole lines to search
+ * (NULL if whole text is searched), search owns it even if it isn't started
+ * @param rangesNumber - number of runs in ranges
+ * @param trigrams - index of text narrowing search to blocks containing pattern (may be NULL, unused with ranges)
+ * @param options - kernel and number of threads to search with (NULL means default ones)
+ * @param notify - function called from search thread after new hits are published (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param search - gets pointer to started search (it has to be destroyed with DestroyTextSearch)
+ * @return ERR_REGEX if pattern is malformed, other code of error occured during starting (ERR_NO if successed)
+ */
+ErrorType StartLineSearch(TextSearch ** search, char const * data, TextReader read, void * source, long long size,
+                          char const * pattern, size_t patternLength, BOOL regex, long long * ranges, long long rangesNumber,
+                          TrigramIndex const * trigrams, IndexerOptions const * options, IndexerCallback notify, void * context) {
+    Regex * compiled = NULL;
+    ErrorType errorType;
+    char const * literal = pattern;
+    size_t literalLength = patternLength;
+
+    if (search == NULL || pattern == NULL || (!regex && patternLength == 0) || size < 0 || rangesNumber < 0 ||
+        (ranges == NULL && rangesNumber > 0) || (data == NULL && read == NULL && size > 0)) {
+        free(ranges);
+        return ERR_NULL_PTR;
+    }
+
+    if (regex) {
+        errorType = CompileRegex(&compiled, pattern, patternLength);
+        if (errorType != ERR_NO) {
+            free(ranges);
+            return errorType;
+        }
+        literal = GetRegexLiteral(compiled, &literalLength);
+        if (literalLength < MIN_PREFILTER_LENGTH)
+            literalLength = 0;
+    }
+    return CreateTextSearch(search, data, read, source, size, literal, literalLength, compiled, TRUE, ranges, rangesNumber,
+                            trigrams, options, notify, context);
+}
+
+/**
+ * Gives number of hits found so far.
+ * IN:
+ * @param search - pointer to search
+ *
+ * OUT:
+ * @return number of hits
+ */
+long long GetSearchHitsNumber(TextSearch * search) {
+    long long hitsNumber;
+
+    LockMutex(&search->mutex);
+    hitsNumber = search->hitsNumber;
+    UnlockMutex(&search->mutex);
+    return hitsNumber;
+}
+
+/**
+ * Gives beginning of hit.
+ * IN:
+ * @param search - pointer to search
+ * @param hitNumber - number of hit in ascending order
+ *
+ * OUT:
+ * @return index of the first byte of hit in text (-1 if there's no such hit found yet)
+ */
+long long GetSearchHit(TextSearch * search, long long hitNumber) {
+    long long position = -1;
+
+    LockMutex(&search->mutex);
+    if (hitNumber >= 0 && hitNumber < search->hitsNumber)
+        position = search->hits[hitNumber];
+    UnlockMutex(&search->mutex);
+    return position;
+}
+
+/**
+ * Finds the first hit beginning not before specified position with binary search.
+ * IN:
+ * @param search - pointer to search
+ * @param position - index of byte in text
+ *
+ * OUT:
+ * @return number of hit (number of hits found so far if there's no such hit)
+ */
+long long FindSearchHit(TextSearch * search, long long position) {
+    long long low = 0;
+    long long high, middle;
+
+    LockMutex(&search->mutex);
+    for (high = search->hitsNumber; low < high; ) {
+        middle = low + (high - low) / 2;
+        if (search->hits[middle] < position)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    UnlockMutex(&search->mutex);
+    return low;
+}
+
+/**
+ * Gives length of searched string.
+ * IN:
+ * @param search - pointer to search
+ *
+ * OUT:
+ * @return length of pattern (0 for regex and line search, their hits are line beginnings)
+ */
+size_t GetSearchPatternLength(TextSearch const * search) {
+    return !search->lineHits ? search->patternLength : 0;
+}
+
+/**
+ * Gives part of text which is already searched.
+ * IN:
+ * @param search - pointer to search
+ *
+ * OUT:
+ * @return number from 0 to 1
+ */
+double GetSearchProgress(TextSearch * search) {
+    double progress;
+
+    LockMutex(&search->mutex);
+    progress = (search->size > 0) ? (double)search->scanned / search->size : 1.0;
+    UnlockMutex(&search->mutex);
+    return progress;
+}
+
+/**
+ * Checks whether all hits are found.
+ * IN:
+ * @param search - pointer to search
+ *
+ * OUT:
+ * @param errorType - gets code of error occured during search if it's finished (may be NULL)
+ * @return TRUE if hits won't change anymore
+ */
+BOOL IsTextSearchFinished(TextSearch * search, ErrorType * errorType) {
+    BOOL finished;
+
+    LockMutex(&search->mutex);
+    finished = search->finished;
+    if (finished && errorType != NULL)
+        *errorType = search->errorType;
+    UnlockMutex(&search->mutex);
+    return finished;
+}
+
+/**
+ * Asks search thread to stop. Hits found so far stay available.
+ * IN:
+ * @param search - pointer to search
+ */
+void CancelTextSearch(TextSearch * search) {
+    LockMutex(&search->mutex);
+    search->cancelled = TRUE;
+    UnlockMutex(&search->mutex);
+}
+
+/**
+ * Stops search, waits for search thread and frees memory of search.
+ * IN:
+ * @param search - pointer to search (may be NULL)
+ */
+void DestroyTextSearch(TextSearch * search) {
+    int i;
+
+    if (search == NULL)
+        return;
+
+    CancelTextSearch(search);
+    JoinThread(search->thread);
+    DestroyMutex(&search->mutex);
+    for (i = 0; i < MAX_SEARCH_TASKS; ++i)
+        DestroyRegexMatcher(search->matchers[i]);
+    DestroyRegex(search->regex);
+    free(search->candidates);
+    free(search->ranges);
+    free(search->hits);
+    free(search->pattern);
+    free(search->window);
+    free(search);
+}
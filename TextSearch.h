@@ -0,0 +1,30 @@
+#ifndef TEXTSEARCH_H_INCLUDED
+#define TEXTSEARCH_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+#include "LineIndexer.h"
+#include "TrigramIndex.h"
+
+typedef struct tag_TextSearch TextSearch;
+
+ErrorType StartTextSearch(TextSearch ** search, char const * data, TextReader read, void * source, long long size,
+                          char const * pattern, size_t patternLength, TrigramIndex const * trigrams,
+                          IndexerOptions const * options, IndexerCallback notify, void * context);
+ErrorType StartRegexSearch(TextSearch ** search, char const * data, TextReader read, void * source, long long size,
+                           char const * pattern, size_t patternLength, TrigramIndex const * trigrams,
+                           IndexerOptions const * options, IndexerCallback notify, void * context);
+ErrorType StartLineSearch(TextSearch ** search, char const * data, TextReader read, void * source, long long size,
+                          char const * pattern, size_t patternLength, BOOL regex, long long * ranges, long long rangesNumber,
+                          TrigramIndex const * trigrams, IndexerOptions const * options, IndexerCallback notify, void * context);
+long long GetSearchHitsNumber(TextSearch * search);
+long long GetSearchHit(TextSearch * search, long long hitNumber);
+long long FindSearchHit(TextSearch * search, long long position);
+size_t GetSearchPatternLength(TextSearch const * search);
+double GetSearchProgress(TextSearch * search);
+BOOL IsTextSearchFinished(TextSearch * search, ErrorType * errorType);
+void CancelTextSearch(TextSearch * search);
+void DestroyTextSearch(TextSearch * search);
+
+#endif // TEXTSEARCH_H_INCLUDED
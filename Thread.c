@@ -0,0 +1,190 @@
+#include "Thread.h"
+#include <stdlib.h>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+typedef struct {
+    ThreadRoutine routine;
+    void * argument;
+} ThreadStart;
+
+/**
+ * Entry point of started threads: calls routine passed to StartThread.
+ * IN:
+ * @param parameter - pointer to ThreadStart structure allocated by StartThread (freed here)
+ */
+#ifdef _WIN32
+static DWORD WINAPI ThreadEntry(LPVOID parameter) {
+#else
+static void * ThreadEntry(void * parameter) {
+#endif
+    ThreadStart start = *(ThreadStart*)parameter;
+
+    free(parameter);
+    start.routine(start.argument);
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * Starts new thread executing routine.
+ * IN:
+ * @param routine - function to execute in new thread
+ * @param argument - argument to pass to routine
+ *
+ * OUT:
+ * @param thread - gets handle of started thread (it has to be joined with JoinThread)
+ * @return code of error occured during starting thread (ERR_NO if successed)
+ */
+ErrorType StartThread(ThreadHandle * thread, ThreadRoutine routine, void * argument) {
+    ThreadStart * start;
+
+    if (thread == NULL || routine == NULL)
+        return ERR_NULL_PTR;
+
+    start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    if (start == NULL)
+        return ERR_NOMEM;
+    start->routine  = routine;
+    start->argument = argument;
+
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, ThreadEntry, start, 0, NULL);
+    if (*thread == NULL) {
+        free(start);
+        return ERR_THREAD;
+    }
+#else
+    if (pthread_create(thread, NULL, ThreadEntry, start) != 0) {
+        free(start);
+        return ERR_THREAD;
+    }
+#endif
+    return ERR_NO;
+}
+
+/**
+ * Waits for thread to finish and releases it's handle.
+ * IN:
+ * @param thread - handle of thread started with StartThread
+ */
+void JoinThread(ThreadHandle thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+/**
+ * Runs routine for each task: the last task is processed in calling thread, the others in new threads.
+ * IN:
+ * @param tasks - array of tasks
+ * @param taskSize - size of each task in bytes
+ * @param tasksNumber - number of tasks
+ * @param routine - routine to run with pointer to task
+ *
+ * OUT:
+ * @return ERR_NOMEM if there's not enough memory for threads handles (ERR_NO if successed)
+ */
+ErrorType RunThreadTasks(void * tasks, size_t taskSize, int tasksNumber, ThreadRoutine routine) {
+    ThreadHandle * threads;
+    int started, i;
+
+    if (tasksNumber <= 0)
+        return ERR_NO;
+    threads = (ThreadHandle*)malloc(tasksNumber * sizeof(ThreadHandle));
+    if (threads == NULL)
+        return ERR_NOMEM;
+
+    for (started = 0; started < tasksNumber - 1; ++started) {
+        if (StartThread(&threads[started], routine, (char*)tasks + started * taskSize) != ERR_NO)
+            break;
+    }
+    // if some threads haven't started their tasks are processed here
+    for (i = started; i < tasksNumber; ++i)
+        routine((char*)tasks + i * taskSize);
+    for (i = 0; i < started; ++i)
+        JoinThread(threads[i]);
+
+    free(threads);
+    return ERR_NO;
+}
+
+/**
+ * Gives number of logical processors available.
+ * OUT:
+ * @return number of logical processors (at least 1)
+ */
+int GetHardwareConcurrency(void) {
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwNumberOfProcessors > 0 ? (int)systemInfo.dwNumberOfProcessors : 1;
+#else
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? (int)processors : 1;
+#endif
+}
+
+/**
+ * Initializes mutex.
+ * IN:
+ * @param mutex - pointer to mutex to initialize (it has to be destroyed with DestroyMutex)
+ *
+ * OUT:
+ * @return code of error occured during initialization (ERR_NO if successed)
+ */
+ErrorType InitMutex(Mutex * mutex) {
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+    return ERR_NO;
+#else
+    return pthread_mutex_init(mutex, NULL) == 0 ? ERR_NO : ERR_THREAD;
+#endif
+}
+
+/**
+ * Releases resources of unlocked mutex.
+ * IN:
+ * @param mutex - pointer to mutex initialized with InitMutex
+ */
+void DestroyMutex(Mutex * mutex) {
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+/**
+ * Waits until mutex is unlocked and locks it.
+ * IN:
+ * @param mutex - pointer to mutex initialized with InitMutex
+ */
+void LockMutex(Mutex * mutex) {
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+/**
+ * Unlocks mutex locked by calling thread.
+ * IN:
+ * @param mutex - pointer to mutex locked with LockMutex
+ */
+void UnlockMutex(Mutex * mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
@@ -0,0 +1,31 @@
+#ifndef THREAD_H_INCLUDED
+#define THREAD_H_INCLUDED
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+#include <stddef.h>
+#include "Error.h"
+
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+typedef CRITICAL_SECTION Mutex;
+#else
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t Mutex;
+#endif
+
+typedef void (*ThreadRoutine)(void * argument);
+
+ErrorType StartThread(ThreadHandle * thread, ThreadRoutine routine, void * argument);
+void JoinThread(ThreadHandle thread);
+ErrorType RunThreadTasks(void * tasks, size_t taskSize, int tasksNumber, ThreadRoutine routine);
+int GetHardwareConcurrency(void);
+ErrorType InitMutex(Mutex * mutex);
+void DestroyMutex(Mutex * mutex);
+void LockMutex(Mutex * mutex);
+void UnlockMutex(Mutex * mutex);
+
+#endif // THREAD_H_INCLUDED
@@ -0,0 +1,386 @@
+#include "Trace.h"
+#include "Portable.h"
+#include "Thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+    #define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+    #define TRACE_THREAD_LOCAL __thread
+#endif
+
+#define INITIAL_RING_CAPACITY 256       // events thread ring takes at first (worker threads record few events)
+#define MAX_RING_CAPACITY 65536         // events kept per thread, the oldest ones are overwritten after that
+#define MAX_SUMMARY_NAMES 64            // distinct names PrintTraceSummary reports
+#define HISTOGRAM_BUCKETS 24            // buckets of scope durations: below 1 us, then doubling from 1 us
+#define HISTOGRAM_BAR_WIDTH 40
+
+typedef enum {
+    TRACE_EVENT_SCOPE,
+    TRACE_EVENT_COUNTER
+} TraceEventKind;
+
+typedef struct {
+    char const * name;          // Name of scope or counter (string literal)
+    long long time;             // Beginning of scope or moment of counter sample in ns (see GetTraceTime)
+    long long value;            // Duration of scope in ns or value of counter
+    TraceEventKind kind;
+} TraceEvent;
+
+typedef struct tag_TraceRing TraceRing;
+
+// events of one thread, only the thread itself writes them
+struct tag_TraceRing {
+    TraceEvent * events;        // Array of recorded events, event number i is kept at [i % capacity]
+    long long written;          // Number of events recorded by thread (only the last capacity ones are kept)
+    long long capacity;         // Number of items memory of events is allocated for
+    int threadNumber;           // Number of thread in order of the first recorded event (tid in trace)
+    TraceRing * next;           // Ring of thread which has started recording before
+};
+
+static TraceRing * rings = NULL;                        // rings of all threads, the latest registered first
+static Mutex ringsMutex;
+static BOOL ringsMutexReady = FALSE;
+static volatile int tracing = 0;                        // events are recorded only between StartTrace and StopTrace
+static long long traceOrigin = 0;                       // time StartTrace was called at
+static int threadsNumber = 0;
+static int generation = 0;                              // number of DestroyTrace calls: rings of older generations are freed
+static TRACE_THREAD_LOCAL TraceRing * threadRing = NULL;
+static TRACE_THREAD_LOCAL int threadGeneration = -1;
+
+/**
+ * Gives current value of monotonic clock.
+ * OUT:
+ * @return time in nanoseconds
+ */
+long long GetTraceTime(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return counter.QuadPart / frequency.QuadPart * 1000000000LL +
+           counter.QuadPart % frequency.QuadPart * 1000000000LL / frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+#endif
+}
+
+/**
+ * Starts recording events. Events recorded before are kept.
+ * OUT:
+ * @return code of error occured during initialization (ERR_NO if successed)
+ */
+ErrorType StartTrace(void) {
+    ErrorType errorType;
+
+    if (!ringsMutexReady) {
+        errorType = InitMutex(&ringsMutex);
+        if (errorType != ERR_NO)
+            return errorType;
+        ringsMutexReady = TRUE;
+        traceOrigin = GetTraceTime();
+    }
+    tracing = 1;
+    return ERR_NO;
+}
+
+/**
+ * Stops recording events, recorded ones are kept for SaveTrace and PrintTraceSummary.
+ */
+void StopTrace(void) {
+    tracing = 0;
+}
+
+/**
+ * Stops recording and frees recorded events. Traced threads have to be finished or idle.
+ */
+void DestroyTrace(void) {
+    TraceRing * next;
+
+    tracing = 0;
+    while (rings != NULL) {
+        next = rings->next;
+        free(rings->events);
+        free(rings);
+        rings = next;
+    }
+    if (ringsMutexReady)
+        DestroyMutex(&ringsMutex);
+    ringsMutexReady = FALSE;
+    threadsNumber = 0;
+    generation++;
+}
+
+/**
+ * Gives place for the next event of calling thread, ring of thread is registered on the first call.
+ * OUT:
+ * @return pointer to event to fill (NULL if there's no memory for ring)
+ */
+static TraceEvent * AddTraceEvent(void) {
+    TraceRing * ring = threadRing;
+    TraceEvent * events;
+
+    if (ring == NULL || threadGeneration != generation) {
+        ring = (TraceRing*)calloc(1, sizeof(TraceRing));
+        if (ring == NULL)
+            return NULL;
+        LockMutex(&ringsMutex);
+        ring->threadNumber = ++threadsNumber;
+        ring->next = rings;
+        rings = ring;
+        UnlockMutex(&ringsMutex);
+        threadRing       = ring;
+        threadGeneration = generation;
+    }
+
+    // ring grows until it's full, then the oldest events are overwritten
+    if (ring->written == ring->capacity && ring->capacity < MAX_RING_CAPACITY) {
+        events = (TraceEvent*)realloc(ring->events, (size_t)max(INITIAL_RING_CAPACITY, ring->capacity * 2) * sizeof(TraceEvent));
+        if (events != NULL) {
+            ring->events   = events;
+            ring->capacity = max(INITIAL_RING_CAPACITY, ring->capacity * 2);
+        }
+    }
+    if (ring->capacity == 0)
+        return NULL;
+    return &ring->events[ring->written++ % ring->capacity];
+}
+
+/**
+ * Records scope of calling thread which ends now (see TRACE_START, TRACE_STOP).
+ * IN:
+ * @param name - name of scope (string literal)
+ * @param start - time scope has begun at (see GetTraceTime)
+ */
+void TraceScope(char const * name, long long start) {
+    long long now;
+    TraceEvent * event;
+
+    if (!tracing)
+        return;
+    now = GetTraceTime();
+    if ((event = AddTraceEvent()) == NULL)
+        return;
+    event->name  = name;
+    event->time  = start;
+    event->value = now - start;
+    event->kind  = TRACE_EVENT_SCOPE;
+}
+
+/**
+ * Records amount of work done by calling thread now, e.g. rows painted in a frame (see TRACE_COUNTER).
+ * IN:
+ * @param name - name of counter (string literal)
+ * @param value - value of counter
+ */
+void TraceCounter(char const * name, long long value) {
+    TraceEvent * event;
+
+    if (!tracing || (event = AddTraceEvent()) == NULL)
+        return;
+    event->name  = name;
+    event->time  = GetTraceTime();
+    event->value = value;
+    event->kind  = TRACE_EVENT_COUNTER;
+}
+
+/**
+ * Gives the oldest event of ring which is still kept.
+ * IN:
+ * @param ring - pointer to ring of thread
+ *
+ * OUT:
+ * @return number of event (events from it to ring->written are kept)
+ */
+static long long GetFirstKeptEvent(TraceRing const * ring) {
+    return max(0, ring->written - ring->capacity);
+}
+
+/**
+ * Writes recorded events as Chrome trace: scopes are complete ("X") events, counters are counter ("C") events.
+ * Traced threads have to be idle while trace is written.
+ * IN:
+ * @param filename - name of JSON file to write
+ *
+ * OUT:
+ * @return code of error occured during writing (ERR_NO if successed)
+ */
+ErrorType SaveTrace(char const * filename) {
+    TraceRing const * ring;
+    TraceEvent const * event;
+    FILE * file;
+    long long i;
+    BOOL first = TRUE;
+
+    if (filename == NULL)
+        return ERR_NULL_PTR;
+    file = fopen(filename, "w");
+    if (file == NULL)
+        return ERR_OPEN_FILE;
+
+    fprintf(file, "{\"traceEvents\":[");
+    for (ring = rings; ring != NULL; ring = ring->next) {
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",", ring->threadNumber, ring->threadNumber);
+        first = FALSE;
+        for (i = GetFirstKeptEvent(ring); i < ring->written; ++i) {
+            event = &ring->events[i % ring->capacity];
+            if (event->kind == TRACE_EVENT_SCOPE)
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                        event->name, (event->time - traceOrigin) / 1000.0, event->value / 1000.0, ring->threadNumber);
+            else
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%lld}}",
+                        event->name, (event->time - traceOrigin) / 1000.0, ring->threadNumber, event->value);
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    if (ferror(file)) {
+        fclose(file);
+        return ERR_WRITE;
+    }
+    return (fclose(file) == 0) ? ERR_NO : ERR_WRITE;
+}
+
+/**
+ * Compares durations for sorting in ascending order.
+ * IN:
+ * @param first - pointer to the first duration
+ * @param second - pointer to the second duration
+ *
+ * OUT:
+ * @return negative, zero or positive value as for qsort
+ */
+static int CompareDurations(void const * first, void const * second) {
+    long long a = *(long long const*)first;
+    long long b = *(long long const*)second;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Gives histogram bucket of scope duration.
+ * IN:
+ * @param duration - duration of scope in ns
+ *
+ * OUT:
+ * @return number of bucket: 0 for durations below 1 us, b for durations from 2^(b-1) us to 2^b us
+ */
+static int GetHistogramBucket(long long duration) {
+    long long micros = duration / 1000;
+    int bucket = 0;
+
+    while (micros > 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Prints latency statistics and histogram of recorded scopes of one name.
+ * IN:
+ * @param output - stream to print to
+ * @param name - name of scopes
+ * @param durations - array of durations of scopes in ns (it gets sorted)
+ * @param count - number of items in durations
+ */
+static void PrintScopeSummary(FILE * output, char const * name, long long * durations, long long count) {
+    long long histogram[HISTOGRAM_BUCKETS] = { 0 };
+    long long total = 0, highest = 0;
+    long long i;
+    int bucket, firstBucket = HISTOGRAM_BUCKETS, lastBucket = 0;
+
+    qsort(durations, (size_t)count, sizeof(long long), CompareDurations);
+    for (i = 0; i < count; ++i) {
+        total += durations[i];
+        bucket = GetHistogramBucket(durations[i]);
+        histogram[bucket]++;
+        highest     = max(highest, histogram[bucket]);
+        firstBucket = min(firstBucket, bucket);
+        lastBucket  = max(lastBucket, bucket);
+    }
+
+    fprintf(output, "%s: %lld scopes, mean %.1f us, p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n", name, count,
+            total / 1000.0 / count, durations[count / 2] / 1000.0, durations[count * 9 / 10] / 1000.0,
+            durations[count * 99 / 100] / 1000.0, durations[count - 1] / 1000.0);
+    for (bucket = firstBucket; bucket <= lastBucket; ++bucket) {
+        if (bucket == 0)
+            fprintf(output, "  %10s us |", "< 1");
+        else
+            fprintf(output, "  %10lld us |", 1LL << (bucket - 1));
+        for (i = 0; i < (histogram[bucket] * HISTOGRAM_BAR_WIDTH + highest - 1) / highest; ++i)
+            fputc('#', output);
+        fprintf(output, " %lld\n", histogram[bucket]);
+    }
+}
+
+/**
+ * Prints summary of recorded events: latency histogram of each scope name (e.g. paint and scroll handlers)
+ * and totals of counters. Traced threads have to be idle while summary is printed.
+ * IN:
+ * @param output - stream to print to (NULL means stdout)
+ */
+void PrintTraceSummary(FILE * output) {
+    char const * names[MAX_SUMMARY_NAMES];
+    TraceEventKind kinds[MAX_SUMMARY_NAMES];
+    long long counts[MAX_SUMMARY_NAMES];
+    long long totals[MAX_SUMMARY_NAMES];
+    TraceRing const * ring;
+    TraceEvent const * event;
+    long long * durations;
+    long long i, count;
+    int namesNumber = 0, name;
+
+    if (output == NULL)
+        output = stdout;
+
+    // names are collected first, so durations of each scope are gathered into one array
+    for (ring = rings; ring != NULL; ring = ring->next) {
+        for (i = GetFirstKeptEvent(ring); i < ring->written; ++i) {
+            event = &ring->events[i % ring->capacity];
+            for (name = 0; name < namesNumber; ++name) {
+                if (kinds[name] == event->kind && strcmp(names[name], event->name) == 0)
+                    break;
+            }
+            if (name == namesNumber) {
+                if (namesNumber == MAX_SUMMARY_NAMES)
+                    continue;
+                names[namesNumber]  = event->name;
+                kinds[namesNumber]  = event->kind;
+                counts[namesNumber] = totals[namesNumber] = 0;
+                namesNumber++;
+            }
+            counts[name]++;
+            totals[name] += event->value;
+        }
+    }
+
+    for (name = 0; name < namesNumber; ++name) {
+        if (kinds[name] == TRACE_EVENT_COUNTER) {
+            fprintf(output, "%s: %lld samples, total %lld\n", names[name], counts[name], totals[name]);
+            continue;
+        }
+        durations = (long long*)malloc((size_t)counts[name] * sizeof(long long));
+        if (durations == NULL) {
+            PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+            continue;
+        }
+        count = 0;
+        for (ring = rings; ring != NULL; ring = ring->next) {
+            for (i = GetFirstKeptEvent(ring); i < ring->written; ++i) {
+                event = &ring->events[i % ring->capacity];
+                if (event->kind == TRACE_EVENT_SCOPE && strcmp(event->name, names[name]) == 0)
+                    durations[count++] = event->value;
+            }
+        }
+        PrintScopeSummary(output, names[name], durations, count);
+        free(durations);
+    }
+}
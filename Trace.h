@@ -0,0 +1,37 @@
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#include <stdio.h>
+#include "Error.h"
+
+/* hot path instrumentation: scopes and counters are recorded into ring buffer of each thread
+ * and dumped as Chrome trace (chrome://tracing, ui.perfetto.dev) with SaveTrace.
+ * Macros compile out completely unless TRACE_ENABLED is defined (cmake -DENABLE_TRACING=ON),
+ * so instrumented code costs nothing in normal builds.
+ *
+ *     TRACE_START(start);
+ *     ...
+ *     TRACE_STOP("UpdateModelMetrics", start);
+ *     TRACE_COUNTER("rows painted", rowsNumber);
+ *
+ * Names have to be string literals: only pointers to them are kept. */
+#ifdef TRACE_ENABLED
+    #define TRACE_START(start)          long long start = GetTraceTime()
+    #define TRACE_STOP(name, start)     TraceScope(name, start)
+    #define TRACE_COUNTER(name, value)  TraceCounter(name, (long long)(value))
+#else
+    #define TRACE_START(start)
+    #define TRACE_STOP(name, start)     ((void)0)
+    #define TRACE_COUNTER(name, value)  ((void)0)
+#endif
+
+ErrorType StartTrace(void);
+void StopTrace(void);
+void DestroyTrace(void);
+long long GetTraceTime(void);
+void TraceScope(char const * name, long long start);
+void TraceCounter(char const * name, long long value);
+ErrorType SaveTrace(char const * filename);
+void PrintTraceSummary(FILE * output);
+
+#endif // TRACE_H_INCLUDED
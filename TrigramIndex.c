@@ -0,0 +1,893 @@
+#include "TrigramIndex.h"
+#include "FileMapping.h"
+#include "Thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// trigrams are hashed into 2^bits buckets: each block adds buckets up to maximum, so offsets of buckets
+// don't outweigh postings of small text (a few blocks are scanned fast anyway, collisions cost little there)
+#define MIN_TRIGRAM_BUCKETS_BITS 12
+#define MAX_TRIGRAM_BUCKETS_BITS 20
+#define BLOCK_TRIGRAM_BUCKETS_BITS 15
+#define TRIGRAM_WINDOW_SIZE (64LL << 20)        // blocks are processed by groups of about this size
+#define MAX_TRIGRAM_TASKS 64                    // the biggest number of threads processing group of blocks
+#define INITIAL_KEYS_CAPACITY 4096
+#define TRIGRAM_MAGIC "TRIGRAM2"
+
+struct tag_TrigramIndex {
+    long long size;                 // size of indexed text
+    long long blocksNumber;         // number of blocks of lines
+    long long * blockBeginnings;    // [blocksNumber + 1] beginnings of blocks, the last one equals to size
+    int bucketsBits;                // number of buckets is 2^bucketsBits (see GetTrigramBucketsBits)
+    unsigned int * offsets;         // [2^bucketsBits + 1] offsets of buckets postings in pool (in words)
+    unsigned int * pool;            // postings of buckets: sorted numbers of blocks or bitmap if list isn't shorter
+    long long poolSize;             // number of words in pool
+};
+
+// saved index begins with this header, then blocks beginnings, offsets and pool follow
+typedef struct {
+    char magic[8];                  // TRIGRAM_MAGIC
+    long long size;                 // size of indexed file
+    long long modified;             // time of the last modification of indexed file
+    long long blocksNumber;         // number of blocks of lines
+    long long poolSize;             // number of words in pool
+    long long bucketsNumber;        // number of buckets of index
+} TrigramFileHeader;
+
+// blocks containing trigrams of bucket while index is built
+typedef struct {
+    unsigned int * words;           // sorted numbers of blocks or bitmap of blocks
+    unsigned int count;             // number of blocks in list (number of bitmap words for bitmap)
+    unsigned int capacity;          // number of words memory is allocated for
+    BOOL bitmap;                    // set when list is replaced with bitmap
+} Posting;
+
+// group of blocks processed by one thread
+typedef struct {
+    char const * text;              // text of blocks group
+    long long base;                 // index of text byte text begins with
+    long long const * blockBeginnings;  // beginnings of all blocks
+    long long firstBlock;           // the first block of task
+    long long endBlock;             // the block after the last one of task
+    int bucketsBits;                // bucketsBits of index
+    unsigned char * seen;           // [2^bucketsBits / 8] flags of buckets already found in current block
+    unsigned int * keys;            // buckets found in blocks of task (distinct within each block)
+    long long keysNumber;
+    long long keysCapacity;
+    long long * blockKeys;          // [endBlock - firstBlock + 1] offsets of blocks keys
+    long long blockKeysCapacity;
+    BOOL failed;                    // set if keys array can't grow
+} TrigramTask;
+
+struct tag_TrigramIndexBuilder {
+    char const * data;              // indexed text (NULL if it's read by groups of blocks)
+    TextReader read;                // function reading text which isn't kept in memory
+    void * source;                  // argument of read
+    char * window;                  // buffer for group of blocks read from file
+    long long windowSize;           // size of window (it holds the biggest block at least)
+    int threadsNumber;              // number of threads processing each group of blocks
+    IndexerCallback notify;         // function called after each processed group (may be NULL)
+    void * context;                 // argument of notify
+    ThreadHandle thread;            // background thread
+    TrigramIndex * trigrams;        // built index (blocks are set before thread starts)
+    Posting * postings;             // [bucketsNumber] postings of buckets while index is built
+    unsigned int bucketsNumber;     // number of buckets of built index
+    unsigned int bitmapWords;       // number of words of bitmap of all blocks
+    TrigramTask tasks[MAX_TRIGRAM_TASKS];   // state of threads kept between groups
+
+    // fields below are guarded by mutex
+    Mutex mutex;
+    long long processed;            // number of indexed bytes
+    BOOL cancelled;                 // set to stop building
+    BOOL finished;                  // set when building is over
+    ErrorType errorType;            // result of building
+};
+
+/**
+ * Gives number of bits of buckets of index of text splitted into blocks.
+ * IN:
+ * @param blocksNumber - number of blocks of text
+ *
+ * OUT:
+ * @return bucketsBits of index
+ */
+static int GetTrigramBucketsBits(long long blocksNumber) {
+    int bits = MIN_TRIGRAM_BUCKETS_BITS;
+
+    while (bits < MAX_TRIGRAM_BUCKETS_BITS && (1LL << bits) < (blocksNumber << BLOCK_TRIGRAM_BUCKETS_BITS))
+        ++bits;
+    return bits;
+}
+
+/**
+ * Gives bucket of trigram.
+ * IN:
+ * @param trigram - three bytes of text (the first one in the highest bits)
+ * @param bucketsBits - bucketsBits of index
+ *
+ * OUT:
+ * @return number of bucket
+ */
+static unsigned int GetTrigramBucket(unsigned int trigram, int bucketsBits) {
+    return (trigram * 2654435761u) >> (32 - bucketsBits);
+}
+
+/**
+ * Adds bucket to keys of current block unless it's already there.
+ * IN:
+ * @param task - pointer to task
+ * @param key - number of bucket
+ *
+ * OUT:
+ * task->failed is set if there's not enough memory
+ */
+static void AddTrigramKey(TrigramTask * task, unsigned int key) {
+    unsigned int * keys;
+    long long capacity;
+
+    if (task->seen[key >> 3] & (1u << (key & 7)))
+        return;
+    if (task->keysNumber == task->keysCapacity) {
+        capacity = (task->keysCapacity > 0) ? task->keysCapacity * 2 : INITIAL_KEYS_CAPACITY;
+        keys = (unsigned int*)realloc(task->keys, (size_t)capacity * sizeof(unsigned int));
+        if (keys == NULL) {
+            task->failed = TRUE;
+            return;
+        }
+        task->keys = keys;
+        task->keysCapacity = capacity;
+    }
+    task->seen[key >> 3] |= (unsigned char)(1u << (key & 7));
+    task->keys[task->keysNumber++] = key;
+}
+
+/**
+ * Thread routine finding distinct buckets of trigrams of each block of task.
+ * Trigrams containing line breaks are skipped, so no trigram crosses blocks.
+ * IN:
+ * @param argument - pointer to TrigramTask
+ *
+ * OUT:
+ * task keys get buckets of blocks
+ */
+static void CollectTrigrams(void * argument) {
+    TrigramTask * task = (TrigramTask*)argument;
+    unsigned char const * bytes;
+    unsigned int trigram;
+    long long block, position, end, key;
+    int valid;
+
+    task->keysNumber = 0;
+    for (block = task->firstBlock; block < task->endBlock && !task->failed; ++block) {
+        task->blockKeys[block - task->firstBlock] = task->keysNumber;
+        bytes = (unsigned char const *)task->text + (task->blockBeginnings[block] - task->base);
+        end   = task->blockBeginnings[block + 1] - task->blockBeginnings[block];
+
+        for (position = 0, trigram = 0, valid = 0; position < end; ++position) {
+            if (bytes[position] == '\n' || bytes[position] == '\r') {
+                valid = 0;
+                continue;
+            }
+            trigram = ((trigram << 8) | bytes[position]) & 0xFFFFFF;
+            if (++valid >= 3)
+                AddTrigramKey(task, GetTrigramBucket(trigram, task->bucketsBits));
+        }
+
+        // flags are cleared for the next block
+        for (key = task->blockKeys[block - task->firstBlock]; key < task->keysNumber; ++key)
+            task->seen[task->keys[key] >> 3] = 0;
+    }
+    task->blockKeys[task->endBlock - task->firstBlock] = task->keysNumber;
+}
+
+/**
+ * Adds block to posting of bucket. Blocks are added in ascending order,
+ * list is replaced with bitmap when it would take as much memory.
+ * IN:
+ * @param builder - pointer to builder
+ * @param key - number of bucket
+ * @param block - number of block
+ *
+ * OUT:
+ * @return FALSE if there's not enough memory
+ */
+static BOOL AddPosting(TrigramIndexBuilder * builder, unsigned int key, unsigned int block) {
+    Posting * posting = &builder->postings[key];
+    unsigned int * words;
+    unsigned int capacity, i;
+
+    if (!posting->bitmap && posting->count + 1 >= builder->bitmapWords) {
+        words = (unsigned int*)calloc(builder->bitmapWords, sizeof(unsigned int));
+        if (words == NULL)
+            return FALSE;
+        for (i = 0; i < posting->count; ++i)
+            words[posting->words[i] >> 5] |= 1u << (posting->words[i] & 31);
+        free(posting->words);
+        posting->words    = words;
+        posting->count    = builder->bitmapWords;
+        posting->capacity = builder->bitmapWords;
+        posting->bitmap   = TRUE;
+    }
+    if (posting->bitmap) {
+        posting->words[block >> 5] |= 1u << (block & 31);
+        return TRUE;
+    }
+
+    if (posting->count == posting->capacity) {
+        capacity = (posting->capacity > 0) ? posting->capacity * 2 : 4;
+        words = (unsigned int*)realloc(posting->words, capacity * sizeof(unsigned int));
+        if (words == NULL)
+            return FALSE;
+        posting->words    = words;
+        posting->capacity = capacity;
+    }
+    posting->words[posting->count++] = block;
+    return TRUE;
+}
+
+/**
+ * Moves postings of all buckets into single pool of index.
+ * IN:
+ * @param builder - pointer to builder
+ *
+ * OUT:
+ * builder->trigrams gets offsets and pool, postings are freed
+ * @return ERR_NOMEM if there's not enough memory or pool doesn't fit 32-bit offsets (ERR_NO if successed)
+ */
+static ErrorType FreezePostings(TrigramIndexBuilder * builder) {
+    TrigramIndex * trigrams = builder->trigrams;
+    long long poolSize = 0;
+    unsigned int key;
+
+    for (key = 0; key < builder->bucketsNumber; ++key) {
+        trigrams->offsets[key] = (unsigned int)poolSize;
+        poolSize += builder->postings[key].count;
+        if (poolSize > UINT_MAX)
+            return ERR_NOMEM;
+    }
+    trigrams->offsets[builder->bucketsNumber] = (unsigned int)poolSize;
+
+    trigrams->pool = (unsigned int*)malloc((size_t)max(poolSize, 1) * sizeof(unsigned int));
+    if (trigrams->pool == NULL)
+        return ERR_NOMEM;
+    trigrams->poolSize = poolSize;
+    for (key = 0; key < builder->bucketsNumber; ++key) {
+        if (builder->postings[key].count > 0)
+            memcpy(trigrams->pool + trigrams->offsets[key], builder->postings[key].words,
+                   builder->postings[key].count * sizeof(unsigned int));
+        free(builder->postings[key].words);
+        builder->postings[key].words = NULL;
+    }
+    return ERR_NO;
+}
+
+/**
+ * Processes group of blocks fitting into window: it's splitted between threads,
+ * buckets found by them are added to postings in order of blocks.
+ * IN:
+ * @param builder - pointer to builder
+ * @param firstBlock - the first block of group
+ * @param endBlock - the block after the last one of group
+ *
+ * OUT:
+ * builder->postings get blocks of group
+ * @return code of error occured during processing (ERR_NO if successed)
+ */
+static ErrorType IndexBlocks(TrigramIndexBuilder * builder, long long firstBlock, long long endBlock) {
+    long long const * blockBeginnings = builder->trigrams->blockBeginnings;
+    char const * text = builder->data;
+    long long base = 0;
+    long long block, key;
+    ErrorType errorType = ERR_NO;
+    TrigramTask * task;
+    int tasksNumber = (int)min(builder->threadsNumber, endBlock - firstBlock);
+    int i;
+
+    if (text == NULL) {
+        base = blockBeginnings[firstBlock];
+        if (!builder->read(builder->source, base, builder->window, (size_t)(blockBeginnings[endBlock] - base)))
+            return ERR_READ;
+        text = builder->window;
+    }
+
+    for (i = 0; i < tasksNumber; ++i) {
+        task = &builder->tasks[i];
+        task->text            = text;
+        task->base            = base;
+        task->blockBeginnings = blockBeginnings;
+        task->bucketsBits     = builder->trigrams->bucketsBits;
+        task->firstBlock      = firstBlock + (endBlock - firstBlock) * i / tasksNumber;
+        task->endBlock        = firstBlock + (endBlock - firstBlock) * (i + 1) / tasksNumber;
+        if (task->blockKeysCapacity < task->endBlock - task->firstBlock + 1) {
+            free(task->blockKeys);
+            task->blockKeysCapacity = task->endBlock - task->firstBlock + 1;
+            task->blockKeys = (long long*)malloc((size_t)task->blockKeysCapacity * sizeof(long long));
+        }
+        if (task->seen == NULL)
+            task->seen = (unsigned char*)calloc(builder->bucketsNumber / 8, sizeof(unsigned char));
+        if (task->seen == NULL || task->blockKeys == NULL) {
+            task->blockKeysCapacity = 0;
+            return ERR_NOMEM;
+        }
+    }
+
+    if (tasksNumber > 1)
+        errorType = RunThreadTasks(builder->tasks, sizeof(TrigramTask), tasksNumber, CollectTrigrams);
+    else
+        CollectTrigrams(&builder->tasks[0]);
+
+    for (i = 0; i < tasksNumber && errorType == ERR_NO; ++i) {
+        task = &builder->tasks[i];
+        if (task->failed)
+            return ERR_NOMEM;
+        for (block = task->firstBlock; block < task->endBlock; ++block) {
+            for (key = task->blockKeys[block - task->firstBlock]; key < task->blockKeys[block - task->firstBlock + 1]; ++key) {
+                if (!AddPosting(builder, task->keys[key], (unsigned int)block))
+                    return ERR_NOMEM;
+            }
+        }
+    }
+    return errorType;
+}
+
+/**
+ * Thread routine building index by groups of blocks.
+ * IN:
+ * @param argument - pointer to TrigramIndexBuilder
+ *
+ * OUT:
+ * builder->trigrams gets built index (it's destroyed if building is cancelled or failed)
+ */
+static void BuildInBackground(void * argument) {
+    TrigramIndexBuilder * builder = (TrigramIndexBuilder*)argument;
+    TrigramIndex * trigrams = builder->trigrams;
+    ErrorType errorType = ERR_NO;
+    long long block, endBlock;
+    BOOL cancelled = FALSE;
+
+    for (block = 0; block < trigrams->blocksNumber && errorType == ERR_NO; block = endBlock) {
+        LockMutex(&builder->mutex);
+        cancelled = builder->cancelled;
+        UnlockMutex(&builder->mutex);
+        if (cancelled)
+            break;
+
+        for (endBlock = block + 1; endBlock < trigrams->blocksNumber &&
+             trigrams->blockBeginnings[endBlock + 1] - trigrams->blockBeginnings[block] <= builder->windowSize; ++endBlock)
+            ;
+        errorType = IndexBlocks(builder, block, endBlock);
+
+        LockMutex(&builder->mutex);
+        builder->processed = trigrams->blockBeginnings[endBlock];
+        UnlockMutex(&builder->mutex);
+        if (builder->notify != NULL && endBlock < trigrams->blocksNumber)
+            builder->notify(builder->context);
+    }
+
+    if (errorType == ERR_NO && !cancelled)
+        errorType = FreezePostings(builder);
+    if (errorType != ERR_NO || cancelled) {
+        DestroyTrigramIndex(builder->trigrams);
+        builder->trigrams = NULL;
+    }
+
+    LockMutex(&builder->mutex);
+    builder->finished  = TRUE;
+    builder->errorType = errorType;
+    UnlockMutex(&builder->mutex);
+
+    if (builder->notify != NULL)
+        builder->notify(builder->context);
+}
+
+/**
+ * Creates empty index with blocks of whole lines about TRIGRAM_BLOCK_SIZE bytes each.
+ * IN:
+ * @param index - finished line index of text
+ * @param size - size of text
+ *
+ * OUT:
+ * @return pointer to created index (NULL if there's not enough memory)
+ */
+static TrigramIndex * CreateTrigramIndex(LineIndex const * index, long long size) {
+    TrigramIndex * trigrams = (TrigramIndex*)calloc(1, sizeof(TrigramIndex));
+    long long block, line, position;
+
+    if (trigrams == NULL)
+        return NULL;
+    trigrams->size = size;
+    trigrams->blocksNumber    = (size + TRIGRAM_BLOCK_SIZE - 1) / TRIGRAM_BLOCK_SIZE;
+    trigrams->blockBeginnings = (long long*)malloc((size_t)(trigrams->blocksNumber + 1) * sizeof(long long));
+    if (trigrams->blockBeginnings == NULL) {
+        DestroyTrigramIndex(trigrams);
+        return NULL;
+    }
+
+    // each block ends at the first line beginning after it's planned size
+    for (block = 0, position = 0; position < size; ++block) {
+        trigrams->blockBeginnings[block] = position;
+        position += TRIGRAM_BLOCK_SIZE;
+        if (position < size) {
+            line = FindIndexedLine(index, position);
+            if (GetIndexedLineBeginning(index, line) < position)
+                position = (line + 1 < index->linesNumber) ? GetIndexedLineBeginning(index, line + 1) : size;
+        }
+        else
+            position = size;
+    }
+    trigrams->blocksNumber = block;
+    trigrams->blockBeginnings[block] = size;
+
+    trigrams->bucketsBits = GetTrigramBucketsBits(trigrams->blocksNumber);
+    trigrams->offsets     = (unsigned int*)calloc(((size_t)1 << trigrams->bucketsBits) + 1, sizeof(unsigned int));
+    if (trigrams->offsets == NULL) {
+        DestroyTrigramIndex(trigrams);
+        return NULL;
+    }
+    return trigrams;
+}
+
+/**
+ * Starts background thread building trigram index of text. Blocks of text are taken from line index,
+ * each group of blocks is processed by several threads.
+ * IN:
+ * @param data - text to index (NULL if it's read with read function)
+ * @param read - function reading text (used if data is NULL)
+ * @param source - argument of read
+ * @param index - finished line index of text (it's used before this function returns only)
+ * @param size - size of text in bytes
+ * @param options - number of threads to index with (NULL means default one)
+ * @param notify - function called from builder thread after each group of blocks and at the end (may be NULL)
+ * @param context - argument of notify
+ *
+ * OUT:
+ * @param builder - gets pointer to started builder (it has to be destroyed with DestroyTrigramIndexBuilder)
+ * @return code of error occured during starting (ERR_NO if successed)
+ */
+ErrorType StartTrigramIndexBuilder(TrigramIndexBuilder ** builder, char const * data, TextReader read, void * source,
+                                   LineIndex const * index, long long size, IndexerOptions const * options,
+                                   IndexerCallback notify, void * context) {
+    TrigramIndexBuilder * created;
+    ErrorType errorType;
+    long long block;
+
+    if (builder == NULL || index == NULL || size < 0 || (data == NULL && read == NULL && size > 0))
+        return ERR_NULL_PTR;
+
+    created = (TrigramIndexBuilder*)calloc(1, sizeof(TrigramIndexBuilder));
+    if (created == NULL)
+        return ERR_NOMEM;
+    created->data          = data;
+    created->read          = read;
+    created->source        = source;
+    created->threadsNumber = (options != NULL) ? options->threadsNumber : 0;
+    created->notify        = notify;
+    created->context       = context;
+    if (created->threadsNumber <= 0)
+        created->threadsNumber = GetHardwareConcurrency();
+    created->threadsNumber = min(created->threadsNumber, MAX_TRIGRAM_TASKS);
+
+    created->trigrams = CreateTrigramIndex(index, size);
+    errorType = (created->trigrams != NULL) ? ERR_NO : ERR_NOMEM;
+    if (errorType == ERR_NO) {
+        created->bitmapWords   = (unsigned int)((created->trigrams->blocksNumber + 31) / 32);
+        created->bucketsNumber = 1u << created->trigrams->bucketsBits;
+        created->postings      = (Posting*)calloc(created->bucketsNumber, sizeof(Posting));
+        if (created->postings == NULL)
+            errorType = ERR_NOMEM;
+    }
+
+    // window holds at least the biggest block, so blocks are never splitted
+    created->windowSize = TRIGRAM_WINDOW_SIZE;
+    for (block = 0; errorType == ERR_NO && block < created->trigrams->blocksNumber; ++block)
+        created->windowSize = max(created->windowSize, created->trigrams->blockBeginnings[block + 1] -
+                                                       created->trigrams->blockBeginnings[block]);
+    if (errorType == ERR_NO && data == NULL) {
+        created->window = (char*)malloc((size_t)min(size, created->windowSize) + 1);
+        if (created->window == NULL)
+            errorType = ERR_NOMEM;
+    }
+
+    if (errorType == ERR_NO) {
+        errorType = InitMutex(&created->mutex);
+        if (errorType == ERR_NO) {
+            errorType = StartThread(&created->thread, BuildInBackground, created);
+            if (errorType != ERR_NO)
+                DestroyMutex(&created->mutex);
+        }
+    }
+    if (errorType != ERR_NO) {
+        DestroyTrigramIndex(created->trigrams);
+        free(created->postings);
+        free(created->window);
+        free(created);
+        return errorType;
+    }
+
+    *builder = created;
+    return ERR_NO;
+}
+
+/**
+ * Gives part of text which is already indexed.
+ * IN:
+ * @param builder - pointer to builder
+ *
+ * OUT:
+ * @return number from 0 to 1
+ */
+double GetTrigramIndexProgress(TrigramIndexBuilder * builder) {
+    double progress;
+
+    LockMutex(&builder->mutex);
+    progress = (builder->trigrams != NULL && builder->trigrams->size > 0 && !builder->finished) ?
+               (double)builder->processed / builder->trigrams->size : 1.0;
+    UnlockMutex(&builder->mutex);
+    return progress;
+}
+
+/**
+ * Takes built index from finished builder.
+ * IN:
+ * @param builder - pointer to builder
+ *
+ * OUT:
+ * @param trigrams - gets pointer to index if building is finished (NULL if it's failed or cancelled),
+ *                   it has to be destroyed with DestroyTrigramIndex
+ * @param errorType - gets code of error occured during building (may be NULL)
+ * @return TRUE if building is finished
+ */
+BOOL TakeTrigramIndex(TrigramIndexBuilder * builder, TrigramIndex ** trigrams, ErrorType * errorType) {
+    BOOL finished;
+
+    LockMutex(&builder->mutex);
+    finished = builder->finished;
+    if (finished) {
+        *trigrams = builder->trigrams;
+        builder->trigrams = NULL;
+        if (errorType != NULL)
+            *errorType = builder->errorType;
+    }
+    UnlockMutex(&builder->mutex);
+    return finished;
+}
+
+/**
+ * Stops building: builder finishes without index soon, final notification still comes.
+ * IN:
+ * @param builder - pointer to builder
+ */
+void CancelTrigramIndexBuilder(TrigramIndexBuilder * builder) {
+    LockMutex(&builder->mutex);
+    builder->cancelled = TRUE;
+    UnlockMutex(&builder->mutex);
+}
+
+/**
+ * Stops building, waits for builder thread and frees memory of builder.
+ * IN:
+ * @param builder - pointer to builder (may be NULL)
+ */
+void DestroyTrigramIndexBuilder(TrigramIndexBuilder * builder) {
+    unsigned int i;
+
+    if (builder == NULL)
+        return;
+
+    CancelTrigramIndexBuilder(builder);
+    JoinThread(builder->thread);
+    DestroyMutex(&builder->mutex);
+
+    for (i = 0; i < MAX_TRIGRAM_TASKS; ++i) {
+        free(builder->tasks[i].seen);
+        free(builder->tasks[i].keys);
+        free(builder->tasks[i].blockKeys);
+    }
+    for (i = 0; i < builder->bucketsNumber; ++i)
+        free(builder->postings[i].words);
+    free(builder->postings);
+    DestroyTrigramIndex(builder->trigrams);
+    free(builder->window);
+    free(builder);
+}
+
+/**
+ * Gives number of blocks of lines.
+ * IN:
+ * @param trigrams - pointer to index
+ *
+ * OUT:
+ * @return number of blocks
+ */
+long long GetTrigramBlocksNumber(TrigramIndex const * trigrams) {
+    return trigrams->blocksNumber;
+}
+
+/**
+ * Gives beginning of block of lines.
+ * IN:
+ * @param trigrams - pointer to index
+ * @param block - number of block (blocks number gives size of text)
+ *
+ * OUT:
+ * @return index of the first byte of block in text
+ */
+long long GetTrigramBlockBeginning(TrigramIndex const * trigrams, long long block) {
+    return trigrams->blockBeginnings[block];
+}
+
+/**
+ * Gives size of indexed text.
+ * IN:
+ * @param trigrams - pointer to index
+ *
+ * OUT:
+ * @return size of text in bytes
+ */
+long long GetTrigramIndexedSize(TrigramIndex const * trigrams) {
+    return trigrams->size;
+}
+
+/**
+ * Finds blocks which may contain string: each trigram of string has to be in block.
+ * IN:
+ * @param trigrams - pointer to index
+ * @param literal - string to look up
+ * @param literalLength - length of string
+ *
+ * OUT:
+ * @return bitmap of candidate blocks (it has to be freed), NULL if index can't narrow search
+ * (string is shorter than 3 bytes, has line breaks or there's not enough memory)
+ */
+unsigned int * FindTrigramCandidates(TrigramIndex const * trigrams, char const * literal, size_t literalLength) {
+    unsigned char const * bytes = (unsigned char const *)literal;
+    long long bitmapWords = (trigrams->blocksNumber + 31) / 32;
+    long long words, i, word;
+    unsigned int * candidates;
+    unsigned int * posting;
+    unsigned int * list;
+    unsigned int key;
+    size_t position;
+
+    if (literalLength < 3 || trigrams->blocksNumber == 0 || memchr(literal, '\n', literalLength) != NULL ||
+        memchr(literal, '\r', literalLength) != NULL)
+        return NULL;
+    candidates = (unsigned int*)malloc((size_t)bitmapWords * sizeof(unsigned int));
+    list       = (unsigned int*)malloc((size_t)bitmapWords * sizeof(unsigned int));
+    if (candidates == NULL || list == NULL) {
+        free(candidates);
+        free(list);
+        return NULL;
+    }
+
+    memset(candidates, 0xFF, (size_t)bitmapWords * sizeof(unsigned int));
+    if (trigrams->blocksNumber % 32 != 0)
+        candidates[bitmapWords - 1] = (1u << (trigrams->blocksNumber % 32)) - 1;
+
+    for (position = 0; position + 3 <= literalLength; ++position) {
+        key = GetTrigramBucket(((unsigned int)bytes[position] << 16) | ((unsigned int)bytes[position + 1] << 8) |
+                               bytes[position + 2], trigrams->bucketsBits);
+        posting = trigrams->pool + trigrams->offsets[key];
+        words   = (long long)trigrams->offsets[key + 1] - trigrams->offsets[key];
+
+        // short postings are lists of blocks
+        if (words < bitmapWords) {
+            memset(list, 0, (size_t)bitmapWords * sizeof(unsigned int));
+            for (i = 0; i < words; ++i)
+                list[posting[i] >> 5] |= 1u << (posting[i] & 31);
+            posting = list;
+        }
+        for (word = 0; word < bitmapWords; ++word)
+            candidates[word] &= posting[word];
+    }
+
+    free(list);
+    return candidates;
+}
+
+/**
+ * Gives number of bytes occupied by index.
+ * IN:
+ * @param trigrams - pointer to index
+ *
+ * OUT:
+ * @return size of index arrays in bytes
+ */
+size_t GetTrigramIndexMemory(TrigramIndex const * trigrams) {
+    return (size_t)(trigrams->blocksNumber + 1) * sizeof(long long) +
+           (((size_t)1 << trigrams->bucketsBits) + 1) * sizeof(unsigned int) +
+           (size_t)trigrams->poolSize * sizeof(unsigned int);
+}
+
+/**
+ * Gives name of file index of text file is saved in.
+ * IN:
+ * @param filename - name of text file
+ *
+ * OUT:
+ * @return name of index file (it has to be freed), NULL if there's not enough memory
+ */
+static char * GetTrigramFilename(char const * filename) {
+    char * trigramFilename = (char*)malloc(strlen(filename) + sizeof(TRIGRAM_FILE_EXTENSION));
+
+    if (trigramFilename != NULL) {
+        strcpy(trigramFilename, filename);
+        strcat(trigramFilename, TRIGRAM_FILE_EXTENSION);
+    }
+    return trigramFilename;
+}
+
+/**
+ * Saves index next to text file. Index is valid while size and modification time of text file stay the same.
+ * IN:
+ * @param trigrams - pointer to index
+ * @param filename - name of indexed text file
+ * @param modified - modification time of text file when it's indexing started (see GetFileStamp)
+ *
+ * OUT:
+ * @return code of error occured during saving (ERR_NO if successed)
+ */
+ErrorType SaveTrigramIndex(TrigramIndex const * trigrams, char const * filename, long long modified) {
+    TrigramFileHeader header;
+    char * trigramFilename;
+    FILE * file;
+    size_t bucketsNumber;
+    BOOL written;
+
+    if (trigrams == NULL || filename == NULL)
+        return ERR_NULL_PTR;
+    bucketsNumber = (size_t)1 << trigrams->bucketsBits;
+    trigramFilename = GetTrigramFilename(filename);
+    if (trigramFilename == NULL)
+        return ERR_NOMEM;
+    file = fopen(trigramFilename, "wb");
+    if (file == NULL) {
+        free(trigramFilename);
+        return ERR_OPEN_FILE;
+    }
+
+    memset(&header, 0, sizeof(TrigramFileHeader));
+    memcpy(header.magic, TRIGRAM_MAGIC, sizeof(header.magic));
+    header.size          = trigrams->size;
+    header.modified      = modified;
+    header.blocksNumber  = trigrams->blocksNumber;
+    header.poolSize      = trigrams->poolSize;
+    header.bucketsNumber = (long long)bucketsNumber;
+    written = fwrite(&header, sizeof(TrigramFileHeader), 1, file) == 1 &&
+              fwrite(trigrams->blockBeginnings, sizeof(long long), (size_t)trigrams->blocksNumber + 1, file) ==
+                  (size_t)trigrams->blocksNumber + 1 &&
+              fwrite(trigrams->offsets, sizeof(unsigned int), bucketsNumber + 1, file) == bucketsNumber + 1 &&
+              fwrite(trigrams->pool, sizeof(unsigned int), (size_t)trigrams->poolSize, file) == (size_t)trigrams->poolSize;
+    written = (fclose(file) == 0) && written;
+
+    // incomplete index mustn't be loaded later
+    if (!written)
+        remove(trigramFilename);
+    free(trigramFilename);
+    return written ? ERR_NO : ERR_WRITE;
+}
+
+/**
+ * Checks that blocks of loaded index cover text and postings fit into pool, so damaged file can't make lookups
+ * read outside of pool or give wrong ranges of blocks.
+ * IN:
+ * @param trigrams - pointer to loaded index
+ *
+ * OUT:
+ * @return TRUE if blocks beginnings ascend from 0 to size of text, offsets are ascending
+ * and each posting is either a list or a bitmap of blocks
+ */
+static BOOL IsTrigramIndexConsistent(TrigramIndex const * trigrams) {
+    long long bitmapWords = (trigrams->blocksNumber + 31) / 32;
+    long long bucketsNumber = 1LL << trigrams->bucketsBits;
+    long long words, i, key;
+
+    if (trigrams->blockBeginnings[0] != 0 || trigrams->blockBeginnings[trigrams->blocksNumber] != trigrams->size)
+        return FALSE;
+    for (i = 0; i < trigrams->blocksNumber; ++i) {
+        if (trigrams->blockBeginnings[i] >= trigrams->blockBeginnings[i + 1])
+            return FALSE;
+    }
+    if (trigrams->offsets[0] != 0 || trigrams->offsets[bucketsNumber] != trigrams->poolSize)
+        return FALSE;
+    for (key = 0; key < bucketsNumber; ++key) {
+        words = (long long)trigrams->offsets[key + 1] - trigrams->offsets[key];
+        if (words < 0 || words > bitmapWords)
+            return FALSE;
+        for (i = 0; words < bitmapWords && i < words; ++i) {
+            if (trigrams->pool[trigrams->offsets[key] + i] >= (unsigned long long)trigrams->blocksNumber)
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Loads index saved next to text file. Index saved for other size or modification time of text file is removed.
+ * IN:
+ * @param filename - name of indexed text file
+ *
+ * OUT:
+ * @param trigrams - gets pointer to loaded index (NULL if there's no valid index), it has to be destroyed with DestroyTrigramIndex
+ * @return code of error occured during loading (ERR_NO if index is loaded or there's no valid index)
+ */
+ErrorType LoadTrigramIndex(TrigramIndex ** trigrams, char const * filename) {
+    TrigramFileHeader header;
+    TrigramIndex * loaded = NULL;
+    char * trigramFilename;
+    long long size, modified;
+    size_t bucketsNumber = 0;
+    FILE * file;
+    BOOL valid;
+
+    if (trigrams == NULL || filename == NULL)
+        return ERR_NULL_PTR;
+    *trigrams = NULL;
+    if (GetFileStamp(filename, &size, &modified) != ERR_NO)
+        return ERR_OPEN_FILE;
+    trigramFilename = GetTrigramFilename(filename);
+    if (trigramFilename == NULL)
+        return ERR_NOMEM;
+    file = fopen(trigramFilename, "rb");
+    if (file == NULL) {
+        free(trigramFilename);
+        return ERR_NO;
+    }
+
+    valid = fread(&header, sizeof(TrigramFileHeader), 1, file) == 1 &&
+            memcmp(header.magic, TRIGRAM_MAGIC, sizeof(header.magic)) == 0 &&
+            header.size == size && header.modified == modified && header.blocksNumber >= 0 &&
+            header.blocksNumber <= size && header.poolSize >= 0 && header.poolSize <= UINT_MAX &&
+            header.bucketsNumber == 1LL << GetTrigramBucketsBits(header.blocksNumber);
+    if (valid) {
+        bucketsNumber = (size_t)header.bucketsNumber;
+        loaded = (TrigramIndex*)calloc(1, sizeof(TrigramIndex));
+        if (loaded != NULL) {
+            loaded->blockBeginnings = (long long*)malloc((size_t)(header.blocksNumber + 1) * sizeof(long long));
+            loaded->offsets         = (unsigned int*)malloc((bucketsNumber + 1) * sizeof(unsigned int));
+            loaded->pool            = (unsigned int*)malloc((size_t)max(header.poolSize, 1) * sizeof(unsigned int));
+        }
+        if (loaded == NULL || loaded->blockBeginnings == NULL || loaded->offsets == NULL || loaded->pool == NULL) {
+            fclose(file);
+            DestroyTrigramIndex(loaded);
+            free(trigramFilename);
+            return ERR_NOMEM;
+        }
+        loaded->size         = header.size;
+        loaded->blocksNumber = header.blocksNumber;
+        loaded->bucketsBits  = GetTrigramBucketsBits(header.blocksNumber);
+        loaded->poolSize     = header.poolSize;
+        valid = fread(loaded->blockBeginnings, sizeof(long long), (size_t)header.blocksNumber + 1, file) ==
+                    (size_t)header.blocksNumber + 1 &&
+                fread(loaded->offsets, sizeof(unsigned int), bucketsNumber + 1, file) == bucketsNumber + 1 &&
+                fread(loaded->pool, sizeof(unsigned int), (size_t)header.poolSize, file) == (size_t)header.poolSize &&
+                IsTrigramIndexConsistent(loaded);
+    }
+    fclose(file);
+
+    // stale or damaged index is thrown away
+    if (!valid) {
+        DestroyTrigramIndex(loaded);
+        remove(trigramFilename);
+        free(trigramFilename);
+        return ERR_NO;
+    }
+    free(trigramFilename);
+    *trigrams = loaded;
+    return ERR_NO;
+}
+
+/**
+ * Frees memory of index.
+ * IN:
+ * @param trigrams - pointer to index (may be NULL)
+ */
+void DestroyTrigramIndex(TrigramIndex * trigrams) {
+    if (trigrams == NULL)
+        return;
+    free(trigrams->blockBeginnings);
+    free(trigrams->offsets);
+    free(trigrams->pool);
+    free(trigrams);
+}
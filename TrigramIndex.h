@@ -0,0 +1,33 @@
+#ifndef TRIGRAMINDEX_H_INCLUDED
+#define TRIGRAMINDEX_H_INCLUDED
+
+#include "Portable.h"
+#include <stddef.h>
+#include "Error.h"
+#include "LineIndexer.h"
+
+#define TRIGRAM_BLOCK_SIZE (1LL << 20)      // text is splitted into blocks of whole lines about this size
+#define TRIGRAM_FILE_EXTENSION ".trigrams"  // index is saved next to text file with this suffix
+
+/* index of blocks of lines containing each trigram (trigrams are hashed, so collisions give extra candidates);
+ * trigrams with line breaks aren't indexed, so only strings without line breaks can be looked up */
+typedef struct tag_TrigramIndex TrigramIndex;
+typedef struct tag_TrigramIndexBuilder TrigramIndexBuilder;
+
+ErrorType StartTrigramIndexBuilder(TrigramIndexBuilder ** builder, char const * data, TextReader read, void * source,
+                                   LineIndex const * index, long long size, IndexerOptions const * options,
+                                   IndexerCallback notify, void * context);
+double GetTrigramIndexProgress(TrigramIndexBuilder * builder);
+BOOL TakeTrigramIndex(TrigramIndexBuilder * builder, TrigramIndex ** trigrams, ErrorType * errorType);
+void CancelTrigramIndexBuilder(TrigramIndexBuilder * builder);
+void DestroyTrigramIndexBuilder(TrigramIndexBuilder * builder);
+long long GetTrigramBlocksNumber(TrigramIndex const * trigrams);
+long long GetTrigramBlockBeginning(TrigramIndex const * trigrams, long long block);
+long long GetTrigramIndexedSize(TrigramIndex const * trigrams);
+unsigned int * FindTrigramCandidates(TrigramIndex const * trigrams, char const * literal, size_t literalLength);
+size_t GetTrigramIndexMemory(TrigramIndex const * trigrams);
+ErrorType SaveTrigramIndex(TrigramIndex const * trigrams, char const * filename, long long modified);
+ErrorType LoadTrigramIndex(TrigramIndex ** trigrams, char const * filename);
+void DestroyTrigramIndex(TrigramIndex * trigrams);
+
+#endif // TRIGRAMINDEX_H_INCLUDED
@@ -0,0 +1,264 @@
+#include "WrapIndex.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Counts number of rows line takes in wrap view mode.
+ * IN:
+ * @param index - pointer to index of text lines
+ * @param lineNumber - number of line
+ * @param width - number of characters in row (values less than 1 are treated as 1)
+ *
+ * OUT:
+ * @return number of rows (empty line takes one row)
+ */
+long long CountWrapRows(LineIndex const * index, long long lineNumber, int width) {
+    long long length = GetLineContentEnd(index, lineNumber) - GetIndexedLineBeginning(index, lineNumber);
+
+    if (width < 1)
+        width = 1;
+    if (length <= 0)
+        return 1;
+    return (length + width - 1) / width;
+}
+
+/**
+ * Counts number of rows of the entire text in wrap view mode using histogram of lines lengths.
+ * Takes time proportional to number of distinct lengths instead of number of lines,
+ * so width can be changed without rescanning lines.
+ * IN:
+ * @param index - pointer to index of text lines
+ * @param width - number of characters in row (values less than 1 are treated as 1)
+ *
+ * OUT:
+ * @return number of rows
+ */
+long long CountTotalWrapRows(LineIndex const * index, int width) {
+    long long rowsNumber;
+    long long length, i;
+
+    if (width < 1)
+        width = 1;
+
+    // index being built in background has no histogram yet
+    if (index->lengthCounts == NULL) {
+        for (rowsNumber = 0, i = 0; i < index->linesNumber; ++i)
+            rowsNumber += CountWrapRows(index, i, width);
+        return rowsNumber;
+    }
+
+    rowsNumber = index->lengthCounts[0];    // empty lines take one row
+
+    for (length = 1; length < LENGTH_COUNTS_SIZE; ++length)
+        rowsNumber += index->lengthCounts[length] * ((length + width - 1) / width);
+    for (i = 0; i < index->lengthsNumber; ++i)
+        rowsNumber += index->longLengths[i].linesNumber * ((index->longLengths[i].length + width - 1) / width);
+
+    return rowsNumber;
+}
+
+/**
+ * Builds prefix sums of rows of text lines in wrap view mode.
+ * Each WRAP_BLOCK_SIZE lines share one sum, so index takes 8 bytes per block.
+ * IN:
+ * @param index - pointer to index of text lines
+ * @param width - number of characters in row (values less than 1 are treated as 1)
+ *
+ * OUT:
+ * @param wrapIndex - pointer to index to build (previous content is destroyed)
+ * @return code of error occured during building (ERR_NO if successed)
+ */
+ErrorType BuildWrapIndex(WrapIndex * wrapIndex, LineIndex const * index, int width) {
+    DestroyWrapIndex(wrapIndex);
+    wrapIndex->width = (width < 1) ? 1 : width;
+    return ExtendWrapIndex(wrapIndex, index, 0);
+}
+
+/**
+ * Adds prefix sums of lines appended to index since wrap index has been built.
+ * Lines before the first changed one have to stay unchanged.
+ * IN:
+ * @param wrapIndex - pointer to wrap index with width set
+ * @param index - pointer to index of text lines
+ * @param firstLine - number of the first line which may have changed or been appended
+ *
+ * OUT:
+ * wrapIndex gets sums of all lines of index (it's destroyed if there's not enough memory)
+ * @return code of error occured during building (ERR_NO if successed)
+ */
+ErrorType ExtendWrapIndex(WrapIndex * wrapIndex, LineIndex const * index, long long firstLine) {
+    long long * blockRows;
+    long long blocksNumber = (index->linesNumber >> WRAP_BLOCK_SHIFT) + 1;
+    long long firstBlock = (wrapIndex->blocksNumber > 0) ? wrapIndex->blocksNumber - 1 : 0;
+    long long rowsNumber;
+    long long line;
+    int width = wrapIndex->width;
+
+    if ((unsigned long long)blocksNumber > SIZE_MAX / sizeof(long long))
+        blockRows = NULL;
+    else
+        blockRows = (long long*)realloc(wrapIndex->blockRows, (size_t)blocksNumber * sizeof(long long));
+    if (blockRows == NULL) {
+        DestroyWrapIndex(wrapIndex);
+        return ERR_NOMEM;
+    }
+
+    // the last block may get new lines, so sums are recounted from it's beginning
+    // (or from the beginning of the block of the first changed line)
+    if (firstBlock > (firstLine >> WRAP_BLOCK_SHIFT))
+        firstBlock = firstLine >> WRAP_BLOCK_SHIFT;
+    rowsNumber = (wrapIndex->blocksNumber > 0) ? blockRows[firstBlock] : 0;
+    for (line = firstBlock << WRAP_BLOCK_SHIFT; line < index->linesNumber; ++line) {
+        if ((line & (WRAP_BLOCK_SIZE - 1)) == 0)
+            blockRows[line >> WRAP_BLOCK_SHIFT] = rowsNumber;
+        rowsNumber += CountWrapRows(index, line, width);
+    }
+    // block after the last line is complete only if number of lines is multiple of block size
+    if ((index->linesNumber & (WRAP_BLOCK_SIZE - 1)) == 0)
+        blockRows[blocksNumber - 1] = rowsNumber;
+
+    wrapIndex->blockRows    = blockRows;
+    wrapIndex->blocksNumber = blocksNumber;
+    wrapIndex->rowsNumber   = rowsNumber;
+    wrapIndex->width        = width;
+    return ERR_NO;
+}
+
+/**
+ * Frees memory allocated for wrap index.
+ * IN:
+ * @param wrapIndex - pointer to index to destroy
+ *
+ * OUT:
+ * wrapIndex fields set as zero (index isn't built for any width)
+ */
+void DestroyWrapIndex(WrapIndex * wrapIndex) {
+    free(wrapIndex->blockRows);
+    memset(wrapIndex, 0, sizeof(WrapIndex));
+}
+
+/**
+ * Gives number of row in wrap view mode which symbol belongs to.
+ * Takes a prefix sum and adds rows of at most WRAP_BLOCK_SIZE - 1 lines.
+ * IN:
+ * @param wrapIndex - pointer to built wrap index
+ * @param index - pointer to index of text lines wrap index is built of
+ * @param lineNumber - number of line symbol belongs to
+ * @param position - position of symbol to the right from it's line beginning
+ *
+ * OUT:
+ * @return number of row counting from the beginning of text
+ */
+long long GetWrapRow(WrapIndex const * wrapIndex, LineIndex const * index, long long lineNumber, long long position) {
+    long long row;
+    long long line;
+
+    if (lineNumber >= index->linesNumber)
+        return wrapIndex->rowsNumber;
+
+    line = lineNumber & ~(long long)(WRAP_BLOCK_SIZE - 1);
+    row = wrapIndex->blockRows[lineNumber >> WRAP_BLOCK_SHIFT];
+    for (; line < lineNumber; ++line)
+        row += CountWrapRows(index, line, wrapIndex->width);
+
+    return row + position / wrapIndex->width;
+}
+
+/**
+ * Finds line and position in it which row in wrap view mode begins from.
+ * Binary searches prefix sums and walks at most WRAP_BLOCK_SIZE lines.
+ * IN:
+ * @param wrapIndex - pointer to built wrap index
+ * @param index - pointer to index of text lines wrap index is built of
+ * @param row - number of row (it's cut to range of existing rows)
+ *
+ * OUT:
+ * @param position - gets position of row beginning to the right from it's line beginning
+ * @return number of line row belongs to
+ */
+long long FindWrapRow(WrapIndex const * wrapIndex, LineIndex const * index, long long row, long long * position) {
+    long long left = 0;
+    long long right = wrapIndex->blocksNumber - 1;
+    long long middle, line, rows;
+
+    if (row >= wrapIndex->rowsNumber)
+        row = wrapIndex->rowsNumber - 1;
+    if (row < 0)
+        row = 0;
+
+    // the last block which begins not after the row (the first block always begins with row 0)
+    while (left < right) {
+        middle = left + (right - left + 1) / 2;
+        if (middle << WRAP_BLOCK_SHIFT < index->linesNumber && wrapIndex->blockRows[middle] <= row)
+            left = middle;
+        else
+            right = middle - 1;
+    }
+
+    row -= wrapIndex->blockRows[left];
+    for (line = left << WRAP_BLOCK_SHIFT; line < index->linesNumber - 1; ++line) {
+        rows = CountWrapRows(index, line, wrapIndex->width);
+        if (row < rows)
+            break;
+        row -= rows;
+    }
+
+    *position = row * wrapIndex->width;
+    return line;
+}
+
+/**
+ * Moves row in wrap view mode by specified number of rows. Rows of the same line are passed at once,
+ * so it takes time proportional to number of passed lines.
+ * IN:
+ * @param index - pointer to index of text lines
+ * @param width - number of characters in row (values less than 1 are treated as 1)
+ * @param rows - number of rows to move down by (negative moves up)
+ *
+ * INOUT:
+ * @param cursor - pointer to row to move, it stops at the first or the last row of text
+ *
+ * OUT:
+ * @return number of rows cursor has been moved by (negative if it's moved up)
+ */
+long long MoveWrapCursor(WrapCursor * cursor, LineIndex const * index, int width, long long rows) {
+    long long rowsLeft = rows;
+    long long length, lineRows;
+
+    if (width < 1)
+        width = 1;
+    if (index->linesNumber == 0)
+        return 0;
+
+    while (rowsLeft > 0) {
+        // rows of current line below cursor
+        length   = GetLineContentEnd(index, cursor->line) - GetIndexedLineBeginning(index, cursor->line);
+        lineRows = (length > cursor->position) ? (length - cursor->position - 1) / width : 0;
+        if (rowsLeft <= lineRows || cursor->line + 1 >= index->linesNumber) {
+            lineRows = min(rowsLeft, lineRows);
+            cursor->position += lineRows * width;
+            rowsLeft -= lineRows;
+            break;
+        }
+        rowsLeft -= lineRows + 1;
+        cursor->line++;
+        cursor->position = 0;
+    }
+
+    while (rowsLeft < 0) {
+        // rows of current line above cursor
+        lineRows = cursor->position / width;
+        if (-rowsLeft <= lineRows || cursor->line == 0) {
+            lineRows = min(-rowsLeft, lineRows);
+            cursor->position -= lineRows * width;
+            rowsLeft += lineRows;
+            break;
+        }
+        rowsLeft += lineRows + 1;
+        cursor->line--;
+        cursor->position = (CountWrapRows(index, cursor->line, width) - 1) * width;
+    }
+
+    return rows - rowsLeft;
+}
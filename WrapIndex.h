@@ -0,0 +1,34 @@
+#ifndef WRAPINDEX_H_INCLUDED
+#define WRAPINDEX_H_INCLUDED
+
+#include "Error.h"
+#include "LineIndexer.h"
+
+#define WRAP_BLOCK_SHIFT 6
+#define WRAP_BLOCK_SIZE (1 << WRAP_BLOCK_SHIFT)    // number of lines summed up in each prefix sum
+
+/* cumulative number of rows lines take in wrap view mode with specified width
+ * (line of length L takes ceil(L / width) rows, empty line takes one row) */
+typedef struct {
+    long long * blockRows;      // Array of [blocksNumber] numbers of rows before every block of [WRAP_BLOCK_SIZE] lines
+    long long blocksNumber;     // Number of blocks
+    long long rowsNumber;       // Number of rows of the entire text
+    int width;                  // Width index is built for (0 if index isn't built)
+} WrapIndex;
+
+// row in wrap view mode: it's line and beginning, moved by rows without walking through rows of the same line
+typedef struct {
+    long long line;             // number of line row belongs to
+    long long position;         // position of row beginning counting from line beginning
+} WrapCursor;
+
+ErrorType BuildWrapIndex(WrapIndex * wrapIndex, LineIndex const * index, int width);
+ErrorType ExtendWrapIndex(WrapIndex * wrapIndex, LineIndex const * index, long long firstLine);
+void DestroyWrapIndex(WrapIndex * wrapIndex);
+long long CountWrapRows(LineIndex const * index, long long lineNumber, int width);
+long long CountTotalWrapRows(LineIndex const * index, int width);
+long long GetWrapRow(WrapIndex const * wrapIndex, LineIndex const * index, long long lineNumber, long long position);
+long long FindWrapRow(WrapIndex const * wrapIndex, LineIndex const * index, long long row, long long * position);
+long long MoveWrapCursor(WrapCursor * cursor, LineIndex const * index, int width, long long rows);
+
+#endif // WRAPINDEX_H_INCLUDED
@@ -1,452 +1,871 @@
-#if defined(UNICODE) && !defined(_UNICODE)
-    #define _UNICODE
-#elif defined(_UNICODE) && !defined(UNICODE)
-    #define UNICODE
-#endif
-
-#include <tchar.h>
-#include <windows.h>
-#include <stdio.h>
-#include "TextModel.h"
-#include "Menu.h"
-#include "Error.h"
-
-// declare Windows procedure
-LRESULT CALLBACK WindowProcedure (HWND, UINT, WPARAM, LPARAM);
-
-int WINAPI WinMain (HINSTANCE hThisInstance,
-                    HINSTANCE hPrevInstance,
-                    LPSTR lpszArgument,
-                    int nCmdShow) {
-    static char szApplicationName[] = "TextViewer";
-    HWND hWindow;                       // handle for our window
-    MSG message;                        // here message to the application is saved
-    WNDCLASSEX windowClassExtended;     // data structure for the window class
-
-    // REMOVED 30/11/2019:
-    // if (lpszArgument == NULL || strcmp(lpszArgument, "") == 0) {
-    //     PrintError(NULL, ERR_ARGC, __FILE__, __LINE__);
-    //     return ERR_ARGC;
-    // }
-
-    // the window structure
-    windowClassExtended.hInstance     = hThisInstance;
-    windowClassExtended.lpszClassName = szApplicationName;
-    windowClassExtended.lpfnWndProc   = WindowProcedure;
-    windowClassExtended.style         = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
-    windowClassExtended.cbSize        = sizeof(WNDCLASSEX);
-
-    // use default icon and mouse-pointer
-    windowClassExtended.hbrBackground = (HBRUSH)GetStockObject(WHITE_BRUSH);
-    windowClassExtended.hCursor = LoadCursor(NULL, IDC_ARROW);
-    windowClassExtended.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
-    windowClassExtended.hIcon   = LoadIcon(NULL, IDI_APPLICATION);
-    windowClassExtended.lpszMenuName = "Menu";
-    windowClassExtended.cbClsExtra = 0;         // no extra bytes after the window class structure
-    windowClassExtended.cbWndExtra = 0;         // or the window instance
-
-    // register the window class, and if it fails quit the program
-    if (!RegisterClassEx(&windowClassExtended)) {
-        PrintError(NULL, ERR_UNKNOWN, __FILE__, __LINE__);
-        return ERR_UNKNOWN;
-    }
-
-    // the class is registered, let's create the program
-    hWindow = CreateWindowEx(
-           0,                   // extended possibilities for variation
-           windowClassExtended.lpszClassName,
-           windowClassExtended.lpszClassName,
-           WS_OVERLAPPEDWINDOW | WS_HSCROLL | WS_VSCROLL,
-           CW_USEDEFAULT,       // windows decides the position
-           CW_USEDEFAULT,       // where the window ends up on the screen
-           CW_USEDEFAULT,       // the program's width
-           CW_USEDEFAULT,       // and height in pixels
-           HWND_DESKTOP,        // the window is a child-window to desktop
-           NULL,
-           hThisInstance,       // program Instance handler
-           lpszArgument         // window Creation data (command line argument passed)
-           );
-
-    // make the window visible on the screen
-    ShowWindow (hWindow, nCmdShow);
-
-    // run the message loop. It will run until GetMessage() returns 0
-    while (GetMessage(&message, NULL, 0, 0)) {
-        TranslateMessage(&message);    // Translate virtual-key message into character message
-        DispatchMessage(&message);     // Send message to WindowProcedure
-    }
-
-    // the program return-value is the value that PostQuitMessage() gave
-    return message.wParam;
-}
-
-/**
- * Initializes OPENFILENAME structure with information for Open dialog box.
- * IN:
- * @param hWindow - handler of window
- *
- * OUT:
- * @param openFilename - pointer to OPENFILENAME structure, initialized with default values
- */
-void InitOpenFilename(HWND hWindow, OPENFILENAME * openFilename) {
-    char * szFilter = "Text Files(*.TXT)\0*.txt\0";
-
-    openFilename->lStructSize       = sizeof(OPENFILENAME);
-    openFilename->hwndOwner         = hWindow;
-    openFilename->hInstance         = NULL;
-    openFilename->lpstrFilter       = szFilter;
-    openFilename->lpstrCustomFilter = NULL;
-    openFilename->nMaxCustFilter    = 0;
-    openFilename->nFilterIndex      = 0;
-    openFilename->lpstrFile         = NULL;
-    openFilename->nMaxFile          = _MAX_PATH;
-    openFilename->lpstrFileTitle    = NULL;
-    openFilename->nMaxFileTitle     = _MAX_FNAME + _MAX_EXT;
-    openFilename->lpstrInitialDir   = NULL;
-    openFilename->lpstrTitle        = NULL;
-    openFilename->Flags             = 0;
-    openFilename->nFileOffset       = 0;
-    openFilename->nFileExtension    = 0;
-    openFilename->lpstrDefExt       = "txt";
-    openFilename->lCustData         = 0L;
-    openFilename->lpfnHook          = NULL;
-    openFilename->lpTemplateName    = NULL;
-}
-
-/**
- * Pops standard Windows file open dialog to get filename to process
- * and saves this information in OPENFILENAME structure.
- * IN:
- * @param hWindow - handler of window
- * @param openFilename - pointer to structure for saving info
- *
- * OUT:
- * @param pstrFilename - buffer, saves name of file to open
- * @return result of comdlg32.lib function GetOpenFileName()
- * (0 if failed or dialog box was closed or Cancel button was pressed)
- */
-BOOL PopFileOpenDialog(HWND hWindow, OPENFILENAME * openFilename, PSTR pstrFilename) {
-    openFilename->hwndOwner = hWindow;
-    openFilename->lpstrFile = pstrFilename;
-    openFilename->Flags = OFN_HIDEREADONLY | OFN_CREATEPROMPT;
-
-    return GetOpenFileName((LPOPENFILENAME)openFilename);
-}
-
-// this function is called by the Windows function DispatchMessage()
-LRESULT CALLBACK WindowProcedure (HWND hWindow, UINT message, WPARAM wParam, LPARAM lParam) {
-    static TextModel model = { NULL, NULL };
-    static ErrorType errorType = ERR_NO;
-    HDC hDeviceContext;
-    PAINTSTRUCT paintStruct;
-    TEXTMETRIC textMetric;
-    RECT invalidRectangle;
-    RECT invalidChars;
-    char const * line = NULL;
-    long capacityCharsX;
-    long prevFirstSymbol;
-    long prevFirstLine;
-    long lineLength;
-    long incrementX;
-    long incrementY;
-    int scrollPosition;
-    OPENFILENAME openFilename;
-    PSTR pstrFilename;
-
-    // ADDED 30/11/2019:
-    if (errorType != ERR_NO) {
-        return DefWindowProc (hWindow, message, wParam, lParam);
-    }
-
-    // handle message
-    switch (message) {
-    case WM_CREATE:
-        // processing input file to build stored and displayed models
-        errorType = BuildTextModel(&model, *(char**)lParam);
-        if (errorType != ERR_NO) {
-            SendMessage(hWindow, WM_DESTROY, 0, 0);
-            break;
-        }
-
-        // device context initialization
-        hDeviceContext = GetDC(hWindow);
-        SetMapMode(hDeviceContext, MM_TEXT);
-        SelectObject(hDeviceContext, GetStockObject(SYSTEM_FIXED_FONT));
-
-        // set text metrics
-        GetTextMetrics(hDeviceContext, &textMetric);
-        model.displayed->charPixelsX = textMetric.tmAveCharWidth;
-        model.displayed->charPixelsY = textMetric.tmHeight;
-
-        ReleaseDC(hWindow, hDeviceContext);
-
-        break;
-    // WM_CREATE
-
-    case WM_COMMAND:
-        switch (LOWORD(wParam)) {
-        case IDM_FILE_OPEN:
-            InitOpenFilename(hWindow, &openFilename);
-            pstrFilename = (PSTR)calloc(_MAX_PATH, sizeof(char));
-            if (PopFileOpenDialog(hWindow, &openFilename, pstrFilename)) {
-                errorType = RebuildTextModel(&model, openFilename.lpstrFile);
-                if (errorType != ERR_NO) {
-                    free(pstrFilename);
-                    SendMessage(hWindow, WM_DESTROY, 0, 0);
-                }
-            }
-            free(pstrFilename);
-            break;
-
-        case IDM_FILE_EXIT:
-            DestroyTextModel(&model);
-            PostMessage(hWindow, WM_CLOSE, 0, 0);
-            break;
-
-        case IDM_VIEW_STANDARD:
-            if (model.displayed->viewMode != VIEW_MODE_STANDARD)
-                SwitchMode(model.stored, model.displayed, VIEW_MODE_STANDARD);
-            break;
-
-        case IDM_VIEW_WRAP:
-            if (model.displayed->viewMode != VIEW_MODE_WRAP)
-                SwitchMode(model.stored, model.displayed, VIEW_MODE_WRAP);
-            break;
-
-        default:
-            PrintError(NULL, ERR_UNKNOWN, __FILE__, __LINE__);
-            break;
-        }
-
-        // common actions for listed commands
-        if (LOWORD(wParam) == IDM_FILE_OPEN ||
-            LOWORD(wParam) == IDM_VIEW_STANDARD ||
-            LOWORD(wParam) == IDM_VIEW_WRAP) {
-                // update metrics binded with window size
-                // 0 passed as a parameter to force recount of linesNumberWrap
-                UpdateModelMetrics(hWindow, model.stored, model.displayed, 0);
-
-                // force repaint
-                InvalidateRect(hWindow, NULL, TRUE);
-                UpdateWindow(hWindow);
-            }
-
-        break;
-    // WM_COMMAND
-
-    case WM_SIZE:
-        // if error has alreary occured during opening file
-        if (errorType != ERR_NO)
-            break;
-
-        // set new metrics of displayed model
-        capacityCharsX = model.displayed->capacityCharsX;   // temp value with previous capacity
-        model.displayed->clientAreaX    = LOWORD(lParam);
-        model.displayed->clientAreaY    = HIWORD(lParam);
-        model.displayed->capacityCharsX = LOWORD(lParam) / model.displayed->charPixelsX;
-        model.displayed->capacityCharsY = HIWORD(lParam) / model.displayed->charPixelsY;
-
-        UpdateModelMetrics(hWindow, model.stored, model.displayed, capacityCharsX);
-        break;
-    // WM_SIZE
-
-    case WM_MOVE:
-        InvalidateRect(hWindow, NULL, TRUE);
-        break;
-    // WM_MOVE
-
-    case WM_HSCROLL:
-        if (model.displayed->viewMode != VIEW_MODE_STANDARD)
-            break;
-        incrementX = 0;
-
-        switch (LOWORD(wParam)) {
-        case SB_LINEUP:
-            incrementX = -1;
-            break;
-        case SB_LINEDOWN:
-            incrementX = 1;
-            break;
-        case SB_PAGEUP:
-            incrementX = -model.displayed->capacityCharsX;
-            break;
-        case SB_PAGEDOWN:
-            incrementX = model.displayed->capacityCharsX;
-            break;
-        case SB_THUMBTRACK:
-            incrementX = scrollToIncrementX(model.stored, model.displayed, HIWORD(wParam));
-            break;
-        default:
-            break;
-        }
-
-        if (incrementX != 0) {
-            // update model and set valid increment
-            incrementX = UpdateModelStandardX(model.stored, model.displayed, incrementX);
-
-            // set window changes
-            ScrollWindow(hWindow, -incrementX * model.displayed->charPixelsX, 0, NULL, NULL);
-            SetInvalidRectagleX(model.displayed, incrementX, &invalidRectangle);
-            InvalidateRect(hWindow, &invalidRectangle, TRUE);
-
-            // process scrollbars changes
-            if (LOWORD(wParam) == SB_THUMBTRACK)
-                scrollPosition = HIWORD(wParam);
-            else
-                scrollPosition = countScrollPositionX(model.stored, model.displayed);
-
-            SetScrollPos(hWindow, SB_HORZ, scrollPosition, TRUE);
-        }
-
-        break;
-    // WM_HSCROLL
-
-    case WM_VSCROLL:
-        incrementY = 0;
-
-        switch (LOWORD(wParam)) {
-        case SB_LINEUP:
-            incrementY = -1;
-            break;
-        case SB_LINEDOWN:
-            incrementY = 1;
-            break;
-        case SB_PAGEUP:
-            incrementY = -model.displayed->capacityCharsY;
-            break;
-        case SB_PAGEDOWN:
-            incrementY = model.displayed->capacityCharsY;
-            break;
-        case SB_THUMBTRACK:
-            incrementY = HIWORD(wParam);
-            incrementY = scrollToIncrementY(model.stored, model.displayed, HIWORD(wParam));
-            break;
-        default:
-            break;
-        }
-
-        if (incrementY != 0) {
-            // update model and set valid increment
-            if (model.displayed->viewMode == VIEW_MODE_STANDARD)
-                incrementY = UpdateModelStandardY(model.stored, model.displayed, incrementY);
-            if (model.displayed->viewMode == VIEW_MODE_WRAP)
-                incrementY = UpdateModelWrapY(model.stored, model.displayed, incrementY);
-
-            // set window changes
-            ScrollWindow(hWindow, 0, -incrementY * model.displayed->charPixelsY, NULL, NULL);
-            SetInvalidRectagleY(model.displayed, incrementY, &invalidRectangle);
-            InvalidateRect(hWindow, &invalidRectangle, TRUE);
-
-            // process scrollbars changes
-            if (LOWORD(wParam) == SB_THUMBTRACK)
-                scrollPosition = HIWORD(wParam);
-            else
-                scrollPosition = countScrollPositionY(model.stored, model.displayed);
-
-            SetScrollPos(hWindow, SB_VERT, scrollPosition, TRUE);
-        }
-
-        break;
-    // WM_VSCROLL
-
-    case WM_KEYDOWN:
-        switch (wParam) {
-        case VK_UP:
-            PostMessage(hWindow, WM_VSCROLL, SB_LINEUP, (LPARAM)0);
-            break;
-        case VK_DOWN:
-            PostMessage(hWindow, WM_VSCROLL, SB_LINEDOWN, (LPARAM)0);
-            break;
-        case VK_LEFT:
-            PostMessage(hWindow, WM_HSCROLL, SB_LINEUP, (LPARAM)0);
-            break;
-        case VK_RIGHT:
-            PostMessage(hWindow, WM_HSCROLL, SB_LINEDOWN, (LPARAM)0);
-            break;
-        case VK_PRIOR:
-            PostMessage(hWindow, WM_VSCROLL, SB_PAGEUP, (LPARAM)0);
-            break;
-        case VK_NEXT:
-            PostMessage(hWindow, WM_VSCROLL, SB_PAGEDOWN, (LPARAM)0);
-            break;
-        case VK_HOME:
-            PostMessage(hWindow, WM_HSCROLL, SB_PAGEUP, (LPARAM)0);
-            break;
-        case VK_END:
-            PostMessage(hWindow, WM_HSCROLL, SB_PAGEDOWN, (LPARAM)0);
-            break;
-        default:
-            break;
-        }
-
-        break;
-    // WM_KEYDOWN
-
-    case WM_PAINT:
-        hDeviceContext = BeginPaint(hWindow, &paintStruct);
-        switch (model.displayed->viewMode) {
-        case VIEW_MODE_STANDARD:
-            invalidChars.top    = paintStruct.rcPaint.top    / model.displayed->charPixelsY;
-            invalidChars.bottom = paintStruct.rcPaint.bottom / model.displayed->charPixelsY;
-            invalidChars.left   = paintStruct.rcPaint.left   / model.displayed->charPixelsX;
-            invalidChars.right  = paintStruct.rcPaint.right  / model.displayed->charPixelsX;
-
-            capacityCharsX = invalidChars.right - invalidChars.left;
-            for (incrementY = invalidChars.top; incrementY < invalidChars.bottom; ++incrementY) {
-                line = GetLineStandard(model.stored,
-                                       model.displayed->firstLine + incrementY,
-                                       model.displayed->firstSymbol + invalidChars.left,
-                                       capacityCharsX,
-                                       &lineLength);
-                if (line == NULL) break;
-                TextOut(hDeviceContext,
-                        paintStruct.rcPaint.left,
-                        incrementY * model.displayed->charPixelsY,
-                        line,
-                        lineLength);
-            }
-            break;
-
-        case  VIEW_MODE_WRAP:
-            invalidChars.top    = paintStruct.rcPaint.top    / model.displayed->charPixelsY;
-            invalidChars.bottom = paintStruct.rcPaint.bottom / model.displayed->charPixelsY;
-
-            // process first line
-            prevFirstLine   = model.displayed->firstLine;
-            prevFirstSymbol = model.displayed->firstSymbol;
-            line = GetLineWrap(model.stored, model.displayed, invalidChars.top, &lineLength, &prevFirstSymbol, &prevFirstLine);
-            if (line == NULL) break;
-            TextOut(hDeviceContext, 0, paintStruct.rcPaint.top, line, lineLength);
-
-            // process the remaining lines
-            for (incrementY = invalidChars.top + 1; incrementY < invalidChars.bottom; ++incrementY) {
-                line = GetLineWrap(model.stored, model.displayed, 1, &lineLength, &prevFirstSymbol, &prevFirstLine);
-                if (line == NULL) break;
-                TextOut(hDeviceContext,
-                        0,
-                        incrementY * model.displayed->charPixelsY,
-                        line,
-                        lineLength);
-            }
-            break;
-
-        default:
-            break;
-        }
-
-        EndPaint(hWindow, &paintStruct);
-        break;
-    // WM_PAINT
-
-    case WM_DESTROY:
-        DestroyTextModel(&model);
-        PostQuitMessage(errorType);
-        break;
-    // WM_DESTROY
-
-    default:
-        return DefWindowProc (hWindow, message, wParam, lParam);
-    }
-
-    return errorType;
-}
+#if defined(UNICODE) && !defined(_UNICODE)
+    #define _UNICODE
+#elif defined(_UNICODE) && !defined(UNICODE)
+    #define UNICODE
+#endif
+
+#include <tchar.h>
+#include <windows.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "TextModel.h"
+#include "DocumentManager.h"
+#include "ModelWindow.h"
+#include "TabIndex.h"
+#include "Menu.h"
+#include "Error.h"
+#include "Trace.h"
+
+// posted by background indexing thread when new lines of file are indexed
+#define WM_INDEXING_PROGRESS (WM_APP + 1)
+
+// posted by search thread when new hits are found
+#define WM_SEARCH_PROGRESS (WM_APP + 2)
+
+// posted by trigram indexing thread when it's progress changes
+#define WM_TRIGRAM_PROGRESS (WM_APP + 3)
+
+// posted by filter thread when new matching lines are found
+#define WM_FILTER_PROGRESS (WM_APP + 4)
+
+#define FIND_PATTERN_SIZE 256   // size of buffer for string typed in find dialog
+
+// timer checking growth of followed file
+#define FOLLOW_TIMER_ID 1
+#define FOLLOW_PERIOD   500     // in milliseconds
+
+// files written when program built with tracing ends (see Trace.h)
+#define TRACE_FILENAME "TextViewer.trace.json"
+#define TRACE_SUMMARY_FILENAME "TextViewer.trace.txt"
+
+// declare Windows procedure
+LRESULT CALLBACK WindowProcedure (HWND, UINT, WPARAM, LPARAM);
+
+// modeless find dialog (NULL if it's closed)
+static HWND hFindDialog = NULL;
+
+// files opened in window, one of them is shown
+static DocumentManager documents;
+
+int WINAPI WinMain (HINSTANCE hThisInstance,
+                    HINSTANCE hPrevInstance,
+                    LPSTR lpszArgument,
+                    int nCmdShow) {
+    static char szApplicationName[] = "TextViewer";
+    HWND hWindow;                       // handle for our window
+    MSG message;                        // here message to the application is saved
+    WNDCLASSEX windowClassExtended;     // data structure for the window class
+#ifdef TRACE_ENABLED
+    ErrorType errorType;
+    FILE * summary;                     // latency histograms of painting and scrolling
+#endif
+
+    // REMOVED 30/11/2019:
+    // if (lpszArgument == NULL || strcmp(lpszArgument, "") == 0) {
+    //     PrintError(NULL, ERR_ARGC, __FILE__, __LINE__);
+    //     return ERR_ARGC;
+    // }
+
+    // the window structure
+    windowClassExtended.hInstance     = hThisInstance;
+    windowClassExtended.lpszClassName = szApplicationName;
+    windowClassExtended.lpfnWndProc   = WindowProcedure;
+    windowClassExtended.style         = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
+    windowClassExtended.cbSize        = sizeof(WNDCLASSEX);
+
+    // use default icon and mouse-pointer
+    windowClassExtended.hbrBackground = (HBRUSH)GetStockObject(WHITE_BRUSH);
+    windowClassExtended.hCursor = LoadCursor(NULL, IDC_ARROW);
+    windowClassExtended.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
+    windowClassExtended.hIcon   = LoadIcon(NULL, IDI_APPLICATION);
+    windowClassExtended.lpszMenuName = "Menu";
+    windowClassExtended.cbClsExtra = 0;         // no extra bytes after the window class structure
+    windowClassExtended.cbWndExtra = 0;         // or the window instance
+
+    // register the window class, and if it fails quit the program
+    if (!RegisterClassEx(&windowClassExtended)) {
+        PrintError(NULL, ERR_UNKNOWN, __FILE__, __LINE__);
+        return ERR_UNKNOWN;
+    }
+
+    // the class is registered, let's create the program
+    hWindow = CreateWindowEx(
+           0,                   // extended possibilities for variation
+           windowClassExtended.lpszClassName,
+           windowClassExtended.lpszClassName,
+           WS_OVERLAPPEDWINDOW | WS_HSCROLL | WS_VSCROLL,
+           CW_USEDEFAULT,       // windows decides the position
+           CW_USEDEFAULT,       // where the window ends up on the screen
+           CW_USEDEFAULT,       // the program's width
+           CW_USEDEFAULT,       // and height in pixels
+           HWND_DESKTOP,        // the window is a child-window to desktop
+           NULL,
+           hThisInstance,       // program Instance handler
+           lpszArgument         // window Creation data (command line argument passed)
+           );
+
+#ifdef TRACE_ENABLED
+    if (StartTrace() != ERR_NO)
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+#endif
+
+    // make the window visible on the screen
+    ShowWindow (hWindow, nCmdShow);
+
+    // run the message loop. It will run until GetMessage() returns 0
+    while (GetMessage(&message, NULL, 0, 0)) {
+        // keyboard messages of modeless find dialog are processed by dialog itself
+        if (hFindDialog != NULL && IsDialogMessage(hFindDialog, &message))
+            continue;
+        TranslateMessage(&message);    // Translate virtual-key message into character message
+        DispatchMessage(&message);     // Send message to WindowProcedure
+    }
+
+#ifdef TRACE_ENABLED
+    // background threads are finished with documents, so trace is complete
+    errorType = SaveTrace(TRACE_FILENAME);
+    if (errorType != ERR_NO)
+        PrintError(NULL, errorType, __FILE__, __LINE__);
+    if ((summary = fopen(TRACE_SUMMARY_FILENAME, "w")) != NULL) {
+        PrintTraceSummary(summary);
+        fclose(summary);
+    }
+    DestroyTrace();
+#endif
+
+    // the program return-value is the value that PostQuitMessage() gave
+    return message.wParam;
+}
+
+/**
+ * Initializes OPENFILENAME structure with information for Open dialog box.
+ * IN:
+ * @param hWindow - handler of window
+ *
+ * OUT:
+ * @param openFilename - pointer to OPENFILENAME structure, initialized with default values
+ */
+void InitOpenFilename(HWND hWindow, OPENFILENAME * openFilename) {
+    char * szFilter = "Text Files(*.TXT)\0*.txt\0Compressed Text Files(*.GZ;*.ZST)\0*.gz;*.zst\0All Files(*.*)\0*.*\0";
+
+    openFilename->lStructSize       = sizeof(OPENFILENAME);
+    openFilename->hwndOwner         = hWindow;
+    openFilename->hInstance         = NULL;
+    openFilename->lpstrFilter       = szFilter;
+    openFilename->lpstrCustomFilter = NULL;
+    openFilename->nMaxCustFilter    = 0;
+    openFilename->nFilterIndex      = 0;
+    openFilename->lpstrFile         = NULL;
+    openFilename->nMaxFile          = _MAX_PATH;
+    openFilename->lpstrFileTitle    = NULL;
+    openFilename->nMaxFileTitle     = _MAX_FNAME + _MAX_EXT;
+    openFilename->lpstrInitialDir   = NULL;
+    openFilename->lpstrTitle        = NULL;
+    openFilename->Flags             = 0;
+    openFilename->nFileOffset       = 0;
+    openFilename->nFileExtension    = 0;
+    openFilename->lpstrDefExt       = "txt";
+    openFilename->lCustData         = 0L;
+    openFilename->lpfnHook          = NULL;
+    openFilename->lpTemplateName    = NULL;
+}
+
+/**
+ * Pops standard Windows file open dialog to get filename to process
+ * and saves this information in OPENFILENAME structure.
+ * IN:
+ * @param hWindow - handler of window
+ * @param openFilename - pointer to structure for saving info
+ *
+ * OUT:
+ * @param pstrFilename - buffer, saves name of file to open
+ * @return result of comdlg32.lib function GetOpenFileName()
+ * (0 if failed or dialog box was closed or Cancel button was pressed)
+ */
+BOOL PopFileOpenDialog(HWND hWindow, OPENFILENAME * openFilename, PSTR pstrFilename) {
+    openFilename->hwndOwner = hWindow;
+    openFilename->lpstrFile = pstrFilename;
+    openFilename->Flags = OFN_HIDEREADONLY | OFN_CREATEPROMPT;
+
+    return GetOpenFileName((LPOPENFILENAME)openFilename);
+}
+
+/**
+ * Notifies window about lines indexed in background. Called from indexing thread.
+ * IN:
+ * @param context - handler of window
+ */
+void NotifyIndexingProgress(void * context) {
+    PostMessage((HWND)context, WM_INDEXING_PROGRESS, 0, 0);
+}
+
+/**
+ * Notifies window about hits found by search. Called from search thread.
+ * IN:
+ * @param context - handler of window
+ */
+void NotifySearchProgress(void * context) {
+    PostMessage((HWND)context, WM_SEARCH_PROGRESS, 0, 0);
+}
+
+/**
+ * Notifies window about progress of trigram indexing. Called from trigram indexing thread.
+ * IN:
+ * @param context - handler of window
+ */
+void NotifyTrigramProgress(void * context) {
+    PostMessage((HWND)context, WM_TRIGRAM_PROGRESS, 0, 0);
+}
+
+/**
+ * Notifies window about lines found by filter. Called from filter thread.
+ * IN:
+ * @param context - handler of window
+ */
+void NotifyFilterProgress(void * context) {
+    PostMessage((HWND)context, WM_FILTER_PROGRESS, 0, 0);
+}
+
+/**
+ * Appends formatted text to string, text which doesn't fit into buffer is cut.
+ * IN:
+ * @param size - size of buffer
+ * @param format - format of appended text like for printf
+ *
+ * INOUT:
+ * @param text - buffer with string
+ */
+void AppendTitle(char * text, size_t size, char const * format, ...) {
+    size_t length = strlen(text);
+    va_list arguments;
+
+    if (length + 1 >= size)
+        return;
+    va_start(arguments, format);
+    vsnprintf(text + length, size - length, format, arguments);
+    va_end(arguments);
+}
+
+/**
+ * Shows part of file indexed in background and state of search in window title.
+ * IN:
+ * @param hWindow - handler of window
+ * @param stored - pointer to stored model structure of text file
+ */
+void ShowIndexingProgress(HWND hWindow, StoredModel const * stored) {
+    char title[160 + _MAX_PATH];
+    double progress = GetIndexingProgress(stored);
+    double searched, trigrams, filtered;
+    long long hitNumber, hitsNumber, shownLines;
+    char const * filename;
+
+    // name of shown file without directories
+    strcpy(title, "TextViewer");
+    if (documents.current >= 0 && (filename = documents.documents[documents.current].filename) != NULL) {
+        if (strrchr(filename, '\\') != NULL)
+            filename = strrchr(filename, '\\') + 1;
+        AppendTitle(title, sizeof(title), " - %s", filename);
+    }
+    if (documents.documentsNumber > 1)
+        AppendTitle(title, sizeof(title), " (%i of %i)", documents.current + 1, documents.documentsNumber);
+    if (progress < 1.0)
+        AppendTitle(title, sizeof(title), " - indexing %i%%", (int)(progress * 100));
+    trigrams = GetTrigramIndexingProgress(stored);
+    if (trigrams >= 0.0)
+        AppendTitle(title, sizeof(title), " - building trigram index %i%%", (int)(trigrams * 100));
+
+    filtered = GetFilterState(stored, &shownLines);
+    if (filtered >= 0.0) {
+        AppendTitle(title, sizeof(title), " - %lld lines shown", shownLines);
+        if (filtered < 1.0)
+            AppendTitle(title, sizeof(title), ", filtering %i%%", (int)(filtered * 100));
+    }
+
+    searched = GetSearchState(stored, &hitNumber, &hitsNumber);
+    if (searched >= 0.0) {
+        if (hitNumber >= 0)
+            AppendTitle(title, sizeof(title), " - match %lld of %lld", hitNumber + 1, hitsNumber);
+        else
+            AppendTitle(title, sizeof(title), " - %lld matches", hitsNumber);
+        if (searched < 1.0)
+            AppendTitle(title, sizeof(title), ", searching %i%%", (int)(searched * 100));
+    }
+    if (progress < 1.0 || trigrams >= 0.0 || (searched >= 0.0 && searched < 1.0) || (filtered >= 0.0 && filtered < 1.0))
+        AppendTitle(title, sizeof(title), " (Esc to stop)");
+    SetWindowText(hWindow, title);
+}
+
+/**
+ * Shows memory taken by each opened document in message box.
+ * IN:
+ * @param hWindow - handler of window
+ */
+void ShowMemoryReport(HWND hWindow) {
+    ModelMemory memory;
+    long long total = 0;
+    char * report;
+    char const * filename;
+    size_t length = 0;
+    int i;
+
+    report = (char*)malloc((size_t)(documents.documentsNumber + 1) * (_MAX_PATH + 160));
+    if (report == NULL) {
+        PrintError(NULL, ERR_NOMEM, __FILE__, __LINE__);
+        return;
+    }
+    for (i = 0; i < documents.documentsNumber; ++i) {
+        total += GetDocumentMemory(&documents, i, &memory);
+        filename = (documents.documents[i].filename != NULL) ? documents.documents[i].filename : "(blank)";
+        length += (size_t)sprintf(report + length, "%s%s\ntext %.1f MB, index %.1f MB, caches %.1f MB, mapped %.1f MB%s\n\n",
+                          (i == documents.current) ? "* " : "", filename, memory.text / 1048576.0, memory.index / 1048576.0,
+                          memory.caches / 1048576.0, memory.mapped / 1048576.0,
+                          (documents.documents[i].model.stored == NULL) ? " (unloaded)" : "");
+    }
+    sprintf(report + length, "total %.1f MB of %.1f MB budget", total / 1048576.0, documents.budget / 1048576.0);
+    MessageBox(hWindow, report, "Memory usage", MB_OK | MB_ICONINFORMATION);
+    free(report);
+}
+
+// this function is called by the Windows function DispatchMessage()
+LRESULT CALLBACK WindowProcedure (HWND hWindow, UINT message, WPARAM wParam, LPARAM lParam) {
+    static TextModel model = { NULL, NULL };        // model of shown document (see documents)
+    static ErrorType errorType = ERR_NO;
+    static BOOL follow = FALSE;         // file growth is shown (see IDM_VIEW_FOLLOW)
+    static BOOL utf8 = FALSE;           // text is shown as UTF-8 (see IDM_VIEW_UTF8)
+    static BOOL tabs = TRUE;            // tabs are expanded to tab stops (see IDM_VIEW_TABS)
+    static BOOL highlight = FALSE;      // log lines are highlighted (see IDM_VIEW_HIGHLIGHT)
+    static UINT findMessage = 0;        // message sent by find dialog
+    static FINDREPLACE findReplace;     // settings of find dialog
+    static char findWhat[FIND_PATTERN_SIZE];    // string typed in find dialog
+    static char searched[FIND_PATTERN_SIZE];    // string searched in file
+    static BOOL regex = FALSE;          // searched string is regular expression (see IDM_SEARCH_REGEX)
+    static DisplayList shownRows;       // frame of client area painted last
+    static DisplayList nextRows;        // frame built after scrolling to compare it with the shown one
+    LPFINDREPLACE findRequest;
+    ErrorType searchError;
+    ErrorType filterError;
+    ErrorType listError;
+    long long hitNumber, hitsNumber;
+    BOOL moved;
+    HDC hDeviceContext;
+    PAINTSTRUCT paintStruct;
+    TEXTMETRIC textMetric;
+    long capacityCharsX;
+    long long lineWidth;
+    long long incrementX;
+    long long incrementY;
+    int scrollPosition;
+    OPENFILENAME openFilename;
+    PSTR pstrFilename;
+    TRACE_START(messageStart);          // latency of painting and scrolling is traced
+
+    // ADDED 30/11/2019:
+    if (errorType != ERR_NO) {
+        return DefWindowProc (hWindow, message, wParam, lParam);
+    }
+
+    // message of find dialog is registered at run time, so it can't be a case of switch
+    if (findMessage != 0 && message == findMessage) {
+        findRequest = (LPFINDREPLACE)lParam;
+        if (findRequest->Flags & FR_DIALOGTERM) {
+            hFindDialog = NULL;
+            return 0;
+        }
+        if ((findRequest->Flags & FR_FINDNEXT) == 0 || model.stored == NULL)
+            return 0;
+
+        // new string is searched in background, the first hit is shown as soon as it's found
+        moved = FALSE;
+        if (strcmp(findRequest->lpstrFindWhat, searched) != 0 || GetSearchState(model.stored, &hitNumber, &hitsNumber) < 0.0) {
+            strcpy(searched, findRequest->lpstrFindWhat);
+            searchError = StartSearch(model.stored, model.displayed, searched, strlen(searched), regex);
+            if (searchError != ERR_NO)
+                PrintError(NULL, searchError, __FILE__, __LINE__);
+        }
+        else
+            moved = ShowNextSearchHit(model.stored, model.displayed, (findRequest->Flags & FR_DOWN) != 0);
+
+        ShowIndexingProgress(hWindow, model.stored);
+        if (moved) {
+            UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+            InvalidateRect(hWindow, NULL, TRUE);
+        }
+        return 0;
+    }
+
+    // handle message
+    switch (message) {
+    case WM_CREATE:
+        // processing input file to build stored and displayed models
+        // (big files are indexed in background and shown as their lines are found)
+        SetIndexingNotification(NotifyIndexingProgress, hWindow);
+        SetSearchNotification(NotifySearchProgress, hWindow);
+        SetTrigramNotification(NotifyTrigramProgress, hWindow);
+        SetFilterNotification(NotifyFilterProgress, hWindow);
+        findMessage = RegisterWindowMessage(FINDMSGSTRING);
+        InitDocumentManager(&documents, DEFAULT_DOCUMENTS_BUDGET);
+        errorType = OpenDocument(&documents, *(char**)lParam);
+        if (errorType != ERR_NO) {
+            SendMessage(hWindow, WM_DESTROY, 0, 0);
+            break;
+        }
+        model = *GetShownModel(&documents);
+
+        // device context initialization
+        hDeviceContext = GetDC(hWindow);
+        SetMapMode(hDeviceContext, MM_TEXT);
+        SelectObject(hDeviceContext, GetStockObject(SYSTEM_FIXED_FONT));
+
+        // set text metrics
+        GetTextMetrics(hDeviceContext, &textMetric);
+        model.displayed->charPixelsX = textMetric.tmAveCharWidth;
+        model.displayed->charPixelsY = textMetric.tmHeight;
+
+        ReleaseDC(hWindow, hDeviceContext);
+
+        break;
+    // WM_CREATE
+
+    case WM_COMMAND:
+        switch (LOWORD(wParam)) {
+        case IDM_FILE_OPEN:
+            InitOpenFilename(hWindow, &openFilename);
+            pstrFilename = (PSTR)calloc(_MAX_PATH, sizeof(char));
+            if (PopFileOpenDialog(hWindow, &openFilename, pstrFilename)) {
+                // opened files stay in memory, the shown one stays if new one can't be opened (error is reported by model)
+                OpenDocument(&documents, openFilename.lpstrFile);
+                model = *GetShownModel(&documents);
+            }
+            free(pstrFilename);
+            break;
+
+        case IDM_FILE_CLOSE:
+            CloseDocument(&documents, documents.current);
+            model = *GetShownModel(&documents);
+            break;
+
+        case IDM_FILE_EXIT:
+            PostMessage(hWindow, WM_CLOSE, 0, 0);
+            break;
+
+        case IDM_WINDOW_NEXT:
+        case IDM_WINDOW_PREVIOUS:
+            if (documents.documentsNumber < 2)
+                break;
+            ShowDocument(&documents, (documents.current + documents.documentsNumber +
+                                      (LOWORD(wParam) == IDM_WINDOW_NEXT ? 1 : -1)) % documents.documentsNumber);
+            model = *GetShownModel(&documents);
+
+            // document keeps it's position, so metrics are updated with the same width
+            UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+            ShowIndexingProgress(hWindow, model.stored);
+            InvalidateRect(hWindow, NULL, TRUE);
+            break;
+
+        case IDM_WINDOW_MEMORY:
+            ShowMemoryReport(hWindow);
+            break;
+
+        case IDM_VIEW_STANDARD:
+            if (model.displayed->viewMode != VIEW_MODE_STANDARD)
+                SwitchMode(model.stored, model.displayed, VIEW_MODE_STANDARD);
+            break;
+
+        case IDM_VIEW_WRAP:
+            if (model.displayed->viewMode != VIEW_MODE_WRAP)
+                SwitchMode(model.stored, model.displayed, VIEW_MODE_WRAP);
+            break;
+
+        case IDM_VIEW_FOLLOW:
+            // file is polled: appended bytes are indexed on timer
+            follow = !follow;
+            CheckMenuItem(GetMenu(hWindow), IDM_VIEW_FOLLOW, follow ? MF_CHECKED : MF_UNCHECKED);
+            if (follow)
+                SetTimer(hWindow, FOLLOW_TIMER_ID, FOLLOW_PERIOD, NULL);
+            else
+                KillTimer(hWindow, FOLLOW_TIMER_ID);
+            break;
+
+        case IDM_VIEW_UTF8:
+            // lines are measured in characters here, it takes a pass over file
+            utf8 = !utf8;
+            CheckMenuItem(GetMenu(hWindow), IDM_VIEW_UTF8, utf8 ? MF_CHECKED : MF_UNCHECKED);
+            SwitchEncoding(model.stored, model.displayed, utf8);
+            break;
+
+        case IDM_VIEW_TABS:
+            // widths of lines with tabs are measured again when they're shown
+            tabs = !tabs;
+            CheckMenuItem(GetMenu(hWindow), IDM_VIEW_TABS, tabs ? MF_CHECKED : MF_UNCHECKED);
+            SwitchTabSize(model.stored, model.displayed, tabs ? DEFAULT_TAB_SIZE : 1);
+            break;
+
+        case IDM_VIEW_HIGHLIGHT:
+            // only shown lines are tokenized, metrics don't change
+            highlight = !highlight;
+            CheckMenuItem(GetMenu(hWindow), IDM_VIEW_HIGHLIGHT, highlight ? MF_CHECKED : MF_UNCHECKED);
+            if (SwitchHighlighting(model.stored, highlight))
+                InvalidateRect(hWindow, NULL, TRUE);
+            break;
+
+        case IDM_VIEW_FILTER:
+        case IDM_VIEW_REFINE:
+            // string typed in find dialog is the filter, matching lines are shown as they're found
+            // (refined filter searches only lines shown already)
+            filterError = StartFilter(model.stored, model.displayed, findWhat, strlen(findWhat), regex,
+                                      LOWORD(wParam) == IDM_VIEW_REFINE);
+            if (filterError != ERR_NO)
+                PrintError(NULL, filterError, __FILE__, __LINE__);
+            break;
+
+        case IDM_VIEW_UNFILTER:
+            // the first shown line stays at the top
+            ClearFilter(model.stored, model.displayed);
+            break;
+
+        case IDM_SEARCH_FIND:
+            if (hFindDialog != NULL) {
+                SetFocus(hFindDialog);
+                break;
+            }
+            memset(&findReplace, 0, sizeof(FINDREPLACE));
+            findReplace.lStructSize   = sizeof(FINDREPLACE);
+            findReplace.hwndOwner     = hWindow;
+            findReplace.lpstrFindWhat = findWhat;
+            findReplace.wFindWhatLen  = sizeof(findWhat);
+            findReplace.Flags         = FR_DOWN | FR_HIDEMATCHCASE | FR_HIDEWHOLEWORD;
+            hFindDialog = FindText(&findReplace);
+            break;
+
+        case IDM_SEARCH_REGEX:
+            // the same string is searched again with new meaning
+            regex = !regex;
+            searched[0] = '\0';
+            CheckMenuItem(GetMenu(hWindow), IDM_SEARCH_REGEX, regex ? MF_CHECKED : MF_UNCHECKED);
+            break;
+
+        case IDM_SEARCH_INDEX:
+            // searches started after index is built skip blocks without searched string
+            searchError = StartTrigramIndexing(model.stored);
+            if (searchError != ERR_NO)
+                PrintError(NULL, searchError, __FILE__, __LINE__);
+            ShowIndexingProgress(hWindow, model.stored);
+            break;
+
+        case IDM_SEARCH_NEXT:
+        case IDM_SEARCH_PREVIOUS:
+            if (!ShowNextSearchHit(model.stored, model.displayed, LOWORD(wParam) == IDM_SEARCH_NEXT))
+                break;
+
+            // position in line is kept in wrap mode, so metrics are updated with the same width
+            UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+            ShowIndexingProgress(hWindow, model.stored);
+            InvalidateRect(hWindow, NULL, TRUE);
+            break;
+
+        default:
+            PrintError(NULL, ERR_UNKNOWN, __FILE__, __LINE__);
+            break;
+        }
+
+        // common actions for listed commands
+        if (LOWORD(wParam) == IDM_FILE_OPEN ||
+            LOWORD(wParam) == IDM_FILE_CLOSE ||
+            LOWORD(wParam) == IDM_VIEW_STANDARD ||
+            LOWORD(wParam) == IDM_VIEW_WRAP ||
+            LOWORD(wParam) == IDM_VIEW_UTF8 ||
+            LOWORD(wParam) == IDM_VIEW_TABS ||
+            LOWORD(wParam) == IDM_VIEW_FILTER ||
+            LOWORD(wParam) == IDM_VIEW_REFINE ||
+            LOWORD(wParam) == IDM_VIEW_UNFILTER) {
+                // update metrics binded with window size
+                // 0 passed as a parameter to force recount of linesNumberWrap
+                UpdateWindowMetrics(hWindow, model.stored, model.displayed, 0);
+                ShowIndexingProgress(hWindow, model.stored);
+
+                // force repaint
+                InvalidateRect(hWindow, NULL, TRUE);
+                UpdateWindow(hWindow);
+            }
+
+        break;
+    // WM_COMMAND
+
+    case WM_SIZE:
+        // if error has alreary occured during opening file
+        if (errorType != ERR_NO)
+            break;
+
+        // set new metrics of displayed model
+        capacityCharsX = model.displayed->capacityCharsX;   // temp value with previous capacity
+        model.displayed->clientAreaX    = LOWORD(lParam);
+        model.displayed->clientAreaY    = HIWORD(lParam);
+        model.displayed->capacityCharsX = LOWORD(lParam) / model.displayed->charPixelsX;
+        model.displayed->capacityCharsY = HIWORD(lParam) / model.displayed->charPixelsY;
+
+        UpdateWindowMetrics(hWindow, model.stored, model.displayed, capacityCharsX);
+        break;
+    // WM_SIZE
+
+    case WM_INDEXING_PROGRESS:
+        // model may be destroyed while notifications are still in queue
+        if (model.stored == NULL)
+            break;
+        ShowIndexingProgress(hWindow, model.stored);
+        if (!UpdateIndexingProgress(model.stored, model.displayed))
+            break;
+
+        // hit found before it's line has been indexed may be shown now
+        moved = UpdateSearchProgress(model.stored, model.displayed);
+        if (moved)
+            ShowIndexingProgress(hWindow, model.stored);
+
+        // new lines extend scrollbars ranges and may appear in client area
+        // (lines shown already don't change, so only rows of new lines are repainted)
+        UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+        if (moved)
+            InvalidateRect(hWindow, NULL, TRUE);
+        else
+            ShowDisplayList(hWindow, model.stored, model.displayed, 0, &shownRows, &nextRows);
+        break;
+    // WM_INDEXING_PROGRESS
+
+    case WM_SEARCH_PROGRESS:
+        // model may be destroyed while notifications are still in queue
+        if (model.stored == NULL)
+            break;
+        moved = UpdateSearchProgress(model.stored, model.displayed);
+        ShowIndexingProgress(hWindow, model.stored);
+        if (!moved)
+            break;
+
+        // the first hit is shown
+        UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+        InvalidateRect(hWindow, NULL, TRUE);
+        break;
+    // WM_SEARCH_PROGRESS
+
+    case WM_TRIGRAM_PROGRESS:
+        // model may be destroyed while notifications are still in queue
+        if (model.stored == NULL)
+            break;
+        UpdateTrigramIndexing(model.stored);
+        ShowIndexingProgress(hWindow, model.stored);
+        break;
+    // WM_TRIGRAM_PROGRESS
+
+    case WM_FILTER_PROGRESS:
+        // model may be destroyed while notifications are still in queue
+        if (model.stored == NULL)
+            break;
+        moved = UpdateFilterProgress(model.stored, model.displayed);
+        ShowIndexingProgress(hWindow, model.stored);
+        if (!moved)
+            break;
+
+        // new lines extend scrollbars ranges and may appear in client area
+        UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+        ShowDisplayList(hWindow, model.stored, model.displayed, 0, &shownRows, &nextRows);
+        break;
+    // WM_FILTER_PROGRESS
+
+    case WM_TIMER:
+        if (wParam != FOLLOW_TIMER_ID || model.stored == NULL)
+            break;
+        if (!FollowFile(model.stored, model.displayed))
+            break;
+
+        // view may be scrolled to the new end of text
+        UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+        InvalidateRect(hWindow, NULL, TRUE);
+        break;
+    // WM_TIMER
+
+    case WM_MOVE:
+        InvalidateRect(hWindow, NULL, TRUE);
+        break;
+    // WM_MOVE
+
+    case WM_HSCROLL:
+        if (model.displayed->viewMode != VIEW_MODE_STANDARD)
+            break;
+        incrementX = 0;
+
+        switch (LOWORD(wParam)) {
+        case SB_LINEUP:
+            incrementX = -1;
+            break;
+        case SB_LINEDOWN:
+            incrementX = 1;
+            break;
+        case SB_PAGEUP:
+            incrementX = -model.displayed->capacityCharsX;
+            break;
+        case SB_PAGEDOWN:
+            incrementX = model.displayed->capacityCharsX;
+            break;
+        case SB_THUMBTRACK:
+            incrementX = scrollToIncrementX(model.stored, model.displayed, HIWORD(wParam));
+            break;
+        default:
+            break;
+        }
+
+        if (incrementX != 0) {
+            // update model and set valid increment
+            incrementX = UpdateModelStandardX(model.stored, model.displayed, incrementX);
+
+            // rows moved horizontally are repainted, empty rows are kept
+            ShowDisplayList(hWindow, model.stored, model.displayed, 0, &shownRows, &nextRows);
+
+            // process scrollbars changes
+            if (LOWORD(wParam) == SB_THUMBTRACK)
+                scrollPosition = HIWORD(wParam);
+            else
+                scrollPosition = countScrollPositionX(model.stored, model.displayed);
+
+            SetScrollPos(hWindow, SB_HORZ, scrollPosition, TRUE);
+        }
+
+        break;
+    // WM_HSCROLL
+
+    case WM_VSCROLL:
+        incrementY = 0;
+        // current row is needed in wrap mode, so the index dropped by resize is rebuilt now
+        PrepareWrapIndex(model.stored, model.displayed);
+
+        switch (LOWORD(wParam)) {
+        case SB_LINEUP:
+            incrementY = -1;
+            break;
+        case SB_LINEDOWN:
+            incrementY = 1;
+            break;
+        case SB_PAGEUP:
+            incrementY = -model.displayed->capacityCharsY;
+            break;
+        case SB_PAGEDOWN:
+            incrementY = model.displayed->capacityCharsY;
+            break;
+        case SB_THUMBTRACK:
+            incrementY = HIWORD(wParam);
+            incrementY = scrollToIncrementY(model.stored, model.displayed, HIWORD(wParam));
+            break;
+        default:
+            break;
+        }
+
+        if (incrementY != 0) {
+            // update model and set valid increment
+            if (model.displayed->viewMode == VIEW_MODE_STANDARD)
+                incrementY = UpdateModelStandardY(model.stored, model.displayed, incrementY);
+            if (model.displayed->viewMode == VIEW_MODE_WRAP)
+                incrementY = UpdateModelWrapY(model.stored, model.displayed, incrementY);
+
+            // rows kept in client area are scrolled, only rows which have changed are repainted
+            ShowDisplayList(hWindow, model.stored, model.displayed, incrementY, &shownRows, &nextRows);
+
+            // process scrollbars changes
+            if (LOWORD(wParam) == SB_THUMBTRACK)
+                scrollPosition = HIWORD(wParam);
+            else
+                scrollPosition = countScrollPositionY(model.stored, model.displayed);
+
+            SetScrollPos(hWindow, SB_VERT, scrollPosition, TRUE);
+        }
+
+        break;
+    // WM_VSCROLL
+
+    case WM_KEYDOWN:
+        switch (wParam) {
+        case VK_UP:
+            PostMessage(hWindow, WM_VSCROLL, SB_LINEUP, (LPARAM)0);
+            break;
+        case VK_DOWN:
+            PostMessage(hWindow, WM_VSCROLL, SB_LINEDOWN, (LPARAM)0);
+            break;
+        case VK_LEFT:
+            PostMessage(hWindow, WM_HSCROLL, SB_LINEUP, (LPARAM)0);
+            break;
+        case VK_RIGHT:
+            PostMessage(hWindow, WM_HSCROLL, SB_LINEDOWN, (LPARAM)0);
+            break;
+        case VK_PRIOR:
+            PostMessage(hWindow, WM_VSCROLL, SB_PAGEUP, (LPARAM)0);
+            break;
+        case VK_NEXT:
+            PostMessage(hWindow, WM_VSCROLL, SB_PAGEDOWN, (LPARAM)0);
+            break;
+        case VK_HOME:
+            PostMessage(hWindow, WM_HSCROLL, SB_PAGEUP, (LPARAM)0);
+            break;
+        case VK_END:
+            PostMessage(hWindow, WM_HSCROLL, SB_PAGEDOWN, (LPARAM)0);
+            break;
+        case VK_ESCAPE:
+            CancelIndexing(model.stored);
+            CancelSearch(model.stored);
+            CancelFilter(model.stored);
+            break;
+        case VK_F3:
+            PostMessage(hWindow, WM_COMMAND, (GetKeyState(VK_SHIFT) < 0) ? IDM_SEARCH_PREVIOUS : IDM_SEARCH_NEXT, (LPARAM)0);
+            break;
+        case 'F':
+            if (GetKeyState(VK_CONTROL) < 0)
+                PostMessage(hWindow, WM_COMMAND, IDM_SEARCH_FIND, (LPARAM)0);
+            break;
+        case VK_TAB:
+            if (GetKeyState(VK_CONTROL) < 0)
+                PostMessage(hWindow, WM_COMMAND, (GetKeyState(VK_SHIFT) < 0) ? IDM_WINDOW_PREVIOUS : IDM_WINDOW_NEXT, (LPARAM)0);
+            break;
+        default:
+            break;
+        }
+
+        break;
+    // WM_KEYDOWN
+
+    case WM_PAINT:
+        hDeviceContext = BeginPaint(hWindow, &paintStruct);
+        lineWidth = GetMaxLineWidth(model.stored);
+        // frame is built again, since model may be changed after scrolling
+        listError = BuildDisplayList(model.stored, model.displayed, &shownRows);
+        if (listError == ERR_NO)
+            PaintDisplayList(hDeviceContext, &paintStruct.rcPaint, model.stored, model.displayed, &shownRows);
+        else
+            PrintError(NULL, listError, __FILE__, __LINE__);
+
+        EndPaint(hWindow, &paintStruct);
+
+        // shown lines with tabs may be wider than lines measured before, horizontal scrollbar is extended
+        if (GetMaxLineWidth(model.stored) != lineWidth)
+            UpdateWindowMetrics(hWindow, model.stored, model.displayed, model.displayed->capacityCharsX);
+        break;
+    // WM_PAINT
+
+    case WM_DESTROY:
+        if (follow)
+            KillTimer(hWindow, FOLLOW_TIMER_ID);
+        DestroyDocumentManager(&documents);
+        model.stored    = NULL;
+        model.displayed = NULL;
+        ReleaseRetainedBuffers();
+        DestroyDisplayList(&shownRows);
+        DestroyDisplayList(&nextRows);
+        PostQuitMessage(errorType);
+        break;
+    // WM_DESTROY
+
+    default:
+        return DefWindowProc (hWindow, message, wParam, lParam);
+    }
+
+    if (message == WM_PAINT)
+        TRACE_STOP("WM_PAINT", messageStart);
+    else if (message == WM_VSCROLL || message == WM_HSCROLL)
+        TRACE_STOP((message == WM_VSCROLL) ? "WM_VSCROLL" : "WM_HSCROLL", messageStart);
+    return errorType;
+}